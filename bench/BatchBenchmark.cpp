@@ -0,0 +1,199 @@
+// Throughput of the batch entries of LibraryInterfaceBatch.h against the
+// scalar long double ones of the same library. Times residual vectors and
+// Jacobians per point, and complete solves of many guesses one by one and
+// through Solver::solveBatch. The library is one built on LibraryTemplate.h.
+// Reports the CpuLevel the batch kernels run at (EAN_CPU picks a lower one)
+// and times their linear solves at every level this CPU supports.
+//
+// Usage: batch_benchmark LIBRARY [INITIAL GUESS...]
+// e.g.   batch_benchmark lib/Lib2ExampleAAutoDiff.so 0.1 0.1 -0.1
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../include/BatchKernels.h"
+#include "../include/NewtonSystemBatch.h"
+#include "../include/SharedLibrary.h"
+#include "../include/Solver.h"
+
+using NStandard::Val;
+using NStandard::Vector;
+
+namespace {
+
+const int POINTS = 4096;
+const int ROUNDS = 200;
+const int SOLVES = 8;
+
+// Nanoseconds per call of body, which is called count times
+template <typename F>
+double Time(int count, F body) {
+  auto start = std::chrono::steady_clock::now();
+  for (int k = 0; k < count; k++) {
+    body(k);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return seconds * 1e9 / count;
+}
+
+void Report(const char *what, double scalar, double batch) {
+  std::cout << what << ": long double " << scalar << " ns, batch " << batch
+            << " ns, speed-up " << scalar / batch << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: batch_benchmark LIBRARY [INITIAL GUESS...]"
+              << std::endl;
+    return 1;
+  }
+  SharedLibrary library;
+  if (!library.load(argv[1])) {
+    std::cerr << library.errorString() << std::endl;
+    return 1;
+  }
+  auto f = (NStandard::FunctionTypeC)library.resolve("evaluateFunction");
+  auto df =
+      (NStandard::DerivativeTypeC)library.resolve("evaluateDerivatives");
+  auto equations = (GetNumberOfEquationsFunc)library.resolve(
+      "getNumberOfEquations");
+  auto fBatch =
+      (NStandard::BatchFunctionTypeC)library.resolve("evaluateSystemBatch");
+  auto dfBatch =
+      (NStandard::BatchJacobianTypeC)library.resolve("evaluateJacobianBatch");
+  if (!f || !df || !equations || !fBatch || !dfBatch) {
+    std::cerr << "Missing functions in library" << std::endl;
+    return 1;
+  }
+
+  int n = equations();
+  Vector guess(n + 1, 1);
+  for (int i = 1; i <= n && i + 1 < argc; i++) {
+    guess[i] = std::strtold(argv[i + 1], nullptr);
+  }
+  // Guesses spread by up to 10% around the given one
+  std::vector<Vector> guesses(POINTS, guess);
+  unsigned seed = 12345;
+  for (Vector &g : guesses) {
+    for (int j = 1; j <= n; j++) {
+      seed = seed * 1103515245u + 12345u;
+      g[j] *= 1 + 0.2L * ((seed >> 8) / 16777216.0L - 0.5L);
+    }
+  }
+  std::vector<double> X(static_cast<size_t>(n) * POINTS);
+  for (int k = 0; k < POINTS; k++) {
+    for (int j = 0; j < n; j++) {
+      X[static_cast<size_t>(j) * POINTS + k] =
+          static_cast<double>(guesses[k][j + 1]);
+    }
+  }
+  std::vector<double> F(X.size()), J(X.size() * n);
+  Vector fx(n + 1), dfx(n + 1);
+  volatile Val sink = 0;
+
+  double residuals = Time(ROUNDS, [&](int) {
+                       for (const Vector &x : guesses) {
+                         for (int i = 1; i <= n; i++) {
+                           fx[i] = f(i, n, &x[0]);
+                         }
+                       }
+                       sink = fx[1];
+                     }) /
+                     POINTS;
+  double residualsBatch = Time(ROUNDS, [&](int) {
+                            fBatch(n, POINTS, X.data(), F.data());
+                            sink = F[0];
+                          }) /
+                          POINTS;
+  double jacobian = Time(ROUNDS, [&](int) {
+                      for (const Vector &x : guesses) {
+                        for (int i = 1; i <= n; i++) {
+                          df(i, n, &x[0], &dfx[0]);
+                        }
+                      }
+                      sink = dfx[1];
+                    }) /
+                    POINTS;
+  double jacobianBatch = Time(ROUNDS, [&](int) {
+                           dfBatch(n, POINTS, X.data(), J.data());
+                           sink = J[0];
+                         }) /
+                         POINTS;
+
+  // The Newton steps at the guesses, J and F copied in every round as the
+  // solves overwrite them
+  fBatch(n, POINTS, X.data(), F.data());
+  dfBatch(n, POINTS, X.data(), J.data());
+  std::vector<double> a(J.size()), b(F.size());
+  std::vector<unsigned char> failed(POINTS);
+  std::vector<double> linear;
+  for (CpuLevel level :
+       {CpuLevel::BASELINE, CpuLevel::AVX2, CpuLevel::AVX512}) {
+    if (level > DetectedCpuLevel()) {
+      break;
+    }
+    const NStandard::BatchKernels &kernels = NStandard::GetBatchKernels(level);
+    linear.push_back(Time(ROUNDS, [&](int) {
+                       a = J;
+                       b = F;
+                       kernels.solveLinear(n, POINTS, a.data(), b.data(),
+                                           failed.data());
+                       sink = b[0];
+                     }) /
+                     POINTS);
+  }
+
+  NStandard::Solver solver;
+  if (!solver.loadLibrary(argv[1])) {
+    std::cerr << solver.getLastError() << std::endl;
+    return 1;
+  }
+  int solved = 0, solvedBatch = 0;
+  double solve = Time(SOLVES, [&](int) {
+                   solved = 0;
+                   for (const Vector &g : guesses) {
+                     Vector x = g;
+                     solved += solver.solve(x, 20, 1e-16L).status ==
+                               SolverStatus::SUCCESS;
+                   }
+                 }) /
+                 POINTS;
+  double solveBatch = Time(SOLVES, [&](int) {
+                        std::vector<Vector> xs = guesses;
+                        solvedBatch = 0;
+                        for (const auto &result :
+                             solver.solveBatch(xs, 20, 1e-16L)) {
+                          solvedBatch +=
+                              result.status == SolverStatus::SUCCESS;
+                        }
+                      }) /
+                      POINTS;
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "System: " << n << " equations, " << POINTS
+            << " points, kernels at "
+            << CpuLevelName(NStandard::GetBatchKernels().level) << " (CPU "
+            << CpuLevelName(DetectedCpuLevel()) << ")" << std::endl;
+  Report("Residuals", residuals, residualsBatch);
+  Report("Jacobian ", jacobian, jacobianBatch);
+  Report("Solve    ", solve, solveBatch);
+  std::cout << "Linear solve with copy:";
+  for (size_t level = 0; level < linear.size(); level++) {
+    std::cout << " " << CpuLevelName(static_cast<CpuLevel>(level)) << " "
+              << linear[level] << " ns";
+  }
+  std::cout << std::endl;
+  std::cout << "Converged: " << solved << " one by one, " << solvedBatch
+            << " batched" << std::endl;
+  return 0;
+}
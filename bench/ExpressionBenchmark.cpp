@@ -0,0 +1,137 @@
+// Cost of typed equations against the compiled library of the same system.
+// Times residual vectors computed by the library, by the bytecode one point
+// at a time and in batches, and complete solves with both (the typed system
+// using its symbolic Jacobian).
+//
+// Usage: expression_benchmark LIBRARY EQUATIONS [INITIAL GUESS...]
+// e.g.   expression_benchmark lib/Lib3ExampleC.so lib/ExampleC.ean 1 1
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../include/ExpressionSystem.h"
+#include "../include/SharedLibrary.h"
+#include "../include/Solver.h"
+
+using NStandard::Val;
+using NStandard::Vector;
+
+namespace {
+
+const int EVALUATIONS = 1000000;
+const int SOLVES = 20000;
+
+// Nanoseconds per call of body, which is called count times
+template <typename F>
+double Time(int count, F body) {
+  auto start = std::chrono::steady_clock::now();
+  for (int k = 0; k < count; k++) {
+    body(k);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return seconds * 1e9 / count;
+}
+
+void Report(const char *what, double compiled, double typed) {
+  std::cout << what << ": library " << compiled << " ns, equations "
+            << typed << " ns, ratio " << typed / compiled << std::endl;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: expression_benchmark LIBRARY EQUATIONS "
+                 "[INITIAL GUESS...]"
+              << std::endl;
+    return 1;
+  }
+  SharedLibrary library;
+  if (!library.load(argv[1])) {
+    std::cerr << library.errorString() << std::endl;
+    return 1;
+  }
+  auto f = (NStandard::FunctionTypeC)library.resolve("evaluateFunction");
+  if (!f) {
+    std::cerr << "Missing functions in library" << std::endl;
+    return 1;
+  }
+  std::ifstream file(argv[2]);
+  std::stringstream source;
+  source << file.rdbuf();
+  ExpressionSystem system;
+  if (!file || !system.parse(source.str())) {
+    std::cerr << argv[2] << ": " << system.errorString() << std::endl;
+    return 1;
+  }
+
+  int n = system.equations();
+  Vector guess(n + 1, 1);
+  for (int i = 1; i <= n && i + 2 < argc; i++) {
+    guess[i] = std::strtold(argv[i + 2], nullptr);
+  }
+  Vector x = guess, fx(n + 1);
+  volatile Val sink = 0;
+
+  // x moves between evaluations, as in a Newton iteration
+  double compiled = Time(EVALUATIONS, [&](int k) {
+    x[1] = guess[1] + k * 1e-12L;
+    for (int i = 1; i <= n; i++) {
+      fx[i] = f(i, n, &x[0]);
+    }
+    sink = fx[1];
+  });
+  ExpressionSystem::Evaluator evaluator(system);
+  double scalar = Time(EVALUATIONS, [&](int k) {
+    x[1] = guess[1] + k * 1e-12L;
+    evaluator.evaluate(&x[0], &fx[0]);
+    sink = fx[1];
+  });
+  const int batch = 1024;
+  Vector points(static_cast<size_t>(batch) * n), residuals(points.size());
+  for (int p = 0; p < batch; p++) {
+    for (int j = 0; j < n; j++) {
+      points[p * n + j] = guess[j + 1] + p * 1e-12L;
+    }
+  }
+  double batched = Time(EVALUATIONS / batch, [&](int) {
+                     evaluator.evaluateBatch(batch, &points[0],
+                                             &residuals[0]);
+                     sink = residuals[0];
+                   }) /
+                   batch;
+
+  NStandard::Solver standard, typed;
+  if (!standard.loadLibrary(argv[1]) ||
+      !typed.loadExpressions(source.str())) {
+    std::cerr << "Cannot load the system" << std::endl;
+    return 1;
+  }
+  int iterations = 0;
+  auto solve = [&](NStandard::Solver &solver) {
+    return Time(SOLVES, [&](int) {
+      Vector start = guess;
+      iterations = solver.solve(start, 20, 1e-16L).iterations;
+    });
+  };
+  double solveCompiled = solve(standard);
+  double solveTyped = solve(typed);
+
+  std::cout << std::fixed << std::setprecision(1);
+  std::cout << "System: " << n << " equations, " << system.nonZeros()
+            << " Jacobian entries, " << system.instructionCount() << " ("
+            << system.fusedInstructionCount() << " with the Jacobian) "
+            << "instructions, " << iterations << " iterations per solve"
+            << std::endl;
+  Report("Residuals        ", compiled, scalar);
+  Report("Residuals batched", compiled, batched);
+  Report("Solve            ", solveCompiled, solveTyped);
+  return 0;
+}
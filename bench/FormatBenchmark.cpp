@@ -0,0 +1,92 @@
+// Throughput of the decimal formatter against the previous MPFR and
+// stringstream based output. Prints values per second for each path.
+
+#include <mpfr.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../include/DecimalFormat.h"
+
+namespace {
+
+const size_t COUNT = 1000000;
+
+template <typename F>
+double Rate(F body) {
+  auto start = std::chrono::steady_clock::now();
+  size_t checksum = body();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  // Keeps the work observable
+  if (checksum == 0) {
+    std::cout << "";
+  }
+  return COUNT / seconds;
+}
+
+// Previous implementation: MPFR conversion per endpoint, then stringstream
+size_t Reference(const std::vector<long double> &values, int digits) {
+  size_t total = 0;
+  mpfr_t v;
+  mpfr_init2(v, 64);
+  for (long double x : values) {
+    mpfr_set_ld(v, x, MPFR_RNDN);
+    mpfr_exp_t exponent;
+    char *text = mpfr_get_str(nullptr, &exponent, 10, digits, v, MPFR_RNDD);
+    std::ostringstream out;
+    out << text << "E" << exponent;
+    total += out.str().size();
+    mpfr_free_str(text);
+  }
+  mpfr_clear(v);
+  return total;
+}
+}  // namespace
+
+int main() {
+  std::mt19937_64 generator(12345);
+  std::uniform_real_distribution<long double> significand(-1, 1);
+  std::uniform_int_distribution<int> exponent(-30, 30);
+  std::vector<long double> values(COUNT);
+  for (long double &x : values) {
+    x = std::ldexp(significand(generator), exponent(generator));
+  }
+
+  char buffer[interval_arithmetic::FORMAT_BUFFER_SIZE];
+  const int digits = 17;
+
+  double fixed = Rate([&] {
+    size_t total = 0;
+    for (long double x : values) {
+      total += interval_arithmetic::FormatDecimal(x, digits, MPFR_RNDD, buffer,
+                                                  sizeof(buffer));
+    }
+    return total;
+  });
+  double shortest = Rate([&] {
+    size_t total = 0;
+    for (long double x : values) {
+      total += interval_arithmetic::FormatShortest(x, MPFR_RNDN, buffer,
+                                                   sizeof(buffer));
+    }
+    return total;
+  });
+  double reference = Rate([&] { return Reference(values, digits); });
+
+  std::cout << std::scientific << std::setprecision(3);
+  std::cout << "FormatDecimal (" << digits << " digits): " << fixed
+            << " values/s" << std::endl;
+  std::cout << "FormatShortest:             " << shortest << " values/s"
+            << std::endl;
+  std::cout << "MPFR + stringstream:        " << reference << " values/s"
+            << std::endl;
+  return 0;
+}
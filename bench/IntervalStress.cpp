@@ -0,0 +1,159 @@
+// Runs interval solves with different arithmetic contexts on many threads
+// at once: every thread installs its own context (mode, precision, output
+// digits) and repeatedly verifies a root with KrawczykSystem, enumerates
+// the roots of a box with BoxSearch (which starts workers of its own) and
+// formats the results. Each result must equal the one computed for the same
+// context on a single thread beforehand, and the context must be unchanged
+// afterwards. Exits with 1 on any difference. Meant to be run in a build
+// configured with -DEAN_SANITIZE_THREAD=ON, where ThreadSanitizer reports
+// any data race between the threads.
+//
+// Usage: interval_stress [THREADS] [ROUNDS]
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/BoxSearch.h"
+#include "../include/KrawczykSystem.h"
+
+using interval_arithmetic::IAContext;
+using interval_arithmetic::IAContextGuard;
+using NInterval::ValInterval;
+using NInterval::Vector;
+
+namespace {
+
+// x1^2 + x2^2 = 4, x1 = x2, roots at +-(sqrt 2, sqrt 2)
+ValInterval Residual(int i, int n, const ValInterval *x) {
+  int st = 0;
+  if (i == 1) {
+    return ISqr(x[1], st) + ISqr(x[2], st) - ValInterval(4, 4);
+  }
+  return x[1] - x[2];
+}
+
+void Derivatives(int i, int n, const ValInterval *x, ValInterval *dfatx) {
+  if (i == 1) {
+    dfatx[1] = 2.0L * x[1];
+    dfatx[2] = 2.0L * x[2];
+  } else {
+    dfatx[1] = ValInterval(1, 1);
+    dfatx[2] = ValInterval(-1, -1);
+  }
+}
+
+struct Outcome {
+  std::vector<std::string> verified;
+  std::vector<std::string> roots;
+  long undecided = 0;
+
+  bool operator==(const Outcome &other) const {
+    return verified == other.verified && roots == other.roots &&
+           undecided == other.undecided;
+  }
+};
+
+// Ends of every component, at the output digits of the context
+std::vector<std::string> Format(const Vector &x) {
+  std::vector<std::string> ends;
+  for (size_t i = 1; i < x.size(); i++) {
+    ValInterval component = x[i];
+    std::string left, right;
+    component.IEndsToStrings(left, right);
+    ends.push_back(left);
+    ends.push_back(right);
+  }
+  return ends;
+}
+
+Outcome Solve(const IAContext &context) {
+  IAContextGuard<long double> guard(context);
+  Outcome outcome;
+
+  Vector x(3);
+  x[1] = ValInterval(1.3L, 1.5L);
+  x[2] = ValInterval(1.3L, 1.5L);
+  int it = 0;
+  int st = 0;
+  bool unique = false;
+  NInterval::KrawczykSystem(2, x, Residual, Derivatives,
+                            NInterval::Contractor::KRAWCZYK, 20,
+                            ValInterval(1e-16L, 1e-16L), it, st, unique);
+  outcome.verified = Format(x);
+
+  Vector box(3);
+  box[1] = ValInterval(-3, 3);
+  box[2] = ValInterval(-3, 3);
+  NInterval::BoxSearchOptions options;
+  options.threads = 2;
+  NInterval::BoxSearchResult result =
+      NInterval::BoxSearch(2, box, Residual, Derivatives, options);
+  // The workers report in no particular order
+  for (const Vector &root : result.roots) {
+    std::vector<std::string> ends = Format(root);
+    outcome.roots.insert(outcome.roots.end(), ends.begin(), ends.end());
+  }
+  std::sort(outcome.roots.begin(), outcome.roots.end());
+  outcome.undecided = result.undecided.size();
+  return outcome;
+}
+
+bool Same(const IAContext &p, const IAContext &q) {
+  return p.mode == q.mode && p.precision == q.precision &&
+         p.outdigits == q.outdigits;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  int threads = argc > 1 ? std::atoi(argv[1]) : 8;
+  int rounds = argc > 2 ? std::atoi(argv[2]) : 20;
+
+  std::vector<IAContext> contexts(4);
+  contexts[1].mode = interval_arithmetic::DINT_MODE;
+  contexts[2].precision = interval_arithmetic::DOUBLE_PREC;
+  contexts[2].outdigits = interval_arithmetic::DOUBLE_DIGITS;
+  contexts[3].mode = interval_arithmetic::DINT_MODE;
+  contexts[3].precision = interval_arithmetic::FLOAT_PREC;
+  contexts[3].outdigits = interval_arithmetic::FLOAT_DIGITS;
+
+  std::vector<Outcome> expected;
+  for (const IAContext &context : contexts) {
+    expected.push_back(Solve(context));
+    // Two roots of two components with two ends
+    if (expected.back().roots.size() != 8) {
+      std::cerr << "expected 2 roots, found "
+                << expected.back().roots.size() / 4 << std::endl;
+      return 1;
+    }
+  }
+
+  std::atomic<int> failures(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t] {
+      const size_t c = t % contexts.size();
+      // Left on the thread by the guards of the previous rounds
+      IAContext outside = ValInterval::GetContext();
+      for (int k = 0; k < rounds; k++) {
+        if (!(Solve(contexts[c]) == expected[c])) {
+          failures++;
+        }
+        if (!Same(ValInterval::GetContext(), outside)) {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+
+  std::cout << threads * rounds << " solves on " << threads << " threads, "
+            << failures << " differences" << std::endl;
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+// Cost of running a library in an ean-worker process. Times whole-system
+// evaluations (all residuals and Jacobian rows) and complete solves, once
+// with the library loaded in process and once isolated, and prints the
+// time per call of both and the difference.
+//
+// Usage: isolation_benchmark LIBRARY [INITIAL GUESS...]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "../include/IsolatedLibrary.h"
+#include "../include/SharedLibrary.h"
+#include "../include/Solver.h"
+
+using NStandard::Val;
+using NStandard::Vector;
+
+namespace {
+
+const int EVALUATIONS = 200000;
+const int SOLVES = 20000;
+
+// Microseconds per call of body, which is called count times
+template <typename F>
+double Time(int count, F body) {
+  auto start = std::chrono::steady_clock::now();
+  for (int k = 0; k < count; k++) {
+    body(k);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return seconds * 1e6 / count;
+}
+
+void Report(const char *what, double inProcess, double isolated) {
+  std::cout << what << ": in process " << inProcess << " us, isolated "
+            << isolated << " us, overhead " << isolated - inProcess << " us"
+            << std::endl;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: isolation_benchmark LIBRARY [INITIAL GUESS...]"
+              << std::endl;
+    return 1;
+  }
+  std::string path = argv[1];
+
+  SharedLibrary library;
+  if (!library.load(path)) {
+    std::cerr << library.errorString() << std::endl;
+    return 1;
+  }
+  auto f = (NStandard::FunctionTypeC)library.resolve("evaluateFunction");
+  auto df =
+      (NStandard::DerivativeTypeC)library.resolve("evaluateDerivatives");
+  auto equations = (int (*)())library.resolve("getNumberOfEquations");
+  if (!f || !df || !equations) {
+    std::cerr << "Missing functions in library" << std::endl;
+    return 1;
+  }
+  IsolatedLibrary isolated;
+  if (!isolated.load(path)) {
+    std::cerr << isolated.errorString() << std::endl;
+    return 1;
+  }
+
+  int n = equations();
+  Vector guess(n + 1, 1);
+  for (int i = 1; i <= n && i + 1 < argc; i++) {
+    guess[i] = std::strtold(argv[i + 1], nullptr);
+  }
+  Vector x = guess, fx(n + 1), jacobian((n + 1) * (n + 1));
+  // Val sink keeps the in-process results observable
+  volatile Val sink = 0;
+
+  // x moves between evaluations, as in a Newton iteration
+  double direct = Time(EVALUATIONS, [&](int k) {
+    x[1] = guess[1] + k * 1e-12L;
+    for (int i = 1; i <= n; i++) {
+      fx[i] = f(i, n, &x[0]);
+      df(i, n, &x[0], &jacobian[i * (n + 1)]);
+    }
+    sink = fx[1];
+  });
+  double remote;
+  {
+    IsolatedLibrary::Session session(isolated);
+    remote = Time(EVALUATIONS, [&](int k) {
+      x[1] = guess[1] + k * 1e-12L;
+      session.evaluate(&x[0]);
+    });
+  }
+
+  NStandard::Solver standard, separate;
+  if (!standard.loadLibrary(path) ||
+      !separate.loadLibrary(path, NStandard::LibraryMode::ISOLATED)) {
+    std::cerr << "Cannot load " << path << std::endl;
+    return 1;
+  }
+  int iterations = 0;
+  auto solve = [&](NStandard::Solver &solver) {
+    return Time(SOLVES, [&](int) {
+      Vector start = guess;
+      iterations = solver.solve(start, 20, 1e-16L).iterations;
+    });
+  };
+  double solveDirect = solve(standard);
+  double solveRemote = solve(separate);
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "System: " << n << " equations, " << iterations
+            << " iterations per solve" << std::endl;
+  Report("Evaluation", direct, remote);
+  Report("Solve     ", solveDirect, solveRemote);
+  return 0;
+}
@@ -0,0 +1,420 @@
+// Checks the table-driven Kaucher multiplication and division (DIMul,
+// DIDiv) against the sign case analysis they replaced, then compares their
+// throughput on operands of random sign and orientation. Exits with 1 if
+// any result differs.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/Interval.h"
+
+namespace {
+
+using Val = long double;
+using I = interval_arithmetic::Interval<Val>;
+using interval_arithmetic::SetRounding;
+
+const size_t RANDOM_CHECKS = 2000000;
+const size_t COUNT = 1000000;
+
+// Previous DIMul. Two cases are taken here as the tables take them: an
+// improper [0, b < 0] times a negative interval used the proper interval's
+// endpoints, and [0, 0] counted as improper, so [0, 0] times an improper
+// interval with an infinite end gave NaN instead of zero.
+I ReferenceMul(const I &x, const I &y) {
+  I z1, z2, r;
+  Val z;
+  bool xn, xp, yn, yp, zero;
+
+  if ((x.a <= x.b) && (y.a <= y.b)) return IMul(x, y);
+  xn = (x.a < 0) && (x.b < 0);
+  xp = (x.a > 0) && (x.b > 0);
+  yn = (y.a < 0) && (y.b < 0);
+  yp = (y.a > 0) && (y.b > 0);
+  zero = false;
+  // A, B in H-T
+  if ((xn || xp) && (yn || yp)) {
+    if (xp && yp) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a * y.a;
+      z2.b = x.b * y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b * y.b;
+      z2.a = x.a * y.a;
+    } else if (xp && yn) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b * y.a;
+      z2.b = x.a * y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a * y.b;
+      z2.a = x.b * y.a;
+    } else if (xn && yp) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a * y.b;
+      z2.b = x.b * y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b * y.a;
+      z2.a = x.a * y.b;
+    } else {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b * y.b;
+      z2.b = x.a * y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a * y.a;
+      z2.a = x.b * y.b;
+    }
+    // A in H-T, B in T
+  } else if ((xn || xp) && (((y.a <= 0) && (y.b >= 0)) ||
+                            ((y.a >= 0) && (y.b <= 0)))) {
+    if (xp && (y.a <= y.b)) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b * y.a;
+      z2.b = x.b * y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b * y.b;
+      z2.a = x.b * y.a;
+    } else if (xp && (y.a > y.b)) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a * y.a;
+      z2.b = x.a * y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a * y.b;
+      z2.a = x.a * y.a;
+    } else if (xn && (y.a <= y.b)) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a * y.b;
+      z2.b = x.a * y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a * y.a;
+      z2.a = x.a * y.b;
+    } else {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b * y.b;
+      z2.b = x.b * y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b * y.a;
+      z2.a = x.b * y.b;
+    }
+    // A in T, B in H-T
+  } else if ((((x.a <= 0) && (x.b >= 0)) || ((x.a >= 0) && (x.b <= 0))) &&
+             (yn || yp)) {
+    if ((x.a <= x.b) && yp) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a * y.b;
+      z2.b = x.b * y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b * y.b;
+      z2.a = x.a * y.b;
+    } else if ((x.a <= x.b) && yn) {  // was (x.a <= 0)
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b * y.a;
+      z2.b = x.a * y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a * y.a;
+      z2.a = x.b * y.a;
+    } else if ((x.a > x.b) && yp) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a * y.a;
+      z2.b = x.b * y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b * y.a;
+      z2.a = x.a * y.a;
+    } else {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b * y.b;
+      z2.b = x.a * y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a * y.b;
+      z2.a = x.b * y.b;
+    }
+    // A, B in Z-, neither [0, 0]
+  } else if ((x.a >= 0) && (x.b <= 0) && (x.a > x.b) && (y.a >= 0) &&
+             (y.b <= 0) && (y.a > y.b)) {
+    SetRounding<Val>(FE_DOWNWARD);
+    z1.a = x.a * y.a;
+    z = x.b * y.b;
+    if (z1.a < z) z1.a = z;
+    z2.b = x.a * y.b;
+    z = x.b * y.a;
+    if (z < z2.b) z2.b = z;
+    SetRounding<Val>(FE_UPWARD);
+    z1.b = x.a * y.b;
+    z = x.b * y.a;
+    if (z < z1.b) z1.b = z;
+    z2.a = x.a * y.a;
+    z = x.b * y.b;
+    if (z2.a < z) z2.a = z;
+    // A in Z and B in Z- or A in Z- and B in Z
+  } else {
+    zero = true;
+  }
+  if (zero) {
+    r.a = 0;
+    r.b = 0;
+  } else if (z1.GetWidth() >= z2.GetWidth()) {
+    r = z1;
+  } else {
+    r = z2;
+  }
+  SetRounding<Val>(FE_TONEAREST);
+  return r;
+}
+
+// Previous DIDiv. Fixed here as in the tables: a proper interval containing
+// zero divided by a divisor containing zero, proper or not, was divided
+// instead of rejected (the class test lacked parentheses).
+I ReferenceDiv(const I &x, const I &y) {
+  I z1, z2, r;
+  bool xn, xp, yn, yp;
+
+  if ((x.a <= x.b) && (y.a <= y.b)) return IDiv(x, y);
+  xn = (x.a < 0) && (x.b < 0);
+  xp = (x.a > 0) && (x.b > 0);
+  yn = (y.a < 0) && (y.b < 0);
+  yp = (y.a > 0) && (y.b > 0);
+  // A, B in H-T
+  if ((xn || xp) && (yn || yp)) {
+    if (xp && yp) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a / y.b;
+      z2.b = x.b / y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b / y.a;
+      z2.a = x.a / y.b;
+    } else if (xp && yn) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b / y.b;
+      z2.b = x.a / y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a / y.a;
+      z2.a = x.b / y.b;
+    } else if (xn && yp) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a / y.a;
+      z2.b = x.b / y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b / y.b;
+      z2.a = x.a / y.a;
+    } else {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b / y.a;
+      z2.b = x.a / y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a / y.b;
+      z2.a = x.b / y.a;
+    }
+    // A in T, B in H-T
+  } else if ((((x.a <= 0) && (x.b >= 0)) || ((x.a >= 0) && (x.b <= 0))) &&
+             (yn || yp)) {
+    if ((x.a <= x.b) && yp) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a / y.a;
+      z2.b = x.b / y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b / y.a;
+      z2.a = x.a / y.a;
+    } else if ((x.a <= x.b) && yn) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b / y.b;
+      z2.b = x.a / y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a / y.b;
+      z2.a = x.b / y.b;
+    } else if ((x.a > x.b) && yp) {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.a / y.b;
+      z2.b = x.b / y.b;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.b / y.b;
+      z2.a = x.a / y.b;
+    } else {
+      SetRounding<Val>(FE_DOWNWARD);
+      z1.a = x.b / y.a;
+      z2.b = x.a / y.a;
+      SetRounding<Val>(FE_UPWARD);
+      z1.b = x.a / y.a;
+      z2.a = x.b / y.a;
+    }
+  } else {
+    SetRounding<Val>(FE_TONEAREST);
+    throw std::runtime_error("Division by an interval containing 0.");
+  }
+  if (z1.GetWidth() >= z2.GetWidth()) {
+    r = z1;
+  } else {
+    r = z2;
+  }
+  SetRounding<Val>(FE_TONEAREST);
+  return r;
+}
+
+// Equal ends, NaN matching NaN; a thrown division matches only a throw
+bool Same(Val p, Val q) { return p == q || (std::isnan(p) && std::isnan(q)); }
+
+template <typename F, typename G>
+bool Agree(F reference, G kernel, const I &x, const I &y, const char *name) {
+  I r, k;
+  bool referenceThrew = false, kernelThrew = false;
+  try {
+    r = reference(x, y);
+  } catch (const std::runtime_error &) {
+    referenceThrew = true;
+  }
+  try {
+    k = kernel(x, y);
+  } catch (const std::runtime_error &) {
+    kernelThrew = true;
+  }
+  if (referenceThrew == kernelThrew &&
+      (referenceThrew || (Same(r.a, k.a) && Same(r.b, k.b)))) {
+    return true;
+  }
+  std::cout << std::setprecision(21) << name << "([" << x.a << ", " << x.b
+            << "], [" << y.a << ", " << y.b << "]): ";
+  if (referenceThrew) {
+    std::cout << "throws";
+  } else {
+    std::cout << "[" << r.a << ", " << r.b << "]";
+  }
+  std::cout << " before, ";
+  if (kernelThrew) {
+    std::cout << "throws";
+  } else {
+    std::cout << "[" << k.a << ", " << k.b << "]";
+  }
+  std::cout << " now" << std::endl;
+  return false;
+}
+
+// Both operations on (x, y); counts the disagreements
+size_t Compare(const I &x, const I &y) {
+  size_t failures = 0;
+  failures += !Agree(ReferenceMul, interval_arithmetic::DIMul<Val>, x, y,
+                     "DIMul");
+  failures += !Agree(ReferenceDiv, interval_arithmetic::DIDiv<Val>, x, y,
+                     "DIDiv");
+  return failures;
+}
+
+// Random interval of either sign class and orientation
+I RandomInterval(std::mt19937_64 &generator, bool zeroFree) {
+  std::uniform_real_distribution<Val> magnitude(0.5L, 4);
+  std::uniform_int_distribution<int> kind(0, zeroFree ? 1 : 3);
+  Val p = magnitude(generator);
+  Val q = magnitude(generator);
+  if (p > q) std::swap(p, q);
+  I x;
+  switch (kind(generator)) {
+    case 0:
+      x = I(p, q);
+      break;
+    case 1:
+      x = I(-q, -p);
+      break;
+    default:
+      x = I(-p, q);
+      break;
+  }
+  return generator() & 1 ? x : x.Dual();
+}
+
+template <typename F>
+double Rate(F body) {
+  auto start = std::chrono::steady_clock::now();
+  Val checksum = body();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  // Keeps the work observable
+  if (checksum == 0) {
+    std::cout << "";
+  }
+  return COUNT / seconds;
+}
+
+template <typename F>
+Val Sum(F operation, const std::vector<I> &xs, const std::vector<I> &ys) {
+  Val total = 0;
+  for (size_t k = 0; k < xs.size(); k++) {
+    I r = operation(xs[k], ys[k]);
+    total += r.a + r.b;
+  }
+  return total;
+}
+}  // namespace
+
+int main() {
+  // The widths of the candidates are compared as DIntWidth does
+  I::SetMode(interval_arithmetic::DINT_MODE);
+
+  // Every interval with ends among the edge values, against every other
+  const Val inf = std::numeric_limits<Val>::infinity();
+  const Val edges[] = {0,
+                       -0.0L,
+                       std::numeric_limits<Val>::denorm_min(),
+                       -std::numeric_limits<Val>::denorm_min(),
+                       std::numeric_limits<Val>::min(),
+                       -std::numeric_limits<Val>::min(),
+                       0.1L,
+                       -0.1L,
+                       1,
+                       -1,
+                       3,
+                       -3,
+                       std::numeric_limits<Val>::max(),
+                       -std::numeric_limits<Val>::max(),
+                       inf,
+                       -inf};
+  std::vector<I> intervals;
+  for (Val a : edges) {
+    for (Val b : edges) {
+      intervals.push_back(I(a, b));
+    }
+  }
+  size_t failures = 0;
+  size_t checks = 0;
+  for (const I &x : intervals) {
+    for (const I &y : intervals) {
+      failures += Compare(x, y);
+      checks += 2;
+    }
+  }
+
+  std::mt19937_64 generator(12345);
+  std::uniform_real_distribution<Val> end(-4, 4);
+  for (size_t k = 0; k < RANDOM_CHECKS; k++) {
+    I x(end(generator), end(generator));
+    I y(end(generator), end(generator));
+    failures += Compare(x, y);
+    checks += 2;
+  }
+  std::cout << checks << " operations checked, " << failures
+            << " differences" << std::endl;
+
+  std::vector<I> xs(COUNT), ys(COUNT), divisors(COUNT);
+  for (size_t k = 0; k < COUNT; k++) {
+    xs[k] = RandomInterval(generator, false);
+    ys[k] = RandomInterval(generator, false);
+    divisors[k] = RandomInterval(generator, true);
+  }
+  double mul = Rate([&] { return Sum(ReferenceMul, xs, ys); });
+  double dimul = Rate(
+      [&] { return Sum(interval_arithmetic::DIMul<Val>, xs, ys); });
+  double div = Rate([&] { return Sum(ReferenceDiv, xs, divisors); });
+  double didiv = Rate(
+      [&] { return Sum(interval_arithmetic::DIDiv<Val>, xs, divisors); });
+
+  std::cout << std::scientific << std::setprecision(3);
+  std::cout << "DIMul, case analysis: " << mul << " ops/s" << std::endl;
+  std::cout << "DIMul, tables:        " << dimul << " ops/s" << std::endl;
+  std::cout << "DIDiv, case analysis: " << div << " ops/s" << std::endl;
+  std::cout << "DIDiv, tables:        " << didiv << " ops/s" << std::endl;
+  return failures == 0 ? 0 : 1;
+}
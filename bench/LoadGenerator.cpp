@@ -0,0 +1,316 @@
+// Load generator for ean-server. Opens a number of connections, keeps a
+// fixed number of SOLVE requests in flight on each for the given duration
+// and reports throughput and latency percentiles.
+
+#include <getopt.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/ServerProtocol.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+  std::string socketPath = "/tmp/ean.sock";
+  std::string library;
+  uint32_t arithmetic = protocol::STANDARD;
+  int connections = 4;
+  int depth = 16;
+  double seconds = 5;
+  int maxIterations = 10;
+  long double epsilon = 1e-16L;
+  // Guesses are drawn uniformly from [low, high] in every component
+  long double low = 0.5L;
+  long double high = 2.0L;
+};
+
+int Connect(const std::string &path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address),
+                        sizeof(address)) < 0) {
+    std::perror(("connect " + path).c_str());
+    std::exit(1);
+  }
+  return fd;
+}
+
+void SendAll(int fd, const std::string &data) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    ssize_t sent = send(fd, data.data() + offset, data.size() - offset,
+                        MSG_NOSIGNAL);
+    if (sent <= 0) {
+      std::perror("send");
+      std::exit(1);
+    }
+    offset += sent;
+  }
+}
+
+// Reads one message; returns its header and stores the payload
+protocol::Header Receive(int fd, std::string &buffer, std::string &payload) {
+  protocol::Header header;
+  for (;;) {
+    if (buffer.size() >= sizeof(header)) {
+      std::memcpy(&header, buffer.data(), sizeof(header));
+      if (!protocol::ValidHeader(header)) {
+        std::fprintf(stderr, "invalid response\n");
+        std::exit(1);
+      }
+      if (buffer.size() >= sizeof(header) + header.length) {
+        payload.assign(buffer, sizeof(header), header.length);
+        buffer.erase(0, sizeof(header) + header.length);
+        return header;
+      }
+    }
+    char chunk[65536];
+    ssize_t got = recv(fd, chunk, sizeof(chunk), 0);
+    if (got <= 0) {
+      std::fprintf(stderr, "server closed the connection\n");
+      std::exit(1);
+    }
+    buffer.append(chunk, got);
+  }
+}
+
+struct Totals {
+  std::mutex lock;
+  std::vector<double> latencies;
+  long statuses[8] = {0};
+  long failed = 0;
+};
+
+void RunConnection(const Options &options, uint32_t system, int n, int seed,
+                   Clock::time_point deadline, Totals &totals) {
+  int fd = Connect(options.socketPath);
+  std::mt19937_64 generator(seed);
+  std::uniform_real_distribution<long double> component(options.low,
+                                                        options.high);
+  const size_t count = options.arithmetic == protocol::INTERVAL ? 2 * n : n;
+  std::vector<long double> values(count);
+  std::vector<Clock::time_point> sentAt(options.depth);
+  std::vector<double> latencies;
+  long statuses[8] = {0};
+  long failed = 0;
+  std::string out, buffer, payload;
+
+  auto send = [&](uint32_t slot) {
+    for (size_t i = 0; i < count; i++) {
+      values[i] = component(generator);
+    }
+    if (options.arithmetic == protocol::INTERVAL) {
+      for (int i = 0; i < n; i++) {
+        if (values[2 * i] > values[2 * i + 1]) {
+          std::swap(values[2 * i], values[2 * i + 1]);
+        }
+      }
+    }
+    protocol::SolveRequest request = {system, options.maxIterations, 0, 0,
+                                      options.epsilon};
+    out.clear();
+    protocol::AppendMessage(out, protocol::SOLVE, slot, &request,
+                            sizeof(request), values.data(),
+                            count * sizeof(long double));
+    sentAt[slot] = Clock::now();
+    SendAll(fd, out);
+  };
+
+  // The request id is the slot of the in-flight window
+  for (int slot = 0; slot < options.depth; slot++) {
+    send(slot);
+  }
+  int inFlight = options.depth;
+  while (inFlight > 0) {
+    protocol::Header header = Receive(fd, buffer, payload);
+    Clock::time_point now = Clock::now();
+    uint32_t slot = header.requestId;
+    latencies.push_back(
+        std::chrono::duration<double, std::micro>(now - sentAt[slot]).count());
+    if (header.type == protocol::RESULT) {
+      protocol::SolveResult result;
+      std::memcpy(&result, payload.data(), sizeof(result));
+      if (result.status >= 0 && result.status < 8) {
+        statuses[result.status]++;
+      }
+    } else {
+      failed++;
+    }
+    if (now < deadline) {
+      send(slot);
+    } else {
+      inFlight--;
+    }
+  }
+  close(fd);
+
+  std::lock_guard<std::mutex> guard(totals.lock);
+  totals.latencies.insert(totals.latencies.end(), latencies.begin(),
+                          latencies.end());
+  for (int s = 0; s < 8; s++) {
+    totals.statuses[s] += statuses[s];
+  }
+  totals.failed += failed;
+}
+
+double Percentile(const std::vector<double> &sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+void PrintUsage(FILE *out) {
+  std::fputs(
+      "Usage: ean-loadgen [options] LIBRARY\n"
+      "\n"
+      "Options:\n"
+      "  -s, --socket PATH       server socket (default /tmp/ean.sock)\n"
+      "  -c, --connections N     parallel connections (default 4)\n"
+      "  -d, --depth N           requests in flight per connection\n"
+      "                          (default 16)\n"
+      "  -t, --seconds T         duration (default 5)\n"
+      "  -I, --interval          use interval arithmetic\n"
+      "  -n, --max-iterations N  iteration limit (default 10)\n"
+      "      --low X, --high X   range of the random guesses (0.5, 2)\n"
+      "  -h, --help              show this help\n",
+      out);
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options) {
+  enum { LOW = 256, HIGH };
+  static const struct option longOptions[] = {
+      {"socket", required_argument, nullptr, 's'},
+      {"connections", required_argument, nullptr, 'c'},
+      {"depth", required_argument, nullptr, 'd'},
+      {"seconds", required_argument, nullptr, 't'},
+      {"interval", no_argument, nullptr, 'I'},
+      {"max-iterations", required_argument, nullptr, 'n'},
+      {"low", required_argument, nullptr, LOW},
+      {"high", required_argument, nullptr, HIGH},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+  int c;
+  while ((c = getopt_long(argc, argv, "s:c:d:t:In:h", longOptions,
+                          nullptr)) != -1) {
+    switch (c) {
+      case 's':
+        options.socketPath = optarg;
+        break;
+      case 'c':
+        options.connections = std::max(1, std::atoi(optarg));
+        break;
+      case 'd':
+        options.depth = std::max(1, std::atoi(optarg));
+        break;
+      case 't':
+        options.seconds = std::atof(optarg);
+        break;
+      case 'I':
+        options.arithmetic = protocol::INTERVAL;
+        break;
+      case 'n':
+        options.maxIterations = std::max(1, std::atoi(optarg));
+        break;
+      case LOW:
+        options.low = std::strtold(optarg, nullptr);
+        break;
+      case HIGH:
+        options.high = std::strtold(optarg, nullptr);
+        break;
+      case 'h':
+        PrintUsage(stdout);
+        std::exit(0);
+      default:
+        return false;
+    }
+  }
+  if (optind != argc - 1) {
+    return false;
+  }
+  options.library = argv[optind];
+  return true;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage(stderr);
+    return 1;
+  }
+
+  // The server resolves the path itself, so make it absolute
+  if (options.library[0] != '/') {
+    char cwd[4096];
+    if (getcwd(cwd, sizeof(cwd))) {
+      options.library = std::string(cwd) + "/" + options.library;
+    }
+  }
+  int fd = Connect(options.socketPath);
+  std::string out, buffer, payload;
+  protocol::LoadRequest load = {options.arithmetic};
+  protocol::AppendMessage(out, protocol::LOAD, 0, &load, sizeof(load),
+                          options.library.data(), options.library.size());
+  SendAll(fd, out);
+  protocol::Header header = Receive(fd, buffer, payload);
+  close(fd);
+  if (header.type != protocol::LOADED) {
+    std::fprintf(stderr, "load failed: %s\n",
+                 payload.substr(sizeof(protocol::ErrorResult)).c_str());
+    return 1;
+  }
+  protocol::LoadResult loaded;
+  std::memcpy(&loaded, payload.data(), sizeof(loaded));
+
+  Totals totals;
+  Clock::time_point start = Clock::now();
+  Clock::time_point deadline =
+      start + std::chrono::microseconds(
+                  static_cast<long>(options.seconds * 1e6));
+  std::vector<std::thread> threads;
+  for (int c = 0; c < options.connections; c++) {
+    threads.emplace_back(RunConnection, std::cref(options), loaded.system,
+                         loaded.equations, c + 1, deadline,
+                         std::ref(totals));
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+  double elapsed =
+      std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::sort(totals.latencies.begin(), totals.latencies.end());
+  std::printf("requests      %zu in %.2f s\n", totals.latencies.size(),
+              elapsed);
+  std::printf("throughput    %.0f solves/s\n",
+              totals.latencies.size() / elapsed);
+  std::printf("latency p50   %.1f us\n", Percentile(totals.latencies, 0.50));
+  std::printf("latency p99   %.1f us\n", Percentile(totals.latencies, 0.99));
+  std::printf("latency p99.9 %.1f us\n", Percentile(totals.latencies, 0.999));
+  std::printf("converged     %ld, other status %ld, failed %ld\n",
+              totals.statuses[0],
+              static_cast<long>(totals.latencies.size()) -
+                  totals.statuses[0] - totals.failed,
+              totals.failed);
+  return 0;
+}
@@ -0,0 +1,602 @@
+// Headless front end for the solvers. Loads a system library, reads initial
+// guesses from a file or stdin and writes one result line per guess, in
+// input order, while the next batch is being solved.
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/DecimalFormat.h"
+#include "../include/DecimalParse.h"
+#include "../include/NativeCompiler.h"
+#include "../include/Solver.h"
+#include "../include/SolverInterval.h"
+
+namespace {
+
+enum class Mode { STANDARD, INTERVAL, VERIFY };
+
+struct Options {
+  std::string library;
+  std::string input = "-";
+  std::string output = "-";
+  Mode mode = Mode::STANDARD;
+  NStandard::Globalization globalization = NStandard::Globalization::NONE;
+  bool binary = false;
+  long double epsilon = 1e-16L;
+  int maxIterations = 10;
+  int threads = 0;
+  // Significant digits of the output, 0 = shortest that reads back exactly.
+  // The default matches the GUI and stays on the integer fast path.
+  int digits = std::numeric_limits<long double>::digits10 + 1;
+  size_t batch = 4096;
+  bool isolated = false;
+  bool compile = false;
+};
+
+// One initial guess and, after solving, its result. Only the vector that
+// belongs to the mode is used.
+struct Job {
+  bool valid = false;
+  NStandard::Vector point;
+  NInterval::Vector box;
+  SolverStatus status = SolverStatus::INVALID_INPUT;
+  int iterations = 0;
+  bool unique = false;
+};
+
+void PrintUsage(FILE *out) {
+  std::fputs(
+      "Usage: ean-cli [options] LIBRARY\n"
+      "\n"
+      "Solves the system exported by LIBRARY once per initial guess. Text\n"
+      "input holds one guess per line, n numbers separated by spaces, tabs,\n"
+      "commas or semicolons; empty lines and lines starting with # are\n"
+      "skipped. In the interval modes a line may also hold 2n numbers, read\n"
+      "as lower and upper bounds. Binary input is a sequence of blocks of n\n"
+      "doubles in native byte order.\n"
+      "\n"
+      "A LIBRARY ending in .ean is a text file of equations in x1 ... xn,\n"
+      "one per line (e.g. \"x1^2 + 8*x2 - 16\" or \"x1 = exp(x2)\"). It is\n"
+      "interpreted in standard mode and compiled with the installed C++\n"
+      "compiler ($CXX) in the interval modes or with --compile; compiled\n"
+      "libraries are kept in ~/.cache/ean/native.\n"
+      "\n"
+      "Each guess produces one line\n"
+      "  INDEX STATUS ITERATIONS [UNIQUE] X1 ... Xn\n"
+      "where UNIQUE (1 or 0) is only present in verify mode and interval\n"
+      "components are written as [lo;hi].\n"
+      "\n"
+      "Options:\n"
+      "  -i, --input FILE          read guesses from FILE (default stdin)\n"
+      "  -o, --output FILE         write results to FILE (default stdout)\n"
+      "  -m, --mode MODE           standard, interval or verify\n"
+      "                            (default standard)\n"
+      "  -s, --step STEP           full, line-search or trust-region: how\n"
+      "                            far each Newton step goes in standard\n"
+      "                            mode (default full)\n"
+      "  -b, --binary              read binary blocks instead of text\n"
+      "  -e, --epsilon EPS         tolerance (default 1e-16)\n"
+      "  -n, --max-iterations N    iteration limit (default 10)\n"
+      "  -j, --threads N           worker threads (default: all cores)\n"
+      "  -d, --digits N            significant digits, 0 = shortest\n"
+      "                            round-trip representation (default 19)\n"
+      "      --batch N             guesses solved per batch (default 4096)\n"
+      "      --isolated            run the library in separate processes\n"
+      "                            (standard mode); a crash fails only the\n"
+      "                            guess being solved\n"
+      "      --compile             compile a .ean file to native code\n"
+      "  -h, --help                show this help\n",
+      out);
+}
+
+bool ParseInt(const char *text, int minimum, int &value) {
+  char *end;
+  long v = std::strtol(text, &end, 10);
+  if (*text == '\0' || *end != '\0' || v < minimum || v > 1000000000L) {
+    return false;
+  }
+  value = static_cast<int>(v);
+  return true;
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options) {
+  enum { BATCH = 256, ISOLATED, COMPILE };
+  static const struct option longOptions[] = {
+      {"input", required_argument, nullptr, 'i'},
+      {"output", required_argument, nullptr, 'o'},
+      {"mode", required_argument, nullptr, 'm'},
+      {"step", required_argument, nullptr, 's'},
+      {"binary", no_argument, nullptr, 'b'},
+      {"epsilon", required_argument, nullptr, 'e'},
+      {"max-iterations", required_argument, nullptr, 'n'},
+      {"threads", required_argument, nullptr, 'j'},
+      {"digits", required_argument, nullptr, 'd'},
+      {"batch", required_argument, nullptr, BATCH},
+      {"isolated", no_argument, nullptr, ISOLATED},
+      {"compile", no_argument, nullptr, COMPILE},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+  int c;
+  int value;
+  while ((c = getopt_long(argc, argv, "i:o:m:s:be:n:j:d:h", longOptions,
+                          nullptr)) != -1) {
+    switch (c) {
+      case 'i':
+        options.input = optarg;
+        break;
+      case 'o':
+        options.output = optarg;
+        break;
+      case 'm':
+        if (std::strcmp(optarg, "standard") == 0) {
+          options.mode = Mode::STANDARD;
+        } else if (std::strcmp(optarg, "interval") == 0) {
+          options.mode = Mode::INTERVAL;
+        } else if (std::strcmp(optarg, "verify") == 0) {
+          options.mode = Mode::VERIFY;
+        } else {
+          std::fprintf(stderr, "ean-cli: unknown mode '%s'\n", optarg);
+          return false;
+        }
+        break;
+      case 's':
+        if (std::strcmp(optarg, "full") == 0) {
+          options.globalization = NStandard::Globalization::NONE;
+        } else if (std::strcmp(optarg, "line-search") == 0) {
+          options.globalization = NStandard::Globalization::LINE_SEARCH;
+        } else if (std::strcmp(optarg, "trust-region") == 0) {
+          options.globalization = NStandard::Globalization::TRUST_REGION;
+        } else {
+          std::fprintf(stderr, "ean-cli: unknown step '%s'\n", optarg);
+          return false;
+        }
+        break;
+      case 'b':
+        options.binary = true;
+        break;
+      case 'e':
+        if (!interval_arithmetic::ParseDecimal(
+                optarg, optarg + std::strlen(optarg), options.epsilon) ||
+            !(options.epsilon >= 0)) {
+          std::fprintf(stderr, "ean-cli: invalid epsilon '%s'\n", optarg);
+          return false;
+        }
+        break;
+      case 'n':
+        if (!ParseInt(optarg, 1, options.maxIterations)) {
+          std::fprintf(stderr, "ean-cli: invalid iteration limit '%s'\n",
+                       optarg);
+          return false;
+        }
+        break;
+      case 'j':
+        if (!ParseInt(optarg, 0, options.threads)) {
+          std::fprintf(stderr, "ean-cli: invalid thread count '%s'\n",
+                       optarg);
+          return false;
+        }
+        break;
+      case 'd':
+        if (!ParseInt(optarg, 0, options.digits) ||
+            options.digits > interval_arithmetic::FORMAT_MAX_DIGITS) {
+          std::fprintf(stderr, "ean-cli: digits must be 0..%d\n",
+                       interval_arithmetic::FORMAT_MAX_DIGITS);
+          return false;
+        }
+        break;
+      case BATCH:
+        if (!ParseInt(optarg, 1, value)) {
+          std::fprintf(stderr, "ean-cli: invalid batch size '%s'\n", optarg);
+          return false;
+        }
+        options.batch = static_cast<size_t>(value);
+        break;
+      case ISOLATED:
+        options.isolated = true;
+        break;
+      case COMPILE:
+        options.compile = true;
+        break;
+      case 'h':
+        PrintUsage(stdout);
+        std::exit(0);
+      default:
+        return false;
+    }
+  }
+  if (optind != argc - 1) {
+    std::fputs("ean-cli: expected exactly one LIBRARY argument\n", stderr);
+    return false;
+  }
+  options.library = argv[optind];
+  // dlopen only searches the library path for names without a slash
+  if (options.library.find('/') == std::string::npos &&
+      access(options.library.c_str(), F_OK) == 0) {
+    options.library = "./" + options.library;
+  }
+  if (options.threads == 0) {
+    options.threads =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  return true;
+}
+
+class GuessReader {
+ public:
+  GuessReader(FILE *file, const Options &options, int n)
+      : file(file), options(options), n(n), line(nullptr), capacity(0),
+        lineNumber(0), malformed(0) {}
+
+  ~GuessReader() { std::free(line); }
+
+  // Replaces jobs with up to options.batch guesses; false at end of input
+  bool readBatch(std::vector<Job> &jobs) {
+    jobs.clear();
+    while (jobs.size() < options.batch) {
+      Job job;
+      bool more = options.binary ? readBinary(job) : readText(job);
+      if (!more) {
+        break;
+      }
+      if (!job.valid) {
+        malformed++;
+      }
+      jobs.push_back(std::move(job));
+    }
+    return !jobs.empty();
+  }
+
+  long malformedCount() const { return malformed; }
+
+ private:
+  FILE *file;
+  const Options &options;
+  int n;
+  char *line;
+  size_t capacity;
+  long lineNumber;
+  long malformed;
+  std::vector<long double> lo, hi;
+
+  bool readBinary(Job &job) {
+    std::vector<double> values(n);
+    size_t count = std::fread(values.data(), sizeof(double), n, file);
+    if (count == 0) {
+      return false;
+    }
+    if (count < static_cast<size_t>(n)) {
+      std::fprintf(stderr, "ean-cli: truncated block at end of input\n");
+      return true;
+    }
+    job.valid = true;
+    if (options.mode == Mode::STANDARD) {
+      job.point.assign(n + 1, 0.0L);
+      for (int i = 0; i < n; i++) {
+        job.point[i + 1] = values[i];
+      }
+    } else {
+      job.box.assign(n + 1, NInterval::ValInterval(0, 0));
+      for (int i = 0; i < n; i++) {
+        job.box[i + 1] = NInterval::ValInterval(values[i], values[i]);
+      }
+    }
+    return true;
+  }
+
+  bool readText(Job &job) {
+    ssize_t length;
+    while ((length = getline(&line, &capacity, file)) != -1) {
+      lineNumber++;
+      const char *first =
+          interval_arithmetic::decimal::SkipSeparators(line, line + length);
+      const char *last = line + length;
+      if (first == last || *first == '#') {
+        continue;
+      }
+      job.valid = options.mode == Mode::STANDARD ? parsePoint(first, last, job)
+                                                 : parseBox(first, last, job);
+      if (!job.valid && options.mode == Mode::STANDARD) {
+        std::fprintf(stderr, "ean-cli: line %ld: expected %d numbers\n",
+                     lineNumber, n);
+      } else if (!job.valid) {
+        std::fprintf(stderr,
+                     "ean-cli: line %ld: expected %d numbers or %d bounds\n",
+                     lineNumber, n, 2 * n);
+      }
+      return true;
+    }
+    return false;
+  }
+
+  bool parsePoint(const char *first, const char *last, Job &job) {
+    using interval_arithmetic::decimal::IsSeparator;
+    using interval_arithmetic::decimal::SkipSeparators;
+    job.point.assign(n + 1, 0.0L);
+    int count = 0;
+    for (const char *p = first; p < last; p = SkipSeparators(p, last)) {
+      const char *end = p;
+      while (end < last && !IsSeparator(*end)) {
+        end++;
+      }
+      if (count == n ||
+          !interval_arithmetic::ParseDecimal(p, end, job.point[count + 1])) {
+        return false;
+      }
+      count++;
+      p = end;
+    }
+    return count == n;
+  }
+
+  bool parseBox(const char *first, const char *last, Job &job) {
+    lo.clear();
+    hi.clear();
+    if (!interval_arithmetic::ParseDecimalColumn(first, last, lo, hi)) {
+      return false;
+    }
+    job.box.assign(n + 1, NInterval::ValInterval(0, 0));
+    if (lo.size() == static_cast<size_t>(n)) {
+      for (int i = 0; i < n; i++) {
+        job.box[i + 1] = NInterval::ValInterval(lo[i], hi[i]);
+      }
+      return true;
+    }
+    if (lo.size() == static_cast<size_t>(2 * n)) {
+      for (int i = 0; i < n; i++) {
+        if (!(lo[2 * i] <= hi[2 * i + 1])) {
+          return false;
+        }
+        job.box[i + 1] = NInterval::ValInterval(lo[2 * i], hi[2 * i + 1]);
+      }
+      return true;
+    }
+    return false;
+  }
+};
+
+// Guesses taken at a time by a worker when the library evaluates batches
+const size_t BATCH_CHUNK = 64;
+
+// Jobs [first, last) through Solver::solveBatch
+void SolveChunk(std::vector<Job> &jobs, size_t first, size_t last,
+                const Options &options, NStandard::Solver &standard) {
+  std::vector<NStandard::Vector> points;
+  std::vector<Job *> solved;
+  for (size_t k = first; k < last; k++) {
+    if (jobs[k].valid) {
+      points.push_back(std::move(jobs[k].point));
+      solved.push_back(&jobs[k]);
+    }
+  }
+  std::vector<NStandard::SolverResult> results =
+      standard.solveBatch(points, options.maxIterations, options.epsilon,
+                          options.globalization);
+  for (size_t p = 0; p < solved.size(); p++) {
+    solved[p]->point = std::move(points[p]);
+    solved[p]->status = results[p].status;
+    solved[p]->iterations = results[p].iterations;
+  }
+}
+
+void SolveBatch(std::vector<Job> &jobs, std::atomic<size_t> &cursor,
+                const Options &options, NStandard::Solver &standard,
+                NInterval::Solver &interval) {
+  const NInterval::ValInterval epsilon(options.epsilon, options.epsilon);
+  size_t k;
+  if (options.mode == Mode::STANDARD && standard.hasBatch()) {
+    while ((k = cursor.fetch_add(BATCH_CHUNK)) < jobs.size()) {
+      SolveChunk(jobs, k, std::min(k + BATCH_CHUNK, jobs.size()), options,
+                 standard);
+    }
+    return;
+  }
+  while ((k = cursor.fetch_add(1)) < jobs.size()) {
+    Job &job = jobs[k];
+    if (!job.valid) {
+      continue;
+    }
+    if (options.mode == Mode::STANDARD) {
+      NStandard::SolverResult result =
+          standard.solve(job.point, options.maxIterations, options.epsilon,
+                         options.globalization);
+      job.status = result.status;
+      job.iterations = result.iterations;
+    } else {
+      NInterval::SolverResult result =
+          options.mode == Mode::INTERVAL
+              ? interval.solve(job.box, options.maxIterations, epsilon)
+              : interval.verify(job.box, options.maxIterations, epsilon,
+                                NInterval::Contractor::HANSEN_SENGUPTA);
+      job.status = result.status;
+      job.iterations = result.iterations;
+      job.unique = result.unique;
+    }
+  }
+}
+
+void WriteBatch(const std::vector<Job> &jobs, long firstIndex,
+                const Options &options, std::string &text, FILE *out) {
+  char buffer[2 * interval_arithmetic::FORMAT_BUFFER_SIZE];
+  text.clear();
+  for (size_t k = 0; k < jobs.size(); k++) {
+    const Job &job = jobs[k];
+    int length = std::snprintf(buffer, sizeof(buffer), "%ld %s %d",
+                               firstIndex + static_cast<long>(k),
+                               SolverStatusName(job.status), job.iterations);
+    text.append(buffer, length);
+    if (options.mode == Mode::VERIFY) {
+      text += job.unique ? " 1" : " 0";
+    }
+    if (job.valid) {
+      if (options.mode == Mode::STANDARD) {
+        for (size_t i = 1; i < job.point.size(); i++) {
+          size_t size =
+              options.digits > 0
+                  ? interval_arithmetic::FormatDecimal(
+                        job.point[i], options.digits, MPFR_RNDN, buffer,
+                        sizeof(buffer))
+                  : interval_arithmetic::FormatShortest(
+                        job.point[i], MPFR_RNDN, buffer, sizeof(buffer));
+          text += ' ';
+          text.append(buffer, size);
+        }
+      } else {
+        for (size_t i = 1; i < job.box.size(); i++) {
+          size_t size = interval_arithmetic::FormatInterval(
+              job.box[i], options.digits, buffer, sizeof(buffer));
+          text += ' ';
+          text.append(buffer, size);
+        }
+      }
+    }
+    text += '\n';
+  }
+  std::fwrite(text.data(), 1, text.size(), out);
+  // Results are streamed: a consumer sees each batch as soon as it is done
+  std::fflush(out);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage(stderr);
+    return 1;
+  }
+
+  NStandard::Solver standard;
+  NInterval::Solver interval;
+  int n;
+  const std::string suffix = ".ean";
+  bool typed =
+      options.library.size() > suffix.size() &&
+      options.library.compare(options.library.size() - suffix.size(),
+                              suffix.size(), suffix) == 0;
+  bool interpreted = typed && !options.compile &&
+                     options.mode == Mode::STANDARD;
+  if (typed) {
+    std::ifstream file(options.library);
+    if (!file) {
+      std::perror(("ean-cli: " + options.library).c_str());
+      return 1;
+    }
+    std::stringstream source;
+    source << file.rdbuf();
+    std::string name = options.library.substr(options.library.rfind('/') + 1);
+    name.resize(name.size() - suffix.size());
+    if (interpreted) {
+      if (!standard.loadExpressions(source.str(), name)) {
+        std::fprintf(stderr, "ean-cli: %s: %s\n", options.library.c_str(),
+                     standard.getLastError().c_str());
+        return 1;
+      }
+    } else {
+      // Loaded below like any library
+      ExpressionSystem system;
+      std::string error;
+      std::string library;
+      if (!system.parse(source.str(), name)) {
+        error = system.errorString();
+      } else {
+        library = NativeCompiler().compile(
+            system,
+            options.mode == Mode::STANDARD
+                ? ExpressionSystem::Target::STANDARD
+                : ExpressionSystem::Target::INTERVAL,
+            error);
+      }
+      if (library.empty()) {
+        std::fprintf(stderr, "ean-cli: %s: %s\n", options.library.c_str(),
+                     error.c_str());
+        return 1;
+      }
+      options.library = library;
+    }
+  }
+  if (interpreted) {
+    n = standard.getEquationsCount();
+  } else if (options.mode == Mode::STANDARD) {
+    if (!standard.loadLibrary(options.library,
+                              options.isolated
+                                  ? NStandard::LibraryMode::ISOLATED
+                                  : NStandard::LibraryMode::IN_PROCESS)) {
+      std::fprintf(stderr, "ean-cli: %s\n", standard.getLastError().c_str());
+      return 1;
+    }
+    n = standard.getEquationsCount();
+  } else {
+    if (!interval.loadLibrary(options.library)) {
+      std::fprintf(stderr, "ean-cli: %s\n", interval.getLastError().c_str());
+      return 1;
+    }
+    n = interval.getEquationsCount();
+  }
+  if (n < 1) {
+    std::fprintf(stderr, "ean-cli: library reports %d equations\n", n);
+    return 1;
+  }
+
+  FILE *in = stdin;
+  if (options.input != "-") {
+    in = std::fopen(options.input.c_str(), options.binary ? "rb" : "r");
+    if (!in) {
+      std::perror(("ean-cli: " + options.input).c_str());
+      return 1;
+    }
+  }
+  FILE *out = stdout;
+  if (options.output != "-") {
+    out = std::fopen(options.output.c_str(), "w");
+    if (!out) {
+      std::perror(("ean-cli: " + options.output).c_str());
+      return 1;
+    }
+  }
+
+  GuessReader reader(in, options, n);
+  std::vector<Job> current, next;
+  std::string text;
+  long index = 0;
+  bool more = reader.readBatch(current);
+  while (more) {
+    // Workers solve the current batch while this thread reads the next one
+    std::atomic<size_t> cursor(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.threads; t++) {
+      workers.emplace_back(SolveBatch, std::ref(current), std::ref(cursor),
+                           std::cref(options), std::ref(standard),
+                           std::ref(interval));
+    }
+    more = reader.readBatch(next);
+    for (auto &w : workers) {
+      w.join();
+    }
+    WriteBatch(current, index, options, text, out);
+    index += static_cast<long>(current.size());
+    current.swap(next);
+  }
+
+  if (in != stdin) {
+    std::fclose(in);
+  }
+  if (out != stdout && std::fclose(out) != 0) {
+    std::perror(("ean-cli: " + options.output).c_str());
+    return 1;
+  }
+  return reader.malformedCount() > 0 ? 2 : 0;
+}
@@ -0,0 +1,34 @@
+#ifndef __BATCHKERNELS_H__
+#define __BATCHKERNELS_H__
+
+#include "./CpuDispatch.h"
+
+namespace NStandard {
+
+// The arithmetic of one iteration of NewtonSystemBatch, for count points
+// at once in the layout of LibraryInterfaceBatch.h (0-based, point p of
+// row i at [i * count + p]). The loops run across the points, so each is
+// built for every CpuLevel.
+struct BatchKernels {
+  CpuLevel level;
+
+  // Overwrites F with the Newton steps d, J d = -F, by Gaussian
+  // elimination with partial pivoting; J is destroyed. failed[p] is set
+  // for points whose J is singular or whose step is not finite, and their
+  // step is zero.
+  void (*solveLinear)(int n, int count, double *J, double *F,
+                      unsigned char *failed);
+
+  // x += d; converged[p] is set where the largest step component is at
+  // most eps times the largest component of x before or after it
+  void (*update)(int n, int count, double *x, const double *d, double eps,
+                 unsigned char *converged);
+};
+
+// The kernels built for level, which the CPU must support
+const BatchKernels &GetBatchKernels(CpuLevel level);
+
+// The kernels of ActiveCpuLevel()
+const BatchKernels &GetBatchKernels();
+}  // namespace NStandard
+#endif  // __BATCHKERNELS_H__
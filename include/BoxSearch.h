@@ -0,0 +1,42 @@
+#ifndef __BOXSEARCH_H__
+#define __BOXSEARCH_H__
+
+#include <vector>
+
+#include "./KrawczykSystem.h"
+
+namespace NInterval {
+
+struct BoxSearchOptions {
+  // Operator used to contract the boxes that survive the residual test
+  Contractor method = Contractor::HANSEN_SENGUPTA;
+  // Number of worker threads, 0 = one per hardware thread
+  int threads = 0;
+  // Contraction steps applied to each box before it is bisected
+  int contractIterations = 8;
+  // Boxes narrower than this are reported as undecided instead of bisected
+  long double minWidth = 1e-12L;
+  // Upper bound on the number of boxes examined
+  long maxBoxes = 1000000;
+  ValInterval eps = ValInterval(1e-16L, 1e-16L);
+};
+
+struct BoxSearchResult {
+  // Boxes proven to contain exactly one root
+  std::vector<Vector> roots;
+  // Boxes that could be neither discarded nor verified
+  std::vector<Vector> undecided;
+  long processed = 0;
+  long discarded = 0;
+  double seconds = 0;
+
+  double boxesPerSecond() const {
+    return seconds > 0 ? processed / seconds : 0;
+  }
+};
+
+BoxSearchResult BoxSearch(int n, const Vector &x, FunctionTypeC f,
+                          DerivativeTypeC df, const BoxSearchOptions &options);
+
+}  // namespace NInterval
+#endif  // __BOXSEARCH_H__
@@ -0,0 +1,24 @@
+#ifndef __CPUDISPATCH_H__
+#define __CPUDISPATCH_H__
+
+// Instruction set levels that the vectorised kernels of ean_core are built
+// for. The build targets the baseline, so one binary runs everywhere; the
+// kernels of the higher levels are compiled alongside and picked at run
+// time (see BatchKernels.h).
+enum class CpuLevel {
+  BASELINE,  // SSE2
+  AVX2,      // AVX2 and FMA
+  AVX512     // AVX-512F
+};
+
+// The highest level this CPU supports (CPUID)
+CpuLevel DetectedCpuLevel();
+
+// The level the kernels run at: the detected one, or the one named by
+// EAN_CPU ("baseline", "avx2" or "avx512") if it is set and supported.
+// Fixed at the first call.
+CpuLevel ActiveCpuLevel();
+
+// "baseline", "avx2" or "avx512"
+const char *CpuLevelName(CpuLevel level);
+#endif  // __CPUDISPATCH_H__
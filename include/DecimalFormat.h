@@ -0,0 +1,579 @@
+#ifndef __DECIMALFORMAT_H__
+#define __DECIMALFORMAT_H__
+
+#include <mpfr.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include "DecimalParse.h"
+
+namespace interval_arithmetic {
+
+// Binary to decimal conversion into caller-supplied buffers. Output has the
+// form [-]d.dddE<exp>, the same layout IEndsToStrings always produced.
+// Values whose scaled significand fits 128-bit integer arithmetic (roughly
+// 1e-27 .. 1e38 for up to 19 digits) are converted exactly with integer
+// operations; the rest go through MPFR on a per-thread scratch variable.
+// Shortest output is found directly from the exact ends of the interval of
+// values that read back to x, with 256-bit integer products, over roughly
+// the same range (1e-34 .. 1e38 for long double); outside of it, the digit
+// count is bisected with FormatDecimal and ParseDecimal.
+
+// Enough for any supported digit count, sign, exponent and terminator
+const size_t FORMAT_BUFFER_SIZE = 64;
+const int FORMAT_MAX_DIGITS = 40;
+
+namespace decimal {
+
+const char *const DIGIT_PAIRS =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "3738394041424344454647484950515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+inline uint64_t Pow10U64(int k) {
+  static const uint64_t table[20] = {1ULL,
+                                     10ULL,
+                                     100ULL,
+                                     1000ULL,
+                                     10000ULL,
+                                     100000ULL,
+                                     1000000ULL,
+                                     10000000ULL,
+                                     100000000ULL,
+                                     1000000000ULL,
+                                     10000000000ULL,
+                                     100000000000ULL,
+                                     1000000000000ULL,
+                                     10000000000000ULL,
+                                     100000000000000ULL,
+                                     1000000000000000ULL,
+                                     10000000000000000ULL,
+                                     100000000000000000ULL,
+                                     1000000000000000000ULL,
+                                     10000000000000000000ULL};
+  return table[k];
+}
+
+// Writes the D decimal digits of n (10^(D-1) <= n < 10^D) to out
+inline void WriteDigits(uint64_t n, int count, char *out) {
+  int i = count;
+  while (i >= 2) {
+    int pair = static_cast<int>(n % 100) * 2;
+    n /= 100;
+    out[--i] = DIGIT_PAIRS[pair + 1];
+    out[--i] = DIGIT_PAIRS[pair];
+  }
+  if (i == 1) {
+    out[0] = static_cast<char>('0' + n);
+  }
+}
+
+inline char *WriteExponent(int e, char *p) {
+  *p++ = 'E';
+  if (e < 0) {
+    *p++ = '-';
+    e = -e;
+  }
+  char tmp[8];
+  int len = 0;
+  do {
+    tmp[len++] = static_cast<char>('0' + e % 10);
+    e /= 10;
+  } while (e > 0);
+  while (len > 0) {
+    *p++ = tmp[--len];
+  }
+  return p;
+}
+
+// Assembles [-]d.ddd...E<exp> from a digit string; returns the end pointer
+inline char *Assemble(bool negative, const char *digits, int count,
+                      int exponent, char *p) {
+  if (negative) {
+    *p++ = '-';
+  }
+  *p++ = digits[0];
+  if (count > 1) {
+    *p++ = '.';
+    for (int i = 1; i < count; i++) {
+      *p++ = digits[i];
+    }
+  }
+  return WriteExponent(exponent, p);
+}
+
+// Direction on the magnitude of x: away from zero for RNDU on positive and
+// RNDD on negative values, toward zero for the opposite and RNDZ
+inline int Direction(bool negative, mpfr_rnd_t rnd) {
+  if (rnd == MPFR_RNDU) {
+    return negative ? -1 : 1;
+  }
+  if (rnd == MPFR_RNDD) {
+    return negative ? 1 : -1;
+  }
+  return rnd == MPFR_RNDZ ? -1 : 0;
+}
+
+#if defined(__SIZEOF_INT128__)
+using uint128 = unsigned __int128;
+
+inline int BitLength(uint128 v) {
+  uint64_t high = static_cast<uint64_t>(v >> 64);
+  uint64_t low = static_cast<uint64_t>(v);
+  if (high != 0) {
+    return 128 - __builtin_clzll(high);
+  }
+  return low != 0 ? 64 - __builtin_clzll(low) : 0;
+}
+
+inline uint64_t Pow5U64(int k) {
+  static const struct Table {
+    uint64_t value[28];
+    Table() {
+      value[0] = 1;
+      for (int i = 1; i < 28; i++) {
+        value[i] = value[i - 1] * 5;
+      }
+    }
+  } table;
+  return table.value[k];
+}
+
+inline uint128 Pow10U128(int k) {
+  uint128 r = 1;
+  for (int i = 0; i < k; i++) {
+    r *= 10;
+  }
+  return r;
+}
+
+// Computes the count-digit decimal significand of x > 0 and its decimal
+// exponent k (x ~ n * 10^(k - count + 1)), rounded toward zero (dir < 0),
+// away from zero (dir > 0) or to nearest even (dir == 0). Returns false
+// when the scaled value does not fit the integer fast path.
+template <typename T>
+inline bool FastDigits(T x, int count, int dir, uint64_t &n, int &k) {
+  const int precision = std::numeric_limits<T>::digits;
+  if (count > 19 || precision > 64) {
+    return false;
+  }
+  int binaryExponent;
+  T fraction = std::frexp(x, &binaryExponent);
+  uint64_t m = static_cast<uint64_t>(std::ldexp(fraction, precision));
+  int e = binaryExponent - precision;
+
+  k = static_cast<int>(std::floor(std::log10(x)));
+  for (int attempt = 0; attempt < 3; attempt++) {
+    int s = count - 1 - k;
+    uint128 floor, rem, den;
+    if (s >= 0) {
+      // m * 10^s * 2^e = m * 5^s * 2^(e + s), and 5^27 still fits 64 bits
+      if (s > 27) {
+        return false;
+      }
+      uint128 num = static_cast<uint128>(m) * Pow5U64(s);
+      int shift = e + s;
+      if (shift >= 0) {
+        if (BitLength(num) + shift > 127) {
+          return false;
+        }
+        floor = num << shift;
+        rem = 0;
+        den = 1;
+      } else {
+        int sh = -shift;
+        if (sh > 126) {
+          return false;
+        }
+        den = static_cast<uint128>(1) << sh;
+        floor = num >> sh;
+        rem = num & (den - 1);
+      }
+    } else {
+      int t = -s;
+      if (t > 38) {
+        return false;
+      }
+      uint128 div = Pow10U128(t);
+      uint128 num = m;
+      if (e >= 0) {
+        if (e > 63) {
+          return false;
+        }
+        num <<= e;
+        den = div;
+      } else {
+        if (BitLength(div) - e > 126) {
+          return false;
+        }
+        den = div << -e;
+      }
+      floor = num / den;
+      rem = num % den;
+    }
+
+    if (floor >= Pow10U64(count)) {
+      k++;
+      continue;
+    }
+    if (floor < Pow10U64(count - 1)) {
+      k--;
+      continue;
+    }
+
+    n = static_cast<uint64_t>(floor);
+    if (rem != 0) {
+      if (dir > 0) {
+        n++;
+      } else if (dir == 0) {
+        uint128 twice = rem * 2;
+        if (twice > den || (twice == den && (n & 1) != 0)) {
+          n++;
+        }
+      }
+    }
+    if (n == Pow10U64(count)) {
+      n = Pow10U64(count - 1);
+      k++;
+    }
+    return true;
+  }
+  return false;
+}
+
+inline uint128 Pow5U128(int k) {
+  static const struct Table {
+    uint128 value[56];
+    Table() {
+      value[0] = 1;
+      for (int i = 1; i < 56; i++) {
+        value[i] = value[i - 1] * 5;
+      }
+    }
+  } table;
+  return table.value[k];
+}
+
+// a * b as the 256-bit value high * 2^128 + low
+inline void Multiply(uint128 a, uint128 b, uint128 &high, uint128 &low) {
+  const uint128 mask = ~static_cast<uint64_t>(0);
+  uint128 p00 = (a & mask) * (b & mask);
+  uint128 p01 = (a & mask) * (b >> 64);
+  uint128 p10 = (a >> 64) * (b & mask);
+  uint128 p11 = (a >> 64) * (b >> 64);
+  uint128 middle = (p00 >> 64) + (p01 & mask) + (p10 & mask);
+  low = (middle << 64) | (p00 & mask);
+  high = p11 + (p01 >> 64) + (p10 >> 64) + (middle >> 64);
+}
+
+// floor(a / 10) for a < 2^124, as a * ceil(2^131 / 10) / 2^131, whose error
+// stays below 1/128 and never crosses an integer
+inline uint128 Divide10(uint128 a) {
+  const uint64_t pattern = 0xCCCCCCCCCCCCCCCCULL;
+  const uint128 reciprocal =
+      (static_cast<uint128>(pattern) << 64) | (pattern + 1);
+  uint128 high, low;
+  Multiply(a, reciprocal, high, low);
+  return high >> 3;
+}
+
+// n * 2^e * 10^s as its integer part and its fraction, which is above 1/2
+// (half and sticky), exactly 1/2 (half), below 1/2 (sticky) or zero
+struct Scaled {
+  uint128 floor;
+  bool half;
+  bool sticky;
+};
+
+// Returns false when the value does not fit the integer arithmetic
+inline bool Scale(uint128 n, int e, int s, Scaled &out) {
+  out.half = false;
+  out.sticky = false;
+  if (s < 0) {
+    // Only large values, which are integers in binary
+    int t = -s;
+    if (t > 38 || e < 0 || BitLength(n) + e > 127) {
+      return false;
+    }
+    uint128 num = n << e;
+    uint128 den = Pow10U128(t);
+    uint128 twice = (num % den) * 2;
+    out.floor = num / den;
+    out.half = twice >= den;
+    out.sticky = out.half ? twice > den : twice != 0;
+    return true;
+  }
+
+  // n * 10^s * 2^e = n * 5^s * 2^(e + s)
+  if (s > 55) {
+    return false;
+  }
+  uint128 high, low;
+  Multiply(n, Pow5U128(s), high, low);
+  int shift = e + s;
+  if (shift >= 0) {
+    if (high != 0 || BitLength(low) + shift > 127) {
+      return false;
+    }
+    out.floor = low << shift;
+    return true;
+  }
+  int sh = -shift;
+  const uint128 one = 1;
+  if (sh < 128) {
+    if ((high >> sh) != 0) {
+      return false;
+    }
+    out.floor = (low >> sh) | (high << (128 - sh));
+    out.half = ((low >> (sh - 1)) & 1) != 0;
+    out.sticky = (low & ((one << (sh - 1)) - 1)) != 0;
+  } else if (sh == 128) {
+    out.floor = high;
+    out.half = (low >> 127) != 0;
+    out.sticky = (low & ((one << 127) - 1)) != 0;
+  } else if (sh < 256) {
+    out.floor = high >> (sh - 128);
+    out.half = ((high >> (sh - 129)) & 1) != 0;
+    out.sticky = low != 0 || (high & ((one << (sh - 129)) - 1)) != 0;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Shortest decimal significand r and exponent k (x ~ r * 10^k) of x > 0
+// that reads back to x: to nearest for dir == 0, in [x, succ(x)) for
+// dir > 0 and in (pred(x), x] for dir < 0. Among the decimals of that
+// length, r is x rounded in direction dir. The ends of the interval are
+// scaled to integers with a digit more than max_digits10, then digits are
+// dropped from all three values as long as the rounded x stays inside.
+// Returns false outside the range of the integer arithmetic.
+template <typename T>
+inline bool ShortestDigits(T x, int dir, uint128 &r, int &k) {
+  const int precision = std::numeric_limits<T>::digits;
+  if (precision > 64) {
+    return false;
+  }
+  int binaryExponent;
+  T fraction = std::frexp(x, &binaryExponent);
+  // Below, the spacing is that of the subnormals
+  if (binaryExponent <= std::numeric_limits<T>::min_exponent) {
+    return false;
+  }
+  uint64_t m = static_cast<uint64_t>(std::ldexp(fraction, precision));
+
+  // In units of a quarter of the spacing above x; the spacing below is
+  // half as large at a power of two
+  uint128 v = static_cast<uint128>(m) * 4;
+  int gap = m == (static_cast<uint64_t>(1) << (precision - 1)) ? 2 : 4;
+  uint128 lower = v, upper = v;
+  bool lowerInside = true, upperInside = true;
+  if (dir < 0) {
+    lower = v - gap;
+    lowerInside = false;
+  } else if (dir > 0) {
+    upper = v + 4;
+    upperInside = false;
+  } else {
+    // Halfway points round to the even neighbour
+    lower = v - gap / 2;
+    upper = v + 2;
+    lowerInside = upperInside = (m & 1) == 0;
+  }
+
+  int e = binaryExponent - precision - 2;
+  // The estimate of floor(log10 x) is at most one too small
+  int s = std::numeric_limits<T>::max_digits10 -
+          static_cast<int>(std::floor((binaryExponent - 1) *
+                                      0.30102999566398119521L));
+  Scaled sv, sl, su;
+  if (!Scale(v, e, s, sv) || !Scale(lower, e, s, sl) ||
+      !Scale(upper, e, s, su) || BitLength(su.floor) > 123) {
+    return false;
+  }
+
+  // a, b and c are x and the ends divided by 10^j and rounded down. The
+  // fraction of x below a is given by its first digit (5 stands for a half
+  // or more at j = 0) and whether any further one is nonzero.
+  uint128 a = sv.floor, b = sl.floor, c = su.floor;
+  int digit = sv.half ? 5 : 0;
+  bool rest = sv.sticky;
+  bool lowerExact = !sl.half && !sl.sticky;
+  bool upperExact = !su.half && !su.sticky;
+  bool found = false;
+  for (int j = 0; j < 40; j++) {
+    // Multiples of 10^j in the interval; none for j means none for j + 1
+    uint128 first = lowerExact && lowerInside ? b : b + 1;
+    bool upperOut = upperExact && !upperInside;
+    if (first + (upperOut ? 1 : 0) > c) {
+      break;
+    }
+    bool up = dir > 0 ? digit != 0 || rest
+                      : dir == 0 && (digit > 5 ||
+                                     (digit == 5 && (rest || (a & 1) != 0)));
+    uint128 rounded = a + (up ? 1 : 0);
+    if (rounded >= first && rounded + (upperOut ? 1 : 0) <= c) {
+      r = rounded;
+      k = j - s;
+      found = true;
+    }
+    uint128 a10 = Divide10(a), b10 = Divide10(b), c10 = Divide10(c);
+    rest = rest || digit != 0;
+    digit = static_cast<int>(a - a10 * 10);
+    lowerExact = lowerExact && b == b10 * 10;
+    upperExact = upperExact && c == c10 * 10;
+    a = a10;
+    b = b10;
+    c = c10;
+  }
+  if (!found) {
+    return false;
+  }
+  while (r % 10 == 0) {
+    r /= 10;
+    k++;
+  }
+  return true;
+}
+
+// Writes the decimal digits of r > 0 to out; returns their count
+inline int WriteSignificand(uint128 r, char *out) {
+  const uint64_t base = Pow10U64(19);
+  uint64_t high = static_cast<uint64_t>(r / base);
+  uint64_t low = static_cast<uint64_t>(r % base);
+  uint64_t leading = high != 0 ? high : low;
+  int count = 1;
+  while (count < 20 && leading >= Pow10U64(count)) {
+    count++;
+  }
+  if (high == 0) {
+    WriteDigits(low, count, out);
+    return count;
+  }
+  WriteDigits(high, count, out);
+  WriteDigits(low, 19, out + count);
+  return count + 19;
+}
+#endif
+
+inline void ToMPFR(mpfr_ptr v, float x) { mpfr_set_flt(v, x, MPFR_RNDN); }
+inline void ToMPFR(mpfr_ptr v, double x) { mpfr_set_d(v, x, MPFR_RNDN); }
+inline void ToMPFR(mpfr_ptr v, long double x) {
+  mpfr_set_ld(v, x, MPFR_RNDN);
+}
+}  // namespace decimal
+
+// Writes x with the given number of significant digits, rounded in
+// direction rnd (MPFR_RNDD, MPFR_RNDU or MPFR_RNDN), into buffer.
+// Returns the length without the terminating zero, or 0 if the buffer is
+// smaller than FORMAT_BUFFER_SIZE.
+template <typename T>
+inline size_t FormatDecimal(T x, int digits, mpfr_rnd_t rnd, char *buffer,
+                            size_t size) {
+  if (size < FORMAT_BUFFER_SIZE) {
+    return 0;
+  }
+  digits = digits < 1 ? 1 : (digits > FORMAT_MAX_DIGITS ? FORMAT_MAX_DIGITS
+                                                        : digits);
+  char *p = buffer;
+  bool negative = std::signbit(x);
+  if (std::isnan(x) || std::isinf(x)) {
+    const char *text = std::isnan(x) ? "NaN" : (negative ? "-Inf" : "Inf");
+    while (*text) {
+      *p++ = *text++;
+    }
+    *p = '\0';
+    return static_cast<size_t>(p - buffer);
+  }
+
+  char digitText[FORMAT_MAX_DIGITS + 2];
+  if (x == 0) {
+    for (int i = 0; i < digits; i++) {
+      digitText[i] = '0';
+    }
+    p = decimal::Assemble(negative, digitText, digits, 0, p);
+    *p = '\0';
+    return static_cast<size_t>(p - buffer);
+  }
+
+#if defined(__SIZEOF_INT128__)
+  int dir = decimal::Direction(negative, rnd);
+  uint64_t n;
+  int k;
+  if (decimal::FastDigits(negative ? -x : x, digits, dir, n, k)) {
+    decimal::WriteDigits(n, digits, digitText);
+    p = decimal::Assemble(negative, digitText, digits, k, p);
+    *p = '\0';
+    return static_cast<size_t>(p - buffer);
+  }
+#endif
+
+  mpfr_ptr v = decimal::ScratchValue(128);
+  decimal::ToMPFR(v, x);
+  mpfr_exp_t exponent;
+  mpfr_get_str(digitText, &exponent, 10, digits, v, rnd);
+  const char *d = digitText + (negative ? 1 : 0);
+  p = decimal::Assemble(negative, d, digits, static_cast<int>(exponent - 1),
+                        p);
+  *p = '\0';
+  return static_cast<size_t>(p - buffer);
+}
+
+// Shortest representation in direction rnd. For MPFR_RNDN the output reads
+// back to exactly x; for MPFR_RNDD (MPFR_RNDU) it is the shortest decimal in
+// (pred(x), x] ([x, succ(x))), so it still bounds x from below (above) and
+// reads back to x or its neighbour.
+template <typename T>
+inline size_t FormatShortest(T x, mpfr_rnd_t rnd, char *buffer, size_t size) {
+  const int maxDigits = std::numeric_limits<T>::max_digits10;
+  if (std::isnan(x) || std::isinf(x) || x == 0) {
+    return FormatDecimal(x, 1, rnd, buffer, size);
+  }
+#if defined(__SIZEOF_INT128__)
+  if (size < FORMAT_BUFFER_SIZE) {
+    return 0;
+  }
+  bool negative = std::signbit(x);
+  decimal::uint128 r;
+  int k;
+  if ((rnd == MPFR_RNDN || rnd == MPFR_RNDD || rnd == MPFR_RNDU) &&
+      decimal::ShortestDigits(negative ? -x : x,
+                              decimal::Direction(negative, rnd), r, k)) {
+    char digitText[FORMAT_MAX_DIGITS + 2];
+    int count = decimal::WriteSignificand(r, digitText);
+    char *p = decimal::Assemble(negative, digitText, count, k + count - 1,
+                                buffer);
+    *p = '\0';
+    return static_cast<size_t>(p - buffer);
+  }
+#endif
+  // Reading back correctly is monotone in the digit count, so bisect
+  int low = 1, high = maxDigits;
+  while (low < high) {
+    int digits = (low + high) / 2;
+    size_t length = FormatDecimal(x, digits, rnd, buffer, size);
+    if (length == 0) {
+      return 0;
+    }
+    T lo, hi;
+    bool exact;
+    if (rnd == MPFR_RNDD || rnd == MPFR_RNDU) {
+      ParseDecimal(buffer, buffer + length, lo, hi);
+      exact = (rnd == MPFR_RNDD ? hi : lo) == x;
+    } else {
+      ParseDecimal(buffer, buffer + length, lo);
+      exact = lo == x;
+    }
+    if (exact) {
+      high = digits;
+    } else {
+      low = digits + 1;
+    }
+  }
+  return FormatDecimal(x, low, rnd, buffer, size);
+}
+}  // namespace interval_arithmetic
+#endif  // __DECIMALFORMAT_H__
@@ -0,0 +1,376 @@
+#ifndef __DECIMALPARSE_H__
+#define __DECIMALPARSE_H__
+
+#include <fenv.h>
+#include <mpfr.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace interval_arithmetic {
+
+// Decimal to binary conversion with directed rounding. Short decimals (at
+// most 19 significant digits and a small exponent) are converted exactly in
+// hardware: the mantissa and the power of ten are both representable, so a
+// single multiplication or division under FE_DOWNWARD / FE_UPWARD yields the
+// tightest enclosure. Everything else falls back to one MPFR conversion.
+namespace decimal {
+
+const int MAX_MANTISSA_DIGITS = 19;
+
+// One scanned literal. Unless truncated or special, its value is
+// (-1)^negative * mantissa * 10^exponent.
+struct Literal {
+  const char *begin;
+  const char *end;
+  uint64_t mantissa;
+  int exponent;
+  bool negative;
+  bool truncated;
+  bool special;
+};
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline bool IsSeparator(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == ',' ||
+         c == ';';
+}
+
+inline const char *SkipSeparators(const char *p, const char *last) {
+  while (p < last && IsSeparator(*p)) {
+    p++;
+  }
+  return p;
+}
+
+// End of the inf, infinity, nan, @inf@ or @nan@ (in any case) at p, or
+// nullptr if there is none
+inline const char *ScanSpecial(const char *p, const char *last) {
+  static const char *const WORDS[] = {"infinity", "inf", "nan", "@inf@",
+                                      "@nan@"};
+  for (const char *word : WORDS) {
+    const char *q = p;
+    const char *w = word;
+    while (*w != '\0' && q < last &&
+           (*q == *w || (*q >= 'A' && *q <= 'Z' && *q - 'A' + 'a' == *w))) {
+      q++;
+      w++;
+    }
+    if (*w == '\0') {
+      return q;
+    }
+  }
+  return nullptr;
+}
+
+// Scans one literal at p. Returns false if p does not start a number.
+inline bool Scan(const char *p, const char *last, Literal &lit) {
+  lit.begin = p;
+  lit.mantissa = 0;
+  lit.exponent = 0;
+  lit.negative = false;
+  lit.truncated = false;
+  lit.special = false;
+
+  if (p < last && (*p == '+' || *p == '-')) {
+    lit.negative = *p == '-';
+    p++;
+  }
+
+  int digits = 0;
+  bool any = false;
+  bool fraction = false;
+  for (; p < last; p++) {
+    if (*p == '.' && !fraction) {
+      fraction = true;
+      continue;
+    }
+    if (!IsDigit(*p)) {
+      break;
+    }
+    any = true;
+    int d = *p - '0';
+    if (lit.mantissa == 0 && d == 0) {
+      lit.exponent -= fraction ? 1 : 0;
+    } else if (digits < MAX_MANTISSA_DIGITS) {
+      lit.mantissa = lit.mantissa * 10 + d;
+      digits++;
+      lit.exponent -= fraction ? 1 : 0;
+    } else {
+      lit.truncated = lit.truncated || d != 0;
+      lit.exponent += fraction ? 0 : 1;
+    }
+  }
+
+  if (!any) {
+    // inf and nan are left to MPFR, which reads all of these
+    const char *end = fraction ? nullptr : ScanSpecial(p, last);
+    if (end == nullptr) {
+      return false;
+    }
+    lit.special = true;
+    lit.end = end;
+    return true;
+  }
+
+  if (p < last && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool negativeExponent = false;
+    if (q < last && (*q == '+' || *q == '-')) {
+      negativeExponent = *q == '-';
+      q++;
+    }
+    if (q < last && IsDigit(*q)) {
+      int e = 0;
+      for (; q < last && IsDigit(*q); q++) {
+        if (e < 100000) {
+          e = e * 10 + (*q - '0');
+        }
+      }
+      lit.exponent += negativeExponent ? -e : e;
+      p = q;
+    }
+  }
+  lit.end = p;
+  return true;
+}
+
+// Largest k such that 10^k is exactly representable in W (5^k < 2^digits)
+template <typename W>
+inline int FastPow10Limit() {
+  return static_cast<int>(std::numeric_limits<W>::digits *
+                          0.43067655807339306);
+}
+
+template <typename W>
+inline const std::vector<W> &Pow10Table() {
+  static const std::vector<W> table = [] {
+    std::vector<W> t(FastPow10Limit<W>() + 1);
+    W p = 1;
+    for (size_t k = 0; k < t.size(); k++) {
+      t[k] = p;
+      p *= 10;
+    }
+    return t;
+  }();
+  return table;
+}
+
+// True if the literal converts exactly in W with one rounded operation
+template <typename W>
+inline bool IsFast(const Literal &lit) {
+  const int digits = std::numeric_limits<W>::digits;
+  if (lit.truncated || lit.special) {
+    return false;
+  }
+  if (lit.mantissa == 0) {
+    return true;
+  }
+  if (digits < 64 && lit.mantissa > (uint64_t(1) << (digits & 63))) {
+    return false;
+  }
+  return lit.exponent <= FastPow10Limit<W>() &&
+         -lit.exponent <= FastPow10Limit<W>();
+}
+
+// |value| of a fast literal in W, rounded in the current rounding mode
+template <typename W>
+inline W FastMagnitude(const Literal &lit) {
+  W m = static_cast<W>(lit.mantissa);
+  if (lit.mantissa == 0) {
+    return m;
+  }
+  const std::vector<W> &pow10 = Pow10Table<W>();
+  return lit.exponent >= 0 ? m * pow10[lit.exponent]
+                           : m / pow10[-lit.exponent];
+}
+
+inline void FromMPFR(mpfr_srcptr v, mpfr_rnd_t rnd, float &x) {
+  x = mpfr_get_flt(v, rnd);
+}
+
+inline void FromMPFR(mpfr_srcptr v, mpfr_rnd_t rnd, double &x) {
+  x = mpfr_get_d(v, rnd);
+}
+
+inline void FromMPFR(mpfr_srcptr v, mpfr_rnd_t rnd, long double &x) {
+  x = mpfr_get_ld(v, rnd);
+}
+
+// Per-thread MPFR variable for the slow path, allocated once
+struct Scratch {
+  mpfr_t value;
+  Scratch() { mpfr_init2(value, 128); }
+  ~Scratch() { mpfr_clear(value); }
+};
+
+inline mpfr_ptr ScratchValue(mpfr_prec_t precision) {
+  static thread_local Scratch scratch;
+  if (mpfr_get_prec(scratch.value) != precision) {
+    mpfr_set_prec(scratch.value, precision);
+  }
+  return scratch.value;
+}
+
+// Parses the literal with MPFR rounded toward -inf; returns the ternary
+// value (0 if the decimal is exact at the scratch precision).
+inline int SlowParse(const Literal &lit, mpfr_ptr v) {
+  std::string token(lit.begin, lit.end);
+  return mpfr_strtofr(v, token.c_str(), nullptr, 10, MPFR_RNDD);
+}
+
+// Tightest [lo, hi] in T around a literal that is not fast
+template <typename T>
+inline void SlowEnclose(const Literal &lit, T &lo, T &hi) {
+  const int digits = std::numeric_limits<T>::digits;
+  mpfr_ptr v = ScratchValue(digits + 64 > 128 ? digits + 64 : 128);
+  int ternary = SlowParse(lit, v);
+  FromMPFR(v, MPFR_RNDD, lo);
+  // x lies in [v, next(v)) and the scratch precision exceeds T's, so
+  // rounding next(v) upward gives the same T as rounding x upward
+  if (ternary != 0) {
+    mpfr_nextabove(v);
+  }
+  FromMPFR(v, MPFR_RNDU, hi);
+}
+
+// Scans a whole string holding exactly one number (surrounding separators
+// allowed).
+inline bool ScanSingle(const char *first, const char *last, Literal &lit) {
+  const char *p = SkipSeparators(first, last);
+  if (!Scan(p, last, lit)) {
+    return false;
+  }
+  return SkipSeparators(lit.end, last) == last;
+}
+}  // namespace decimal
+
+// Tightest enclosure [lo, hi] of the decimal number in [first, last).
+// Returns false if the text is not a single number.
+template <typename T>
+inline bool ParseDecimal(const char *first, const char *last, T &lo, T &hi) {
+  decimal::Literal lit;
+  if (!decimal::ScanSingle(first, last, lit)) {
+    return false;
+  }
+  if (!decimal::IsFast<long double>(lit)) {
+    decimal::SlowEnclose(lit, lo, hi);
+    return true;
+  }
+  // Rounding the magnitude down (up) in long double and then converting it
+  // down (up) to T gives the same result as rounding directly into T.
+  T down, up;
+  fesetround(FE_DOWNWARD);
+  down = static_cast<T>(decimal::FastMagnitude<long double>(lit));
+  fesetround(FE_UPWARD);
+  up = static_cast<T>(decimal::FastMagnitude<long double>(lit));
+  fesetround(FE_TONEAREST);
+  lo = lit.negative ? -up : down;
+  hi = lit.negative ? -down : up;
+  return true;
+}
+
+template <typename T>
+inline bool ParseDecimal(const std::string &text, T &lo, T &hi) {
+  return ParseDecimal(text.data(), text.data() + text.size(), lo, hi);
+}
+
+// Correctly rounded (to nearest) value of the decimal number in
+// [first, last), a drop-in replacement for std::stold.
+template <typename T>
+inline bool ParseDecimal(const char *first, const char *last, T &value) {
+  decimal::Literal lit;
+  if (!decimal::ScanSingle(first, last, lit)) {
+    return false;
+  }
+  if (decimal::IsFast<T>(lit)) {
+    T m = decimal::FastMagnitude<T>(lit);
+    value = lit.negative ? -m : m;
+    return true;
+  }
+  const int digits = std::numeric_limits<T>::digits;
+  const int precision = digits + 64 > 128 ? digits + 64 : 128;
+  mpfr_ptr v = decimal::ScratchValue(precision);
+  std::string token(lit.begin, lit.end);
+  // Round to odd at the scratch precision (truncate, then force the last
+  // bit when inexact), so that the final rounding to T is not a double
+  // rounding
+  int ternary = mpfr_strtofr(v, token.c_str(), nullptr, 10, MPFR_RNDZ);
+  if (ternary != 0 && mpfr_min_prec(v) < precision) {
+    if (mpfr_sgn(v) > 0) {
+      mpfr_nextabove(v);
+    } else {
+      mpfr_nextbelow(v);
+    }
+  }
+  decimal::FromMPFR(v, MPFR_RNDN, value);
+  return true;
+}
+
+template <typename T>
+inline bool ParseDecimal(const std::string &text, T &value) {
+  return ParseDecimal(text.data(), text.data() + text.size(), value);
+}
+
+// Bulk variant for columns of values separated by whitespace, commas or
+// semicolons. The enclosures are appended to lo and hi. Scanning is done
+// first and the rounding mode is switched once per column instead of twice
+// per value. On a malformed token, returns false and stores its offset in
+// errorOffset (if given); the values before it are still appended.
+template <typename T>
+inline bool ParseDecimalColumn(const char *first, const char *last,
+                               std::vector<T> &lo, std::vector<T> &hi,
+                               size_t *errorOffset = nullptr) {
+  std::vector<decimal::Literal> literals;
+  const char *p = decimal::SkipSeparators(first, last);
+  bool valid = true;
+  while (p < last) {
+    decimal::Literal lit;
+    if (!decimal::Scan(p, last, lit) ||
+        (lit.end < last && !decimal::IsSeparator(*lit.end))) {
+      valid = false;
+      if (errorOffset) {
+        *errorOffset = static_cast<size_t>(p - first);
+      }
+      break;
+    }
+    literals.push_back(lit);
+    p = decimal::SkipSeparators(lit.end, last);
+  }
+
+  size_t base = lo.size();
+  lo.resize(base + literals.size());
+  hi.resize(base + literals.size());
+
+  fesetround(FE_DOWNWARD);
+  for (size_t k = 0; k < literals.size(); k++) {
+    const decimal::Literal &lit = literals[k];
+    if (decimal::IsFast<long double>(lit)) {
+      T down = static_cast<T>(decimal::FastMagnitude<long double>(lit));
+      (lit.negative ? hi[base + k] : lo[base + k]) = lit.negative ? -down : down;
+    }
+  }
+  fesetround(FE_UPWARD);
+  for (size_t k = 0; k < literals.size(); k++) {
+    const decimal::Literal &lit = literals[k];
+    if (decimal::IsFast<long double>(lit)) {
+      T up = static_cast<T>(decimal::FastMagnitude<long double>(lit));
+      (lit.negative ? lo[base + k] : hi[base + k]) = lit.negative ? -up : up;
+    }
+  }
+  fesetround(FE_TONEAREST);
+
+  for (size_t k = 0; k < literals.size(); k++) {
+    if (!decimal::IsFast<long double>(literals[k])) {
+      decimal::SlowEnclose(literals[k], lo[base + k], hi[base + k]);
+    }
+  }
+  return valid;
+}
+}  // namespace interval_arithmetic
+#endif  // __DECIMALPARSE_H__
@@ -0,0 +1,395 @@
+#ifndef __DUAL_H__
+#define __DUAL_H__
+
+#include <math.h>
+
+#include <cmath>
+#include <type_traits>
+
+// Forward mode automatic differentiation.
+//
+// Dual<T, N> carries a value and its derivatives along N directions
+// (tangents). Any function written as a template over its number type and
+// evaluated on duals returns the derivatives of its result along the same
+// directions, exact up to rounding, at a small constant multiple of the
+// cost of evaluating it. N = 1 is the scalar mode, one directional
+// derivative per pass; with N >= n a whole gradient comes out of a single
+// pass. The tangents are a plain array updated element by element in
+// every operation, which the compiler vectorises for float and double.
+//
+// T may be long double, double or interval_arithmetic::Interval<T> (with
+// GenericMath.h, which provides the functions and mixed operators the
+// interval type lacks), or anything else with the usual operators and
+// functions found by argument-dependent lookup.
+namespace NAutoDiff {
+
+// c as a value of the same type as like. Interval types overload it.
+template <typename T>
+inline T Constant(const T &, long double c) {
+  return static_cast<T>(c);
+}
+
+// pi as a value of the same type as like, rounded to nearest. Interval
+// types overload it with an enclosure.
+template <typename T>
+inline T Pi(const T &) {
+  return static_cast<T>(3.14159265358979323846264338327950288L);
+}
+
+template <typename T, int N = 1>
+class Dual {
+ public:
+  static_assert(N >= 1, "a dual number needs a tangent");
+  static const int TANGENTS = N;
+
+  T value;
+  T tangent[N];
+
+  Dual() : value(), tangent() {}
+
+  // A constant: all derivatives are 0
+  Dual(const T &v) : value(v) {
+    T zero = Constant(v, 0);
+    for (int k = 0; k < N; k++) {
+      tangent[k] = zero;
+    }
+  }
+  template <typename S, typename = typename std::enable_if<
+                            std::is_arithmetic<S>::value>::type>
+  Dual(S c) : Dual(Constant(T(), c)) {}
+
+  // The variable for direction k: its derivative along k is 1
+  static Dual Variable(const T &v, int k) {
+    Dual x(v);
+    x.tangent[k] = Constant(v, 1);
+    return x;
+  }
+
+  Dual &operator+=(const Dual &y) { return *this = *this + y; }
+  Dual &operator-=(const Dual &y) { return *this = *this - y; }
+  Dual &operator*=(const Dual &y) { return *this = *this * y; }
+  Dual &operator/=(const Dual &y) { return *this = *this / y; }
+};
+
+namespace detail {
+
+// f(x) from f(value) and f'(value): the chain rule
+template <typename T, int N>
+inline Dual<T, N> Chain(const Dual<T, N> &x, const T &f, const T &df) {
+  Dual<T, N> r;
+  r.value = f;
+  for (int k = 0; k < N; k++) {
+    r.tangent[k] = df * x.tangent[k];
+  }
+  return r;
+}
+
+template <typename S>
+using IfScalar =
+    typename std::enable_if<std::is_arithmetic<S>::value, int>::type;
+}  // namespace detail
+
+template <typename T, int N>
+inline Dual<T, N> operator+(const Dual<T, N> &x) {
+  return x;
+}
+
+template <typename T, int N>
+inline Dual<T, N> operator-(const Dual<T, N> &x) {
+  Dual<T, N> r;
+  r.value = -x.value;
+  for (int k = 0; k < N; k++) {
+    r.tangent[k] = -x.tangent[k];
+  }
+  return r;
+}
+
+template <typename T, int N>
+inline Dual<T, N> operator+(const Dual<T, N> &x, const Dual<T, N> &y) {
+  Dual<T, N> r;
+  r.value = x.value + y.value;
+  for (int k = 0; k < N; k++) {
+    r.tangent[k] = x.tangent[k] + y.tangent[k];
+  }
+  return r;
+}
+
+template <typename T, int N>
+inline Dual<T, N> operator-(const Dual<T, N> &x, const Dual<T, N> &y) {
+  Dual<T, N> r;
+  r.value = x.value - y.value;
+  for (int k = 0; k < N; k++) {
+    r.tangent[k] = x.tangent[k] - y.tangent[k];
+  }
+  return r;
+}
+
+template <typename T, int N>
+inline Dual<T, N> operator*(const Dual<T, N> &x, const Dual<T, N> &y) {
+  Dual<T, N> r;
+  r.value = x.value * y.value;
+  for (int k = 0; k < N; k++) {
+    r.tangent[k] = x.tangent[k] * y.value + x.value * y.tangent[k];
+  }
+  return r;
+}
+
+template <typename T, int N>
+inline Dual<T, N> operator/(const Dual<T, N> &x, const Dual<T, N> &y) {
+  // (x/y)' = (x' - (x/y) y') / y
+  Dual<T, N> r;
+  r.value = x.value / y.value;
+  for (int k = 0; k < N; k++) {
+    r.tangent[k] = (x.tangent[k] - r.value * y.tangent[k]) / y.value;
+  }
+  return r;
+}
+
+// Constants only touch the value, or scale the tangents
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> operator+(const Dual<T, N> &x, S c) {
+  Dual<T, N> r = x;
+  r.value = x.value + Constant(x.value, c);
+  return r;
+}
+
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> operator+(S c, const Dual<T, N> &x) {
+  return x + c;
+}
+
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> operator-(const Dual<T, N> &x, S c) {
+  Dual<T, N> r = x;
+  r.value = x.value - Constant(x.value, c);
+  return r;
+}
+
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> operator-(S c, const Dual<T, N> &x) {
+  Dual<T, N> r = -x;
+  r.value = Constant(x.value, c) - x.value;
+  return r;
+}
+
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> operator*(const Dual<T, N> &x, S c) {
+  T factor = Constant(x.value, c);
+  Dual<T, N> r;
+  r.value = x.value * factor;
+  for (int k = 0; k < N; k++) {
+    r.tangent[k] = x.tangent[k] * factor;
+  }
+  return r;
+}
+
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> operator*(S c, const Dual<T, N> &x) {
+  return x * c;
+}
+
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> operator/(const Dual<T, N> &x, S c) {
+  T divisor = Constant(x.value, c);
+  Dual<T, N> r;
+  r.value = x.value / divisor;
+  for (int k = 0; k < N; k++) {
+    r.tangent[k] = x.tangent[k] / divisor;
+  }
+  return r;
+}
+
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> operator/(S c, const Dual<T, N> &x) {
+  return Dual<T, N>(Constant(x.value, c)) / x;
+}
+
+// Comparisons look at the values, so that branches in a residual follow
+// the point being evaluated
+template <typename T, int N>
+inline bool operator<(const Dual<T, N> &x, const Dual<T, N> &y) {
+  return x.value < y.value;
+}
+template <typename T, int N>
+inline bool operator>(const Dual<T, N> &x, const Dual<T, N> &y) {
+  return x.value > y.value;
+}
+template <typename T, int N>
+inline bool operator<=(const Dual<T, N> &x, const Dual<T, N> &y) {
+  return x.value <= y.value;
+}
+template <typename T, int N>
+inline bool operator>=(const Dual<T, N> &x, const Dual<T, N> &y) {
+  return x.value >= y.value;
+}
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline bool operator<(const Dual<T, N> &x, S c) {
+  return x.value < Constant(x.value, c);
+}
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline bool operator>(const Dual<T, N> &x, S c) {
+  return x.value > Constant(x.value, c);
+}
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline bool operator<=(const Dual<T, N> &x, S c) {
+  return x.value <= Constant(x.value, c);
+}
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline bool operator>=(const Dual<T, N> &x, S c) {
+  return x.value >= Constant(x.value, c);
+}
+
+// x * x, with the interval overload of sqr for interval values
+template <typename T>
+inline T sqr(const T &x) {
+  return x * x;
+}
+
+template <typename T, int N>
+inline Dual<T, N> sqr(const Dual<T, N> &x) {
+  return detail::Chain(x, sqr(x.value), Constant(x.value, 2) * x.value);
+}
+
+// The functions of the value are found by argument-dependent lookup for
+// class types and in std for the built-in ones
+template <typename T, int N>
+inline Dual<T, N> sin(const Dual<T, N> &x) {
+  using std::cos;
+  using std::sin;
+  return detail::Chain(x, sin(x.value), cos(x.value));
+}
+
+template <typename T, int N>
+inline Dual<T, N> cos(const Dual<T, N> &x) {
+  using std::cos;
+  using std::sin;
+  return detail::Chain(x, cos(x.value), -sin(x.value));
+}
+
+template <typename T, int N>
+inline Dual<T, N> tan(const Dual<T, N> &x) {
+  using std::tan;
+  T t = tan(x.value);
+  return detail::Chain(x, t, Constant(t, 1) + t * t);
+}
+
+template <typename T, int N>
+inline Dual<T, N> asin(const Dual<T, N> &x) {
+  using std::asin;
+  using std::sqrt;
+  T one = Constant(x.value, 1);
+  return detail::Chain(x, asin(x.value), one / sqrt(one - x.value * x.value));
+}
+
+template <typename T, int N>
+inline Dual<T, N> acos(const Dual<T, N> &x) {
+  using std::acos;
+  using std::sqrt;
+  T one = Constant(x.value, 1);
+  return detail::Chain(x, acos(x.value),
+                       -(one / sqrt(one - x.value * x.value)));
+}
+
+template <typename T, int N>
+inline Dual<T, N> atan(const Dual<T, N> &x) {
+  using std::atan;
+  T one = Constant(x.value, 1);
+  return detail::Chain(x, atan(x.value), one / (one + x.value * x.value));
+}
+
+template <typename T, int N>
+inline Dual<T, N> sinh(const Dual<T, N> &x) {
+  using std::cosh;
+  using std::sinh;
+  return detail::Chain(x, sinh(x.value), cosh(x.value));
+}
+
+template <typename T, int N>
+inline Dual<T, N> cosh(const Dual<T, N> &x) {
+  using std::cosh;
+  using std::sinh;
+  return detail::Chain(x, cosh(x.value), sinh(x.value));
+}
+
+template <typename T, int N>
+inline Dual<T, N> tanh(const Dual<T, N> &x) {
+  using std::tanh;
+  T t = tanh(x.value);
+  return detail::Chain(x, t, Constant(t, 1) - t * t);
+}
+
+template <typename T, int N>
+inline Dual<T, N> exp(const Dual<T, N> &x) {
+  using std::exp;
+  T e = exp(x.value);
+  return detail::Chain(x, e, e);
+}
+
+template <typename T, int N>
+inline Dual<T, N> log(const Dual<T, N> &x) {
+  using std::log;
+  return detail::Chain(x, log(x.value), Constant(x.value, 1) / x.value);
+}
+
+template <typename T, int N>
+inline Dual<T, N> sqrt(const Dual<T, N> &x) {
+  using std::sqrt;
+  T s = sqrt(x.value);
+  return detail::Chain(x, s, Constant(s, 1) / (Constant(s, 2) * s));
+}
+
+// -1, 0 or 1; intervals overload it with the signs of their ends
+template <typename T>
+inline T sign(const T &x) {
+  T zero = Constant(x, 0);
+  return Constant(x, (x > zero) - (x < zero));
+}
+
+// The derivative at 0 is taken as 0
+template <typename T, int N>
+inline Dual<T, N> abs(const Dual<T, N> &x) {
+  using std::abs;
+  return detail::Chain(x, abs(x.value), sign(x.value));
+}
+
+template <typename T, int N, typename S, detail::IfScalar<S> = 0>
+inline Dual<T, N> pow(const Dual<T, N> &x, S c) {
+  using std::pow;
+  T exponent = Constant(x.value, c);
+  return detail::Chain(x, pow(x.value, exponent),
+                       exponent * pow(x.value, exponent - Constant(x.value,
+                                                                    1)));
+}
+
+template <typename T, int N>
+inline Dual<T, N> Pi(const Dual<T, N> &x) {
+  return Dual<T, N>(Pi(x.value));
+}
+
+// pi in the arithmetic of T, for templates written once for all of them
+template <typename T>
+inline T Pi() {
+  return Pi(T());
+}
+
+// f(x[1..n]) and its gradient, 1-based like the library interface, in
+// ceil(n / N) forward passes of N directions each
+template <int N, typename T, typename F>
+T Gradient(const F &f, int n, const T *x, T *gradient, Dual<T, N> *point) {
+  T value = T();
+  for (int first = 1; first <= n; first += N) {
+    for (int j = 1; j <= n; j++) {
+      point[j] = j >= first && j < first + N
+                     ? Dual<T, N>::Variable(x[j], j - first)
+                     : Dual<T, N>(x[j]);
+    }
+    Dual<T, N> r = f(static_cast<const Dual<T, N> *>(point));
+    for (int j = first; j <= n && j < first + N; j++) {
+      gradient[j] = r.tangent[j - first];
+    }
+    value = r.value;
+  }
+  return value;
+}
+}  // namespace NAutoDiff
+#endif  // __DUAL_H__
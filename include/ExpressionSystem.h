@@ -0,0 +1,175 @@
+#ifndef __EXPRESSIONSYSTEM_H__
+#define __EXPRESSIONSYSTEM_H__
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "./NewtonSystem.h"
+
+// A system of equations typed as text instead of compiled into a library,
+// one equation per line in the variables x1 ... xn:
+//
+//   # Book example c.
+//   x1^2 + 8*x2 - 16
+//   x1 = exp(x2)
+//
+// "lhs = rhs" stands for lhs - rhs. The operators are + - * / and ^ (or
+// **), the functions sin cos tan asin acos atan sinh cosh tanh exp log sqrt
+// abs, the constants pi and e; # starts a comment.
+//
+// The equations are parsed into one DAG in which equal subexpressions
+// (across all equations) are shared and constants are folded. Every
+// residual is differentiated symbolically in the same DAG, so the Jacobian
+// entries share their intermediate values with each other and with the
+// residuals (sin(x2*x3) is computed once for every entry that uses it), and
+// entries that simplify to 0 give the sparsity pattern. Two register
+// bytecode programs are compiled: one for the residuals alone and a fused
+// one computing the residuals and every structurally non-zero Jacobian
+// entry in a single pass. Registers are reused once their value is dead,
+// so the register file of a typical system fits in a few cache lines. The
+// compiled system is immutable and can be shared by threads, each
+// evaluating through its own Evaluator.
+class ExpressionSystem {
+ public:
+  enum class Op : uint8_t {
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    NEG,
+    POW,
+    POWI,
+    SIN,
+    COS,
+    TAN,
+    ASIN,
+    ACOS,
+    ATAN,
+    SINH,
+    COSH,
+    TANH,
+    EXP,
+    LOG,
+    SQRT,
+    ABS,
+    SIGN
+  };
+
+  // Node of the simplified DAG, created after the nodes it refers to
+  struct Node {
+    int kind;  // CONSTANT, VARIABLE or an Op
+    // operand, variable index, integer exponent or, for a constant, 0 or
+    // the index of its enclosure
+    int a;
+    int b;
+    NStandard::Val value;
+  };
+  static const int CONSTANT = -2;
+  static const int VARIABLE = -1;
+
+  // Interface of the libraries generateLibrary() writes
+  enum class Target { STANDARD, INTERVAL };
+
+  // dst = a op b; POWI raises a to the integer power b
+  struct Instruction {
+    Op op;
+    int32_t dst;
+    int32_t a;
+    int32_t b;
+  };
+
+  // Evaluation state of one thread
+  class Evaluator {
+   public:
+    explicit Evaluator(const ExpressionSystem &system);
+
+    // Residuals f[1..n] at x[1..n], indexed like the library interface
+    void evaluate(const NStandard::Val *x, NStandard::Val *f);
+
+    // Residuals of count points at once: point p is
+    // points[p * n] ... points[p * n + n - 1] and its residuals are stored
+    // the same way. The bytecode is dispatched once per block of points,
+    // which amortises the interpretation overhead.
+    void evaluateBatch(int count, const NStandard::Val *points,
+                       NStandard::Val *residuals);
+
+    // Library interface: rows are served from the last evaluation of the
+    // fused program while x does not change
+    NStandard::Val function(int i, const NStandard::Val *x);
+    void derivatives(int i, const NStandard::Val *x, NStandard::Val *dfatx);
+
+   private:
+    bool update(const NStandard::Val *x);
+
+    const ExpressionSystem &system;
+    std::vector<NStandard::Val> registers;
+    std::vector<NStandard::Val> fusedRegisters;
+    std::vector<NStandard::Val> block;
+    // Last x (0-based), its residuals and Jacobian (row-major)
+    std::vector<NStandard::Val> point;
+    std::vector<NStandard::Val> residuals;
+    std::vector<NStandard::Val> jacobian;
+    bool cached;
+  };
+
+  // Points evaluated together by evaluateBatch
+  static const int BLOCK = 64;
+
+  ExpressionSystem();
+
+  // Parses and compiles source; false with errorString() set
+  bool parse(const std::string &source, const std::string &name = "");
+
+  std::string errorString() const;
+  std::string name() const;
+  int equations() const;
+
+  // Columns j (1-based) of the entries of Jacobian row i that are not
+  // structurally zero, in increasing order
+  std::vector<int> pattern(int i) const;
+  int nonZeros() const;
+
+  // C++ source of a system library with the same equations and exact
+  // derivatives, against LibraryInterface.h or LibraryInterfaceInterval.h.
+  // Every residual and Jacobian row is straight-line code over the DAG. The
+  // interval arithmetic has no tan, asin, acos, atan, hyperbolic, log or
+  // sqrt and no non-integer powers; false with error set if they are used.
+  // Interval libraries fold no constants and enclose every literal, so
+  // their residuals enclose those of the equations as written.
+  bool generateLibrary(Target target, std::string &source,
+                       std::string &error) const;
+
+  // Size of the residual program, and of the fused residual and Jacobian
+  // program
+  int instructionCount() const;
+  int registerCount() const;
+  int fusedInstructionCount() const;
+
+ private:
+  struct Program {
+    // Registers [0, n) hold x, then come the constants, then temporaries
+    int registers;
+    std::vector<NStandard::Val> constants;
+    std::vector<Instruction> code;
+    // Registers holding the results
+    std::vector<int32_t> outputs;
+  };
+
+  std::string systemName;
+  std::string error;
+  std::string text;
+  int n;
+  // The DAG, its residual nodes and the non-zero Jacobian entries by row
+  std::vector<Node> nodes;
+  std::vector<int> residualNodes;
+  std::vector<std::vector<int>> entryNodes;
+  // Residuals only
+  Program residualProgram;
+  // Residuals, then the non-zero Jacobian entries row by row
+  Program fusedProgram;
+  // Non-zero columns (0-based) of each row
+  std::vector<std::vector<int>> columns;
+};
+#endif  // __EXPRESSIONSYSTEM_H__
@@ -0,0 +1,133 @@
+#ifndef __GENERICMATH_H__
+#define __GENERICMATH_H__
+
+#include <limits>
+#include <type_traits>
+
+#include "./Dual.h"
+#include "./Interval.h"
+
+// What intervals need to be used like long double in templates written once
+// for every arithmetic: mixed operators with constants, unary minus and the
+// functions under their usual names. A constant c becomes the point interval
+// [c, c], so a literal such as 0.1 is enclosed only as exactly as the
+// compiler rounded it; write ValInterval bounds where that matters, and
+// Pi<T>() for pi.
+namespace interval_arithmetic {
+
+template <typename T>
+inline Interval<T> Constant(const Interval<T> &, long double c) {
+  return Interval<T>(c, c);
+}
+
+template <typename T>
+inline Interval<T> Pi(const Interval<T> &) {
+  return Interval<T>::IPi();
+}
+
+// -x = [-b, -a]; Opposite() is the Kaucher opposite [-a, -b]
+template <typename T>
+inline Interval<T> operator-(const Interval<T> &x) {
+  return Interval<T>(0, 0) - x;
+}
+
+template <typename T>
+inline Interval<T> operator+(const Interval<T> &x) {
+  return x;
+}
+
+template <typename T, typename S,
+          typename std::enable_if<std::is_arithmetic<S>::value, int>::type = 0>
+inline Interval<T> operator+(const Interval<T> &x, S c) {
+  return x + Interval<T>(c, c);
+}
+
+template <typename T, typename S,
+          typename std::enable_if<std::is_arithmetic<S>::value, int>::type = 0>
+inline Interval<T> operator+(S c, const Interval<T> &x) {
+  return Interval<T>(c, c) + x;
+}
+
+template <typename T, typename S,
+          typename std::enable_if<std::is_arithmetic<S>::value, int>::type = 0>
+inline Interval<T> operator-(const Interval<T> &x, S c) {
+  return x - Interval<T>(c, c);
+}
+
+template <typename T, typename S,
+          typename std::enable_if<std::is_arithmetic<S>::value, int>::type = 0>
+inline Interval<T> operator-(S c, const Interval<T> &x) {
+  return Interval<T>(c, c) - x;
+}
+
+// long double and int factors have their own overloads in Interval.h
+template <typename T, typename S,
+          typename std::enable_if<std::is_arithmetic<S>::value, int>::type = 0>
+inline Interval<T> operator*(const Interval<T> &x, S c) {
+  return x * Interval<T>(c, c);
+}
+
+template <typename T, typename S,
+          typename std::enable_if<std::is_arithmetic<S>::value, int>::type = 0>
+inline Interval<T> operator*(S c, const Interval<T> &x) {
+  return Interval<T>(c, c) * x;
+}
+
+template <typename T, typename S,
+          typename std::enable_if<std::is_arithmetic<S>::value, int>::type = 0>
+inline Interval<T> operator/(const Interval<T> &x, S c) {
+  return x / Interval<T>(c, c);
+}
+
+template <typename T, typename S,
+          typename std::enable_if<std::is_arithmetic<S>::value, int>::type = 0>
+inline Interval<T> operator/(S c, const Interval<T> &x) {
+  return Interval<T>(c, c) / x;
+}
+
+template <typename T>
+inline Interval<T> sin(const Interval<T> &x) {
+  return ISin(x);
+}
+
+template <typename T>
+inline Interval<T> cos(const Interval<T> &x) {
+  return ICos(x);
+}
+
+template <typename T>
+inline Interval<T> exp(const Interval<T> &x) {
+  return IExp(x);
+}
+
+template <typename T>
+inline Interval<T> abs(const Interval<T> &x) {
+  return IAbs(x);
+}
+
+// Tighter than x * x, which treats the factors as independent
+template <typename T>
+inline Interval<T> sqr(const Interval<T> &x) {
+  int st = 0;
+  return ISqr(x, st);
+}
+
+// Restricted to the domain: the negative part of x is ignored, and an x
+// with no point in it gives NaN, like a failed IntRead
+template <typename T>
+inline Interval<T> sqrt(const Interval<T> &x) {
+  if (!(x.b >= 0)) {
+    T nan = std::numeric_limits<T>::quiet_NaN();
+    return Interval<T>(nan, nan);
+  }
+  int st = 0;
+  return ISqrt(Interval<T>(x.a < 0 ? 0 : x.a, x.b), st);
+}
+
+// The signs of the ends, which enclose the sign of every point
+template <typename T>
+inline Interval<T> sign(const Interval<T> &x) {
+  return Interval<T>((x.a > 0) - (x.a < 0), (x.b > 0) - (x.b < 0));
+}
+}  // namespace interval_arithmetic
+#endif  // __GENERICMATH_H__
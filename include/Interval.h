@@ -33,6 +33,10 @@
 #include <string>
 #include <typeinfo>
 #include <utility>
+#include <vector>
+
+#include "DecimalFormat.h"
+#include "DecimalParse.h"
 
 // clang-format on
 
@@ -56,6 +60,15 @@ enum IAOutDigits {
 
 enum IAMode { DINT_MODE, PINT_MODE };
 
+// Arithmetic configuration of one thread. Mode, precision and output digits
+// are kept per thread, so solvers running on different threads can use
+// different settings without racing on shared state.
+struct IAContext {
+  IAMode mode = PINT_MODE;
+  IAPrecision precision = LONGDOUBLE_PREC;
+  IAOutDigits outdigits = LONGDOUBLE_DIGITS;
+};
+
 template <typename T>
 class Interval;
 
@@ -78,6 +91,9 @@ Interval<T> IDiv(const Interval<T> &x, const Interval<T> &y);
 template <typename T>
 Interval<T> IMul(const Interval<T> &x, const Interval<T> &y);
 template <typename T>
+int IDivExtended(const Interval<T> &x, const Interval<T> &y, Interval<T> &r1,
+                 Interval<T> &r2);
+template <typename T>
 Interval<T> ISin(const Interval<T> &x);
 template <typename T>
 Interval<T> ICos(const Interval<T> &x);
@@ -102,6 +118,8 @@ template <typename T>
 Interval<T> Hull(const Interval<T> &x, const Interval<T> &y);
 template <typename T>
 Interval<T> IAbs(const Interval<T> &x);
+template <typename T>
+bool Intersect(const Interval<T> &x, const Interval<T> &y, Interval<T> &r);
 
 template <typename T>
 int SetRounding(int rounding);
@@ -111,11 +129,11 @@ Interval<mpreal> IntRead(const string &sa);
 template <typename T>
 class Interval {
  private:
-  static IAPrecision precision;
-  static IAOutDigits outdigits;
+  static thread_local IAPrecision precision;
+  static thread_local IAOutDigits outdigits;
 
  public:
-  static IAMode mode;
+  static thread_local IAMode mode;
   T a;
   T b;
   Interval();
@@ -146,6 +164,8 @@ class Interval {
   static void SetOutDigits(IAOutDigits o);
   static IAOutDigits GetOutDigits();
   static T GetEpsilon();
+  static IAContext GetContext();
+  static void SetContext(const IAContext &context);
 
   void IEndsToStrings(string &left, string &right);
 
@@ -240,7 +260,7 @@ inline IAPrecision Interval<T>::GetPrecision() {
 
 template <typename T>
 inline void Interval<T>::SetOutDigits(IAOutDigits o) {
-  Interval<T>::outdigits = LONGDOUBLE_DIGITS;
+  Interval<T>::outdigits = o;
 }
 
 template <typename T>
@@ -254,38 +274,56 @@ inline T Interval<T>::GetEpsilon() {
 }
 
 template <typename T>
-inline Interval<T> IntRead(const string &sa) {
-  Interval<T> r;
-  mpfr_t rop;
-  mpfr_init2(rop, Interval<T>::precision);
-  mpfr_set_str(rop, sa.c_str(), 10, MPFR_RNDD);
-  T le = 0.0;
-  if (strcmp(typeid(T).name(), typeid(long double).name()) == 0) {
-    le = mpfr_get_ld(rop, MPFR_RNDD);
-  }
-  if (strcmp(typeid(T).name(), typeid(double).name()) == 0) {
-    le = mpfr_get_d(rop, MPFR_RNDD);
-  }
-  if (strcmp(typeid(T).name(), typeid(float).name()) == 0) {
-    le = mpfr_get_flt(rop, MPFR_RNDD);
-  }
+inline IAContext Interval<T>::GetContext() {
+  IAContext context;
+  context.mode = Interval<T>::mode;
+  context.precision = Interval<T>::precision;
+  context.outdigits = Interval<T>::outdigits;
+  return context;
+}
 
-  mpfr_set_str(rop, sa.c_str(), 10, MPFR_RNDU);
-  T re = 0.0;
-  if (strcmp(typeid(T).name(), typeid(long double).name()) == 0) {
-    re = mpfr_get_ld(rop, MPFR_RNDU);
-  }
-  if (strcmp(typeid(T).name(), typeid(double).name()) == 0) {
-    re = mpfr_get_d(rop, MPFR_RNDU);
+template <typename T>
+inline void Interval<T>::SetContext(const IAContext &context) {
+  Interval<T>::mode = context.mode;
+  Interval<T>::SetPrecision(context.precision);
+  Interval<T>::outdigits = context.outdigits;
+}
+
+// Installs a context on the calling thread for the lifetime of the guard and
+// restores the previous context, the mpreal default precision and the FPU
+// rounding mode when it goes out of scope, also when an exception escapes.
+template <typename T>
+class IAContextGuard {
+ public:
+  explicit IAContextGuard(const IAContext &context)
+      : saved(Interval<T>::GetContext()),
+        savedPrecision(mpreal::get_default_prec()),
+        savedRounding(fegetround()) {
+    Interval<T>::SetContext(context);
+    SetRounding<T>(FE_TONEAREST);
   }
-  if (strcmp(typeid(T).name(), typeid(float).name()) == 0) {
-    re = mpfr_get_flt(rop, MPFR_RNDU);
+
+  ~IAContextGuard() {
+    Interval<T>::SetContext(saved);
+    mpreal::set_default_prec(savedPrecision);
+    SetRounding<T>(savedRounding);
   }
 
-  SetRounding<T>(FE_TONEAREST);
+  IAContextGuard(const IAContextGuard &) = delete;
+  IAContextGuard &operator=(const IAContextGuard &) = delete;
+
+ private:
+  IAContext saved;
+  mpfr_prec_t savedPrecision;
+  int savedRounding;
+};
 
-  r.a = le;
-  r.b = re;
+template <typename T>
+inline Interval<T> IntRead(const string &sa) {
+  Interval<T> r;
+  if (!ParseDecimal(sa, r.a, r.b)) {
+    r.a = r.b = std::numeric_limits<T>::quiet_NaN();
+  }
   return r;
 }
 
@@ -294,49 +332,73 @@ inline Interval<mpreal> IntRead(const string &sa) {
   Interval<mpreal> r;
   mpfr_t rop;
   mpfr_init2(rop, Interval<mpreal>::precision);
-  mpfr_set_str(rop, sa.c_str(), 10, MPFR_RNDD);
-  mpreal le = rop;
-
-  mpfr_set_str(rop, sa.c_str(), 10, MPFR_RNDU);
-  mpreal re = rop;
-
-  r.a = le;
-  r.b = re;
+  int ternary = mpfr_strtofr(rop, sa.c_str(), nullptr, 10, MPFR_RNDD);
+  r.a = mpreal(rop);
+  // At a fixed precision the upward rounding of an inexact value is the
+  // successor of the downward one
+  if (ternary != 0) {
+    mpfr_nextabove(rop);
+  }
+  r.b = mpreal(rop);
+  mpfr_clear(rop);
   return r;
 }
 
+// Reads a whole column of numbers separated by whitespace, commas or
+// semicolons into tight enclosures. Returns false on a malformed token.
 template <typename T>
-inline void Interval<T>::IEndsToStrings(string &left, string &right) {
-  mpfr_t rop;
-  mpfr_exp_t exponent;
-  mpfr_init2(rop, precision);
-  char *str = NULL;
-  char *buffer = new char(precision + 3);
-  mpfr_set_ld(rop, this->a, MPFR_RNDD);
-
-  mpfr_get_str(buffer, &exponent, 10, outdigits, rop, MPFR_RNDD);
-  str = buffer;
-
-  stringstream ss;
-  int prec = std::numeric_limits<T>::digits10;
-  ss.setf(std::ios_base::scientific);
-  bool minus = (str[0] == '-');
-  int splitpoint = minus ? 1 : 0;
-  string sign = minus ? "-" : "";
+inline bool IntReadColumn(const string &text, std::vector<Interval<T>> &column) {
+  std::vector<T> lo, hi;
+  bool valid = ParseDecimalColumn(text.data(), text.data() + text.size(), lo,
+                                  hi);
+  column.reserve(column.size() + lo.size());
+  for (size_t k = 0; k < lo.size(); k++) {
+    column.push_back(Interval<T>(lo[k], hi[k]));
+  }
+  return valid;
+}
 
-  ss << std::setprecision(prec) << sign << str[splitpoint] << "."
-     << &str[splitpoint + 1] << "E" << exponent - 1;
-  left = ss.str();
-  ss.str(std::string());
+// Reads a number rounded to nearest (for non-interval inputs)
+template <typename T>
+inline T NearestRead(const string &sa) {
+  T value;
+  if (!ParseDecimal(sa, value)) {
+    value = std::numeric_limits<T>::quiet_NaN();
+  }
+  return value;
+}
 
-  mpfr_set_ld(rop, this->b, MPFR_RNDU);
-  mpfr_get_str(buffer, &exponent, 10, outdigits, rop, MPFR_RNDU);
-  str = buffer;
-  splitpoint = (str[0] == '-') ? 1 : 0;
-  ss << std::setprecision(prec) << sign << str[splitpoint] << "."
-     << &str[splitpoint + 1] << "E" << exponent - 1;
-  right = ss.str();
-  ss.clear();
+template <typename T>
+inline void Interval<T>::IEndsToStrings(string &left, string &right) {
+  char buffer[FORMAT_BUFFER_SIZE];
+  size_t length =
+      FormatDecimal(this->a, outdigits, MPFR_RNDD, buffer, sizeof(buffer));
+  left.assign(buffer, length);
+  length =
+      FormatDecimal(this->b, outdigits, MPFR_RNDU, buffer, sizeof(buffer));
+  right.assign(buffer, length);
+}
+
+// Writes [lo;hi] with the lower end rounded down and the upper end rounded
+// up; digits == 0 selects the shortest such representation. buffer must
+// hold at least 2 * FORMAT_BUFFER_SIZE characters. Returns the length, or 0
+// if the buffer is too small.
+template <typename T>
+inline size_t FormatInterval(const Interval<T> &x, int digits, char *buffer,
+                             size_t size) {
+  if (size < 2 * FORMAT_BUFFER_SIZE) {
+    return 0;
+  }
+  char *p = buffer;
+  *p++ = '[';
+  p += digits > 0 ? FormatDecimal(x.a, digits, MPFR_RNDD, p, FORMAT_BUFFER_SIZE)
+                  : FormatShortest(x.a, MPFR_RNDD, p, FORMAT_BUFFER_SIZE);
+  *p++ = ';';
+  p += digits > 0 ? FormatDecimal(x.b, digits, MPFR_RNDU, p, FORMAT_BUFFER_SIZE)
+                  : FormatShortest(x.b, MPFR_RNDU, p, FORMAT_BUFFER_SIZE);
+  *p++ = ']';
+  *p = '\0';
+  return static_cast<size_t>(p - buffer);
 }
 
 template <typename T>
@@ -666,7 +728,12 @@ Interval<T> IExp(const Interval<T> &x) {
   Interval<T> tmp = x;
   T eps = 1E-18;  // 2*Interval<T>::GetEpsilon();
   T diff = std::numeric_limits<T>::max();
-  if ((x.a < 0) && (x.b > 0)) return {1, 1};
+  if ((x.a < 0) && (x.b > 0)) {
+    // exp is increasing, so enclose each end separately
+    Interval<T> lo = IExp(Interval<T>(x.a, x.a));
+    Interval<T> hi = IExp(Interval<T>(x.b, x.b));
+    return {lo.a, hi.b};
+  }
   if (x.a > x.b)
     st = 1;
   else {
@@ -698,10 +765,10 @@ Interval<T> IExp(const Interval<T> &x) {
           T wdth = w.GetWidth();
 
           tmp.IEndsToStrings(left, right);
-          cout << "x=[" << left << "," << right << "]" << endl;
+          cerr << "x=[" << left << "," << right << "]" << endl;
           w.IEndsToStrings(left, right);
-          cout << "[" << left << "," << right << "]" << endl;
-          cout << "      width =  " << std::setprecision(17) << wdth << endl
+          cerr << "[" << left << "," << right << "]" << endl;
+          cerr << "      width =  " << std::setprecision(17) << wdth << endl
                << " diff = " << diff << endl
                << " tmpDiff = " << tmpDiff << endl
                << "eps = " << eps << endl;
@@ -818,7 +885,7 @@ Interval<T> IMul(const Interval<T> &x, const Interval<T> &y) {
 template <typename T>
 Interval<T> IDiv(const Interval<T> &x, const Interval<T> &y) {
   Interval<T> r;
-  T x1y1, x1y2, x2y1, t;
+  T x1y1, x1y2, x2y1;
 
   if ((y.a <= 0) && (y.b >= 0)) {
     throw runtime_error("Division by an interval containing 0.");
@@ -828,10 +895,9 @@ Interval<T> IDiv(const Interval<T> &x, const Interval<T> &y) {
     x1y2 = x.a / y.b;
     x2y1 = x.b / y.a;
     r.a = x.b / y.b;
-    t = r.a;
-    if (x2y1 < t) r.a = x2y1;
-    if (x1y2 < t) r.a = x1y2;
-    if (x1y1 < t) r.a = x1y1;
+    if (x2y1 < r.a) r.a = x2y1;
+    if (x1y2 < r.a) r.a = x1y2;
+    if (x1y1 < r.a) r.a = x1y1;
 
     SetRounding<T>(FE_UPWARD);
     x1y1 = x.a / y.a;
@@ -839,15 +905,71 @@ Interval<T> IDiv(const Interval<T> &x, const Interval<T> &y) {
     x2y1 = x.b / y.a;
 
     r.b = x.b / y.b;
-    t = r.b;
-    if (x2y1 > t) r.b = x2y1;
-    if (x1y2 > t) r.b = x1y2;
-    if (x1y1 > t) r.b = x1y1;
+    if (x2y1 > r.b) r.b = x2y1;
+    if (x1y2 > r.b) r.b = x1y2;
+    if (x1y1 > r.b) r.b = x1y1;
   }
   SetRounding<T>(FE_TONEAREST);
   return r;
 }
 
+// Kahan's extended division: encloses {u / v : u in x, v in y, v != 0}
+// in up to two (possibly half-infinite) intervals r1 < r2 and returns how
+// many of them are used. 0 means the quotient set is empty, which happens
+// only for y = [0, 0] and 0 not in x.
+template <typename T>
+int IDivExtended(const Interval<T> &x, const Interval<T> &y, Interval<T> &r1,
+                 Interval<T> &r2) {
+  const T inf = std::numeric_limits<T>::infinity();
+  if ((y.a > 0) || (y.b < 0)) {
+    r1 = IDiv(x, y);
+    return 1;
+  }
+  if ((x.a <= 0) && (x.b >= 0)) {
+    r1 = Interval<T>(-inf, inf);
+    return 1;
+  }
+  if ((y.a == 0) && (y.b == 0)) {
+    return 0;
+  }
+
+  int count = 0;
+  // The quotient has the sign of x on [0, y.b] and the opposite sign on
+  // [y.a, 0], so x / y.b and x / y.a bound the two branches.
+  T u = (x.b < 0) ? x.b : x.a;
+  if (y.a < 0) {
+    if (x.b < 0) {
+      SetRounding<T>(FE_DOWNWARD);
+      r1 = Interval<T>(u / y.a, inf);
+    } else {
+      SetRounding<T>(FE_UPWARD);
+      r1 = Interval<T>(-inf, u / y.a);
+    }
+    count++;
+  }
+  if (y.b > 0) {
+    Interval<T> r;
+    if (x.b < 0) {
+      SetRounding<T>(FE_UPWARD);
+      r = Interval<T>(-inf, u / y.b);
+    } else {
+      SetRounding<T>(FE_DOWNWARD);
+      r = Interval<T>(u / y.b, inf);
+    }
+    if (count == 0) {
+      r1 = r;
+    } else if (r.a < r1.a) {
+      r2 = r1;
+      r1 = r;
+    } else {
+      r2 = r;
+    }
+    count++;
+  }
+  SetRounding<T>(FE_TONEAREST);
+  return count;
+}
+
 template <typename T>
 Interval<T> DIAdd(const Interval<T> &x, const Interval<T> &y) {
   Interval<T> z1, z2;
@@ -888,234 +1010,119 @@ Interval<T> DISub(const Interval<T> &x, const Interval<T> &y) {
   }
 }
 
+// Sign classes of a generalised (Kaucher) interval used to index the DIMul
+// and DIDiv endpoint tables:
+//   0 - both ends strictly positive,
+//   1 - both ends strictly negative,
+//   2 - proper interval containing zero,
+//   3 - improper interval containing zero (dual of class 2).
 template <typename T>
-Interval<T> DIMul(const Interval<T> &x, const Interval<T> &y) {
-  Interval<T> z1, z2, r;
-  T z;
-  bool xn, xp, yn, yp, zero;
+inline int DISignClass(const Interval<T> &x) {
+  int pos = (x.a > 0) & (x.b > 0);
+  int neg = (x.a < 0) & (x.b < 0);
+  int imp = x.a > x.b;
+  return (1 - pos) * (neg + (1 - neg) * (2 + imp));
+}
 
-  if ((x.a <= x.b) && (y.a <= y.b))
-    r = IMul(x, y);
-  else {
-    xn = (x.a < 0) and (x.b < 0);
-    xp = (x.a > 0) and (x.b > 0);
-    yn = (y.a < 0) and (y.b < 0);
-    yp = (y.a > 0) and (y.b > 0);
-    zero = false;
-    // A, B in H-T
-    if ((xn || xp) && (yn || yp))
-      if (xp && yp) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a * y.a;
-        z2.b = x.b * y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b * y.b;
-        z2.a = x.a * y.a;
-      } else if (xp && yn) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b * y.a;
-        z2.b = x.a * y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a * y.b;
-        z2.a = x.b * y.a;
-      } else if (xn && yp) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a * y.b;
-        z2.b = x.b * y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b * y.a;
-        z2.a = x.a * y.b;
-      } else {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b * y.b;
-        z2.b = x.a * y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a * y.a;
-        z2.a = x.b * y.b;
-      }
-    // A in H-T, B in T
-    else if ((xn || xp) &&
-             (((y.a <= 0) && (y.b >= 0)) || ((y.a >= 0) && (y.b <= 0))))
-      if (xp && (y.a <= y.b)) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b * y.a;
-        z2.b = x.b * y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b * y.b;
-        z2.a = x.b * y.a;
-      } else if (xp && (y.a > y.b)) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a * y.a;
-        z2.b = x.a * y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a * y.b;
-        z2.a = x.a * y.a;
-      } else if (xn && (y.a <= y.b)) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a * y.b;
-        z2.b = x.a * y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a * y.a;
-        z2.a = x.a * y.b;
-      } else {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b * y.b;
-        z2.b = x.b * y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b * y.a;
-        z2.a = x.b * y.b;
-      }
-    // A in T, B in H-T
-    else if ((((x.a <= 0) && (x.b >= 0)) || ((x.a >= 0) && (x.b <= 0))) &&
-             (yn || yp))
-      if ((x.a <= x.b) && yp) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a * y.b;
-        z2.b = x.b * y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b * y.b;
-        z2.a = x.a * y.b;
-      } else if ((x.a <= 0) && yn) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b * y.a;
-        z2.b = x.a * y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a * y.a;
-        z2.a = x.b * y.a;
-      } else if ((x.a > x.b) && yp) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a * y.a;
-        z2.b = x.b * y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b * y.a;
-        z2.a = x.a * y.a;
-      } else {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b * y.b;
-        z2.b = x.a * y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a * y.b;
-        z2.a = x.b * y.b;
-      }
-    // A, B in Z-
-    else if ((x.a >= 0) && (x.b <= 0) && (y.a >= 0) && (y.b <= 0)) {
-      SetRounding<T>(FE_DOWNWARD);
-      z1.a = x.a * y.a;
-      z = x.b * y.b;
-      if (z1.a < z) z1.a = z;
-      z2.b = x.a * y.b;
-      z = x.b * y.a;
-      if (z < z2.b) z2.b = z;
-      SetRounding<T>(FE_UPWARD);
-      z1.b = x.a * y.b;
-      z = x.b * y.a;
-      if (z < z1.b) z1.b = z;
-      z2.a = x.a * y.a;
-      z = x.b * y.b;
-      if (z2.a < z) z2.a = z;
-    }
-    // A in Z and B in Z- or A in Z- and B in Z
-    else
-      zero = true;
-    if (zero) {
-      r.a = 0;
-      r.b = 0;
-    } else if (z1.GetWidth() >= z2.GetWidth())
-      r = z1;
-    else
-      r = z2;
-  }
+// Picks the wider of the two directed-rounding candidates
+// z1 = [p_down, q_up] and z2 = [p_up, q_down], measuring widths like
+// DIntWidth. Expects the FPU to be rounding upward.
+template <typename T>
+inline Interval<T> DISelectWider(T pd, T pu, T qd, T qu) {
+  T w1 = (qu >= pd) ? qu - pd : pd - qu;
+  T w2 = (qd >= pu) ? qd - pu : pu - qd;
+  bool first = w1 >= w2;
+  return Interval<T>(first ? pd : pu, first ? qu : qd);
+}
+
+template <typename T>
+Interval<T> DIMul(const Interval<T> &x, const Interval<T> &y) {
+  // Endpoint selectors per (class(x), class(y)); 0 = a, 1 = b, 2 = zero.
+  // The result is [max(x[p0]*y[p1], x[p2]*y[p3]),
+  //                min(x[q0]*y[q1], x[q2]*y[q3])], rounded both ways.
+  static const unsigned char sel[16][8] = {
+      // x strictly positive
+      {0, 0, 0, 0, 1, 1, 1, 1},
+      {1, 0, 1, 0, 0, 1, 0, 1},
+      {1, 0, 1, 0, 1, 1, 1, 1},
+      {0, 0, 0, 0, 0, 1, 0, 1},
+      // x strictly negative
+      {0, 1, 0, 1, 1, 0, 1, 0},
+      {1, 1, 1, 1, 0, 0, 0, 0},
+      {0, 1, 0, 1, 0, 0, 0, 0},
+      {1, 1, 1, 1, 1, 0, 1, 0},
+      // x proper, containing zero
+      {0, 1, 0, 1, 1, 1, 1, 1},
+      {1, 0, 1, 0, 0, 0, 0, 0},
+      {0, 0, 0, 0, 1, 1, 1, 1},  // proper * proper, handled by IMul
+      {2, 2, 2, 2, 2, 2, 2, 2},
+      // x improper, containing zero
+      {0, 0, 0, 0, 1, 0, 1, 0},
+      {1, 1, 1, 1, 0, 1, 0, 1},
+      {2, 2, 2, 2, 2, 2, 2, 2},
+      {0, 0, 1, 1, 0, 1, 1, 0},
+  };
+
+  if ((x.a <= x.b) && (y.a <= y.b)) return IMul(x, y);
+
+  const T xs[3] = {x.a, x.b, T(0)};
+  const T ys[3] = {y.a, y.b, T(0)};
+  const unsigned char *s = sel[4 * DISignClass(x) + DISignClass(y)];
 
+  SetRounding<T>(FE_DOWNWARD);
+  T pd = max(xs[s[0]] * ys[s[1]], xs[s[2]] * ys[s[3]]);
+  T qd = min(xs[s[4]] * ys[s[5]], xs[s[6]] * ys[s[7]]);
+  SetRounding<T>(FE_UPWARD);
+  T pu = max(xs[s[0]] * ys[s[1]], xs[s[2]] * ys[s[3]]);
+  T qu = min(xs[s[4]] * ys[s[5]], xs[s[6]] * ys[s[7]]);
+  Interval<T> r = DISelectWider(pd, pu, qd, qu);
   SetRounding<T>(FE_TONEAREST);
   return r;
 }
 
 template <typename T>
 Interval<T> DIDiv(const Interval<T> &x, const Interval<T> &y) {
-  Interval<T> z1, z2, r;
-  bool xn, xp, yn, yp, zero;
+  // Endpoint selectors per (class(x), class(y)) for [x[p0]/y[p1],
+  // x[q0]/y[q1]]; a leading 2 marks a divisor containing zero.
+  static const unsigned char sel[16][4] = {
+      // x strictly positive
+      {0, 1, 1, 0},
+      {1, 1, 0, 0},
+      {2, 2, 2, 2},
+      {2, 2, 2, 2},
+      // x strictly negative
+      {0, 0, 1, 1},
+      {1, 0, 0, 1},
+      {2, 2, 2, 2},
+      {2, 2, 2, 2},
+      // x proper, containing zero
+      {0, 0, 1, 0},
+      {1, 1, 0, 1},
+      {2, 2, 2, 2},
+      {2, 2, 2, 2},
+      // x improper, containing zero
+      {0, 1, 1, 1},
+      {1, 0, 0, 0},
+      {2, 2, 2, 2},
+      {2, 2, 2, 2},
+  };
+
+  if ((x.a <= x.b) && (y.a <= y.b)) return IDiv(x, y);
+
+  const unsigned char *s = sel[4 * DISignClass(x) + DISignClass(y)];
+  if (s[0] == 2) throw runtime_error("Division by an interval containing 0.");
+
+  const T xs[2] = {x.a, x.b};
+  const T ys[2] = {y.a, y.b};
 
-  if ((x.a <= x.b) && (y.a <= y.b))
-    r = IDiv(x, y);
-  else {
-    xn = (x.a < 0) && (x.b < 0);
-    xp = (x.a > 0) && (x.b > 0);
-    yn = (y.a < 0) && (y.b < 0);
-    yp = (y.a > 0) && (y.b > 0);
-    zero = false;
-    // A, B in H-T
-    if ((xn || xp) && (yn || yp))
-      if (xp && yp) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a / y.b;
-        z2.b = x.b / y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b / y.a;
-        z2.a = x.a / y.b;
-      } else if (xp && yn) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b / y.b;
-        z2.b = x.a / y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a / y.a;
-        z2.a = x.b / y.b;
-      } else if (xn && yp) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a / y.a;
-        z2.b = x.b / y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b / y.b;
-        z2.a = x.a / y.a;
-      } else {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b / y.a;
-        z2.b = x.a / y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a / y.b;
-        z2.a = x.b / y.a;
-      }
-    // A in T, B in H-T
-    else if (((x.a <= 0) && (x.b >= 0)) ||
-             (((x.a >= 0) && (x.b <= 0)) && (yn || yp)))
-      if ((x.a <= x.b) && yp) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a / y.a;
-        z2.b = x.b / y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b / y.a;
-        z2.a = x.a / y.a;
-      } else if ((x.a <= x.b) && yn) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b / y.b;
-        z2.b = x.a / y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a / y.b;
-        z2.a = x.b / y.b;
-      } else if ((x.a > x.b) && yp) {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.a / y.b;
-        z2.b = x.b / y.b;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.b / y.b;
-        z2.a = x.a / y.b;
-      } else {
-        SetRounding<T>(FE_DOWNWARD);
-        z1.a = x.b / y.a;
-        z2.b = x.a / y.a;
-        SetRounding<T>(FE_UPWARD);
-        z1.b = x.a / y.a;
-        z2.a = x.b / y.a;
-      }
-    else
-      zero = true;
-    if (zero)
-      throw runtime_error("Division by an interval containing 0.");
-    else if (z1.GetWidth() >= z2.GetWidth())
-      r = z1;
-    else
-      r = z2;
-    SetRounding<T>(FE_TONEAREST);
-  }
+  SetRounding<T>(FE_DOWNWARD);
+  T pd = xs[s[0]] / ys[s[1]];
+  T qd = xs[s[2]] / ys[s[3]];
+  SetRounding<T>(FE_UPWARD);
+  T pu = xs[s[0]] / ys[s[1]];
+  T qu = xs[s[2]] / ys[s[3]];
+  Interval<T> r = DISelectWider(pd, pu, qd, qu);
+  SetRounding<T>(FE_TONEAREST);
   return r;
 }
 
@@ -1572,37 +1579,34 @@ Interval<T> Hull(const Interval<T> &x, const Interval<T> &y) {
   return r;
 }
 
+// Stores x meet y in r; returns false if the intersection is empty.
+template <typename T>
+bool Intersect(const Interval<T> &x, const Interval<T> &y, Interval<T> &r) {
+  r.a = max(x.a, y.a);
+  r.b = min(x.b, y.b);
+  return r.a <= r.b;
+}
+
 template <>
 inline void Interval<mpreal>::IEndsToStrings(string &left, string &right) {
-  mpfr_t rop;
+  char buffer[FORMAT_BUFFER_SIZE];
   mpfr_exp_t exponent;
-  mpfr_init2(rop, precision);
-  char *str = NULL;
-  char *buffer = new char(precision + 3);
-  mpfr_set(rop, this->a.mpfr_ptr(), MPFR_RNDD);
-  mpfr_get_str(buffer, &exponent, 10, outdigits, rop, MPFR_RNDD);
-  str = buffer;
-
-  stringstream ss;
-  int prec = std::numeric_limits<mpreal>::digits10();
-  ss.setf(std::ios_base::scientific);
-  bool minus = (str[0] == '-');
-  int splitpoint = minus ? 1 : 0;
-  string sign = minus ? "-" : "";
-
-  ss << std::setprecision(prec) << sign << str[splitpoint] << "."
-     << &str[splitpoint + 1] << "E" << exponent - 1;
-  left = ss.str();
-  ss.str(std::string());
-
-  mpfr_set(rop, this->b.mpfr_ptr(), MPFR_RNDU);
-  mpfr_get_str(buffer, &exponent, 10, outdigits, rop, MPFR_RNDU);
-  str = buffer;
-  splitpoint = (str[0] == '-') ? 1 : 0;
-  ss << std::setprecision(prec) << sign << str[splitpoint] << "."
-     << &str[splitpoint + 1] << "E" << exponent - 1;
-  right = ss.str();
-  ss.clear();
+  char *digits =
+      mpfr_get_str(nullptr, &exponent, 10, outdigits, this->a.mpfr_srcptr(),
+                   MPFR_RNDD);
+  bool minus = digits[0] == '-';
+  char *end = decimal::Assemble(minus, digits + (minus ? 1 : 0), outdigits,
+                                static_cast<int>(exponent - 1), buffer);
+  left.assign(buffer, end);
+  mpfr_free_str(digits);
+
+  digits = mpfr_get_str(nullptr, &exponent, 10, outdigits,
+                        this->b.mpfr_srcptr(), MPFR_RNDU);
+  minus = digits[0] == '-';
+  end = decimal::Assemble(minus, digits + (minus ? 1 : 0), outdigits,
+                          static_cast<int>(exponent - 1), buffer);
+  right.assign(buffer, end);
+  mpfr_free_str(digits);
 }
 
 template <>
@@ -1633,6 +1637,9 @@ Interval<T> IAbs(const Interval<T> &x) {
     r.a = r.b;
     r.b = tmp;
   }
+  if (x.a < 0 && x.b > 0) {
+    r.a = 0;
+  }
 
   return r;
 }
@@ -1662,18 +1669,18 @@ template class Interval<float>;
 template class Interval<mpreal>;
 
 template <typename T>
-IAMode Interval<T>::mode = PINT_MODE;
+thread_local IAMode Interval<T>::mode = PINT_MODE;
 template <typename T>
-IAOutDigits Interval<T>::outdigits = LONGDOUBLE_DIGITS;
+thread_local IAOutDigits Interval<T>::outdigits = LONGDOUBLE_DIGITS;
 
 // template<> IAPrecision Interval<long double>::precision = LONGDOUBLE_PREC;
 // template<> IAPrecision Interval<double>::precision = DOUBLE_PREC;
 // template<> IAPrecision Interval<float>::precision = FLOAT_PREC;
 
 template <>
-IAPrecision Interval<mpreal>::precision = MPREAL_PREC;
+thread_local IAPrecision Interval<mpreal>::precision = MPREAL_PREC;
 template <typename T>
-IAPrecision Interval<T>::precision = LONGDOUBLE_PREC;
+thread_local IAPrecision Interval<T>::precision = LONGDOUBLE_PREC;
 // template IAOutDigits Interval<mpreal>::outdigits = LONGDOUBLE_DIGITS;
 
 //-------------------------------------------------------------------------------------
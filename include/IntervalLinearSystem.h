@@ -0,0 +1,22 @@
+#ifndef __INTERVALLINEARSYSTEM_H__
+#define __INTERVALLINEARSYSTEM_H__
+
+#include <vector>
+
+#include "./NewtonSystemInterval.h"
+
+namespace NInterval {
+
+// Interval matrix, 1-based and row-major with stride n + 1
+using Matrix = std::vector<ValInterval>;
+
+bool MidpointInverse(int n, const Matrix &a, std::vector<long double> &y);
+
+void Precondition(int n, const std::vector<long double> &y, const Matrix &a,
+                  const Vector &b, Matrix &c, Vector &r);
+
+void IntervalLinearSystem(int n, const Matrix &a, const Vector &b, Vector &x,
+                          LinearSolver method, int &st);
+
+}  // namespace NInterval
+#endif  // __INTERVALLINEARSYSTEM_H__
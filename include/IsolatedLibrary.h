@@ -0,0 +1,84 @@
+#ifndef __ISOLATEDLIBRARY_H__
+#define __ISOLATEDLIBRARY_H__
+
+#include <sys/types.h>
+
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "./NewtonSystem.h"
+
+// Runs a standard arithmetic system library in helper processes
+// (ean-worker) instead of loading it into this one, so that a library that
+// crashes only takes its worker down. Each worker shares a memory region
+// with us holding x, the residuals and the Jacobian; a request evaluates
+// the whole system and is handed over with a futex, spinning first so that
+// back-to-back evaluations need no system call. A crashed worker is
+// replaced by a fresh one on the next request.
+class IsolatedLibrary {
+ public:
+  // Thrown by Session when the worker died or cannot be started
+  class Error : public std::runtime_error {
+   public:
+    using std::runtime_error::runtime_error;
+  };
+
+  struct Worker;
+
+  // Reserves one worker for the calling thread. Rows are served from the
+  // last evaluation while x does not change, so a Newton step costs one
+  // round trip.
+  class Session {
+   public:
+    explicit Session(IsolatedLibrary &library);
+    ~Session();
+    Session(const Session &) = delete;
+    Session &operator=(const Session &) = delete;
+
+    // Evaluates every residual and Jacobian row at x[1..n]
+    void evaluate(const NStandard::Val *x);
+
+    NStandard::Val function(int i, const NStandard::Val *x);
+    void derivatives(int i, const NStandard::Val *x, NStandard::Val *dfatx);
+
+   private:
+    IsolatedLibrary &library;
+    std::unique_ptr<Worker> worker;
+    bool cached;
+  };
+
+  IsolatedLibrary();
+  ~IsolatedLibrary();
+  IsolatedLibrary(const IsolatedLibrary &) = delete;
+  IsolatedLibrary &operator=(const IsolatedLibrary &) = delete;
+
+  // Starts a worker for the library at path and reads its name and size
+  bool load(const std::string &path);
+
+  std::string errorString() const;
+  std::string name() const;
+  int equations() const;
+
+  // Number of workers that died and were replaced
+  int restarts() const;
+
+ private:
+  std::unique_ptr<Worker> acquire();
+  void release(std::unique_ptr<Worker> worker);
+  std::unique_ptr<Worker> start(std::string &message) const;
+
+  std::string path;
+  std::string libraryName;
+  int n;
+  std::string error;
+  mutable std::mutex lock;
+  std::vector<std::unique_ptr<Worker>> idle;
+  int crashes;
+};
+
+// Entry point of ean-worker
+int RunIsolatedWorker(int argc, char *argv[]);
+#endif  // __ISOLATEDLIBRARY_H__
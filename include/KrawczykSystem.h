@@ -0,0 +1,19 @@
+#ifndef __KRAWCZYKSYSTEM_H__
+#define __KRAWCZYKSYSTEM_H__
+
+#include "./NewtonSystemInterval.h"
+
+namespace NInterval {
+
+// Interval Newton operator used to contract the box
+enum class Contractor {
+  KRAWCZYK = 0,
+  HANSEN_SENGUPTA = 1,
+};
+
+void KrawczykSystem(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                    Contractor method, int mit, ValInterval eps, int &it,
+                    int &st, bool &unique, Vector *split = nullptr);
+
+}  // namespace NInterval
+#endif  // __KRAWCZYKSYSTEM_H__
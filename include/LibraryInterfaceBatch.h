@@ -0,0 +1,23 @@
+#ifndef __LIBRARYINTERFACE_BATCH_H__
+#define __LIBRARYINTERFACE_BATCH_H__
+
+#include "./LibraryInterface.h"
+
+// Optional batched evaluation in double. A library that exports these next
+// to the functions from LibraryInterface.h evaluates the whole system at m
+// points per call, which lets it use SIMD across the points; the batch
+// solver (NewtonSystemBatch.h) uses them. LibraryTemplate.h provides them
+// on top of VectorMath.h.
+//
+// The points are stored as structure of arrays and, unlike the rest of the
+// library interface, all indices are 0-based: X[j * m + k] is x[j + 1] of
+// point k, F[i * m + k] is f[i + 1] there and J[(i * n + j) * m + k] is
+// df[i + 1]/dx[j + 1].
+extern "C" {
+FUNCTION_EXPORT void evaluateSystemBatch(int n, int m, const double *X,
+                                         double *F);
+
+FUNCTION_EXPORT void evaluateJacobianBatch(int n, int m, const double *X,
+                                           double *J);
+}
+#endif  // __LIBRARYINTERFACE_BATCH_H__
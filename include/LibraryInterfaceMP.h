@@ -0,0 +1,23 @@
+#ifndef __LIBRARYINTERFACE_MP_H__
+#define __LIBRARYINTERFACE_MP_H__
+
+#include "./LibraryInterface.h"
+#include "./NewtonSystemMP.h"
+
+using mpfr::mpreal;
+
+// Optional multiprecision entry points. A library that exports them next to
+// the functions from LibraryInterface.h can be solved beyond long double
+// precision. Results are assigned to caller-owned objects; the default
+// mpreal precision is set to the working precision during the calls, so
+// constants should be built as mpreal rather than from double literals.
+extern "C" {
+// Function to evaluate the i-th equation of the system
+FUNCTION_EXPORT void evaluateFunctionMP(int i, int n, const mpreal *x,
+                                        mpreal &fx);
+
+// Function to evaluate the derivatives of the i-th equation
+FUNCTION_EXPORT void evaluateDerivativesMP(int i, int n, const mpreal *x,
+                                           mpreal *dfatx);
+}
+#endif  // __LIBRARYINTERFACE_MP_H__
@@ -0,0 +1,20 @@
+#ifndef __LIBRARYINTERFACE_PRODUCTS_H__
+#define __LIBRARYINTERFACE_PRODUCTS_H__
+
+#include "./LibraryInterface.h"
+
+// Optional Jacobian products. A library that exports them next to the
+// functions from LibraryInterface.h lets Krylov and Gauss-Newton methods
+// work with products instead of assembling the Jacobian; LibraryTemplate.h
+// provides them through reverse mode automatic differentiation. All
+// vectors are 1-based.
+extern "C" {
+// jv = J(x) v
+FUNCTION_EXPORT void evaluateJacobianVector(int n, const Val *x, const Val *v,
+                                            Val *jv);
+
+// wj = w^T J(x)
+FUNCTION_EXPORT void evaluateVectorJacobian(int n, const Val *x, const Val *w,
+                                            Val *wj);
+}
+#endif  // __LIBRARYINTERFACE_PRODUCTS_H__
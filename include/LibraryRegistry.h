@@ -0,0 +1,132 @@
+#ifndef __LIBRARYREGISTRY_H__
+#define __LIBRARYREGISTRY_H__
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "./Solver.h"
+#include "./SolverInterval.h"
+
+// Keeps several system libraries loaded at once, each for one arithmetic,
+// with their metadata, and reloads them when their file is rebuilt.
+//
+// The directories of the libraries are watched with inotify. Nothing runs
+// in the background: the owner polls watchDescriptor() (epoll, a Qt
+// QSocketNotifier, ...) and calls processEvents() when it is readable.
+// Every version is loaded from a private copy, so rewriting the file in
+// place never changes code that is running (dependencies are therefore not
+// found through $ORIGIN). The copy goes to $XDG_RUNTIME_DIR, else next to
+// the library, else to $TMPDIR, skipping places mounted noexec and trying
+// the next one if the library does not load from a copy. Libraries are
+// loaded outside the registry's lock, since they run their constructors.
+// A reload installs a new solver; solves holding the previous one finish
+// with the old code, which is unloaded with the last reference. If the new
+// file does not load, the previous version stays in use.
+class LibraryRegistry {
+ public:
+  enum class Arithmetic { STANDARD, INTERVAL };
+
+  // Cached metadata of a loaded system
+  struct Entry {
+    int id;
+    // Canonical path of the library file, empty for typed equations
+    std::string path;
+    Arithmetic arithmetic;
+    NStandard::LibraryMode mode;
+    std::string name;
+    int equations;
+    bool multiprecision;
+    // 0 for the first load, incremented by every reload
+    int generation;
+    // Why the last reload failed, empty after a successful one
+    std::string reloadError;
+    // Typed equations running as a compiled library (see attach())
+    bool native;
+  };
+
+  LibraryRegistry();
+  ~LibraryRegistry();
+  LibraryRegistry(const LibraryRegistry &) = delete;
+  LibraryRegistry &operator=(const LibraryRegistry &) = delete;
+
+  // Loads the library for the arithmetic and returns its id, or -1 with
+  // error set. Loading a library that is already registered for the
+  // arithmetic reloads it and keeps its id. The mode only applies to
+  // standard arithmetic.
+  int load(const std::string &path, Arithmetic arithmetic, std::string &error,
+           NStandard::LibraryMode mode = NStandard::LibraryMode::IN_PROCESS);
+
+  // Adds a standard arithmetic system typed as equations (see
+  // ExpressionSystem) and returns its id, or -1 with error set
+  int define(const std::string &name, const std::string &source,
+             std::string &error);
+
+  // Replaces the interpreted solver of typed equations with the library
+  // compiled from them (see NativeCompiler), for either arithmetic: a typed
+  // system gains an interval solver this way. Solves holding the previous
+  // solver finish with it. False with error set if the library does not
+  // load or id is not typed equations.
+  bool attach(int id, Arithmetic arithmetic, const std::string &library,
+              std::string &error);
+
+  bool unload(int id);
+
+  std::vector<Entry> entries() const;
+  bool find(int id, Entry &entry) const;
+
+  // Current solver of the system, or null for an unknown id or the other
+  // arithmetic
+  std::shared_ptr<NStandard::Solver> standard(int id) const;
+  std::shared_ptr<NInterval::Solver> interval(int id) const;
+
+  // Readable when a watched file changed, -1 if inotify is unavailable
+  int watchDescriptor() const;
+
+  // Reloads the libraries whose files changed since the last call and
+  // returns their ids, including those whose reload failed. Never blocks.
+  std::vector<int> processEvents();
+
+ private:
+  struct System {
+    Entry entry;
+    std::shared_ptr<NStandard::Solver> standard;
+    std::shared_ptr<NInterval::Solver> interval;
+  };
+
+  // A loaded version of a library, not yet installed in its system
+  struct Version {
+    std::shared_ptr<NStandard::Solver> standard;
+    std::shared_ptr<NInterval::Solver> interval;
+    std::string name;
+    int equations;
+    bool multiprecision;
+    NStandard::LibraryMode mode;
+  };
+
+  // Called without the lock held
+  bool loadVersion(const std::string &path, Arithmetic arithmetic,
+                   NStandard::LibraryMode mode, Version &version,
+                   std::string &error);
+  std::string snapshot(const std::string &path, int location,
+                       std::string &error);
+  std::string snapshotDirectory(const std::string &base, std::string &error);
+
+  // Called with the lock held
+  void install(System &system, Version &version);
+  void watch(const std::string &path);
+
+  mutable std::mutex lock;
+  std::map<int, System> systems;
+  int nextId;
+  int inotifyFd;
+  std::map<int, std::string> watchedDirectories;
+  // Guards the snapshot state, apart from lock
+  std::mutex snapshotLock;
+  // Private directory created under each base directory
+  std::map<std::string, std::string> snapshotDirectories;
+  unsigned snapshots;
+};
+#endif  // __LIBRARYREGISTRY_H__
@@ -0,0 +1,305 @@
+#ifndef __LIBRARYTEMPLATE_H__
+#define __LIBRARYTEMPLATE_H__
+
+// Libraries written once, as a template over the number type, with the
+// derivatives computed by automatic differentiation instead of written by
+// hand:
+//
+//   #include "../include/LibraryTemplate.h"
+//
+//   template <class T>
+//   T residual(int i, const T *x) {
+//     if (i == 1) return sqr(x[1]) + 8 * x[2] - 16;
+//     return x[1] - exp(x[2]);
+//   }
+//
+//   EAN_AUTODIFF_LIBRARY("ExampleC", 2)
+//
+// x is 1-based like in the library interface. A single build exports the
+// system in every arithmetic, the entries of LibraryInterface.h under
+// ean_v1_<variant>_<entry> for each variant, and the solvers pick theirs
+// (see SharedLibrary::resolve):
+//
+//   standard  long double, also under the plain names for older loaders,
+//             with the Jacobian products of LibraryInterfaceProducts.h
+//   double    double
+//   interval  interval_arithmetic::Interval<long double>; the name gets
+//             " (Interval)" appended
+//   pack4     four points at a time in double (see Pack.h), x[4 * j + k]
+//             being x[j] of point k and the results f[k] and
+//             dfatx[4 * j + k]; only evaluateFunction and
+//             evaluateDerivatives
+//   batch     the entries of LibraryInterfaceBatch.h, under their plain
+//             names: any number of points in double, eight at a time
+//
+// residual is instantiated for each of them: use sqr(x) rather than x * x,
+// which intervals overestimate (GenericMath.h lists what intervals offer).
+// Neither intervals nor packs can follow a branch on the variables; define
+// EAN_BRANCHING_RESIDUAL before including this header if residual takes
+// one. The library then has no interval variant, and pack4 and batch
+// evaluate the points one after the other.
+//
+// Derivatives come from forward mode (see Dual.h), every Jacobian row in
+// one pass over residual for systems of up to MAX_TANGENTS equations, in
+// several passes of that many directions beyond. The products come from a
+// reverse mode tape (see Tape.h) that is recorded once per thread and
+// replayed at every further point.
+//
+// Packs use the vectorised functions of VectorMath.h. On x86-64 Linux the
+// batch entries are compiled for AVX-512, AVX2 and the baseline, and the
+// loader picks the best one the CPU runs (GCC's target_clones), so a
+// library built without -march uses the wide registers where they exist.
+
+#include "./GenericMath.h"
+#include "./LibraryInterfaceBatch.h"
+#include "./LibraryInterfaceProducts.h"
+#include "./Tape.h"
+#include "./VectorMath.h"
+
+using namespace NAutoDiff;
+
+namespace NAutoDiff {
+
+const int MAX_TANGENTS = 16;
+
+// Directions per pass for a system of n equations
+constexpr int Tangents(int n) { return n < MAX_TANGENTS ? n : MAX_TANGENTS; }
+
+typedef interval_arithmetic::Interval<long double> IntervalVariant;
+typedef NSimd::Pack<double, 4> PackVariant;
+typedef NSimd::Pack<double, 8> BatchVariant;
+
+// Points first, first + 1, ... of a batch in the lanes of point[1..n];
+// lanes past the last point repeat it
+inline void LoadBatch(int n, int m, int first, const double *X,
+                      BatchVariant *point) {
+  const int W = BatchVariant::WIDTH;
+  for (int j = 1; j <= n; j++) {
+    const double *column = X + static_cast<long>(j - 1) * m;
+    if (first + W <= m) {
+      point[j] = BatchVariant::Load(column + first);
+    } else {
+      for (int k = 0; k < W; k++) {
+        point[j].lane[k] = column[first + k < m ? first + k : m - 1];
+      }
+    }
+  }
+}
+
+// The lanes of value that hold points, into row[first...]
+inline void StoreBatch(const BatchVariant &value, int m, int first,
+                       double *row) {
+  const int W = BatchVariant::WIDTH;
+  if (first + W <= m) {
+    value.store(row + first);
+  } else {
+    for (int k = 0; first + k < m; k++) {
+      row[first + k] = value.lane[k];
+    }
+  }
+}
+}  // namespace NAutoDiff
+
+// Function multiversioning for the batch entries, where the toolchain
+// supports it (it needs ifunc); flatten inlines residual into every clone
+#if defined(__x86_64__) && defined(__linux__) && defined(__has_attribute)
+#if __has_attribute(target_clones) && __has_attribute(flatten)
+#define EAN_TARGET_CLONES \
+  __attribute__((target_clones("avx512f", "avx2", "default"), flatten))
+#endif
+#endif
+#ifndef EAN_TARGET_CLONES
+#define EAN_TARGET_CLONES
+#endif
+
+// Names of the entries of one variant
+#define EAN_PLAIN_ENTRY(entry) entry
+#define EAN_STANDARD_ENTRY(entry) ean_v1_standard_##entry
+#define EAN_DOUBLE_ENTRY(entry) ean_v1_double_##entry
+#define EAN_INTERVAL_ENTRY(entry) ean_v1_interval_##entry
+#define EAN_PACK_ENTRY(entry) ean_v1_pack4_##entry
+
+// The entries of LibraryInterface.h for one arithmetic T
+#define EAN_LIBRARY_VARIANT(ENTRY, T, name, equations)                        \
+  FUNCTION_EXPORT T ENTRY(evaluateFunction)(int i, int n, const T *x) {       \
+    return residual(i, x);                                                    \
+  }                                                                           \
+                                                                              \
+  FUNCTION_EXPORT void ENTRY(evaluateDerivatives)(int i, int n, const T *x,   \
+                                                  T *dfatx) {                 \
+    typedef NAutoDiff::Dual<T, NAutoDiff::Tangents(equations)> D;             \
+    D point[(equations) + 1];                                                 \
+    NAutoDiff::Gradient([i](const D *p) { return residual(i, p); },           \
+                        (equations), x, dfatx, point);                        \
+  }                                                                           \
+                                                                              \
+  FUNCTION_EXPORT const char *ENTRY(getName)() { return name; }               \
+                                                                              \
+  FUNCTION_EXPORT int ENTRY(getNumberOfEquations)() { return (equations); }
+
+#define EAN_LIBRARY_PRODUCTS(ENTRY)                                           \
+  FUNCTION_EXPORT void ENTRY(evaluateJacobianVector)(int n, const Val *x,     \
+                                                     const Val *v, Val *jv) { \
+    ProductTape(n, x).jacobianVector(v, jv);                                  \
+  }                                                                           \
+                                                                              \
+  FUNCTION_EXPORT void ENTRY(evaluateVectorJacobian)(int n, const Val *x,     \
+                                                     const Val *w, Val *wj) { \
+    ProductTape(n, x).vectorJacobian(w, wj);                                  \
+  }
+
+#ifdef EAN_BRANCHING_RESIDUAL
+#define EAN_LIBRARY_INTERVAL(name, equations)
+
+// The points of the batch one by one, through the double variant
+#define EAN_LIBRARY_BATCH(equations)                                          \
+  FUNCTION_EXPORT void evaluateSystemBatch(int n, int m, const double *X,     \
+                                           double *F) {                       \
+    double point[(equations) + 1];                                            \
+    for (int k = 0; k < m; k++) {                                             \
+      for (int j = 1; j <= (equations); j++) {                                \
+        point[j] = X[static_cast<long>(j - 1) * m + k];                       \
+      }                                                                       \
+      for (int i = 1; i <= (equations); i++) {                                \
+        F[static_cast<long>(i - 1) * m + k] =                                 \
+            residual(i, static_cast<const double *>(point));                  \
+      }                                                                       \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  FUNCTION_EXPORT void evaluateJacobianBatch(int n, int m, const double *X,   \
+                                             double *J) {                     \
+    double point[(equations) + 1], gradient[(equations) + 1];                 \
+    for (int k = 0; k < m; k++) {                                             \
+      for (int j = 1; j <= (equations); j++) {                                \
+        point[j] = X[static_cast<long>(j - 1) * m + k];                       \
+      }                                                                       \
+      for (int i = 1; i <= (equations); i++) {                                \
+        EAN_DOUBLE_ENTRY(evaluateDerivatives)(i, n, point, gradient);         \
+        for (int j = 1; j <= (equations); j++) {                              \
+          J[(static_cast<long>(i - 1) * (equations) + j - 1) * m + k] =       \
+              gradient[j];                                                    \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+  }
+
+// The points of the pack one by one, through the double variant
+#define EAN_LIBRARY_PACK(equations)                                           \
+  FUNCTION_EXPORT void EAN_PACK_ENTRY(evaluateFunction)(                      \
+      int i, int n, const double *x, double *f) {                             \
+    const int W = NAutoDiff::PackVariant::WIDTH;                              \
+    double point[(equations) + 1];                                            \
+    for (int k = 0; k < W; k++) {                                             \
+      for (int j = 1; j <= (equations); j++) {                                \
+        point[j] = x[W * j + k];                                              \
+      }                                                                       \
+      f[k] = residual(i, static_cast<const double *>(point));                 \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  FUNCTION_EXPORT void EAN_PACK_ENTRY(evaluateDerivatives)(                   \
+      int i, int n, const double *x, double *dfatx) {                         \
+    const int W = NAutoDiff::PackVariant::WIDTH;                              \
+    double point[(equations) + 1], gradient[(equations) + 1];                 \
+    for (int k = 0; k < W; k++) {                                             \
+      for (int j = 1; j <= (equations); j++) {                                \
+        point[j] = x[W * j + k];                                              \
+      }                                                                       \
+      EAN_DOUBLE_ENTRY(evaluateDerivatives)(i, n, point, gradient);           \
+      for (int j = 1; j <= (equations); j++) {                                \
+        dfatx[W * j + k] = gradient[j];                                       \
+      }                                                                       \
+    }                                                                         \
+  }
+#else
+#define EAN_LIBRARY_INTERVAL(name, equations)                                 \
+  EAN_LIBRARY_VARIANT(EAN_INTERVAL_ENTRY, NAutoDiff::IntervalVariant,         \
+                      name " (Interval)", equations)
+
+#define EAN_LIBRARY_BATCH(equations)                                          \
+  FUNCTION_EXPORT EAN_TARGET_CLONES void evaluateSystemBatch(                 \
+      int n, int m, const double *X, double *F) {                             \
+    typedef NAutoDiff::BatchVariant P;                                        \
+    P point[(equations) + 1];                                                 \
+    for (int first = 0; first < m; first += P::WIDTH) {                       \
+      NAutoDiff::LoadBatch((equations), m, first, X, point);                  \
+      for (int i = 1; i <= (equations); i++) {                                \
+        NAutoDiff::StoreBatch(residual(i, static_cast<const P *>(point)), m,  \
+                              first, F + static_cast<long>(i - 1) * m);       \
+      }                                                                       \
+    }                                                                         \
+  }                                                                           \
+                                                                              \
+  FUNCTION_EXPORT EAN_TARGET_CLONES void evaluateJacobianBatch(               \
+      int n, int m, const double *X, double *J) {                             \
+    typedef NAutoDiff::BatchVariant P;                                        \
+    typedef NAutoDiff::Dual<P, NAutoDiff::Tangents(equations)> D;             \
+    P packs[(equations) + 1], gradient[(equations) + 1];                      \
+    D point[(equations) + 1];                                                 \
+    for (int first = 0; first < m; first += P::WIDTH) {                       \
+      NAutoDiff::LoadBatch((equations), m, first, X, packs);                  \
+      for (int i = 1; i <= (equations); i++) {                                \
+        NAutoDiff::Gradient([i](const D *p) { return residual(i, p); },       \
+                            (equations), static_cast<const P *>(packs),       \
+                            gradient, point);                                 \
+        for (int j = 1; j <= (equations); j++) {                              \
+          long row = static_cast<long>(i - 1) * (equations) + j - 1;          \
+          NAutoDiff::StoreBatch(gradient[j], m, first, J + row * m);          \
+        }                                                                     \
+      }                                                                       \
+    }                                                                         \
+  }
+
+#define EAN_LIBRARY_PACK(equations)                                           \
+  FUNCTION_EXPORT void EAN_PACK_ENTRY(evaluateFunction)(                      \
+      int i, int n, const double *x, double *f) {                             \
+    typedef NAutoDiff::PackVariant P;                                         \
+    P point[(equations) + 1];                                                 \
+    for (int j = 1; j <= (equations); j++) {                                  \
+      point[j] = P::Load(x + P::WIDTH * j);                                   \
+    }                                                                         \
+    residual(i, static_cast<const P *>(point)).store(f);                      \
+  }                                                                           \
+                                                                              \
+  FUNCTION_EXPORT void EAN_PACK_ENTRY(evaluateDerivatives)(                   \
+      int i, int n, const double *x, double *dfatx) {                         \
+    typedef NAutoDiff::PackVariant P;                                         \
+    typedef NAutoDiff::Dual<P, NAutoDiff::Tangents(equations)> D;             \
+    P packs[(equations) + 1], gradient[(equations) + 1];                      \
+    D point[(equations) + 1];                                                 \
+    for (int j = 1; j <= (equations); j++) {                                  \
+      packs[j] = P::Load(x + P::WIDTH * j);                                   \
+    }                                                                         \
+    NAutoDiff::Gradient([i](const D *p) { return residual(i, p); },           \
+                        (equations), static_cast<const P *>(packs), gradient, \
+                        point);                                               \
+    for (int j = 1; j <= (equations); j++) {                                  \
+      gradient[j].store(dfatx + P::WIDTH * j);                                \
+    }                                                                         \
+  }
+#endif
+
+#define EAN_AUTODIFF_LIBRARY(name, equations)                                 \
+  namespace {                                                                 \
+  NAutoDiff::Tape<Val> &ProductTape(int n, const Val *x) {                    \
+    static thread_local NAutoDiff::Tape<Val> tape;                            \
+    tape.evaluate(n, (equations), x,                                          \
+                  [](int i, const NAutoDiff::Reverse<Val> *p) {               \
+                    return residual(i, p);                                    \
+                  });                                                         \
+    return tape;                                                              \
+  }                                                                           \
+  }                                                                           \
+                                                                              \
+  extern "C" {                                                                \
+  EAN_LIBRARY_VARIANT(EAN_PLAIN_ENTRY, Val, name, equations)                  \
+  EAN_LIBRARY_PRODUCTS(EAN_PLAIN_ENTRY)                                       \
+  EAN_LIBRARY_VARIANT(EAN_STANDARD_ENTRY, Val, name, equations)               \
+  EAN_LIBRARY_PRODUCTS(EAN_STANDARD_ENTRY)                                    \
+  EAN_LIBRARY_VARIANT(EAN_DOUBLE_ENTRY, double, name, equations)              \
+  EAN_LIBRARY_INTERVAL(name, equations)                                       \
+  EAN_LIBRARY_PACK(equations)                                                 \
+  EAN_LIBRARY_BATCH(equations)                                                \
+  }
+#endif  // __LIBRARYTEMPLATE_H__
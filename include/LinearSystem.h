@@ -0,0 +1,59 @@
+#ifndef __LINEARSYSTEM_H__
+#define __LINEARSYSTEM_H__
+
+#include <algorithm>
+#include <cmath>
+
+namespace NStandard {
+
+// LU factorisation of a (n x n, row-major) in place, with partial
+// pivoting recorded in pivot; false if a is singular
+template <typename T>
+bool Factor(int n, T *a, int *pivot) {
+  for (int k = 0; k < n; k++) {
+    int p = k;
+    for (int i = k + 1; i < n; i++) {
+      if (std::abs(a[i * n + k]) > std::abs(a[p * n + k])) {
+        p = i;
+      }
+    }
+    pivot[k] = p;
+    if (!(a[p * n + k] != 0) || !std::isfinite(a[p * n + k])) {
+      return false;
+    }
+    if (p != k) {
+      std::swap_ranges(a + k * n, a + (k + 1) * n, a + p * n);
+    }
+    for (int i = k + 1; i < n; i++) {
+      T factor = a[i * n + k] /= a[k * n + k];
+      for (int j = k + 1; j < n; j++) {
+        a[i * n + j] -= factor * a[k * n + j];
+      }
+    }
+  }
+  return true;
+}
+
+// Solves a d = b with a factored by Factor, b overwritten by d; false if
+// the result is not finite
+template <typename T>
+bool Substitute(int n, const T *a, const int *pivot, T *b) {
+  for (int k = 0; k < n; k++) {
+    std::swap(b[k], b[pivot[k]]);
+    for (int i = k + 1; i < n; i++) {
+      b[i] -= a[i * n + k] * b[k];
+    }
+  }
+  for (int k = n - 1; k >= 0; k--) {
+    for (int j = k + 1; j < n; j++) {
+      b[k] -= a[k * n + j] * b[j];
+    }
+    b[k] /= a[k * n + k];
+    if (!std::isfinite(b[k])) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace NStandard
+#endif  // __LINEARSYSTEM_H__
@@ -3,14 +3,18 @@
 
 #include <qspinbox.h>
 
+#include <QComboBox>
 #include <QFileDialog>
 #include <QGroupBox>
 #include <QLibrary>
 #include <QMainWindow>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QThread>
 #include <QVBoxLayout>
 
+#include "LibraryRegistry.h"
+#include "PluginCatalog.h"
 #include "Solver.h"
 #include "SolverInterval.h"
 #include "SolverStatus.h"
@@ -19,6 +23,9 @@ enum class ArithmeticMode {
   STANDARD = 0,
   INTERVAL = 1,
   INTERVAL_INPUT = 2,
+  INTERVAL_VERIFIED = 3,
+  INTERVAL_SEARCH = 4,
+  MULTIPRECISION = 5,
 };
 
 class MainWindow : public QMainWindow {
@@ -29,11 +36,25 @@ class MainWindow : public QMainWindow {
 
  private slots:
   void loadLibrary();
+  void addPluginDirectory();
+  void enterEquations();
   void runSolver();
+  void selectSystem(int index);
+  void reloadLibraries();
 
  private:
-  std::unique_ptr<NStandard::Solver> standardSolver;
-  std::unique_ptr<NInterval::Solver> intervalSolver;
+  // Every loaded system; the solvers below are the selected ones
+  LibraryRegistry registry;
+  // Libraries found in the plugin directories, loaded when selected
+  PluginCatalog catalog;
+  QThread *scanThread = nullptr;
+  bool scanPending = false;
+  int currentSystem = -1;
+  // Last system typed with enterEquations()
+  QString equationsText;
+  int typedSystems = 0;
+  std::shared_ptr<NStandard::Solver> standardSolver;
+  std::shared_ptr<NInterval::Solver> intervalSolver;
   ArithmeticMode arithmeticMode = ArithmeticMode::STANDARD;
   QPushButton *runButton;
   QLabel *resultLabel;
@@ -41,14 +62,32 @@ class MainWindow : public QMainWindow {
   QVBoxLayout *inputsGroupLayout;
   QLineEdit *epsilonInput;
   QSpinBox *maxIterationsInput;
+  QComboBox *stepInput;
+  QComboBox *contractorInput;
+  QComboBox *linearSolverInput;
+  QSpinBox *maxPrecisionInput;
+  QAction *isolateAction;
+  QComboBox *systemInput;
+  void refreshSystems(int selectId);
+  void scanPlugins();
+  int openLibrary(const QString &path, LibraryRegistry::Arithmetic arithmetic);
+  void compileEquations(int id, const std::string &name,
+                        const std::string &source);
   void updateInterface();
   void clearInputs();
   void createInput(int i);
   void showResult(NStandard::SolverResult &result);
+  void showResult(NStandard::SolverResultMP &result);
   void showResult(NInterval::SolverResult &result);
-  void checkResultStatus(SolverStatus status);
+  void showResult(NInterval::BoxSearchResult &result);
+  void checkResultStatus(SolverStatus status,
+                         const std::string &message = "");
   void runStandardSolver();
+  void runMultiprecisionSolver();
   void runIntervalSolver();
   void runIntervalInputSolver();
+  void runVerifiedSolver();
+  void runSearchSolver();
+  NInterval::Vector readIntervalInputs();
 };
 #endif  // __MAINWINDOW_H__
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef __NATIVECOMPILER_H__
+#define __NATIVECOMPILER_H__
+
+#include <string>
+#include <vector>
+
+#include "./ExpressionSystem.h"
+
+// Builds system libraries from generated C++ (see
+// ExpressionSystem::generateLibrary) with the compiler installed on the
+// machine, -O3 -march=native, and keeps them in a cache directory.
+//
+// A library is named after a hash of its source, the compiler command, the
+// flags, the include directory, the headers the source includes and the
+// CPU model, so a system compiled once
+// is found again by every later session on the same machine and nothing is
+// shared with a machine whose CPU differs. Libraries are written under a
+// temporary name and renamed into place, so processes compiling the same
+// system at once never see a partial file.
+//
+// The compiler is $CXX, or c++; the headers are taken from EAN_INCLUDE_PATH,
+// or the include directory of the source tree the program was built from.
+class NativeCompiler {
+ public:
+  // cacheDirectory defaults to $XDG_CACHE_HOME/ean/native
+  // (~/.cache/ean/native)
+  explicit NativeCompiler(
+      const std::string &cacheDirectory = DefaultCacheDirectory());
+
+  static std::string DefaultCacheDirectory();
+
+  // Where the library built from source is, or will be, stored
+  std::string libraryPath(const std::string &source) const;
+  bool isCached(const std::string &source) const;
+
+  // Returns the path of the library built from source, running the
+  // compiler unless it is cached, or an empty string with error set to the
+  // compiler's output. Blocks while the compiler runs (a second or so).
+  std::string compile(const std::string &source, std::string &error) const;
+  std::string compile(const ExpressionSystem &system,
+                      ExpressionSystem::Target target,
+                      std::string &error) const;
+
+ private:
+  std::string cacheDirectory;
+  // Compiler and its arguments, without the output and input files
+  std::vector<std::string> command;
+  // Everything besides the source that the library depends on
+  std::string configuration;
+};
+#endif  // __NATIVECOMPILER_H__
@@ -11,8 +11,18 @@ using FunctionType = Val (*)(int i, int n, const Vector &x);
 using DerivativeType = void (*)(int i, int n, const Vector &x, Vector &dfatx);
 using FunctionTypeC = Val (*)(int i, int n, const Val *x);
 using DerivativeTypeC = void (*)(int i, int n, const Val *x, Val *dfatx);
+// J(x) v or w^T J(x), see LibraryInterfaceProducts.h
+using ProductTypeC = void (*)(int n, const Val *x, const Val *v, Val *result);
+
+// How far each iteration moves along the Newton step
+enum class Globalization {
+  NONE = 0,          // the full step
+  LINE_SEARCH = 1,   // backtracking until |F|^2 decreases enough (Armijo)
+  TRUST_REGION = 2,  // Powell's dogleg, as MINPACK's hybrj
+};
 
 void NewtonSystem(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
-                  int mit, Val eps, int &it, int &st);
+                  int mit, Val eps, int &it, int &st,
+                  Globalization globalization = Globalization::NONE);
 }  // namespace NStandard
 #endif  // __NEWTONSYSTEM_H__
\ No newline at end of file
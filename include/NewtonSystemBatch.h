@@ -0,0 +1,28 @@
+#ifndef __NEWTONSYSTEM_BATCH_H__
+#define __NEWTONSYSTEM_BATCH_H__
+
+#include "./NewtonSystem.h"
+
+namespace NStandard {
+
+// The whole system at m points in double, in the layout of
+// LibraryInterfaceBatch.h
+using BatchFunctionTypeC = void (*)(int n, int m, const double *X, double *F);
+using BatchJacobianTypeC = void (*)(int n, int m, const double *X, double *J);
+
+// Newton's method for m initial guesses at once, in double: X[j * m + k]
+// is x[j + 1] of guess k and is replaced by its result, it[k] and st[k]
+// are what NewtonSystem reports for it, except that the accuracy eps is
+// relative to the largest component. Guesses still iterating are
+// evaluated together in one call of f and df per iteration.
+void NewtonSystemBatch(int n, int m, double *X, BatchFunctionTypeC f,
+                       BatchJacobianTypeC df, int mit, double eps, int *it,
+                       int *st);
+
+// Brings x (1-based), a solution that NewtonSystemBatch found, to long
+// double accuracy with f and the double Jacobian J at x, whose entry
+// df[i + 1]/dx[j + 1] is J[(i * n + j) * stride]
+void RefineSystem(int n, Vector &x, FunctionTypeC f, const double *J,
+                  int stride, int mit, Val eps, int &it, int &st);
+}  // namespace NStandard
+#endif  // __NEWTONSYSTEM_BATCH_H__
@@ -0,0 +1,17 @@
+#ifndef __NEWTONSYSTEM_FIXED_H__
+#define __NEWTONSYSTEM_FIXED_H__
+
+#include "./NewtonSystem.h"
+
+namespace NStandard {
+
+// Largest system NewtonSystemFixed has a kernel for
+const int MAX_FIXED_EQUATIONS = 8;
+
+// NewtonSystem for 1 <= n <= MAX_FIXED_EQUATIONS, with the size a
+// template argument: the iterates and the Jacobian live on the stack and
+// the elimination is unrolled. NewtonSystem forwards such systems here.
+void NewtonSystemFixed(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                       int mit, Val eps, int &it, int &st);
+}  // namespace NStandard
+#endif  // __NEWTONSYSTEM_FIXED_H__
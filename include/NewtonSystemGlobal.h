@@ -0,0 +1,17 @@
+#ifndef __NEWTONSYSTEM_GLOBAL_H__
+#define __NEWTONSYSTEM_GLOBAL_H__
+
+#include "./NewtonSystem.h"
+
+namespace NStandard {
+
+// Newton's method with steps that must decrease |F|^2, for starting points
+// from which the full step diverges or wanders. NewtonSystem forwards here
+// for Globalization::LINE_SEARCH and TRUST_REGION; parameters and status
+// codes are those of NewtonSystem.
+void NewtonLineSearch(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                      int mit, Val eps, int &it, int &st);
+void NewtonTrustRegion(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                       int mit, Val eps, int &it, int &st);
+}  // namespace NStandard
+#endif  // __NEWTONSYSTEM_GLOBAL_H__
@@ -15,8 +15,16 @@ using FunctionTypeC = ValInterval (*)(int i, int n, const ValInterval *x);
 using DerivativeTypeC = void (*)(int i, int n, const ValInterval *x,
                                  ValInterval *dfatx);
 
+// Method used for the linear step of the interval Newton iteration
+enum class LinearSolver {
+  GAUSS = 0,
+  HANSEN_BLIEK_ROHN = 1,
+  GAUSS_SEIDEL = 2,
+};
+
 void NewtonSystem(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
-                  int mit, ValInterval eps, int &it, int &st);
+                  int mit, ValInterval eps, int &it, int &st,
+                  LinearSolver solver = LinearSolver::GAUSS);
 
 }  // namespace NInterval
 #endif  // __NEWTONSYSTEM_INTERVAL_H__
\ No newline at end of file
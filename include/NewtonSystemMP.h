@@ -0,0 +1,39 @@
+#ifndef __NEWTONSYSTEM_MP_H__
+#define __NEWTONSYSTEM_MP_H__
+
+#include <mpreal.h>
+
+#include <vector>
+
+#include "./NewtonSystem.h"
+
+namespace NMultiprecision {
+
+using mpfr::mpreal;
+using Vector = std::vector<mpreal>;
+// Residuals are written into caller-owned mpreal objects so that the solver
+// can keep one allocation per variable for the whole precision stage.
+using FunctionTypeC = void (*)(int i, int n, const mpreal *x, mpreal &fx);
+using DerivativeTypeC = void (*)(int i, int n, const mpreal *x,
+                                 mpreal *dfatx);
+
+// Precision ladder used by NewtonSystem: double, long double, then MPFR at
+// doubling precision (128, 256, 512, ...) up to the requested maximum.
+const int DOUBLE_PRECISION = 53;
+const int LDOUBLE_PRECISION = 64;
+const int FIRST_MP_PRECISION = 128;
+
+void NewtonSystem(int n, Vector &x, NStandard::FunctionTypeC f,
+                  NStandard::DerivativeTypeC df, FunctionTypeC fmp,
+                  DerivativeTypeC dfmp, int mit, const mpreal &eps,
+                  int maxPrecision, int &it, int &prec, int &st);
+
+// Optional speed-up of the MPFR stages, which allocate and free significands
+// at every step: replaces GMP's memory functions, for the whole process,
+// with per-thread free lists of small blocks that forward everything else to
+// the functions installed before. GMP requires its memory functions to be
+// set before any other GMP use, so an application calls this once at
+// start-up, after installing its own functions if it has any.
+void InstallLimbPool();
+}  // namespace NMultiprecision
+#endif  // __NEWTONSYSTEM_MP_H__
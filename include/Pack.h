@@ -0,0 +1,167 @@
+#ifndef __PACK_H__
+#define __PACK_H__
+
+#include <math.h>
+
+#include <cmath>
+#include <type_traits>
+
+// W values of T processed together, one per lane.
+//
+// A function template evaluated on packs computes W independent results
+// in one pass, which is how a residual written once for every arithmetic
+// is evaluated at several points at a time. The operations are loops over
+// a plain aligned array, which the compiler turns into SIMD instructions
+// for float and double when W matches the vector width (4 doubles for
+// AVX2). The functions apply the scalar ones lane by lane; VectorMath.h
+// has vectorised ones for the common functions of double packs.
+//
+// Packs have no comparisons: a comparison would differ between lanes, so
+// residuals that branch on their variables cannot be evaluated on packs.
+namespace NSimd {
+
+template <typename T, int W>
+class Pack {
+ public:
+  static_assert(W >= 1, "a pack needs a lane");
+  static const int WIDTH = W;
+
+  alignas(sizeof(T) * W) T lane[W];
+
+  Pack() : lane() {}
+
+  // The same value in every lane
+  Pack(const T &v) {
+    for (int k = 0; k < W; k++) {
+      lane[k] = v;
+    }
+  }
+  template <typename S, typename = typename std::enable_if<
+                            std::is_arithmetic<S>::value>::type>
+  Pack(S c) : Pack(static_cast<T>(c)) {}
+
+  // Lane k from p[k * stride]
+  static Pack Load(const T *p, int stride = 1) {
+    Pack r;
+    for (int k = 0; k < W; k++) {
+      r.lane[k] = p[k * stride];
+    }
+    return r;
+  }
+
+  void store(T *p, int stride = 1) const {
+    for (int k = 0; k < W; k++) {
+      p[k * stride] = lane[k];
+    }
+  }
+
+  Pack &operator+=(const Pack &y) { return *this = *this + y; }
+  Pack &operator-=(const Pack &y) { return *this = *this - y; }
+  Pack &operator*=(const Pack &y) { return *this = *this * y; }
+  Pack &operator/=(const Pack &y) { return *this = *this / y; }
+};
+
+namespace detail {
+
+template <typename S>
+using IfScalar =
+    typename std::enable_if<std::is_arithmetic<S>::value, int>::type;
+}  // namespace detail
+
+template <typename T, int W>
+inline Pack<T, W> operator+(const Pack<T, W> &x) {
+  return x;
+}
+
+template <typename T, int W>
+inline Pack<T, W> operator-(const Pack<T, W> &x) {
+  Pack<T, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = -x.lane[k];
+  }
+  return r;
+}
+
+// Constants are broadcast to every lane
+#define EAN_PACK_BINARY(symbol)                                         \
+  template <typename T, int W>                                          \
+  inline Pack<T, W> operator symbol(const Pack<T, W> &x,                \
+                                    const Pack<T, W> &y) {              \
+    Pack<T, W> r;                                                       \
+    for (int k = 0; k < W; k++) {                                       \
+      r.lane[k] = x.lane[k] symbol y.lane[k];                           \
+    }                                                                   \
+    return r;                                                           \
+  }                                                                     \
+  template <typename T, int W, typename S, detail::IfScalar<S> = 0>     \
+  inline Pack<T, W> operator symbol(const Pack<T, W> &x, S c) {         \
+    return x symbol Pack<T, W>(c);                                      \
+  }                                                                     \
+  template <typename T, int W, typename S, detail::IfScalar<S> = 0>     \
+  inline Pack<T, W> operator symbol(S c, const Pack<T, W> &y) {         \
+    return Pack<T, W>(c) symbol y;                                      \
+  }
+
+EAN_PACK_BINARY(+)
+EAN_PACK_BINARY(-)
+EAN_PACK_BINARY(*)
+EAN_PACK_BINARY(/)
+#undef EAN_PACK_BINARY
+
+#define EAN_PACK_UNARY(name)                                            \
+  template <typename T, int W>                                          \
+  inline Pack<T, W> name(const Pack<T, W> &x) {                         \
+    using std::name;                                                    \
+    Pack<T, W> r;                                                       \
+    for (int k = 0; k < W; k++) {                                       \
+      r.lane[k] = name(x.lane[k]);                                      \
+    }                                                                   \
+    return r;                                                           \
+  }
+
+EAN_PACK_UNARY(sin)
+EAN_PACK_UNARY(cos)
+EAN_PACK_UNARY(tan)
+EAN_PACK_UNARY(asin)
+EAN_PACK_UNARY(acos)
+EAN_PACK_UNARY(atan)
+EAN_PACK_UNARY(sinh)
+EAN_PACK_UNARY(cosh)
+EAN_PACK_UNARY(tanh)
+EAN_PACK_UNARY(exp)
+EAN_PACK_UNARY(log)
+EAN_PACK_UNARY(sqrt)
+EAN_PACK_UNARY(abs)
+#undef EAN_PACK_UNARY
+
+template <typename T, int W>
+inline Pack<T, W> sqr(const Pack<T, W> &x) {
+  return x * x;
+}
+
+// -1, 0 or 1 in every lane
+template <typename T, int W>
+inline Pack<T, W> sign(const Pack<T, W> &x) {
+  Pack<T, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = (x.lane[k] > 0) - (x.lane[k] < 0);
+  }
+  return r;
+}
+
+template <typename T, int W>
+inline Pack<T, W> pow(const Pack<T, W> &x, const Pack<T, W> &y) {
+  using std::pow;
+  Pack<T, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = pow(x.lane[k], y.lane[k]);
+  }
+  return r;
+}
+
+template <typename T, int W, typename S, detail::IfScalar<S> = 0>
+inline Pack<T, W> pow(const Pack<T, W> &x, S c) {
+  return pow(x, Pack<T, W>(c));
+}
+}  // namespace NSimd
+#endif  // __PACK_H__
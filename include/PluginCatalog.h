@@ -0,0 +1,91 @@
+#ifndef __PLUGINCATALOG_H__
+#define __PLUGINCATALOG_H__
+
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Catalogue of the system libraries found in a set of directories, backed
+// by an on-disk cache so that it can be listed at start-up without touching
+// the libraries.
+//
+// Scanning never loads a library: the exported symbols are read from the
+// ELF file, which tells the plugins apart from other shared objects, lists
+// the optional entry points and, through the interval_arithmetic symbols
+// an interval library carries or the variants a single-source library
+// names (see LibraryTemplate.h), its arithmetic. The name and number of
+// equations can only be learned by running the library, so they are
+// recorded with describe() when it is first loaded and cached from then
+// on. Files whose size, modification time and inode are unchanged are not
+// read again; a changed file keeps its description if its content hash is
+// the same.
+class PluginCatalog {
+ public:
+  // ANY for libraries that export both arithmetics
+  enum class Arithmetic { UNKNOWN, STANDARD, INTERVAL, ANY };
+
+  struct Plugin {
+    std::string path;
+    uint64_t size;
+    int64_t modified;  // nanoseconds since the epoch
+    uint64_t inode;
+    uint64_t hash;     // FNV-1a of the content
+    Arithmetic arithmetic;
+    // Optional entry points, "multiprecision", "products" and "batch"
+    std::vector<std::string> extensions;
+    // Empty and -1 until the library has been loaded once
+    std::string name;
+    int equations;
+  };
+
+  // cacheFile defaults to $XDG_CACHE_HOME/ean/plugins (~/.cache/ean/...)
+  explicit PluginCatalog(const std::string &cacheFile = DefaultCacheFile());
+
+  static std::string DefaultCacheFile();
+
+  // Directories listed in EAN_PLUGIN_PATH, separated by colons
+  static std::vector<std::string> EnvironmentDirectories();
+
+  void setDirectories(const std::vector<std::string> &directories);
+  std::vector<std::string> getDirectories() const;
+
+  // Reads the cache; false if there is none or it is unreadable
+  bool loadCache();
+  bool saveCache();
+
+  // Brings the catalogue in line with the directories. Safe to run on a
+  // background thread while other threads read plugins().
+  void scan();
+
+  // Plugins sorted by path
+  std::vector<Plugin> plugins() const;
+
+  // Records what loading the library at path revealed
+  void describe(const std::string &path, const std::string &name,
+                int equations);
+
+ private:
+  std::string cacheFile;
+  mutable std::mutex lock;
+  std::vector<std::string> directories;
+  std::map<std::string, Plugin> entries;
+  bool dirty;
+};
+
+inline const char *PluginArithmeticName(PluginCatalog::Arithmetic arithmetic) {
+  switch (arithmetic) {
+    case PluginCatalog::Arithmetic::STANDARD:
+      return "standard";
+    case PluginCatalog::Arithmetic::INTERVAL:
+      return "interval";
+    case PluginCatalog::Arithmetic::ANY:
+      return "any";
+    case PluginCatalog::Arithmetic::UNKNOWN:
+      break;
+  }
+  return "unknown";
+}
+#endif  // __PLUGINCATALOG_H__
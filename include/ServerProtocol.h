@@ -0,0 +1,117 @@
+#ifndef __SERVERPROTOCOL_H__
+#define __SERVERPROTOCOL_H__
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+// Binary framing of the ean-server Unix socket protocol. Every message is a
+// Header followed by length bytes of payload. Numbers use the byte order
+// and long double layout of the host: the server only accepts local
+// connections. Requests are answered asynchronously, in any order, with
+// the requestId of the request.
+//
+//   LOAD    LoadRequest + library path           -> LOADED or FAILED
+//   SOLVE   SolveRequest + n guess values         -> RESULT or FAILED
+//   RESULT  SolveResult + n solution values
+//   LOADED  LoadResult
+//   FAILED  ErrorResult + message
+//
+// A value is one long double in standard arithmetic and a (lo, hi) pair of
+// long doubles in interval arithmetic. A SOLVE whose flags do not fit the
+// arithmetic of the system, or set both step flags, fails with
+// INVALID_INPUT.
+namespace protocol {
+
+const uint32_t MAGIC = 0x534e4145;  // "EANS"
+// 2: FLAG_LINE_SEARCH and FLAG_TRUST_REGION
+const uint16_t VERSION = 2;
+const uint32_t MAX_PAYLOAD = 1 << 20;
+
+enum MessageType : uint16_t {
+  LOAD = 1,
+  SOLVE = 2,
+  LOADED = 101,
+  RESULT = 102,
+  FAILED = 199
+};
+
+enum Arithmetic : uint32_t { STANDARD = 0, INTERVAL = 1 };
+
+// SolveRequest::flags
+const uint32_t FLAG_VERIFY = 1;  // interval only: Hansen-Sengupta verify
+const uint32_t FLAG_LINE_SEARCH = 2;   // standard only: backtracking steps
+const uint32_t FLAG_TRUST_REGION = 4;  // standard only: dogleg steps
+const uint32_t FLAG_SOLVE_ALL = FLAG_VERIFY | FLAG_LINE_SEARCH |
+                                FLAG_TRUST_REGION;
+// SolveResult::flags
+const uint32_t FLAG_UNIQUE = 1;  // the box provably holds a unique root
+
+struct Header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t type;
+  uint32_t requestId;
+  uint32_t length;
+};
+
+struct LoadRequest {
+  uint32_t arithmetic;
+};
+
+struct LoadResult {
+  uint32_t system;
+  int32_t equations;
+};
+
+struct SolveRequest {
+  uint32_t system;
+  int32_t maxIterations;
+  uint32_t flags;
+  uint32_t reserved;
+  long double epsilon;
+};
+
+struct SolveResult {
+  int32_t status;
+  int32_t iterations;
+  uint32_t flags;
+  uint32_t reserved;
+};
+
+struct ErrorResult {
+  int32_t status;
+};
+
+static_assert(sizeof(Header) == 16, "unexpected header layout");
+static_assert(offsetof(SolveRequest, epsilon) == 16,
+              "unexpected request layout");
+static_assert(sizeof(SolveResult) == 16, "unexpected result layout");
+
+inline size_t ValueSize(uint32_t arithmetic) {
+  return arithmetic == INTERVAL ? 2 * sizeof(long double)
+                                : sizeof(long double);
+}
+
+// Appends a complete message to out
+inline void AppendMessage(std::string &out, uint16_t type, uint32_t requestId,
+                          const void *fixed, size_t fixedSize,
+                          const void *tail = nullptr, size_t tailSize = 0) {
+  Header header = {MAGIC, VERSION, type, requestId,
+                   static_cast<uint32_t>(fixedSize + tailSize)};
+  out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.append(static_cast<const char *>(fixed), fixedSize);
+  if (tailSize > 0) {
+    out.append(static_cast<const char *>(tail), tailSize);
+  }
+}
+
+// Checks a received header; false means the stream cannot be trusted
+inline bool ValidHeader(const Header &header) {
+  return header.magic == MAGIC && header.version == VERSION &&
+         header.length <= MAX_PAYLOAD;
+}
+}  // namespace protocol
+#endif  // __SERVERPROTOCOL_H__
@@ -0,0 +1,46 @@
+#ifndef __SHAREDLIBRARY_H__
+#define __SHAREDLIBRARY_H__
+
+#include <string>
+
+// Owns a dlopen handle. The library stays loaded for the lifetime of the
+// object, so the solvers keep one next to the pointers they resolve.
+class SharedLibrary {
+ public:
+  SharedLibrary();
+  ~SharedLibrary();
+  SharedLibrary(const SharedLibrary &) = delete;
+  SharedLibrary &operator=(const SharedLibrary &) = delete;
+  SharedLibrary(SharedLibrary &&other);
+  SharedLibrary &operator=(SharedLibrary &&other);
+
+  // Load the library at path (a name without a slash is looked up on the
+  // default search path)
+  bool load(const std::string &path);
+
+  // Address of the symbol, or nullptr if it is not exported
+  void *resolve(const char *symbol) const;
+
+  // The variant of symbol for one arithmetic ("standard", "double",
+  // "interval", "pack4") that single-source libraries export as
+  // ean_v1_<variant>_<symbol> (see LibraryTemplate.h), or else symbol.
+  // Only the standard variant falls back to symbol in a single-source
+  // library: there the plain names are the long double entries.
+  void *resolve(const char *symbol, const char *variant) const;
+
+  // False for a single-source library built without the variant, e.g.
+  // without "interval" for a residual that branches on its variables
+  bool hasVariant(const char *variant) const;
+
+  // Unload the library; pointers resolved from it become invalid
+  void unload();
+
+  bool isLoaded() const;
+
+  std::string errorString() const;
+
+ private:
+  void *handle;
+  std::string error;
+};
+#endif  // __SHAREDLIBRARY_H__
@@ -1,9 +1,16 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "./ExpressionSystem.h"
+#include "./IsolatedLibrary.h"
 #include "./NewtonSystem.h"
+#include "./NewtonSystemBatch.h"
+#include "./NewtonSystemMP.h"
+#include "SharedLibrary.h"
 #include "SolverStatus.h"
 
 using GetNameFunc = const char *(*)();
@@ -11,6 +18,12 @@ using GetNumberOfEquationsFunc = int (*)();
 
 namespace NStandard {
 
+// Where the code of a loaded library runs
+enum class LibraryMode {
+  IN_PROCESS,  // loaded into this process
+  ISOLATED     // in ean-worker processes, see IsolatedLibrary
+};
+
 struct SolverResult {
   SolverStatus status;
   int iterations;
@@ -18,15 +31,61 @@ struct SolverResult {
   std::string errorMessage;
 };
 
+struct SolverResultMP {
+  SolverStatus status;
+  int iterations;
+  int precision;
+  NMultiprecision::Vector solution;
+  std::string errorMessage;
+};
+
 class Solver {
  public:
   Solver();
 
-  // Load user-defined functions from a shared library
-  bool loadLibrary(std::string libraryPath);
+  // Load user-defined functions from a shared library. An isolated library
+  // cannot crash this process and has no multiprecision entry points.
+  bool loadLibrary(std::string libraryPath,
+                   LibraryMode mode = LibraryMode::IN_PROCESS);
+
+  // Use a system typed as equations instead of a library, see
+  // ExpressionSystem for the syntax
+  bool loadExpressions(const std::string &source,
+                       const std::string &name = "");
 
   // Solve the system with the loaded functions
-  SolverResult solve(Vector &x, int maxIterations, Val epsilon);
+  SolverResult solve(Vector &x, int maxIterations, Val epsilon,
+                     Globalization globalization = Globalization::NONE);
+
+  // Solve every guess of xs, replaced by its result. Libraries with the
+  // entries of LibraryInterfaceBatch.h take all guesses through Newton's
+  // method in double together and refine the solutions in long double
+  // (see NewtonSystemBatch.h); guesses that fail there, and all guesses of
+  // other libraries, are solved one by one with globalization.
+  std::vector<SolverResult> solveBatch(
+      std::vector<Vector> &xs, int maxIterations, Val epsilon,
+      Globalization globalization = Globalization::NONE);
+
+  // Solve with precision escalation from double up to maxPrecision bits
+  SolverResultMP solveMultiprecision(NMultiprecision::Vector &x,
+                                     int maxIterations,
+                                     const mpfr::mpreal &epsilon,
+                                     int maxPrecision);
+
+  // Check if the library exports the multiprecision entry points
+  bool hasMultiprecision() const;
+
+  // Check if the library exports the Jacobian products of
+  // LibraryInterfaceProducts.h
+  bool hasProducts() const;
+
+  // Check if the library exports the batch entries of
+  // LibraryInterfaceBatch.h
+  bool hasBatch() const;
+
+  // result = J(x) v and result = w^T J(x), 1-based; false without products
+  bool jacobianVector(const Vector &x, const Vector &v, Vector &result);
+  bool vectorJacobian(const Vector &x, const Vector &w, Vector &result);
 
   // Get the last error message
   std::string getLastError() const;
@@ -41,8 +100,17 @@ class Solver {
  private:
   FunctionTypeC evaluateFunction;
   DerivativeTypeC evaluateDerivatives;
+  NMultiprecision::FunctionTypeC evaluateFunctionMP;
+  NMultiprecision::DerivativeTypeC evaluateDerivativesMP;
+  ProductTypeC evaluateJacobianVector;
+  ProductTypeC evaluateVectorJacobian;
+  BatchFunctionTypeC evaluateSystemBatch;
+  BatchJacobianTypeC evaluateJacobianBatch;
   GetNameFunc getName;
   GetNumberOfEquationsFunc getNumberOfEquations;
+  SharedLibrary library;
+  std::unique_ptr<IsolatedLibrary> isolated;
+  std::shared_ptr<const ExpressionSystem> expressions;
   bool functionsLoaded;
   std::string lastError;
 };
@@ -3,7 +3,10 @@
 
 #include <string>
 
+#include "./BoxSearch.h"
+#include "./KrawczykSystem.h"
 #include "./NewtonSystemInterval.h"
+#include "SharedLibrary.h"
 #include "SolverStatus.h"
 
 namespace NInterval {
@@ -16,6 +19,8 @@ struct SolverResult {
   int iterations;
   Vector solution;
   std::string errorMessage;
+  // Set by verify() when the solution box provably holds a unique root
+  bool unique;
 };
 
 class Solver {
@@ -26,7 +31,23 @@ class Solver {
   bool loadLibrary(std::string libraryPath);
 
   // Solve the system with the loaded functions
-  SolverResult solve(Vector &x, int maxIterations, ValInterval epsilon);
+  SolverResult solve(Vector &x, int maxIterations, ValInterval epsilon,
+                     LinearSolver linearSolver = LinearSolver::GAUSS);
+
+  // Contract the box x with an interval Newton operator and try to prove
+  // that it contains a unique root
+  SolverResult verify(Vector &x, int maxIterations, ValInterval epsilon,
+                      Contractor method);
+
+  // Enumerate all roots in the box x by parallel branch and prune
+  BoxSearchResult search(const Vector &x, const BoxSearchOptions &options);
+
+  // Arithmetic configuration used by solve, verify and search. It is
+  // installed on the calling thread (and on the search workers) for the
+  // duration of each call, so solvers with different settings can run
+  // concurrently on different threads.
+  void setContext(const interval_arithmetic::IAContext &context);
+  interval_arithmetic::IAContext getContext() const;
 
   // Get the last error message
   std::string getLastError() const;
@@ -43,8 +64,10 @@ class Solver {
   DerivativeTypeC evaluateDerivatives;
   GetNameFunc getName;
   GetNumberOfEquationsFunc getNumberOfEquations;
+  SharedLibrary library;
   bool functionsLoaded;
   std::string lastError;
+  interval_arithmetic::IAContext context;
 };
 }  // namespace NInterval
 #endif  // SOLVER_INTERVAL_H
\ No newline at end of file
@@ -8,6 +8,30 @@ enum class SolverStatus {
   SINGULAR_MATRIX = 2,
   MAX_ITERATIONS_EXCEEDED = 3,
   LIBRARY_ERROR = 4,
-  FUNCTION_NOT_LOADED = 5
+  FUNCTION_NOT_LOADED = 5,
+  NO_ROOT = 6,
+  PRECISION_EXHAUSTED = 7
 };
+
+inline const char *SolverStatusName(SolverStatus status) {
+  switch (status) {
+    case SolverStatus::SUCCESS:
+      return "SUCCESS";
+    case SolverStatus::INVALID_INPUT:
+      return "INVALID_INPUT";
+    case SolverStatus::SINGULAR_MATRIX:
+      return "SINGULAR_MATRIX";
+    case SolverStatus::MAX_ITERATIONS_EXCEEDED:
+      return "MAX_ITERATIONS_EXCEEDED";
+    case SolverStatus::LIBRARY_ERROR:
+      return "LIBRARY_ERROR";
+    case SolverStatus::FUNCTION_NOT_LOADED:
+      return "FUNCTION_NOT_LOADED";
+    case SolverStatus::NO_ROOT:
+      return "NO_ROOT";
+    case SolverStatus::PRECISION_EXHAUSTED:
+      return "PRECISION_EXHAUSTED";
+  }
+  return "UNKNOWN";
+}
 #endif  // __SOLVERSTATUS_H__
\ No newline at end of file
@@ -0,0 +1,533 @@
+#ifndef __TAPE_H__
+#define __TAPE_H__
+
+#include <math.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+// Reverse mode automatic differentiation.
+//
+// A Tape records the operations a function template performs when it is
+// evaluated on Reverse<T> variables: residuals f[1..m] of x[1..n]. One
+// reverse sweep over the recording gives a vector-Jacobian product w^T J,
+// one forward sweep a Jacobian-vector product J v, each at a small
+// constant multiple of the cost of evaluating the residuals, whatever n
+// and m are; a full Jacobian takes m reverse sweeps (or n forward ones).
+//
+// The recording can be replayed at another point without running the
+// function again, as long as it takes the same path: comparisons between
+// variables are recorded and replay() fails if one of them now comes out
+// differently. evaluate() records again in that case. Branches on
+// anything but the variables (the residual index, global state) must not
+// change between recordings. Operations are kept in arrays that are
+// reused by every recording, so once a tape has grown to the size of the
+// function it no longer allocates.
+//
+// T is long double or double. Not thread-safe; use a tape per thread.
+namespace NAutoDiff {
+
+template <typename T>
+class Tape;
+
+// A value on the active tape, or a constant (index -1)
+template <typename T>
+class Reverse {
+ public:
+  T value;
+  int index;
+
+  Reverse() : value(), index(-1) {}
+  Reverse(const T &v) : value(v), index(-1) {}
+  template <typename S, typename = typename std::enable_if<
+                            std::is_arithmetic<S>::value>::type>
+  Reverse(S c) : value(static_cast<T>(c)), index(-1) {}
+
+  Reverse &operator+=(const Reverse &y) { return *this = *this + y; }
+  Reverse &operator-=(const Reverse &y) { return *this = *this - y; }
+  Reverse &operator*=(const Reverse &y) { return *this = *this * y; }
+  Reverse &operator/=(const Reverse &y) { return *this = *this / y; }
+};
+
+template <typename T>
+class Tape {
+ public:
+  enum class Op : uint8_t {
+    INPUT,
+    ADD,
+    SUB,
+    MUL,
+    DIV,
+    NEG,
+    SQR,
+    POW,
+    SIN,
+    COS,
+    TAN,
+    ASIN,
+    ACOS,
+    ATAN,
+    SINH,
+    COSH,
+    TANH,
+    EXP,
+    LOG,
+    SQRT,
+    ABS
+  };
+  enum class Comparison : uint8_t { LESS, LESS_EQUAL };
+
+  Tape() : n(0), m(0), recorded(false) {}
+
+  // Records f(i, x) for i = 1..m at x[1..n], both 1-based
+  template <typename F>
+  void record(int n, int m, const T *x, const F &f);
+
+  // Runs the recording at x; false if it took another path there
+  bool replay(const T *x);
+
+  // Replays the recording if it is of the same size and still valid at x,
+  // and records f otherwise
+  template <typename F>
+  void evaluate(int n, int m, const T *x, const F &f) {
+    if (!recorded || n != this->n || m != this->m || !replay(x)) {
+      record(n, m, x, f);
+    }
+  }
+
+  int inputs() const { return n; }
+  int outputs() const { return m; }
+  int operations() const { return static_cast<int>(nodes.size()) - n; }
+
+  // f[i] at the recorded or replayed point
+  T value(int i) const { return Value(results[i - 1]); }
+
+  // result[1..m] = J v[1..n]
+  void jacobianVector(const T *v, T *result);
+
+  // result[1..n] = w[1..m]^T J
+  void vectorJacobian(const T *w, T *result);
+
+  // row[1..n] = row i of J
+  void gradient(int i, T *row);
+
+  // jacobian[(i - 1) * n + j - 1] = df_i/dx_j, by m reverse sweeps
+  void jacobian(T *jacobian);
+
+  // Appends an operation on a and b (or the constant c in place of a
+  // constant operand) and returns its result; constants are folded
+  static Reverse<T> Push(Op op, const Reverse<T> &a, const Reverse<T> &b,
+                         const T &c = T());
+  static bool Compare(Comparison comparison, const Reverse<T> &a,
+                      const Reverse<T> &b);
+
+ private:
+  struct Node {
+    Op op;
+    int32_t a;  // operands, -1 for the constant
+    int32_t b;
+    T constant;
+    T value;
+    T da;  // partial derivatives of value by a and b
+    T db;
+  };
+
+  struct Guard {
+    Comparison comparison;
+    int32_t a;
+    int32_t b;
+    T constant;
+    bool result;
+  };
+
+  // Value and partial derivatives of node from its operands
+  static void Apply(Node &node, const T &a, const T &b);
+  static bool Holds(Comparison comparison, const T &a, const T &b) {
+    return comparison == Comparison::LESS ? a < b : a <= b;
+  }
+
+  T operand(int32_t index, const T &constant) const {
+    return index >= 0 ? nodes[index].value : constant;
+  }
+  T Value(const Reverse<T> &result) const {
+    return result.index >= 0 ? nodes[result.index].value : result.value;
+  }
+
+  // The tape recording on this thread
+  static Tape *&Active() {
+    static thread_local Tape *active = nullptr;
+    return active;
+  }
+
+  int n;
+  int m;
+  bool recorded;
+  std::vector<Node> nodes;
+  std::vector<Guard> guards;
+  std::vector<Reverse<T>> results;
+  std::vector<Reverse<T>> variables;
+  std::vector<T> adjoints;
+};
+
+template <typename T>
+template <typename F>
+void Tape<T>::record(int n, int m, const T *x, const F &f) {
+  this->n = n;
+  this->m = m;
+  nodes.clear();
+  guards.clear();
+  results.clear();
+  variables.assign(n + 1, Reverse<T>());
+  for (int j = 1; j <= n; j++) {
+    Node node = {Op::INPUT, -1, -1, T(), x[j], T(), T()};
+    nodes.push_back(node);
+    variables[j].value = x[j];
+    variables[j].index = j - 1;
+  }
+  Tape *previous = Active();
+  Active() = this;
+  for (int i = 1; i <= m; i++) {
+    results.push_back(f(i, static_cast<const Reverse<T> *>(&variables[0])));
+  }
+  Active() = previous;
+  recorded = true;
+}
+
+template <typename T>
+bool Tape<T>::replay(const T *x) {
+  for (int j = 0; j < n; j++) {
+    nodes[j].value = x[j + 1];
+  }
+  for (size_t k = n; k < nodes.size(); k++) {
+    Node &node = nodes[k];
+    Apply(node, operand(node.a, node.constant),
+          operand(node.b, node.constant));
+  }
+  for (const Guard &guard : guards) {
+    if (Holds(guard.comparison, operand(guard.a, guard.constant),
+              operand(guard.b, guard.constant)) != guard.result) {
+      recorded = false;
+      return false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+void Tape<T>::jacobianVector(const T *v, T *result) {
+  // The adjoint array holds the tangents on the way forward
+  adjoints.resize(nodes.size());
+  for (int j = 0; j < n; j++) {
+    adjoints[j] = v[j + 1];
+  }
+  for (size_t k = n; k < nodes.size(); k++) {
+    const Node &node = nodes[k];
+    T tangent = T();
+    if (node.a >= 0) {
+      tangent += node.da * adjoints[node.a];
+    }
+    if (node.b >= 0) {
+      tangent += node.db * adjoints[node.b];
+    }
+    adjoints[k] = tangent;
+  }
+  for (int i = 0; i < m; i++) {
+    result[i + 1] = results[i].index >= 0 ? adjoints[results[i].index] : T();
+  }
+}
+
+template <typename T>
+void Tape<T>::vectorJacobian(const T *w, T *result) {
+  adjoints.assign(nodes.size(), T());
+  for (int i = 0; i < m; i++) {
+    if (results[i].index >= 0) {
+      adjoints[results[i].index] += w[i + 1];
+    }
+  }
+  for (size_t k = nodes.size(); k-- > static_cast<size_t>(n);) {
+    const Node &node = nodes[k];
+    T adjoint = adjoints[k];
+    if (adjoint == 0) {
+      continue;
+    }
+    if (node.a >= 0) {
+      adjoints[node.a] += node.da * adjoint;
+    }
+    if (node.b >= 0) {
+      adjoints[node.b] += node.db * adjoint;
+    }
+  }
+  for (int j = 0; j < n; j++) {
+    result[j + 1] = adjoints[j];
+  }
+}
+
+template <typename T>
+void Tape<T>::gradient(int i, T *row) {
+  std::vector<T> w(m + 1, T());
+  w[i] = 1;
+  vectorJacobian(&w[0], row);
+}
+
+template <typename T>
+void Tape<T>::jacobian(T *jacobian) {
+  std::vector<T> w(m + 1, T()), row(n + 1);
+  for (int i = 1; i <= m; i++) {
+    w[i] = 1;
+    vectorJacobian(&w[0], &row[0]);
+    w[i] = 0;
+    for (int j = 1; j <= n; j++) {
+      jacobian[(i - 1) * n + j - 1] = row[j];
+    }
+  }
+}
+
+template <typename T>
+void Tape<T>::Apply(Node &node, const T &a, const T &b) {
+  using std::abs;
+  using std::acos;
+  using std::asin;
+  using std::atan;
+  using std::cos;
+  using std::cosh;
+  using std::exp;
+  using std::log;
+  using std::pow;
+  using std::sin;
+  using std::sinh;
+  using std::sqrt;
+  using std::tan;
+  using std::tanh;
+  T &v = node.value;
+  switch (node.op) {
+    case Op::INPUT:
+      break;
+    case Op::ADD:
+      v = a + b;
+      node.da = 1;
+      node.db = 1;
+      break;
+    case Op::SUB:
+      v = a - b;
+      node.da = 1;
+      node.db = -1;
+      break;
+    case Op::MUL:
+      v = a * b;
+      node.da = b;
+      node.db = a;
+      break;
+    case Op::DIV:
+      v = a / b;
+      node.da = 1 / b;
+      node.db = -v / b;
+      break;
+    case Op::NEG:
+      v = -a;
+      node.da = -1;
+      break;
+    case Op::SQR:
+      v = a * a;
+      node.da = 2 * a;
+      break;
+    case Op::POW:
+      // a to the constant power
+      v = pow(a, node.constant);
+      node.da = node.constant * pow(a, node.constant - 1);
+      break;
+    case Op::SIN:
+      v = sin(a);
+      node.da = cos(a);
+      break;
+    case Op::COS:
+      v = cos(a);
+      node.da = -sin(a);
+      break;
+    case Op::TAN:
+      v = tan(a);
+      node.da = 1 + v * v;
+      break;
+    case Op::ASIN:
+      v = asin(a);
+      node.da = 1 / sqrt(1 - a * a);
+      break;
+    case Op::ACOS:
+      v = acos(a);
+      node.da = -1 / sqrt(1 - a * a);
+      break;
+    case Op::ATAN:
+      v = atan(a);
+      node.da = 1 / (1 + a * a);
+      break;
+    case Op::SINH:
+      v = sinh(a);
+      node.da = cosh(a);
+      break;
+    case Op::COSH:
+      v = cosh(a);
+      node.da = sinh(a);
+      break;
+    case Op::TANH:
+      v = tanh(a);
+      node.da = 1 - v * v;
+      break;
+    case Op::EXP:
+      v = exp(a);
+      node.da = v;
+      break;
+    case Op::LOG:
+      v = log(a);
+      node.da = 1 / a;
+      break;
+    case Op::SQRT:
+      v = sqrt(a);
+      node.da = 1 / (2 * v);
+      break;
+    case Op::ABS:
+      // The derivative at 0 is taken as 0
+      v = abs(a);
+      node.da = (a > 0) - (a < 0);
+      break;
+  }
+}
+
+template <typename T>
+Reverse<T> Tape<T>::Push(Op op, const Reverse<T> &a, const Reverse<T> &b,
+                         const T &c) {
+  Tape *tape = Active();
+  Node node = {op, a.index, b.index, c, T(), T(), T()};
+  if (a.index < 0 && op != Op::POW) {
+    node.constant = a.value;
+  } else if (b.index < 0 && op <= Op::DIV) {
+    node.constant = b.value;
+  }
+  Apply(node, a.value, b.value);
+  // Constant operands, or evaluated outside a recording
+  if (!tape || (a.index < 0 && b.index < 0)) {
+    return Reverse<T>(node.value);
+  }
+  Reverse<T> result(node.value);
+  result.index = static_cast<int>(tape->nodes.size());
+  tape->nodes.push_back(node);
+  return result;
+}
+
+template <typename T>
+bool Tape<T>::Compare(Comparison comparison, const Reverse<T> &a,
+                      const Reverse<T> &b) {
+  bool result = Holds(comparison, a.value, b.value);
+  Tape *tape = Active();
+  if (tape && (a.index >= 0 || b.index >= 0)) {
+    Guard guard = {comparison, a.index, b.index,
+                   a.index < 0 ? a.value : b.value, result};
+    tape->guards.push_back(guard);
+  }
+  return result;
+}
+
+namespace detail {
+
+template <typename T>
+using Op = typename Tape<T>::Op;
+
+template <typename S>
+using IfArithmetic =
+    typename std::enable_if<std::is_arithmetic<S>::value, int>::type;
+}  // namespace detail
+
+#define EAN_REVERSE_BINARY(symbol, OP)                                    \
+  template <typename T>                                                   \
+  inline Reverse<T> operator symbol(const Reverse<T> &a,                  \
+                                    const Reverse<T> &b) {                \
+    return Tape<T>::Push(detail::Op<T>::OP, a, b);                        \
+  }                                                                       \
+  template <typename T, typename S, detail::IfArithmetic<S> = 0>          \
+  inline Reverse<T> operator symbol(const Reverse<T> &a, S c) {           \
+    return Tape<T>::Push(detail::Op<T>::OP, a, Reverse<T>(c));            \
+  }                                                                       \
+  template <typename T, typename S, detail::IfArithmetic<S> = 0>          \
+  inline Reverse<T> operator symbol(S c, const Reverse<T> &b) {           \
+    return Tape<T>::Push(detail::Op<T>::OP, Reverse<T>(c), b);            \
+  }
+
+EAN_REVERSE_BINARY(+, ADD)
+EAN_REVERSE_BINARY(-, SUB)
+EAN_REVERSE_BINARY(*, MUL)
+EAN_REVERSE_BINARY(/, DIV)
+#undef EAN_REVERSE_BINARY
+
+template <typename T>
+inline Reverse<T> operator+(const Reverse<T> &x) {
+  return x;
+}
+
+template <typename T>
+inline Reverse<T> operator-(const Reverse<T> &x) {
+  return Tape<T>::Push(detail::Op<T>::NEG, x, Reverse<T>());
+}
+
+#define EAN_REVERSE_UNARY(name, OP)                                     \
+  template <typename T>                                                 \
+  inline Reverse<T> name(const Reverse<T> &x) {                         \
+    return Tape<T>::Push(detail::Op<T>::OP, x, Reverse<T>());           \
+  }
+
+EAN_REVERSE_UNARY(sqr, SQR)
+EAN_REVERSE_UNARY(sin, SIN)
+EAN_REVERSE_UNARY(cos, COS)
+EAN_REVERSE_UNARY(tan, TAN)
+EAN_REVERSE_UNARY(asin, ASIN)
+EAN_REVERSE_UNARY(acos, ACOS)
+EAN_REVERSE_UNARY(atan, ATAN)
+EAN_REVERSE_UNARY(sinh, SINH)
+EAN_REVERSE_UNARY(cosh, COSH)
+EAN_REVERSE_UNARY(tanh, TANH)
+EAN_REVERSE_UNARY(exp, EXP)
+EAN_REVERSE_UNARY(log, LOG)
+EAN_REVERSE_UNARY(sqrt, SQRT)
+EAN_REVERSE_UNARY(abs, ABS)
+#undef EAN_REVERSE_UNARY
+
+template <typename T, typename S, detail::IfArithmetic<S> = 0>
+inline Reverse<T> pow(const Reverse<T> &x, S c) {
+  return Tape<T>::Push(detail::Op<T>::POW, x, Reverse<T>(),
+                       static_cast<T>(c));
+}
+
+// Comparisons are recorded so that replays can check the path
+template <typename T>
+inline bool operator<(const Reverse<T> &a, const Reverse<T> &b) {
+  return Tape<T>::Compare(Tape<T>::Comparison::LESS, a, b);
+}
+template <typename T>
+inline bool operator<=(const Reverse<T> &a, const Reverse<T> &b) {
+  return Tape<T>::Compare(Tape<T>::Comparison::LESS_EQUAL, a, b);
+}
+template <typename T>
+inline bool operator>(const Reverse<T> &a, const Reverse<T> &b) {
+  return b < a;
+}
+template <typename T>
+inline bool operator>=(const Reverse<T> &a, const Reverse<T> &b) {
+  return b <= a;
+}
+template <typename T, typename S, detail::IfArithmetic<S> = 0>
+inline bool operator<(const Reverse<T> &a, S c) {
+  return a < Reverse<T>(c);
+}
+template <typename T, typename S, detail::IfArithmetic<S> = 0>
+inline bool operator<=(const Reverse<T> &a, S c) {
+  return a <= Reverse<T>(c);
+}
+template <typename T, typename S, detail::IfArithmetic<S> = 0>
+inline bool operator>(const Reverse<T> &a, S c) {
+  return Reverse<T>(c) < a;
+}
+template <typename T, typename S, detail::IfArithmetic<S> = 0>
+inline bool operator>=(const Reverse<T> &a, S c) {
+  return Reverse<T>(c) <= a;
+}
+}  // namespace NAutoDiff
+#endif  // __TAPE_H__
@@ -0,0 +1,420 @@
+#ifndef __VECTORMATH_H__
+#define __VECTORMATH_H__
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "./Pack.h"
+
+// sin, cos, exp, log, pow and tanh of double packs, vectorised.
+//
+// The functions of Pack.h call the scalar library once per lane, which
+// the compiler cannot vectorise. These evaluate every lane with the same
+// branch-free instruction sequence instead (argument reduction,
+// polynomial, reconstruction through the exponent bits), so the loop over
+// the lanes becomes SSE2, AVX2 or AVX-512 code depending on the target the
+// caller is compiled for. Results are within 2 ulp of the exact ones.
+//
+// The kernels are the classic ones: Cody-Waite reduction by ln 2 and a
+// Taylor polynomial for exp, the fdlibm rational approximation for log,
+// reduction by pi/2 to 152 bits with the fdlibm sine and cosine kernels,
+// and for pow a double-double logarithm so that y log x keeps the
+// accuracy exp needs. sin and cos of arguments beyond 2^19 pi/2, and pow
+// of non-positive or non-finite x or huge y, are left to the scalar
+// library, lane by lane; so are NaNs and infinities there.
+// The lane functions have to be inlined into the loops over the lanes for
+// those to be vectorised, which their size would otherwise prevent
+#ifdef __GNUC__
+#define EAN_LANE_INLINE inline __attribute__((always_inline))
+#else
+#define EAN_LANE_INLINE inline
+#endif
+
+namespace NSimd {
+namespace detail {
+
+EAN_LANE_INLINE uint64_t Bits(double x) {
+  uint64_t u;
+  memcpy(&u, &x, sizeof(u));
+  return u;
+}
+
+EAN_LANE_INLINE double FromBits(uint64_t u) {
+  double x;
+  memcpy(&x, &u, sizeof(x));
+  return x;
+}
+
+// c ? a : b without a branch. Compilers keep a conditional expression as a
+// branch when one side could raise a floating point exception, and a loop
+// with branches is not vectorised.
+EAN_LANE_INLINE double Select(bool c, double a, double b) {
+  uint64_t mask = 0 - static_cast<uint64_t>(c);
+  return FromBits((Bits(a) & mask) | (Bits(b) & ~mask));
+}
+
+// 1.5 * 2^52: adding it rounds to an integer kept in the low mantissa bits
+const double ROUNDER = 6755399441055744.0;
+const uint64_t ROUNDER_BITS = 0x4338000000000000ULL;
+
+// 2^k for -1022 <= k <= 1023
+EAN_LANE_INLINE double Power2(int64_t k) {
+  return FromBits(static_cast<uint64_t>(k + 1023) << 52);
+}
+
+// A small integer k as a double, without a conversion instruction (AVX2
+// has none from 64-bit integers)
+EAN_LANE_INLINE double ToDouble(int64_t k) {
+  return FromBits(ROUNDER_BITS + static_cast<uint64_t>(k)) - ROUNDER;
+}
+
+// Unevaluated sum hi + lo
+struct DoubleDouble {
+  double hi, lo;
+};
+
+EAN_LANE_INLINE DoubleDouble TwoSum(double a, double b) {
+  double s = a + b;
+  double bb = s - a;
+  return {s, (a - (s - bb)) + (b - bb)};
+}
+
+// For |a| >= |b|
+EAN_LANE_INLINE DoubleDouble FastTwoSum(double a, double b) {
+  double s = a + b;
+  return {s, b - (s - a)};
+}
+
+// a b to about 2^-104 relative, for |a|, |b| well below 2^996. Without
+// FMA the factors are split by masking off their low 27 bits rather than
+// by Dekker's multiplication, which compilers fuse (and break) on targets
+// that do have it
+EAN_LANE_INLINE DoubleDouble TwoProduct(double a, double b) {
+  double p = a * b;
+#ifdef FP_FAST_FMA
+  return {p, std::fma(a, b, -p)};
+#else
+  const uint64_t HIGH = 0xFFFFFFFFF8000000ULL;
+  double ah = FromBits(Bits(a) & HIGH), al = a - ah;
+  double bh = FromBits(Bits(b) & HIGH), bl = b - bh;
+  return {p, ((ah * bh - p) + ah * bl + al * bh) + al * bl};
+#endif
+}
+
+EAN_LANE_INLINE DoubleDouble Add(const DoubleDouble &a, const DoubleDouble &b) {
+  DoubleDouble s = TwoSum(a.hi, b.hi);
+  return FastTwoSum(s.hi, s.lo + a.lo + b.lo);
+}
+
+EAN_LANE_INLINE DoubleDouble Multiply(const DoubleDouble &a,
+                                      const DoubleDouble &b) {
+  DoubleDouble p = TwoProduct(a.hi, b.hi);
+  return FastTwoSum(p.hi, p.lo + a.hi * b.lo + a.lo * b.hi);
+}
+
+EAN_LANE_INLINE DoubleDouble Multiply(const DoubleDouble &a, double b) {
+  DoubleDouble p = TwoProduct(a.hi, b);
+  return FastTwoSum(p.hi, p.lo + a.lo * b);
+}
+
+// e^(x + tail), |tail| small against 1
+EAN_LANE_INLINE double ExpLane(double x, double tail) {
+  const double LOG2E = 1.44269504088896338700e+00;
+  // ln 2 split so that k * LN2_HI is exact for |k| < 2^11
+  const double LN2_HI = 6.93147180369123816490e-01;
+  const double LN2_LO = 1.90821492927058770002e-10;
+  // Beyond these e^x is 0 or infinite; the clamp keeps 2^k representable
+  x = std::min(std::max(x, -746.0), 710.0);
+  double t = x * LOG2E + ROUNDER;
+  int64_t k = static_cast<int64_t>(Bits(t) - ROUNDER_BITS);
+  double kd = t - ROUNDER;
+  double r = (x - kd * LN2_HI) + (tail - kd * LN2_LO);
+  // e^r - 1 for |r| <= ln 2 / 2, Taylor to r^13
+  double q = 1.0 / 6227020800.0;
+  q = q * r + 1.0 / 479001600.0;
+  q = q * r + 1.0 / 39916800.0;
+  q = q * r + 1.0 / 3628800.0;
+  q = q * r + 1.0 / 362880.0;
+  q = q * r + 1.0 / 40320.0;
+  q = q * r + 1.0 / 5040.0;
+  q = q * r + 1.0 / 720.0;
+  q = q * r + 1.0 / 120.0;
+  q = q * r + 1.0 / 24.0;
+  q = q * r + 1.0 / 6.0;
+  q = q * r + 0.5;
+  double p = 1.0 + (r + r * r * q);
+  // 2^k in two factors, so that subnormal results round only once
+  int64_t k1 = k >> 1;
+  return p * Power2(k1) * Power2(k - k1);
+}
+
+// e^x - 1 for 0 <= x <= 40 as a double-double, accurate also near 0
+EAN_LANE_INLINE DoubleDouble Expm1Lane(double x) {
+  const double LOG2E = 1.44269504088896338700e+00;
+  const double LN2_HI = 6.93147180369123816490e-01;
+  const double LN2_LO = 1.90821492927058770002e-10;
+  double t = x * LOG2E + ROUNDER;
+  int64_t k = static_cast<int64_t>(Bits(t) - ROUNDER_BITS);
+  double kd = t - ROUNDER;
+  DoubleDouble r = TwoSum(x - kd * LN2_HI, -(kd * LN2_LO));
+  double q = 1.0 / 6227020800.0;
+  q = q * r.hi + 1.0 / 479001600.0;
+  q = q * r.hi + 1.0 / 39916800.0;
+  q = q * r.hi + 1.0 / 3628800.0;
+  q = q * r.hi + 1.0 / 362880.0;
+  q = q * r.hi + 1.0 / 40320.0;
+  q = q * r.hi + 1.0 / 5040.0;
+  q = q * r.hi + 1.0 / 720.0;
+  q = q * r.hi + 1.0 / 120.0;
+  q = q * r.hi + 1.0 / 24.0;
+  q = q * r.hi + 1.0 / 6.0;
+  q = q * r.hi + 0.5;
+  DoubleDouble p = FastTwoSum(r.hi, r.lo * (1.0 + r.hi) + r.hi * r.hi * q);
+  // 2^k (1 + p) - 1; the scaling is exact for 0 <= k <= 58
+  double scale = Power2(k);
+  return Add({scale * p.hi, scale * p.lo}, {scale - 1.0, 0.0});
+}
+
+// x = 2^k m with sqrt(1/2) <= m < sqrt(2), for finite x > 0
+EAN_LANE_INLINE void Decompose(double x, double &m, double &k) {
+  const double TWO54 = 18014398509481984.0;
+  bool subnormal = x < std::numeric_limits<double>::min();
+  uint64_t u = Bits(Select(subnormal, x * TWO54, x));
+  int64_t e = static_cast<int64_t>(u >> 52) - 1023 - (subnormal ? 54 : 0);
+  m = FromBits((u & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL);
+  bool high = m > 1.41421356237309504880;
+  m = Select(high, 0.5 * m, m);
+  k = ToDouble(e + high);
+}
+
+EAN_LANE_INLINE double LogLane(double x) {
+  const double LN2_HI = 6.93147180369123816490e-01;
+  const double LN2_LO = 1.90821492927058770002e-10;
+  const double LG1 = 6.666666666666735130e-01, LG2 = 3.999999999940941908e-01,
+               LG3 = 2.857142874366239149e-01, LG4 = 2.222219843214978396e-01,
+               LG5 = 1.818357216161805012e-01, LG6 = 1.531383769920937332e-01,
+               LG7 = 1.479819860511658591e-01;
+  double m, k;
+  Decompose(x, m, k);
+  double f = m - 1.0;
+  double s = f / (2.0 + f);
+  double z = s * s;
+  double w = z * z;
+  double t1 = w * (LG2 + w * (LG4 + w * LG6));
+  double t2 = z * (LG1 + w * (LG3 + w * (LG5 + w * LG7)));
+  double hfsq = 0.5 * f * f;
+  double r = k * LN2_HI - ((hfsq - (s * (hfsq + t1 + t2) + k * LN2_LO)) - f);
+  const double INF = std::numeric_limits<double>::infinity();
+  r = Select(x == 0, -INF, Select(x == INF, INF, r));
+  return Select(x >= 0, r, std::numeric_limits<double>::quiet_NaN());
+}
+
+// log x to about 2^-100 relative, for finite x > 0
+EAN_LANE_INLINE DoubleDouble LogDoubleDouble(double x) {
+  const DoubleDouble LN2 = {6.93147180559945286227e-01,
+                            2.31904681384629955842e-17};
+  const DoubleDouble TWO_THIRDS = {6.66666666666666629659e-01,
+                                   3.70074341541718826e-17};
+  double m, k;
+  Decompose(x, m, k);
+  // log m = 2 atanh(s), s = (m - 1) / (m + 1), |s| < 0.1716
+  double f = m - 1.0;
+  DoubleDouble d = TwoSum(m, 1.0);
+  double sh = f / d.hi;
+  DoubleDouble p = Multiply(d, sh);
+  DoubleDouble s = FastTwoSum(sh, ((f - p.hi) - p.lo) / d.hi);
+  DoubleDouble z = Multiply(s, s);
+  // 2 s + s^3 (2/3 + z (2/5 + z (2/7 + ...)))
+  double t = 2.0 / 25;
+  t = t * z.hi + 2.0 / 23;
+  t = t * z.hi + 2.0 / 21;
+  t = t * z.hi + 2.0 / 19;
+  t = t * z.hi + 2.0 / 17;
+  t = t * z.hi + 2.0 / 15;
+  t = t * z.hi + 2.0 / 13;
+  t = t * z.hi + 2.0 / 11;
+  t = t * z.hi + 2.0 / 9;
+  t = t * z.hi + 2.0 / 7;
+  t = t * z.hi + 2.0 / 5;
+  DoubleDouble series =
+      Multiply(Multiply(z, s), Add(Multiply(z, t), TWO_THIRDS));
+  DoubleDouble logm = Add({2.0 * s.hi, 2.0 * s.lo}, series);
+  return Add(Multiply(LN2, k), logm);
+}
+
+// sin and cos of r + tail, |r| <= pi/4 (the fdlibm kernels)
+EAN_LANE_INLINE double SinKernel(double x, double y) {
+  const double S1 = -1.66666666666666324348e-01,
+               S2 = 8.33333333332248946124e-03,
+               S3 = -1.98412698298579493134e-04,
+               S4 = 2.75573137070700676789e-06,
+               S5 = -2.50507602534068634195e-08,
+               S6 = 1.58969099521155010221e-10;
+  double z = x * x;
+  double v = z * x;
+  double r = S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)));
+  return x - ((z * (0.5 * y - v * r) - y) - v * S1);
+}
+
+EAN_LANE_INLINE double CosKernel(double x, double y) {
+  const double C1 = 4.16666666666666019037e-02,
+               C2 = -1.38888888888741095749e-03,
+               C3 = 2.48015872894767294178e-05,
+               C4 = -2.75573143513906633035e-07,
+               C5 = 2.08757232129817482790e-09,
+               C6 = -1.13596475577881948265e-11;
+  double z = x * x;
+  double w = z * z;
+  double r = z * (C1 + z * (C2 + z * C3)) + w * w * (C4 + z * (C5 + z * C6));
+  double hz = 0.5 * z;
+  w = 1.0 - hz;
+  return w + (((1.0 - w) - hz) + (z * r - x * y));
+}
+
+// Arguments up to this are reduced here, larger ones by the scalar library
+const double TRIG_LIMIT = 823549.6;  // 2^19 pi/2
+
+// x - q pi/2 as hi + lo and the quadrant q mod 4, for |x| <= TRIG_LIMIT
+EAN_LANE_INLINE void ReducePiOver2(double x, double &hi, double &lo,
+                                   uint64_t &q) {
+  const double TWO_OVER_PI = 6.36619772367581382433e-01;
+  // pi/2 in four pieces, the first three of 33 bits
+  const double P1 = 1.57079632673412561417e+00, P2 = 6.07710050630396597660e-11,
+               P3 = 2.02226624871116645580e-21, P4 = 8.47842766036889956997e-32;
+  double t = x * TWO_OVER_PI + ROUNDER;
+  q = Bits(t) & 3;
+  double n = t - ROUNDER;
+  // n has at most 20 bits, so the products are exact
+  DoubleDouble a = TwoSum(x - n * P1, -(n * P2));
+  DoubleDouble b = TwoSum(a.hi, -(n * P3));
+  double tail = (a.lo + b.lo) - n * P4;
+  DoubleDouble r = FastTwoSum(b.hi, tail);
+  hi = r.hi;
+  lo = r.lo;
+}
+
+EAN_LANE_INLINE double SinLane(double x) {
+  double hi, lo;
+  uint64_t q;
+  ReducePiOver2(x, hi, lo, q);
+  double v = Select(q & 1, CosKernel(hi, lo), SinKernel(hi, lo));
+  v = FromBits(Bits(v) ^ ((q & 2) << 62));
+  // The reduction turns -0 into +0
+  return Select(x == 0, x, v);
+}
+
+EAN_LANE_INLINE double CosLane(double x) {
+  double hi, lo;
+  uint64_t q;
+  ReducePiOver2(x, hi, lo, q);
+  double v = Select(q & 1, SinKernel(hi, lo), CosKernel(hi, lo));
+  return FromBits(Bits(v) ^ (((q + 1) & 2) << 62));
+}
+
+EAN_LANE_INLINE double TanhLane(double x) {
+  double a = std::abs(x);
+  // e / (e + 2) with e = e^2a - 1, the quotient corrected once
+  DoubleDouble e = Expm1Lane(std::min(2.0 * a, 40.0));
+  DoubleDouble d = Add(e, {2.0, 0.0});
+  double t = e.hi / d.hi;
+  DoubleDouble p = TwoProduct(t, d.hi);
+  t += (((e.hi - p.hi) - p.lo) + (e.lo - t * d.lo)) / d.hi;
+  // 1 once the quotient rounds to 1
+  return std::copysign(Select(a > 20.0, 1.0, t), x);
+}
+
+EAN_LANE_INLINE double PowLane(double x, double y) {
+  DoubleDouble l = Multiply(LogDoubleDouble(x), y);
+  return ExpLane(l.hi, l.lo);
+}
+
+// Lanes pow computes itself; the others go to std::pow
+EAN_LANE_INLINE bool PowInRange(double x, double y) {
+  return (x > 0) & (x <= std::numeric_limits<double>::max()) &
+         (std::abs(y) < 1e18);
+}
+}  // namespace detail
+
+template <int W>
+inline Pack<double, W> exp(const Pack<double, W> &x) {
+  Pack<double, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = detail::ExpLane(x.lane[k], 0.0);
+  }
+  return r;
+}
+
+template <int W>
+inline Pack<double, W> log(const Pack<double, W> &x) {
+  Pack<double, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = detail::LogLane(x.lane[k]);
+  }
+  return r;
+}
+
+// Lanes beyond TRIG_LIMIT, and NaNs, are redone by the scalar library
+template <int W>
+inline Pack<double, W> sin(const Pack<double, W> &x) {
+  Pack<double, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = detail::SinLane(x.lane[k]);
+  }
+  for (int k = 0; k < W; k++) {
+    if (!(std::abs(x.lane[k]) <= detail::TRIG_LIMIT)) {
+      r.lane[k] = std::sin(x.lane[k]);
+    }
+  }
+  return r;
+}
+
+template <int W>
+inline Pack<double, W> cos(const Pack<double, W> &x) {
+  Pack<double, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = detail::CosLane(x.lane[k]);
+  }
+  for (int k = 0; k < W; k++) {
+    if (!(std::abs(x.lane[k]) <= detail::TRIG_LIMIT)) {
+      r.lane[k] = std::cos(x.lane[k]);
+    }
+  }
+  return r;
+}
+
+template <int W>
+inline Pack<double, W> tanh(const Pack<double, W> &x) {
+  Pack<double, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = detail::TanhLane(x.lane[k]);
+  }
+  return r;
+}
+
+template <int W>
+inline Pack<double, W> pow(const Pack<double, W> &x,
+                           const Pack<double, W> &y) {
+  Pack<double, W> r;
+  for (int k = 0; k < W; k++) {
+    r.lane[k] = detail::PowLane(x.lane[k], y.lane[k]);
+  }
+  for (int k = 0; k < W; k++) {
+    if (!detail::PowInRange(x.lane[k], y.lane[k])) {
+      r.lane[k] = std::pow(x.lane[k], y.lane[k]);
+    }
+  }
+  return r;
+}
+
+template <int W, typename S, detail::IfScalar<S> = 0>
+inline Pack<double, W> pow(const Pack<double, W> &x, S c) {
+  return pow(x, Pack<double, W>(c));
+}
+}  // namespace NSimd
+
+#undef EAN_LANE_INLINE
+#endif  // __VECTORMATH_H__
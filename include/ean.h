@@ -0,0 +1,168 @@
+#ifndef __EAN_H__
+#define __EAN_H__
+
+/*
+ * C interface to the Newton solvers, for embedding in C, Fortran (through
+ * ISO_C_BINDING) or any other language with a C FFI.
+ *
+ * A solver is an opaque handle created for one arithmetic. Its system comes
+ * either from a shared library (the same libraries the GUI loads) or from
+ * callbacks with a user data pointer. All vectors are caller-owned and
+ * contiguous; the solver reads the initial guesses from them and writes the
+ * solutions back in place. No C++ exception crosses this interface: every
+ * function reports failures through its return value and
+ * ean_solver_last_error.
+ *
+ * Solving with one handle from several threads at once is allowed; the
+ * configuration functions must not run concurrently with a solve.
+ */
+
+#include <stddef.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#define EAN_API __declspec(dllexport)
+#else
+#define EAN_API __attribute__((visibility("default")))
+#endif
+
+/* Minor versions only add functions and trailing option fields */
+#define EAN_API_VERSION_MAJOR 1
+#define EAN_API_VERSION_MINOR 1
+#define EAN_API_VERSION \
+  ((EAN_API_VERSION_MAJOR << 16) | EAN_API_VERSION_MINOR)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct ean_solver ean_solver;
+
+/* Non-negative values are the solver statuses (same numbering as the
+ * SolverStatus enum), negative values are usage errors. */
+typedef enum {
+  EAN_SUCCESS = 0,
+  EAN_INVALID_INPUT = 1,
+  EAN_SINGULAR_MATRIX = 2,
+  EAN_MAX_ITERATIONS_EXCEEDED = 3,
+  EAN_LIBRARY_ERROR = 4,
+  EAN_FUNCTION_NOT_LOADED = 5,
+  EAN_NO_ROOT = 6,
+  EAN_PRECISION_EXHAUSTED = 7,
+  EAN_ERROR_INVALID_ARGUMENT = -1,
+  EAN_ERROR_WRONG_ARITHMETIC = -2,
+  EAN_ERROR_OUT_OF_MEMORY = -3,
+  EAN_ERROR_INTERNAL = -4
+} ean_status;
+
+typedef enum {
+  EAN_ARITHMETIC_STANDARD = 0,
+  EAN_ARITHMETIC_INTERVAL = 1
+} ean_arithmetic;
+
+typedef enum {
+  /* Newton iteration, in both arithmetics */
+  EAN_METHOD_NEWTON = 0,
+  /* Verified contraction, interval arithmetic only */
+  EAN_METHOD_KRAWCZYK = 1,
+  EAN_METHOD_HANSEN_SENGUPTA = 2,
+  /* Newton iteration with a backtracking line search or a dogleg trust
+   * region, for guesses far from a solution; standard arithmetic only.
+   * Since 1.1: rejected for solvers created with an older api_version. */
+  EAN_METHOD_LINE_SEARCH = 3,
+  EAN_METHOD_TRUST_REGION = 4
+} ean_method;
+
+typedef struct {
+  long double lo;
+  long double hi;
+} ean_interval;
+
+/* Callbacks. i is the equation number (1..n), x points to the n
+ * components and dfatx receives the n partial derivatives of equation i,
+ * both indexed from 0 in C (x(1..n) in Fortran). */
+typedef long double (*ean_function)(void *user_data, int i, int n,
+                                    const long double *x);
+typedef void (*ean_derivative)(void *user_data, int i, int n,
+                               const long double *x, long double *dfatx);
+typedef ean_interval (*ean_interval_function)(void *user_data, int i, int n,
+                                              const ean_interval *x);
+typedef void (*ean_interval_derivative)(void *user_data, int i, int n,
+                                        const ean_interval *x,
+                                        ean_interval *dfatx);
+
+typedef struct {
+  /* sizeof(ean_options) of the caller, set by ean_options_init */
+  size_t size;
+  ean_method method;
+  int max_iterations;
+  long double epsilon;
+  /* Worker threads of the batch functions, 0 = one per hardware thread.
+   * With more than one, callbacks are called concurrently and must be
+   * thread safe. */
+  int threads;
+} ean_options;
+
+/* EAN_API_VERSION of the library */
+EAN_API int ean_version(void);
+
+/* Fills options with the defaults (Newton, 10 iterations, 1e-16) */
+EAN_API void ean_options_init(ean_options *options);
+
+/* Returns NULL if api_version (pass EAN_API_VERSION) is not supported or
+ * memory is exhausted. */
+EAN_API ean_solver *ean_solver_create(int api_version,
+                                      ean_arithmetic arithmetic);
+
+EAN_API void ean_solver_destroy(ean_solver *solver);
+
+/* Takes the system from a shared library exporting evaluateFunction,
+ * evaluateDerivatives, getName and getNumberOfEquations for the solver's
+ * arithmetic. */
+EAN_API int ean_solver_load_library(ean_solver *solver, const char *path);
+
+/* Takes the system from callbacks; user_data is passed back unchanged */
+EAN_API int ean_solver_set_callbacks(ean_solver *solver, int n, ean_function f,
+                                     ean_derivative df, void *user_data);
+
+EAN_API int ean_solver_set_interval_callbacks(ean_solver *solver, int n,
+                                              ean_interval_function f,
+                                              ean_interval_derivative df,
+                                              void *user_data);
+
+EAN_API int ean_solver_set_options(ean_solver *solver,
+                                   const ean_options *options);
+
+/* Number of equations, 0 before a system is set */
+EAN_API int ean_solver_equations(const ean_solver *solver);
+
+/* Solves from the n values in x and returns the status. iterations may be
+ * NULL. */
+EAN_API int ean_solver_solve(ean_solver *solver, long double *x,
+                             int *iterations);
+
+/* Solves count systems whose initial guesses are stored one after another
+ * in x (count * n values) on the configured number of threads. status and
+ * iterations receive count values each and may be NULL. Returns
+ * EAN_SUCCESS when all guesses were processed, whatever their status. */
+EAN_API int ean_solver_solve_batch(ean_solver *solver, size_t count,
+                                   long double *x, int *status,
+                                   int *iterations);
+
+/* Interval counterparts. unique receives 1 when the verified methods prove
+ * that the box holds exactly one root, and may be NULL. */
+EAN_API int ean_solver_solve_interval(ean_solver *solver, ean_interval *x,
+                                      int *iterations, int *unique);
+
+EAN_API int ean_solver_solve_interval_batch(ean_solver *solver, size_t count,
+                                            ean_interval *x, int *status,
+                                            int *iterations, int *unique);
+
+/* Description of the last error reported on this handle. The string is a
+ * copy owned by the calling thread; the pointer stays valid until the next
+ * ean_solver_last_error call on the same thread. */
+EAN_API const char *ean_solver_last_error(const ean_solver *solver);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __EAN_H__ */
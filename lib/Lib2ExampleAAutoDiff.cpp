@@ -0,0 +1,16 @@
+#include "../include/LibraryTemplate.h"
+
+// Book example a. (see Lib2ExampleA.cpp and Lib2ExampleAInterval.cpp)
+// written once for every arithmetic, with the derivatives computed. One
+// library serves both solvers:
+// g++ -O3 -march=native -shared -fPIC
+//     -o Lib2ExampleAAutoDiff.so Lib2ExampleAAutoDiff.cpp -lmpfr -lgmp
+
+template <class T>
+T residual(int i, const T *x) {
+  if (i == 1) return 3 * x[1] - cos(x[2] * x[3]) - 0.5L;
+  if (i == 2) return sqr(x[1]) - 81 * sqr(x[2] + 0.1L) + sin(x[3]) + 1.06L;
+  return exp(-x[1] * x[2]) + 20 * x[3] + (10 * Pi<T>() - 3) / 3;
+}
+
+EAN_AUTODIFF_LIBRARY("ExampleA", 3)
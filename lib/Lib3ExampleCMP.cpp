@@ -0,0 +1,52 @@
+#include <cmath>
+
+#include "../include/LibraryInterfaceMP.h"
+
+// Book example c. with multiprecision entry points
+// g++ -shared -fPIC -o Lib3ExampleCMP.so Lib3ExampleCMP.cpp -lmpfr -lgmp
+
+extern "C" {
+FUNCTION_EXPORT long double evaluateFunction(int i, int n,
+                                             const long double *x) {
+  if (i == 1) return x[1] * x[1] + 8.0L * x[2] - 16.0L;
+  if (i == 2) return x[1] - std::exp(x[2]);
+  return 0.0L;
+}
+
+FUNCTION_EXPORT void evaluateDerivatives(int i, int n, const long double *x,
+                                         long double *dfatx) {
+  if (i == 1) {
+    dfatx[1] = 2.0L * x[1];
+    dfatx[2] = 8.0L;
+  } else if (i == 2) {
+    dfatx[1] = 1.0L;
+    dfatx[2] = -std::exp(x[2]);
+  }
+}
+
+FUNCTION_EXPORT void evaluateFunctionMP(int i, int n, const mpreal *x,
+                                        mpreal &fx) {
+  if (i == 1) {
+    fx = x[1] * x[1] + 8 * x[2] - 16;
+  } else if (i == 2) {
+    fx = x[1] - mpfr::exp(x[2]);
+  } else {
+    fx = 0;
+  }
+}
+
+FUNCTION_EXPORT void evaluateDerivativesMP(int i, int n, const mpreal *x,
+                                           mpreal *dfatx) {
+  if (i == 1) {
+    dfatx[1] = 2 * x[1];
+    dfatx[2] = 8;
+  } else if (i == 2) {
+    dfatx[1] = 1;
+    dfatx[2] = -mpfr::exp(x[2]);
+  }
+}
+
+FUNCTION_EXPORT const char *getName() { return "ExampleC"; }
+
+FUNCTION_EXPORT int getNumberOfEquations() { return 2; }
+}
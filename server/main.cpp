@@ -0,0 +1,759 @@
+// Long-running solver service. Keeps the libraries it has been asked for
+// loaded and answers SOLVE requests from local clients over a Unix domain
+// socket (see include/ServerProtocol.h). Requests for the same system that
+// arrive together are solved as one batch on a worker thread, in standard
+// arithmetic with one Solver::solveBatch call per set of parameters;
+// results are sent back as soon as their batch is done.
+
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../include/ServerProtocol.h"
+#include "../include/Solver.h"
+#include "../include/SolverInterval.h"
+
+namespace {
+
+volatile sig_atomic_t stopRequested = 0;
+
+void OnSignal(int) { stopRequested = 1; }
+
+struct Options {
+  std::string socketPath = "/tmp/ean.sock";
+  int threads = 0;
+  size_t maxBatch = 256;
+  // Runs standard arithmetic libraries in ean-worker processes
+  bool isolated = false;
+};
+
+// A library loaded through the Solver class of its arithmetic
+struct System {
+  protocol::Arithmetic arithmetic;
+  int n;
+  NStandard::Solver standard;
+  NInterval::Solver interval;
+};
+
+struct Job {
+  uint64_t client;
+  uint32_t requestId;
+  protocol::SolveRequest request;
+  // n values in standard arithmetic, n (lo, hi) pairs in interval
+  std::vector<long double> values;
+  protocol::SolveResult result;
+};
+
+struct Batch {
+  System *system;
+  std::vector<Job> jobs;
+};
+
+// Batches waiting for a worker
+class BatchQueue {
+ public:
+  void push(Batch &&batch) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      batches.push_back(std::move(batch));
+    }
+    ready.notify_one();
+  }
+
+  // Blocks until a batch is available; false once closed and drained
+  bool pop(Batch &batch) {
+    std::unique_lock<std::mutex> guard(lock);
+    ready.wait(guard, [this] { return closed || !batches.empty(); });
+    if (batches.empty()) {
+      return false;
+    }
+    batch = std::move(batches.front());
+    batches.pop_front();
+    return true;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      closed = true;
+    }
+    ready.notify_all();
+  }
+
+ private:
+  std::mutex lock;
+  std::condition_variable ready;
+  std::deque<Batch> batches;
+  bool closed = false;
+};
+
+// Finished batches, handed back to the event loop through an eventfd
+class CompletionQueue {
+ public:
+  explicit CompletionQueue(int eventFd) : eventFd(eventFd) {}
+
+  void push(Batch &&batch) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      done.push_back(std::move(batch));
+    }
+    uint64_t one = 1;
+    ssize_t written = write(eventFd, &one, sizeof(one));
+    (void)written;
+  }
+
+  void drain(std::vector<Batch> &out) {
+    uint64_t count;
+    ssize_t got = read(eventFd, &count, sizeof(count));
+    (void)got;
+    std::lock_guard<std::mutex> guard(lock);
+    out.swap(done);
+  }
+
+ private:
+  int eventFd;
+  std::mutex lock;
+  std::vector<Batch> done;
+};
+
+NStandard::Globalization StepsOf(uint32_t flags) {
+  return flags & protocol::FLAG_LINE_SEARCH
+             ? NStandard::Globalization::LINE_SEARCH
+         : flags & protocol::FLAG_TRUST_REGION
+             ? NStandard::Globalization::TRUST_REGION
+             : NStandard::Globalization::NONE;
+}
+
+// Solves standard arithmetic jobs that share their parameters with one
+// Solver::solveBatch call, which takes libraries with batch entries
+// through Newton's method in double all together
+void SolveStandard(System &system, const std::vector<Job *> &jobs) {
+  const int n = system.n;
+  const protocol::SolveRequest &request = jobs[0]->request;
+  std::vector<NStandard::Vector> xs;
+  xs.reserve(jobs.size());
+  for (Job *job : jobs) {
+    job->result = {static_cast<int32_t>(SolverStatus::LIBRARY_ERROR), 0, 0,
+                   0};
+    xs.emplace_back(n + 1, 0.0L);
+    std::copy(job->values.begin(), job->values.end(), xs.back().begin() + 1);
+  }
+  std::vector<NStandard::SolverResult> results =
+      system.standard.solveBatch(xs, request.maxIterations, request.epsilon,
+                                 StepsOf(request.flags));
+  for (size_t k = 0; k < jobs.size() && k < results.size(); k++) {
+    Job &job = *jobs[k];
+    const NStandard::SolverResult &r = results[k];
+    job.result.status = static_cast<int32_t>(r.status);
+    job.result.iterations = r.iterations;
+    if (r.solution.size() == static_cast<size_t>(n + 1)) {
+      std::copy(r.solution.begin() + 1, r.solution.end(), job.values.begin());
+    }
+  }
+}
+
+void SolveInterval(System &system, Job &job) {
+  const int n = system.n;
+  job.result = {static_cast<int32_t>(SolverStatus::LIBRARY_ERROR), 0, 0, 0};
+  NInterval::Vector x(n + 1, NInterval::ValInterval(0, 0));
+  for (int i = 0; i < n; i++) {
+    x[i + 1] = NInterval::ValInterval(job.values[2 * i], job.values[2 * i + 1]);
+  }
+  NInterval::ValInterval eps(job.request.epsilon, job.request.epsilon);
+  NInterval::SolverResult r =
+      job.request.flags & protocol::FLAG_VERIFY
+          ? system.interval.verify(x, job.request.maxIterations, eps,
+                                   NInterval::Contractor::HANSEN_SENGUPTA)
+          : system.interval.solve(x, job.request.maxIterations, eps);
+  job.result.status = static_cast<int32_t>(r.status);
+  job.result.iterations = r.iterations;
+  job.result.flags = r.unique ? protocol::FLAG_UNIQUE : 0;
+  if (r.solution.size() == static_cast<size_t>(n + 1)) {
+    for (int i = 0; i < n; i++) {
+      job.values[2 * i] = r.solution[i + 1].a;
+      job.values[2 * i + 1] = r.solution[i + 1].b;
+    }
+  }
+}
+
+bool SameParameters(const protocol::SolveRequest &p,
+                    const protocol::SolveRequest &q) {
+  return p.maxIterations == q.maxIterations && p.flags == q.flags &&
+         p.epsilon == q.epsilon;
+}
+
+void SolveBatch(Batch &batch) {
+  System &system = *batch.system;
+  if (system.arithmetic != protocol::STANDARD) {
+    for (Job &job : batch.jobs) {
+      try {
+        SolveInterval(system, job);
+      } catch (...) {
+        job.result.status = static_cast<int32_t>(SolverStatus::LIBRARY_ERROR);
+      }
+    }
+    return;
+  }
+
+  // Clients normally send one set of parameters, so this is one group
+  std::vector<bool> grouped(batch.jobs.size(), false);
+  std::vector<Job *> group;
+  for (size_t first = 0; first < batch.jobs.size(); first++) {
+    if (grouped[first]) {
+      continue;
+    }
+    group.clear();
+    for (size_t k = first; k < batch.jobs.size(); k++) {
+      if (!grouped[k] &&
+          SameParameters(batch.jobs[first].request, batch.jobs[k].request)) {
+        grouped[k] = true;
+        group.push_back(&batch.jobs[k]);
+      }
+    }
+    try {
+      SolveStandard(system, group);
+    } catch (...) {
+      for (Job *job : group) {
+        job->result.status =
+            static_cast<int32_t>(SolverStatus::LIBRARY_ERROR);
+      }
+    }
+  }
+}
+
+void Work(BatchQueue &queue, CompletionQueue &completions) {
+  Batch batch;
+  while (queue.pop(batch)) {
+    SolveBatch(batch);
+    completions.push(std::move(batch));
+  }
+}
+
+struct Client {
+  int fd;
+  std::string in;
+  std::string out;
+  size_t outOffset = 0;
+  uint32_t events = 0;
+};
+
+class Server {
+ public:
+  Server(const Options &options)
+      : options(options),
+        epollFd(-1),
+        listenFd(-1),
+        eventFd(-1),
+        nextClient(FIRST_CLIENT),
+        requests(0),
+        batches(0) {}
+
+  ~Server() {
+    for (auto &entry : clients) {
+      close(entry.second.fd);
+    }
+    if (listenFd >= 0) {
+      close(listenFd);
+      unlink(options.socketPath.c_str());
+    }
+    if (eventFd >= 0) {
+      close(eventFd);
+    }
+    if (epollFd >= 0) {
+      close(epollFd);
+    }
+  }
+
+  bool start() {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (options.socketPath.size() >= sizeof(address.sun_path)) {
+      std::fprintf(stderr, "ean-server: socket path too long\n");
+      return false;
+    }
+    std::strcpy(address.sun_path, options.socketPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+      std::perror("ean-server: socket");
+      return false;
+    }
+    // A socket file left behind by a crashed server is replaced, one that
+    // still accepts connections is not
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (connect(probe, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) == 0) {
+      close(probe);
+      close(listenFd);
+      listenFd = -1;
+      std::fprintf(stderr, "ean-server: %s is already in use\n",
+                   options.socketPath.c_str());
+      return false;
+    }
+    close(probe);
+    unlink(options.socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) < 0 ||
+        listen(listenFd, SOMAXCONN) < 0) {
+      std::perror(("ean-server: " + options.socketPath).c_str());
+      close(listenFd);
+      listenFd = -1;
+      return false;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    eventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd < 0 || eventFd < 0) {
+      std::perror("ean-server: epoll");
+      return false;
+    }
+    watch(listenFd, LISTEN_ID, EPOLLIN, EPOLL_CTL_ADD);
+    watch(eventFd, EVENT_ID, EPOLLIN, EPOLL_CTL_ADD);
+    return true;
+  }
+
+  void run() {
+    CompletionQueue completions(eventFd);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < options.threads; t++) {
+      workers.emplace_back(Work, std::ref(queue), std::ref(completions));
+    }
+    std::fprintf(stderr, "ean-server: listening on %s with %d threads\n",
+                 options.socketPath.c_str(), options.threads);
+
+    epoll_event events[64];
+    std::vector<Batch> finished;
+    while (!stopRequested) {
+      int count = epoll_wait(epollFd, events, 64, -1);
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        std::perror("ean-server: epoll_wait");
+        break;
+      }
+      for (int e = 0; e < count; e++) {
+        uint64_t id = events[e].data.u64;
+        if (id == LISTEN_ID) {
+          accept();
+        } else if (id == EVENT_ID) {
+          completions.drain(finished);
+          for (Batch &batch : finished) {
+            respond(batch);
+          }
+          finished.clear();
+        } else {
+          service(id, events[e].events);
+        }
+      }
+      dispatch();
+    }
+
+    queue.close();
+    for (auto &w : workers) {
+      w.join();
+    }
+    std::fprintf(stderr,
+                 "ean-server: %lu requests in %lu batches (%.1f per batch)\n",
+                 requests, batches,
+                 batches ? static_cast<double>(requests) / batches : 0.0);
+  }
+
+ private:
+  static const uint64_t LISTEN_ID = 0;
+  static const uint64_t EVENT_ID = 1;
+  static const uint64_t FIRST_CLIENT = 2;
+  // Stop reading from a client that does not collect its results
+  static const size_t MAX_PENDING_OUTPUT = 64 << 20;
+
+  Options options;
+  int epollFd;
+  int listenFd;
+  int eventFd;
+  uint64_t nextClient;
+  std::unordered_map<uint64_t, Client> clients;
+  std::map<std::pair<uint32_t, std::string>, uint32_t> systemIds;
+  std::vector<std::unique_ptr<System>> systems;
+  // Requests received in this round of the event loop, per system
+  std::map<uint32_t, std::vector<Job>> pending;
+  BatchQueue queue;
+  unsigned long requests;
+  unsigned long batches;
+
+  void watch(int fd, uint64_t id, uint32_t events, int op) {
+    epoll_event event;
+    event.events = events;
+    event.data.u64 = id;
+    epoll_ctl(epollFd, op, fd, &event);
+  }
+
+  void accept() {
+    int fd;
+    while ((fd = accept4(listenFd, nullptr, nullptr,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+      uint64_t id = nextClient++;
+      Client &client = clients[id];
+      client.fd = fd;
+      client.events = EPOLLIN;
+      watch(fd, id, client.events, EPOLL_CTL_ADD);
+    }
+  }
+
+  void drop(uint64_t id) {
+    auto it = clients.find(id);
+    if (it != clients.end()) {
+      close(it->second.fd);
+      clients.erase(it);
+    }
+  }
+
+  void service(uint64_t id, uint32_t events) {
+    auto it = clients.find(id);
+    if (it == clients.end()) {
+      return;
+    }
+    Client &client = it->second;
+    if (events & EPOLLOUT) {
+      if (!flush(id, client)) {
+        return;
+      }
+    }
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+      char buffer[65536];
+      ssize_t got;
+      while ((got = recv(client.fd, buffer, sizeof(buffer), 0)) > 0) {
+        client.in.append(buffer, got);
+      }
+      if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+        drop(id);
+        return;
+      }
+      if (!parse(id, client)) {
+        drop(id);
+        return;
+      }
+      flush(id, client);
+    }
+  }
+
+  // Handles every complete message in the input buffer; false on a
+  // malformed stream
+  bool parse(uint64_t id, Client &client) {
+    size_t offset = 0;
+    while (client.in.size() - offset >= sizeof(protocol::Header)) {
+      protocol::Header header;
+      std::memcpy(&header, client.in.data() + offset, sizeof(header));
+      if (!protocol::ValidHeader(header)) {
+        return false;
+      }
+      if (client.in.size() - offset - sizeof(header) < header.length) {
+        break;
+      }
+      const char *payload = client.in.data() + offset + sizeof(header);
+      if (header.type == protocol::LOAD) {
+        load(client, header.requestId, payload, header.length);
+      } else if (header.type == protocol::SOLVE) {
+        solve(id, client, header.requestId, payload, header.length);
+      } else {
+        return false;
+      }
+      offset += sizeof(header) + header.length;
+    }
+    client.in.erase(0, offset);
+    return true;
+  }
+
+  void fail(Client &client, uint32_t requestId, SolverStatus status,
+            const std::string &message) {
+    protocol::ErrorResult error = {static_cast<int32_t>(status)};
+    protocol::AppendMessage(client.out, protocol::FAILED, requestId, &error,
+                            sizeof(error), message.data(), message.size());
+  }
+
+  void load(Client &client, uint32_t requestId, const char *payload,
+            uint32_t length) {
+    protocol::LoadRequest request;
+    if (length <= sizeof(request)) {
+      fail(client, requestId, SolverStatus::INVALID_INPUT, "Missing path");
+      return;
+    }
+    std::memcpy(&request, payload, sizeof(request));
+    std::string path(payload + sizeof(request), length - sizeof(request));
+    if (request.arithmetic != protocol::STANDARD &&
+        request.arithmetic != protocol::INTERVAL) {
+      fail(client, requestId, SolverStatus::INVALID_INPUT,
+           "Unknown arithmetic");
+      return;
+    }
+
+    auto key = std::make_pair(request.arithmetic, path);
+    auto known = systemIds.find(key);
+    if (known == systemIds.end()) {
+      std::unique_ptr<System> system(new System());
+      system->arithmetic = static_cast<protocol::Arithmetic>(request.arithmetic);
+      bool loaded = system->arithmetic == protocol::STANDARD
+                        ? system->standard.loadLibrary(
+                              path, options.isolated
+                                        ? NStandard::LibraryMode::ISOLATED
+                                        : NStandard::LibraryMode::IN_PROCESS)
+                        : system->interval.loadLibrary(path);
+      if (!loaded) {
+        fail(client, requestId, SolverStatus::FUNCTION_NOT_LOADED,
+             system->arithmetic == protocol::STANDARD
+                 ? system->standard.getLastError()
+                 : system->interval.getLastError());
+        return;
+      }
+      system->n = system->arithmetic == protocol::STANDARD
+                      ? system->standard.getEquationsCount()
+                      : system->interval.getEquationsCount();
+      systems.push_back(std::move(system));
+      known = systemIds.emplace(key, systems.size()).first;
+    }
+    protocol::LoadResult result = {known->second,
+                                   systems[known->second - 1]->n};
+    protocol::AppendMessage(client.out, protocol::LOADED, requestId, &result,
+                            sizeof(result));
+  }
+
+  void solve(uint64_t id, Client &client, uint32_t requestId,
+             const char *payload, uint32_t length) {
+    Job job;
+    if (length < sizeof(job.request)) {
+      fail(client, requestId, SolverStatus::INVALID_INPUT, "Short request");
+      return;
+    }
+    std::memcpy(&job.request, payload, sizeof(job.request));
+    if (job.request.system < 1 || job.request.system > systems.size()) {
+      fail(client, requestId, SolverStatus::FUNCTION_NOT_LOADED,
+           "Unknown system");
+      return;
+    }
+    const System &system = *systems[job.request.system - 1];
+    if (!validFlags(client, requestId, system, job.request.flags)) {
+      return;
+    }
+    size_t count =
+        system.arithmetic == protocol::INTERVAL ? 2 * system.n : system.n;
+    if (length != sizeof(job.request) + count * sizeof(long double)) {
+      fail(client, requestId, SolverStatus::INVALID_INPUT,
+           "Wrong number of values");
+      return;
+    }
+    job.client = id;
+    job.requestId = requestId;
+    job.values.resize(count);
+    std::memcpy(job.values.data(), payload + sizeof(job.request),
+                count * sizeof(long double));
+    pending[job.request.system].push_back(std::move(job));
+    requests++;
+  }
+
+  // Answers FAILED for flags that the system cannot honour, as the C API
+  // rejects such methods
+  bool validFlags(Client &client, uint32_t requestId, const System &system,
+                  uint32_t flags) {
+    const uint32_t steps =
+        protocol::FLAG_LINE_SEARCH | protocol::FLAG_TRUST_REGION;
+    const char *message = nullptr;
+    if (flags & ~protocol::FLAG_SOLVE_ALL) {
+      message = "Unknown flags";
+    } else if ((flags & steps) == steps) {
+      message = "Line search and trust region exclude each other";
+    } else if ((flags & steps) && system.arithmetic != protocol::STANDARD) {
+      message = "Line search and trust region need standard arithmetic";
+    } else if ((flags & protocol::FLAG_VERIFY) &&
+               system.arithmetic != protocol::INTERVAL) {
+      message = "Verification needs interval arithmetic";
+    }
+    if (message) {
+      fail(client, requestId, SolverStatus::INVALID_INPUT, message);
+      return false;
+    }
+    return true;
+  }
+
+  // Hands the requests collected in this round to the workers, split so
+  // that all threads get a share of a large burst
+  void dispatch() {
+    for (auto &entry : pending) {
+      std::vector<Job> &jobs = entry.second;
+      size_t share = (jobs.size() + options.threads - 1) / options.threads;
+      size_t chunk = std::max<size_t>(1, std::min(options.maxBatch, share));
+      for (size_t first = 0; first < jobs.size(); first += chunk) {
+        size_t last = std::min(jobs.size(), first + chunk);
+        Batch batch;
+        batch.system = systems[entry.first - 1].get();
+        batch.jobs.assign(std::make_move_iterator(jobs.begin() + first),
+                          std::make_move_iterator(jobs.begin() + last));
+        queue.push(std::move(batch));
+        batches++;
+      }
+    }
+    pending.clear();
+  }
+
+  void respond(Batch &batch) {
+    std::vector<uint64_t> touched;
+    for (Job &job : batch.jobs) {
+      auto it = clients.find(job.client);
+      if (it == clients.end()) {
+        // The client went away while its request was being solved
+        continue;
+      }
+      protocol::AppendMessage(it->second.out, protocol::RESULT, job.requestId,
+                              &job.result, sizeof(job.result),
+                              job.values.data(),
+                              job.values.size() * sizeof(long double));
+      if (touched.empty() || touched.back() != job.client) {
+        touched.push_back(job.client);
+      }
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (uint64_t id : touched) {
+      auto it = clients.find(id);
+      if (it != clients.end()) {
+        flush(id, it->second);
+      }
+    }
+  }
+
+  // Writes as much output as the socket takes and adjusts the events the
+  // client is watched for; false if the client was dropped
+  bool flush(uint64_t id, Client &client) {
+    while (client.outOffset < client.out.size()) {
+      ssize_t sent = send(client.fd, client.out.data() + client.outOffset,
+                          client.out.size() - client.outOffset, MSG_NOSIGNAL);
+      if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+          break;
+        }
+        drop(id);
+        return false;
+      }
+      client.outOffset += sent;
+    }
+    if (client.outOffset == client.out.size()) {
+      client.out.clear();
+      client.outOffset = 0;
+    }
+    size_t backlog = client.out.size() - client.outOffset;
+    uint32_t events = 0;
+    if (backlog < MAX_PENDING_OUTPUT) {
+      events |= EPOLLIN;
+    }
+    if (backlog > 0) {
+      events |= EPOLLOUT;
+    }
+    if (events != client.events) {
+      client.events = events;
+      watch(client.fd, id, events, EPOLL_CTL_MOD);
+    }
+    return true;
+  }
+};
+
+void PrintUsage(FILE *out) {
+  std::fputs(
+      "Usage: ean-server [options]\n"
+      "\n"
+      "Serves solve requests over a Unix domain socket until SIGINT or\n"
+      "SIGTERM. The protocol is described in include/ServerProtocol.h.\n"
+      "\n"
+      "Options:\n"
+      "  -s, --socket PATH     socket path (default /tmp/ean.sock)\n"
+      "  -j, --threads N       worker threads (default: all cores)\n"
+      "  -b, --max-batch N     largest batch handed to one worker\n"
+      "                        (default 256)\n"
+      "  -I, --isolated        run standard arithmetic libraries in\n"
+      "                        separate processes, so that a crashing\n"
+      "                        library cannot take the server down\n"
+      "  -h, --help            show this help\n",
+      out);
+}
+
+bool ParseOptions(int argc, char *argv[], Options &options) {
+  static const struct option longOptions[] = {
+      {"socket", required_argument, nullptr, 's'},
+      {"threads", required_argument, nullptr, 'j'},
+      {"max-batch", required_argument, nullptr, 'b'},
+      {"isolated", no_argument, nullptr, 'I'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+  int c;
+  while ((c = getopt_long(argc, argv, "s:j:b:Ih", longOptions, nullptr)) !=
+         -1) {
+    switch (c) {
+      case 's':
+        options.socketPath = optarg;
+        break;
+      case 'j':
+        options.threads = std::atoi(optarg);
+        break;
+      case 'b':
+        options.maxBatch = static_cast<size_t>(std::max(1, std::atoi(optarg)));
+        break;
+      case 'I':
+        options.isolated = true;
+        break;
+      case 'h':
+        PrintUsage(stdout);
+        std::exit(0);
+      default:
+        return false;
+    }
+  }
+  if (optind != argc || options.threads < 0) {
+    return false;
+  }
+  if (options.threads == 0) {
+    options.threads =
+        std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage(stderr);
+    return 1;
+  }
+
+  struct sigaction action;
+  std::memset(&action, 0, sizeof(action));
+  action.sa_handler = OnSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  Server server(options);
+  if (!server.start()) {
+    return 1;
+  }
+  server.run();
+  return 0;
+}
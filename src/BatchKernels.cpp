@@ -0,0 +1,182 @@
+#include "../include/BatchKernels.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace NStandard {
+
+namespace {
+
+// Points handled together; the per-point state of a block stays on the
+// stack
+const int BLOCK = 64;
+
+// A finite, nonzero pivot
+inline bool Usable(double x) { return x != 0 && x <= DBL_MAX; }
+
+// The kernels are written once, as plain loops over the points of a block
+// free of branches so that they vectorise, and compiled for every level by
+// the wrappers below.
+inline void SolveLinearKernel(int n, int count, double *J, double *F,
+                              unsigned char *failed) {
+  for (int first = 0; first < count; first += BLOCK) {
+    const int size = std::min(BLOCK, count - first);
+    double *a = J + first;
+    double *b = F + first;
+    double bad[BLOCK], best[BLOCK], row[BLOCK], factor[BLOCK];
+    for (int q = 0; q < size; q++) {
+      bad[q] = 0;
+    }
+    for (int i = 0; i < n; i++) {
+      for (int q = 0; q < size; q++) {
+        b[i * count + q] = -b[i * count + q];
+      }
+    }
+
+    for (int k = 0; k < n; k++) {
+      double *akk = a + (k * n + k) * count;
+      for (int q = 0; q < size; q++) {
+        best[q] = std::abs(akk[q]);
+        row[q] = k;
+      }
+      for (int i = k + 1; i < n; i++) {
+        const double *aik = a + (i * n + k) * count;
+        const double candidate = i;
+        for (int q = 0; q < size; q++) {
+          double v = std::abs(aik[q]);
+          double r = row[q];
+          row[q] = v > best[q] ? candidate : r;
+          best[q] = std::max(best[q], v);
+        }
+      }
+      for (int q = 0; q < size; q++) {
+        bad[q] = Usable(best[q]) ? bad[q] : 1;
+      }
+      // Every point swaps its own pivot row into place
+      for (int i = k + 1; i < n; i++) {
+        for (int j = k; j <= n; j++) {
+          double *u = j < n ? a + (k * n + j) * count : b + k * count;
+          double *v = j < n ? a + (i * n + j) * count : b + i * count;
+          for (int q = 0; q < size; q++) {
+            bool swap = row[q] == i;
+            double x = u[q], y = v[q];
+            u[q] = swap ? y : x;
+            v[q] = swap ? x : y;
+          }
+        }
+      }
+      for (int i = k + 1; i < n; i++) {
+        double *ai = a + i * n * count;
+        const double *ak = a + k * n * count;
+        for (int q = 0; q < size; q++) {
+          factor[q] = ai[k * count + q] / akk[q];
+        }
+        for (int j = k + 1; j < n; j++) {
+          for (int q = 0; q < size; q++) {
+            ai[j * count + q] -= factor[q] * ak[j * count + q];
+          }
+        }
+        for (int q = 0; q < size; q++) {
+          b[i * count + q] -= factor[q] * b[k * count + q];
+        }
+      }
+    }
+
+    for (int k = n - 1; k >= 0; k--) {
+      for (int j = k + 1; j < n; j++) {
+        const double *akj = a + (k * n + j) * count;
+        for (int q = 0; q < size; q++) {
+          b[k * count + q] -= akj[q] * b[j * count + q];
+        }
+      }
+      const double *akk = a + (k * n + k) * count;
+      for (int q = 0; q < size; q++) {
+        b[k * count + q] /= akk[q];
+        bad[q] = std::abs(b[k * count + q]) <= DBL_MAX ? bad[q] : 1;
+      }
+    }
+    for (int i = 0; i < n; i++) {
+      for (int q = 0; q < size; q++) {
+        double v = b[i * count + q];
+        b[i * count + q] = bad[q] != 0 ? 0 : v;
+      }
+    }
+    for (int q = 0; q < size; q++) {
+      failed[first + q] = bad[q] != 0;
+    }
+  }
+}
+
+inline void UpdateKernel(int n, int count, double *x, const double *d,
+                         double eps, unsigned char *converged) {
+  for (int first = 0; first < count; first += BLOCK) {
+    const int size = std::min(BLOCK, count - first);
+    double norm[BLOCK], step[BLOCK];
+    for (int q = 0; q < size; q++) {
+      norm[q] = 0;
+      step[q] = 0;
+    }
+    for (int j = 0; j < n; j++) {
+      double *xj = x + j * count + first;
+      const double *dj = d + j * count + first;
+      for (int q = 0; q < size; q++) {
+        double x1 = xj[q] + dj[q];
+        double larger = std::max(std::abs(xj[q]), std::abs(x1));
+        norm[q] = std::max(norm[q], larger);
+        step[q] = std::max(step[q], std::abs(dj[q]));
+        xj[q] = x1;
+      }
+    }
+    for (int q = 0; q < size; q++) {
+      converged[first + q] = step[q] <= eps * norm[q];
+    }
+  }
+}
+
+// One set of wrappers per level; flatten inlines the kernels into them, so
+// that they are compiled for the wrapper's target
+#define EAN_BATCH_KERNELS(suffix, attributes)                                \
+  attributes void SolveLinear##suffix(int n, int count, double *J,           \
+                                      double *F, unsigned char *failed) {    \
+    SolveLinearKernel(n, count, J, F, failed);                               \
+  }                                                                          \
+  attributes void Update##suffix(int n, int count, double *x,                \
+                                 const double *d, double eps,                \
+                                 unsigned char *converged) {                 \
+    UpdateKernel(n, count, x, d, eps, converged);                            \
+  }
+
+EAN_BATCH_KERNELS(Baseline, __attribute__((flatten)))
+const BatchKernels BASELINE_KERNELS = {CpuLevel::BASELINE,
+                                       SolveLinearBaseline, UpdateBaseline};
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define EAN_MULTIVERSIONED
+EAN_BATCH_KERNELS(Avx2, __attribute__((target("avx2,fma"), flatten)))
+EAN_BATCH_KERNELS(Avx512, __attribute__((target("avx512f"), flatten)))
+const BatchKernels AVX2_KERNELS = {CpuLevel::AVX2, SolveLinearAvx2,
+                                   UpdateAvx2};
+const BatchKernels AVX512_KERNELS = {CpuLevel::AVX512, SolveLinearAvx512,
+                                     UpdateAvx512};
+#endif
+#undef EAN_BATCH_KERNELS
+}  // namespace
+
+const BatchKernels &GetBatchKernels(CpuLevel level) {
+#ifdef EAN_MULTIVERSIONED
+  if (level == CpuLevel::AVX512) {
+    return AVX512_KERNELS;
+  }
+  if (level == CpuLevel::AVX2) {
+    return AVX2_KERNELS;
+  }
+#endif
+  return BASELINE_KERNELS;
+}
+
+const BatchKernels &GetBatchKernels() {
+  static const BatchKernels &kernels = GetBatchKernels(ActiveCpuLevel());
+  return kernels;
+}
+}  // namespace NStandard
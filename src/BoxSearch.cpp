@@ -0,0 +1,254 @@
+#include "../include/BoxSearch.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace NInterval {
+
+namespace {
+
+// Per-thread box queue. The owner works LIFO on the back, idle threads
+// steal the oldest (largest) boxes from the front.
+struct WorkQueue {
+  std::mutex lock;
+  std::deque<Vector> boxes;
+};
+
+class BoxSearchPool {
+ public:
+  BoxSearchPool(int n, FunctionTypeC f, DerivativeTypeC df,
+                const BoxSearchOptions &options, int threads)
+      : n(n),
+        f(f),
+        df(df),
+        options(options),
+        queues(threads),
+        context(interval_arithmetic::Interval<long double>::GetContext()) {}
+
+  void run(const Vector &x, BoxSearchResult &result) {
+    pending = 1;
+    queued = 1;
+    sleeping = 0;
+    processed = 0;
+    discarded = 0;
+    queues[0].boxes.push_back(x);
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < queues.size(); t++) {
+      workers.emplace_back(&BoxSearchPool::work, this, t);
+    }
+    work(0);
+    for (auto &w : workers) {
+      w.join();
+    }
+
+    result.roots = std::move(roots);
+    result.undecided = std::move(undecided);
+    result.processed = processed;
+    result.discarded = discarded;
+  }
+
+ private:
+  int n;
+  FunctionTypeC f;
+  DerivativeTypeC df;
+  BoxSearchOptions options;
+  std::vector<WorkQueue> queues;
+  // Arithmetic context of the calling thread, replicated on every worker
+  interval_arithmetic::IAContext context;
+  std::atomic<long> pending;
+  // Boxes waiting in the queues, and workers asleep waiting for one
+  std::atomic<long> queued;
+  std::atomic<int> sleeping;
+  std::mutex idleLock;
+  std::condition_variable wake;
+  std::atomic<long> processed;
+  std::atomic<long> discarded;
+  std::mutex resultLock;
+  std::vector<Vector> roots;
+  std::vector<Vector> undecided;
+
+  bool pop(size_t self, Vector &box) {
+    {
+      std::lock_guard<std::mutex> guard(queues[self].lock);
+      if (!queues[self].boxes.empty()) {
+        box = std::move(queues[self].boxes.back());
+        queues[self].boxes.pop_back();
+        queued--;
+        return true;
+      }
+    }
+    for (size_t k = 1; k < queues.size(); k++) {
+      WorkQueue &victim = queues[(self + k) % queues.size()];
+      std::lock_guard<std::mutex> guard(victim.lock);
+      if (!victim.boxes.empty()) {
+        box = std::move(victim.boxes.front());
+        victim.boxes.pop_front();
+        queued--;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void push(size_t self, Vector &&box) {
+    pending++;
+    {
+      std::lock_guard<std::mutex> guard(queues[self].lock);
+      queues[self].boxes.push_back(std::move(box));
+      queued++;
+    }
+    signal(false);
+  }
+
+  // Sleeps until a box is queued or the search is over. The count is
+  // raised before the condition is checked and signal() reads it after
+  // changing the condition, so one of them always sees the other.
+  void idle() {
+    std::unique_lock<std::mutex> guard(idleLock);
+    sleeping++;
+    wake.wait(guard, [this] { return queued > 0 || pending == 0; });
+    sleeping--;
+  }
+
+  void signal(bool all) {
+    if (sleeping == 0) {
+      return;
+    }
+    // A worker between its check and its wait holds the lock
+    { std::lock_guard<std::mutex> guard(idleLock); }
+    if (all) {
+      wake.notify_all();
+    } else {
+      wake.notify_one();
+    }
+  }
+
+  void report(std::vector<Vector> &list, Vector &&box) {
+    std::lock_guard<std::mutex> guard(resultLock);
+    list.push_back(std::move(box));
+  }
+
+  void work(size_t self) {
+    interval_arithmetic::IAContextGuard<long double> guard(context);
+    Vector box;
+    while (pending > 0) {
+      if (!pop(self, box)) {
+        idle();
+        continue;
+      }
+      try {
+        process(self, box);
+      } catch (const std::exception &) {
+        // The library could not evaluate the box, e.g. a division by an
+        // interval containing zero
+        report(undecided, std::move(box));
+      }
+      if (--pending == 0) {
+        signal(true);
+      }
+    }
+  }
+
+  void process(size_t self, Vector &box) {
+    long count = ++processed;
+
+    // Prune the box if some residual provably has no zero in it
+    for (int k = 1; k <= n; k++) {
+      ValInterval r = f(k, n, &box[0]);
+      if (r.a > 0 || r.b < 0) {
+        discarded++;
+        return;
+      }
+    }
+
+    int it = 0;
+    int st = 0;
+    bool unique = false;
+    Vector other;
+    KrawczykSystem(n, box, f, df, options.method, options.contractIterations,
+                   options.eps, it, st, unique, &other);
+    if (st == 4) {
+      discarded++;
+      return;
+    }
+    if (st == 5) {
+      // Extended division removed a gap from the box
+      push(self, std::move(other));
+      push(self, std::move(box));
+      return;
+    }
+    if (unique) {
+      report(roots, std::move(box));
+      return;
+    }
+
+    int widest = 1;
+    long double width = 0;
+    for (int i = 1; i <= n; i++) {
+      long double w = IntWidth(box[i]);
+      if (w > width) {
+        width = w;
+        widest = i;
+      }
+    }
+    if (width < options.minWidth || count >= options.maxBoxes) {
+      report(undecided, std::move(box));
+      return;
+    }
+
+    // Split slightly off-centre so that roots at "round" coordinates such
+    // as 0 do not land on a face, where they can never be verified
+    Vector upper = box;
+    long double mid = box[widest].a + width * 0.4921875L;
+    box[widest].b = mid;
+    upper[widest].a = mid;
+    push(self, std::move(upper));
+    push(self, std::move(box));
+  }
+};
+
+}  // namespace
+
+/**
+ * Encloses all solutions of a system of n nonlinear equations
+ * f[i](x[1],x[2],...,x[n])=0 (i=1,2,...,n) lying in the box x by branch and
+ * prune: boxes whose residual enclosure excludes zero are discarded, the
+ * others are contracted with an interval Newton operator and bisected
+ * along their widest component until a unique root is proven or the box
+ * becomes narrower than options.minWidth. Boxes are distributed over a
+ * work-stealing thread pool.
+ *
+ * @param n Number of equations
+ * @param x Initial box
+ * @param f Function that calculates the value of function f[i]
+ * @param df Function that calculates the derivatives df[i]/dx[j] (j=1,2,...,n)
+ * @param options Search parameters
+ * @return Verified root boxes, undecided boxes and throughput counters
+ */
+BoxSearchResult BoxSearch(int n, const Vector &x, FunctionTypeC f,
+                          DerivativeTypeC df, const BoxSearchOptions &options) {
+  BoxSearchResult result;
+  if (n < 1) {
+    return result;
+  }
+
+  int threads = options.threads;
+  if (threads < 1) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  BoxSearchPool pool(n, f, df, options, threads);
+  pool.run(x, result);
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+}  // namespace NInterval
@@ -0,0 +1,527 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "../include/KrawczykSystem.h"
+#include "../include/NewtonSystem.h"
+#include "../include/NewtonSystemInterval.h"
+#include "../include/SharedLibrary.h"
+#include "../include/ean.h"
+
+using NInterval::ValInterval;
+
+struct ean_solver {
+  ean_arithmetic arithmetic;
+  // Minor version of the interface the caller was built against
+  int apiMinor;
+  ean_options options;
+  int n;
+  SharedLibrary library;
+  // The system in the calling convention of the cores: either resolved from
+  // the library or the trampolines that forward to the callbacks below
+  NStandard::FunctionTypeC f;
+  NStandard::DerivativeTypeC df;
+  NInterval::FunctionTypeC intervalF;
+  NInterval::DerivativeTypeC intervalDf;
+  ean_function userF;
+  ean_derivative userDf;
+  ean_interval_function userIntervalF;
+  ean_interval_derivative userIntervalDf;
+  void *userData;
+  interval_arithmetic::IAContext context;
+  // Batch workers report exceptions from the system here
+  mutable std::mutex errorLock;
+  std::string lastError;
+};
+
+namespace {
+
+// Solver whose callbacks are being evaluated on this thread. The cores take
+// plain function pointers, so the user data travels through this variable.
+thread_local const ean_solver *current = nullptr;
+
+class CurrentSolver {
+ public:
+  explicit CurrentSolver(const ean_solver *solver) : saved(current) {
+    current = solver;
+  }
+  ~CurrentSolver() { current = saved; }
+
+ private:
+  const ean_solver *saved;
+};
+
+// The cores index vectors from 1, the callbacks from 0
+long double CallFunction(int i, int n, const long double *x) {
+  return current->userF(current->userData, i, n, x + 1);
+}
+
+void CallDerivatives(int i, int n, const long double *x, long double *dfatx) {
+  current->userDf(current->userData, i, n, x + 1, dfatx + 1);
+}
+
+void ToC(int n, const ValInterval *x, std::vector<ean_interval> &out) {
+  out.resize(n);
+  for (int j = 0; j < n; j++) {
+    out[j].lo = x[j + 1].a;
+    out[j].hi = x[j + 1].b;
+  }
+}
+
+ValInterval CallIntervalFunction(int i, int n, const ValInterval *x) {
+  static thread_local std::vector<ean_interval> in;
+  ToC(n, x, in);
+  ean_interval r = current->userIntervalF(current->userData, i, n, in.data());
+  return ValInterval(r.lo, r.hi);
+}
+
+void CallIntervalDerivatives(int i, int n, const ValInterval *x,
+                             ValInterval *dfatx) {
+  static thread_local std::vector<ean_interval> in, out;
+  ToC(n, x, in);
+  out.assign(n, ean_interval{0, 0});
+  current->userIntervalDf(current->userData, i, n, in.data(), out.data());
+  for (int j = 0; j < n; j++) {
+    dfatx[j + 1] = ValInterval(out[j].lo, out[j].hi);
+  }
+}
+
+int Fail(ean_solver *solver, int code, const char *message) {
+  if (solver) {
+    std::lock_guard<std::mutex> guard(solver->errorLock);
+    solver->lastError = message;
+  }
+  return code;
+}
+
+// Runs body and turns any exception into an error code
+template <typename Body>
+int Guarded(ean_solver *solver, Body body) {
+  try {
+    return body();
+  } catch (const std::bad_alloc &) {
+    return Fail(solver, EAN_ERROR_OUT_OF_MEMORY, "Out of memory");
+  } catch (const std::exception &e) {
+    return Fail(solver, EAN_ERROR_INTERNAL, e.what());
+  } catch (...) {
+    return Fail(solver, EAN_ERROR_INTERNAL, "Unknown error");
+  }
+}
+
+// Maps the status codes of the cores, as Solver and NInterval::Solver do
+int FromCoreStatus(int st, bool verified) {
+  switch (st) {
+    case 0:
+      return EAN_SUCCESS;
+    case 1:
+      return EAN_INVALID_INPUT;
+    case 2:
+      return EAN_SINGULAR_MATRIX;
+    case 3:
+      return EAN_MAX_ITERATIONS_EXCEEDED;
+    case 4:
+      return verified ? EAN_NO_ROOT : EAN_LIBRARY_ERROR;
+    default:
+      return EAN_LIBRARY_ERROR;
+  }
+}
+
+void ClearSystem(ean_solver *solver) {
+  solver->n = 0;
+  solver->f = nullptr;
+  solver->df = nullptr;
+  solver->intervalF = nullptr;
+  solver->intervalDf = nullptr;
+  solver->userF = nullptr;
+  solver->userDf = nullptr;
+  solver->userIntervalF = nullptr;
+  solver->userIntervalDf = nullptr;
+  solver->userData = nullptr;
+  solver->library.unload();
+}
+
+bool Ready(const ean_solver *solver) {
+  return solver->n > 0 &&
+         (solver->arithmetic == EAN_ARITHMETIC_STANDARD
+              ? solver->f && solver->df
+              : solver->intervalF && solver->intervalDf);
+}
+
+// Solves one guess per index taken from cursor, on the calling thread. A
+// throwing system only fails its own guess.
+template <typename SolveOne>
+void Work(ean_solver *solver, size_t count, std::atomic<size_t> &cursor,
+          SolveOne solveOne) {
+  CurrentSolver scope(solver);
+  size_t k;
+  while ((k = cursor.fetch_add(1)) < count) {
+    try {
+      solveOne(k);
+    } catch (const std::exception &e) {
+      Fail(solver, EAN_LIBRARY_ERROR, e.what());
+    } catch (...) {
+      Fail(solver, EAN_LIBRARY_ERROR, "Unknown exception in the system");
+    }
+  }
+}
+
+// Number of threads for a batch; 0 in the options means one per core
+size_t BatchThreads(const ean_solver *solver) {
+  return solver->options.threads > 0
+             ? static_cast<size_t>(solver->options.threads)
+             : std::max(1u, std::thread::hardware_concurrency());
+}
+
+template <typename SolveOne>
+void RunBatch(ean_solver *solver, size_t count, size_t threads,
+              SolveOne solveOne) {
+  threads = std::min(threads, count);
+  std::atomic<size_t> cursor(0);
+  std::vector<std::thread> workers;
+  // Reserved before any worker starts, so that adding one never reallocates
+  workers.reserve(threads);
+  try {
+    for (size_t t = 1; t < threads; t++) {
+      try {
+        workers.emplace_back([&] { Work(solver, count, cursor, solveOne); });
+      } catch (const std::system_error &) {
+        // Fewer threads than asked for still finish the batch
+        break;
+      }
+    }
+    Work(solver, count, cursor, solveOne);
+  } catch (...) {
+    // The workers still use cursor and solveOne
+    for (auto &w : workers) {
+      w.join();
+    }
+    throw;
+  }
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+
+int SolveStandard(ean_solver *solver, size_t count, size_t threads,
+                  long double *x, int *status, int *iterations) {
+  if (solver->arithmetic != EAN_ARITHMETIC_STANDARD) {
+    return Fail(solver, EAN_ERROR_WRONG_ARITHMETIC,
+                "Solver was created for interval arithmetic");
+  }
+  if (!Ready(solver)) {
+    return Fail(solver, EAN_FUNCTION_NOT_LOADED, "No system set");
+  }
+  const int n = solver->n;
+  const ean_options options = solver->options;
+  const NStandard::Globalization globalization =
+      options.method == EAN_METHOD_LINE_SEARCH
+          ? NStandard::Globalization::LINE_SEARCH
+      : options.method == EAN_METHOD_TRUST_REGION
+          ? NStandard::Globalization::TRUST_REGION
+          : NStandard::Globalization::NONE;
+  RunBatch(solver, count, threads, [&](size_t k) {
+    static thread_local NStandard::Vector work;
+    long double *guess = x + k * n;
+    work.assign(n + 1, 0.0L);
+    std::copy(guess, guess + n, work.begin() + 1);
+    int it = 0, st = 0;
+    if (status) {
+      status[k] = EAN_LIBRARY_ERROR;
+    }
+    NStandard::NewtonSystem(n, work, solver->f, solver->df,
+                            options.max_iterations, options.epsilon, it, st,
+                            globalization);
+    std::copy(work.begin() + 1, work.end(), guess);
+    if (status) {
+      status[k] = FromCoreStatus(st, false);
+    }
+    if (iterations) {
+      iterations[k] = it;
+    }
+  });
+  return EAN_SUCCESS;
+}
+
+int SolveInterval(ean_solver *solver, size_t count, size_t threads,
+                  ean_interval *x, int *status, int *iterations, int *unique) {
+  if (solver->arithmetic != EAN_ARITHMETIC_INTERVAL) {
+    return Fail(solver, EAN_ERROR_WRONG_ARITHMETIC,
+                "Solver was created for standard arithmetic");
+  }
+  if (!Ready(solver)) {
+    return Fail(solver, EAN_FUNCTION_NOT_LOADED, "No system set");
+  }
+  const int n = solver->n;
+  const ean_options options = solver->options;
+  const ValInterval eps(options.epsilon, options.epsilon);
+  RunBatch(solver, count, threads, [&](size_t k) {
+    static thread_local NInterval::Vector work;
+    interval_arithmetic::IAContextGuard<long double> guard(solver->context);
+    ean_interval *guess = x + k * n;
+    work.assign(n + 1, ValInterval(0, 0));
+    for (int j = 0; j < n; j++) {
+      work[j + 1] = ValInterval(guess[j].lo, guess[j].hi);
+    }
+    int it = 0, st = 0;
+    bool verified = options.method != EAN_METHOD_NEWTON;
+    bool isUnique = false;
+    if (status) {
+      status[k] = EAN_LIBRARY_ERROR;
+    }
+    if (verified) {
+      NInterval::KrawczykSystem(
+          n, work, solver->intervalF, solver->intervalDf,
+          options.method == EAN_METHOD_KRAWCZYK
+              ? NInterval::Contractor::KRAWCZYK
+              : NInterval::Contractor::HANSEN_SENGUPTA,
+          options.max_iterations, eps, it, st, isUnique);
+    } else {
+      NInterval::NewtonSystem(n, work, solver->intervalF, solver->intervalDf,
+                              options.max_iterations, eps, it, st);
+    }
+    for (int j = 0; j < n; j++) {
+      guess[j].lo = work[j + 1].a;
+      guess[j].hi = work[j + 1].b;
+    }
+    if (status) {
+      status[k] = FromCoreStatus(st, verified);
+    }
+    if (iterations) {
+      iterations[k] = it;
+    }
+    if (unique) {
+      unique[k] = isUnique ? 1 : 0;
+    }
+  });
+  return EAN_SUCCESS;
+}
+}  // namespace
+
+extern "C" {
+
+int ean_version(void) { return EAN_API_VERSION; }
+
+void ean_options_init(ean_options *options) {
+  if (!options) {
+    return;
+  }
+  options->size = sizeof(ean_options);
+  options->method = EAN_METHOD_NEWTON;
+  options->max_iterations = 10;
+  options->epsilon = 1e-16L;
+  options->threads = 0;
+}
+
+ean_solver *ean_solver_create(int api_version, ean_arithmetic arithmetic) {
+  if ((api_version >> 16) != EAN_API_VERSION_MAJOR ||
+      (api_version & 0xffff) > EAN_API_VERSION_MINOR) {
+    return nullptr;
+  }
+  if (arithmetic != EAN_ARITHMETIC_STANDARD &&
+      arithmetic != EAN_ARITHMETIC_INTERVAL) {
+    return nullptr;
+  }
+  ean_solver *solver = new (std::nothrow) ean_solver();
+  if (!solver) {
+    return nullptr;
+  }
+  solver->arithmetic = arithmetic;
+  solver->apiMinor = api_version & 0xffff;
+  ean_options_init(&solver->options);
+  ClearSystem(solver);
+  return solver;
+}
+
+void ean_solver_destroy(ean_solver *solver) { delete solver; }
+
+int ean_solver_load_library(ean_solver *solver, const char *path) {
+  if (!solver || !path) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT, "Null argument");
+  }
+  return Guarded(solver, [&] {
+    SharedLibrary library;
+    if (!library.load(path)) {
+      return Fail(solver, EAN_FUNCTION_NOT_LOADED,
+                  library.errorString().c_str());
+    }
+    const char *variant =
+        solver->arithmetic == EAN_ARITHMETIC_STANDARD ? "standard" : "interval";
+    if (!library.hasVariant(variant)) {
+      return Fail(solver, EAN_FUNCTION_NOT_LOADED,
+                  "Library has no interval variant");
+    }
+    void *f = library.resolve("evaluateFunction", variant);
+    void *df = library.resolve("evaluateDerivatives", variant);
+    void *getName = library.resolve("getName", variant);
+    auto getNumberOfEquations =
+        (int (*)())library.resolve("getNumberOfEquations", variant);
+    if (!f || !df || !getName || !getNumberOfEquations) {
+      return Fail(solver, EAN_FUNCTION_NOT_LOADED,
+                  "Missing functions in library");
+    }
+    int n = getNumberOfEquations();
+    if (n < 1) {
+      return Fail(solver, EAN_FUNCTION_NOT_LOADED,
+                  "Library reports no equations");
+    }
+    ClearSystem(solver);
+    if (solver->arithmetic == EAN_ARITHMETIC_STANDARD) {
+      solver->f = (NStandard::FunctionTypeC)f;
+      solver->df = (NStandard::DerivativeTypeC)df;
+    } else {
+      solver->intervalF = (NInterval::FunctionTypeC)f;
+      solver->intervalDf = (NInterval::DerivativeTypeC)df;
+    }
+    solver->n = n;
+    solver->library = std::move(library);
+    return static_cast<int>(EAN_SUCCESS);
+  });
+}
+
+int ean_solver_set_callbacks(ean_solver *solver, int n, ean_function f,
+                             ean_derivative df, void *user_data) {
+  if (!solver || !f || !df || n < 1) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT,
+                "Callbacks and n >= 1 are required");
+  }
+  if (solver->arithmetic != EAN_ARITHMETIC_STANDARD) {
+    return Fail(solver, EAN_ERROR_WRONG_ARITHMETIC,
+                "Solver was created for interval arithmetic");
+  }
+  ClearSystem(solver);
+  solver->n = n;
+  solver->userF = f;
+  solver->userDf = df;
+  solver->userData = user_data;
+  solver->f = CallFunction;
+  solver->df = CallDerivatives;
+  return EAN_SUCCESS;
+}
+
+int ean_solver_set_interval_callbacks(ean_solver *solver, int n,
+                                      ean_interval_function f,
+                                      ean_interval_derivative df,
+                                      void *user_data) {
+  if (!solver || !f || !df || n < 1) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT,
+                "Callbacks and n >= 1 are required");
+  }
+  if (solver->arithmetic != EAN_ARITHMETIC_INTERVAL) {
+    return Fail(solver, EAN_ERROR_WRONG_ARITHMETIC,
+                "Solver was created for standard arithmetic");
+  }
+  ClearSystem(solver);
+  solver->n = n;
+  solver->userIntervalF = f;
+  solver->userIntervalDf = df;
+  solver->userData = user_data;
+  solver->intervalF = CallIntervalFunction;
+  solver->intervalDf = CallIntervalDerivatives;
+  return EAN_SUCCESS;
+}
+
+int ean_solver_set_options(ean_solver *solver, const ean_options *options) {
+  if (!solver || !options || options->size < sizeof(size_t)) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT, "Invalid options");
+  }
+  // Fields a caller built against an older minor version does not know
+  // about keep their defaults
+  ean_options merged;
+  ean_options_init(&merged);
+  std::memcpy(&merged, options, std::min(options->size, sizeof(merged)));
+  merged.size = sizeof(merged);
+
+  bool verified = merged.method == EAN_METHOD_KRAWCZYK ||
+                  merged.method == EAN_METHOD_HANSEN_SENGUPTA;
+  bool globalized = merged.method == EAN_METHOD_LINE_SEARCH ||
+                    merged.method == EAN_METHOD_TRUST_REGION;
+  // Line search and trust region came with 1.1
+  if (merged.method != EAN_METHOD_NEWTON && !verified &&
+      !(globalized && solver->apiMinor >= 1)) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT, "Unknown method");
+  }
+  if (verified && solver->arithmetic != EAN_ARITHMETIC_INTERVAL) {
+    return Fail(solver, EAN_ERROR_WRONG_ARITHMETIC,
+                "Verified methods need interval arithmetic");
+  }
+  if (globalized && solver->arithmetic != EAN_ARITHMETIC_STANDARD) {
+    return Fail(solver, EAN_ERROR_WRONG_ARITHMETIC,
+                "Line search and trust region need standard arithmetic");
+  }
+  if (merged.max_iterations < 1 || !(merged.epsilon >= 0) ||
+      merged.threads < 0) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT,
+                "Need max_iterations >= 1, epsilon >= 0, threads >= 0");
+  }
+  solver->options = merged;
+  return EAN_SUCCESS;
+}
+
+int ean_solver_equations(const ean_solver *solver) {
+  return solver && Ready(solver) ? solver->n : 0;
+}
+
+int ean_solver_solve(ean_solver *solver, long double *x, int *iterations) {
+  if (!solver || !x) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT, "Null argument");
+  }
+  int status = EAN_LIBRARY_ERROR;
+  // A single guess always runs on the calling thread
+  int code = Guarded(solver, [&] {
+    return SolveStandard(solver, 1, 1, x, &status, iterations);
+  });
+  return code == EAN_SUCCESS ? status : code;
+}
+
+int ean_solver_solve_batch(ean_solver *solver, size_t count, long double *x,
+                           int *status, int *iterations) {
+  if (!solver || (!x && count > 0)) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT, "Null argument");
+  }
+  return Guarded(solver, [&] {
+    return SolveStandard(solver, count, BatchThreads(solver), x, status,
+                         iterations);
+  });
+}
+
+int ean_solver_solve_interval(ean_solver *solver, ean_interval *x,
+                              int *iterations, int *unique) {
+  if (!solver || !x) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT, "Null argument");
+  }
+  int status = EAN_LIBRARY_ERROR;
+  int code = Guarded(solver, [&] {
+    return SolveInterval(solver, 1, 1, x, &status, iterations, unique);
+  });
+  return code == EAN_SUCCESS ? status : code;
+}
+
+int ean_solver_solve_interval_batch(ean_solver *solver, size_t count,
+                                    ean_interval *x, int *status,
+                                    int *iterations, int *unique) {
+  if (!solver || (!x && count > 0)) {
+    return Fail(solver, EAN_ERROR_INVALID_ARGUMENT, "Null argument");
+  }
+  return Guarded(solver, [&] {
+    return SolveInterval(solver, count, BatchThreads(solver), x, status,
+                         iterations, unique);
+  });
+}
+
+const char *ean_solver_last_error(const ean_solver *solver) {
+  if (!solver) {
+    return "Null solver";
+  }
+  // Batch workers may replace lastError while the caller reads the copy
+  static thread_local std::string copy;
+  std::lock_guard<std::mutex> guard(solver->errorLock);
+  copy = solver->lastError;
+  return copy.c_str();
+}
+}
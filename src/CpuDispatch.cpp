@@ -0,0 +1,66 @@
+#include "../include/CpuDispatch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+CpuLevel Detect() {
+#if defined(__GNUC__) && defined(__x86_64__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return CpuLevel::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return CpuLevel::AVX2;
+  }
+#endif
+  return CpuLevel::BASELINE;
+}
+
+CpuLevel Choose() {
+  CpuLevel detected = DetectedCpuLevel();
+  const char *variable = std::getenv("EAN_CPU");
+  if (!variable || !*variable) {
+    return detected;
+  }
+  for (CpuLevel level :
+       {CpuLevel::BASELINE, CpuLevel::AVX2, CpuLevel::AVX512}) {
+    if (std::strcmp(variable, CpuLevelName(level)) == 0) {
+      if (level > detected) {
+        // Running the kernels would fault with an illegal instruction
+        std::fprintf(stderr, "EAN_CPU=%s is not supported here, using %s\n",
+                     variable, CpuLevelName(detected));
+        return detected;
+      }
+      return level;
+    }
+  }
+  std::fprintf(stderr, "Unknown EAN_CPU=%s, using %s\n", variable,
+               CpuLevelName(detected));
+  return detected;
+}
+}  // namespace
+
+CpuLevel DetectedCpuLevel() {
+  static const CpuLevel level = Detect();
+  return level;
+}
+
+CpuLevel ActiveCpuLevel() {
+  static const CpuLevel level = Choose();
+  return level;
+}
+
+const char *CpuLevelName(CpuLevel level) {
+  switch (level) {
+    case CpuLevel::AVX2:
+      return "avx2";
+    case CpuLevel::AVX512:
+      return "avx512";
+    default:
+      return "baseline";
+  }
+}
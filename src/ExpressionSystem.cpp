@@ -0,0 +1,1259 @@
+#include "../include/ExpressionSystem.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <tuple>
+
+#include "../include/DecimalParse.h"
+
+using NStandard::Val;
+using Op = ExpressionSystem::Op;
+
+namespace {
+
+// Largest integer exponent evaluated by repeated multiplication
+const int MAX_INTEGER_POWER = 64;
+
+const struct {
+  const char *name;
+  Op op;
+} FUNCTIONS[] = {{"sin", Op::SIN},   {"cos", Op::COS},   {"tan", Op::TAN},
+                 {"asin", Op::ASIN}, {"acos", Op::ACOS}, {"atan", Op::ATAN},
+                 {"sinh", Op::SINH}, {"cosh", Op::COSH}, {"tanh", Op::TANH},
+                 {"exp", Op::EXP},   {"log", Op::LOG},   {"sqrt", Op::SQRT},
+                 {"abs", Op::ABS}};
+
+bool IsUnary(Op op) { return op == Op::NEG || op >= Op::SIN; }
+
+Val PowI(Val x, int k) {
+  unsigned e = k < 0 ? -static_cast<unsigned>(k) : k;
+  Val result = 1;
+  for (; e; e >>= 1, x *= x) {
+    if (e & 1) {
+      result *= x;
+    }
+  }
+  return k < 0 ? 1 / result : result;
+}
+
+Val Apply(Op op, Val a, Val b) {
+  switch (op) {
+    case Op::ADD:
+      return a + b;
+    case Op::SUB:
+      return a - b;
+    case Op::MUL:
+      return a * b;
+    case Op::DIV:
+      return a / b;
+    case Op::NEG:
+      return -a;
+    case Op::POW:
+      return std::pow(a, b);
+    case Op::POWI:
+      return PowI(a, static_cast<int>(b));
+    case Op::SIN:
+      return std::sin(a);
+    case Op::COS:
+      return std::cos(a);
+    case Op::TAN:
+      return std::tan(a);
+    case Op::ASIN:
+      return std::asin(a);
+    case Op::ACOS:
+      return std::acos(a);
+    case Op::ATAN:
+      return std::atan(a);
+    case Op::SINH:
+      return std::sinh(a);
+    case Op::COSH:
+      return std::cosh(a);
+    case Op::TANH:
+      return std::tanh(a);
+    case Op::EXP:
+      return std::exp(a);
+    case Op::LOG:
+      return std::log(a);
+    case Op::SQRT:
+      return std::sqrt(a);
+    case Op::ABS:
+      return std::fabs(a);
+    case Op::SIGN:
+      return (a > 0) - (a < 0);
+  }
+  return 0;
+}
+
+// Runs the program over `lanes` points at once; register k of point p is
+// r[k * STRIDE + p]. With STRIDE 1 this is the plain scalar interpreter.
+template <int STRIDE>
+void Run(const std::vector<ExpressionSystem::Instruction> &code, Val *r,
+         int lanes) {
+  const int m = STRIDE == 1 ? 1 : lanes;
+  for (const ExpressionSystem::Instruction &in : code) {
+    Val *d = r + in.dst * STRIDE;
+    const Val *a = r + in.a * STRIDE;
+    const Val *b = r + (in.op == Op::POWI ? 0 : in.b) * STRIDE;
+    switch (in.op) {
+#define EAN_LANES(value)          \
+  for (int p = 0; p < m; p++) {   \
+    d[p] = value;                 \
+  }                               \
+  break
+      case Op::ADD:
+        EAN_LANES(a[p] + b[p]);
+      case Op::SUB:
+        EAN_LANES(a[p] - b[p]);
+      case Op::MUL:
+        EAN_LANES(a[p] * b[p]);
+      case Op::DIV:
+        EAN_LANES(a[p] / b[p]);
+      case Op::NEG:
+        EAN_LANES(-a[p]);
+      case Op::POW:
+        EAN_LANES(std::pow(a[p], b[p]));
+      case Op::POWI:
+        EAN_LANES(PowI(a[p], in.b));
+      case Op::SIN:
+        EAN_LANES(std::sin(a[p]));
+      case Op::COS:
+        EAN_LANES(std::cos(a[p]));
+      case Op::TAN:
+        EAN_LANES(std::tan(a[p]));
+      case Op::ASIN:
+        EAN_LANES(std::asin(a[p]));
+      case Op::ACOS:
+        EAN_LANES(std::acos(a[p]));
+      case Op::ATAN:
+        EAN_LANES(std::atan(a[p]));
+      case Op::SINH:
+        EAN_LANES(std::sinh(a[p]));
+      case Op::COSH:
+        EAN_LANES(std::cosh(a[p]));
+      case Op::TANH:
+        EAN_LANES(std::tanh(a[p]));
+      case Op::EXP:
+        EAN_LANES(std::exp(a[p]));
+      case Op::LOG:
+        EAN_LANES(std::log(a[p]));
+      case Op::SQRT:
+        EAN_LANES(std::sqrt(a[p]));
+      case Op::ABS:
+        EAN_LANES(std::fabs(a[p]));
+      case Op::SIGN:
+        EAN_LANES((a[p] > 0) - (a[p] < 0));
+#undef EAN_LANES
+    }
+  }
+}
+
+// Expression DAG. Nodes are created children first, so their order is a
+// topological one; equal nodes are created once. Simplification happens as
+// nodes are created, which keeps derivatives free of the 0 and 1 terms the
+// differentiation rules produce.
+//
+// An exact graph folds no constants, so every constant node is an integer
+// or a literal of the text. Literals whose value is not representable keep
+// their enclosure, in a of the node, and only exact constants take part in
+// simplification; the interval libraries are generated from such a graph.
+class Graph {
+ public:
+  using Node = ExpressionSystem::Node;
+  static const int CONSTANT = ExpressionSystem::CONSTANT;
+  static const int VARIABLE = ExpressionSystem::VARIABLE;
+
+  explicit Graph(bool exact = false) : exact(exact) {}
+
+  int constant(Val value) {
+    return add({CONSTANT, 0, 0, value == 0 ? 0 : value});
+  }
+
+  // Constant of the text with the nearest value and the enclosure [lo, hi]
+  int literal(Val value, Val lo, Val hi) {
+    if (!exact || lo == hi) {
+      return constant(value);
+    }
+    auto key = std::make_pair(lo, hi);
+    auto found = enclosureIndex.find(key);
+    if (found == enclosureIndex.end()) {
+      enclosures.push_back(key);
+      int k = static_cast<int>(enclosures.size());
+      found = enclosureIndex.emplace(key, k).first;
+    }
+    return add({CONSTANT, found->second, 0, value});
+  }
+
+  // Enclosure of constant node i
+  std::pair<Val, Val> enclosure(int i) const {
+    const Node &node = nodes[i];
+    return node.a == 0 ? std::make_pair(node.value, node.value)
+                       : enclosures[node.a - 1];
+  }
+
+  int variable(int index) { return add({VARIABLE, index, 0, 0}); }
+
+  int unary(Op op, int a) {
+    if (isConstant(a) && !exact) {
+      return fold(op, a, a);
+    }
+    if (op == Op::NEG && isOp(a, Op::NEG)) {
+      return nodes[a].a;
+    }
+    if (op == Op::ABS && isOp(a, Op::NEG)) {
+      return unary(Op::ABS, nodes[a].a);
+    }
+    return add({static_cast<int>(op), a, a, 0});
+  }
+
+  int binary(Op op, int a, int b) {
+    if (isConstant(a) && isConstant(b) && !exact) {
+      return fold(op, a, b);
+    }
+    // x2*x1 is the same node as x1*x2; constants come first
+    if ((op == Op::ADD || op == Op::MUL) &&
+        (isConstant(b) ? !isConstant(a) : !isConstant(a) && a > b)) {
+      std::swap(a, b);
+    }
+    switch (op) {
+      case Op::ADD:
+        if (is(a, 0)) return b;
+        if (isOp(b, Op::NEG)) return binary(Op::SUB, a, nodes[b].a);
+        if (isOp(a, Op::NEG)) return binary(Op::SUB, b, nodes[a].a);
+        break;
+      case Op::SUB:
+        if (is(b, 0)) return a;
+        if (is(a, 0)) return unary(Op::NEG, b);
+        if (a == b) return constant(0);
+        if (isOp(b, Op::NEG)) return binary(Op::ADD, a, nodes[b].a);
+        break;
+      case Op::MUL:
+        if (is(a, 1)) return b;
+        if (is(a, 0)) return constant(0);
+        if (is(a, -1)) return unary(Op::NEG, b);
+        // Signs move outwards, where they can cancel
+        if (isOp(a, Op::NEG)) {
+          return unary(Op::NEG, binary(Op::MUL, nodes[a].a, b));
+        }
+        if (isOp(b, Op::NEG)) {
+          return unary(Op::NEG, binary(Op::MUL, a, nodes[b].a));
+        }
+        // c1*(c2*x) is (c1*c2)*x
+        if (!exact && isConstant(a) && isOp(b, Op::MUL) &&
+            isConstant(nodes[b].a)) {
+          Val product = nodes[a].value * nodes[nodes[b].a].value;
+          return binary(Op::MUL, constant(product), nodes[b].b);
+        }
+        break;
+      case Op::DIV:
+        if (is(b, 1)) return a;
+        if (is(a, 0)) return constant(0);
+        if (isOp(a, Op::NEG)) {
+          return unary(Op::NEG, binary(Op::DIV, nodes[a].a, b));
+        }
+        break;
+      case Op::POW: {
+        if (!isConstant(b) || nodes[b].a != 0) break;
+        Val k = nodes[b].value;
+        if (k != std::floor(k) || std::fabs(k) > MAX_INTEGER_POWER) break;
+        if (k == 0) return constant(1);
+        if (k == 1) return a;
+        return add({static_cast<int>(Op::POWI), a, static_cast<int>(k), 0});
+      }
+      default:
+        break;
+    }
+    return add({static_cast<int>(op), a, b, 0});
+  }
+
+  // Node of d node / d x_variable
+  int derivative(int node, int variable) {
+    auto key = std::make_pair(node, variable);
+    auto found = derivatives.find(key);
+    if (found != derivatives.end()) {
+      return found->second;
+    }
+    int result = differentiate(node, variable);
+    derivatives[key] = result;
+    return result;
+  }
+
+  const Node &operator[](int i) const { return nodes[i]; }
+  int size() const { return static_cast<int>(nodes.size()); }
+
+  bool isZero(int i) const { return is(i, 0); }
+
+  const std::vector<Node> &all() const { return nodes; }
+
+ private:
+  int differentiate(int i, int variable) {
+    // Copied: creating nodes may move the vector
+    const Node node = nodes[i];
+    if (node.kind == CONSTANT) {
+      return constant(0);
+    }
+    if (node.kind == VARIABLE) {
+      return constant(node.a == variable ? 1 : 0);
+    }
+    Op op = static_cast<Op>(node.kind);
+    int a = node.a;
+    int b = node.b;
+    int da = derivative(a, variable);
+    // Also covers the unfolded constant subexpressions of exact graphs
+    if (isZero(da) && (op == Op::POWI || IsUnary(op) ||
+                       isZero(derivative(b, variable)))) {
+      return constant(0);
+    }
+    switch (op) {
+      case Op::ADD:
+        return binary(Op::ADD, da, derivative(b, variable));
+      case Op::SUB:
+        return binary(Op::SUB, da, derivative(b, variable));
+      case Op::MUL:
+        return binary(Op::ADD, binary(Op::MUL, da, b),
+                      binary(Op::MUL, a, derivative(b, variable)));
+      case Op::DIV: {
+        // (da - (a/b) db) / b reuses the quotient itself
+        int db = derivative(b, variable);
+        return binary(Op::DIV, binary(Op::SUB, da, binary(Op::MUL, i, db)),
+                      b);
+      }
+      case Op::NEG:
+        return unary(Op::NEG, da);
+      case Op::POW: {
+        int db = derivative(b, variable);
+        if (isZero(db)) {
+          int lower = binary(Op::POW, a, binary(Op::SUB, b, constant(1)));
+          return binary(Op::MUL, binary(Op::MUL, b, lower), da);
+        }
+        // a^b (db log a + b da / a)
+        return binary(
+            Op::MUL, i,
+            binary(Op::ADD, binary(Op::MUL, db, unary(Op::LOG, a)),
+                   binary(Op::DIV, binary(Op::MUL, b, da), a)));
+      }
+      case Op::POWI: {
+        int lower = binary(Op::POW, a, constant(b - 1));
+        return binary(Op::MUL, binary(Op::MUL, constant(b), lower), da);
+      }
+      case Op::SIN:
+        return binary(Op::MUL, unary(Op::COS, a), da);
+      case Op::COS:
+        return unary(Op::NEG, binary(Op::MUL, unary(Op::SIN, a), da));
+      case Op::TAN:
+        // 1 + tan^2
+        return binary(Op::MUL,
+                      binary(Op::ADD, constant(1), binary(Op::MUL, i, i)),
+                      da);
+      case Op::ASIN:
+        return binary(Op::DIV, da, unary(Op::SQRT, oneMinusSquare(a)));
+      case Op::ACOS:
+        return unary(Op::NEG, binary(Op::DIV, da,
+                                     unary(Op::SQRT, oneMinusSquare(a))));
+      case Op::ATAN:
+        return binary(Op::DIV, da,
+                      binary(Op::ADD, constant(1), binary(Op::MUL, a, a)));
+      case Op::SINH:
+        return binary(Op::MUL, unary(Op::COSH, a), da);
+      case Op::COSH:
+        return binary(Op::MUL, unary(Op::SINH, a), da);
+      case Op::TANH:
+        return binary(Op::MUL, oneMinusSquare(i), da);
+      case Op::EXP:
+        return binary(Op::MUL, i, da);
+      case Op::LOG:
+        return binary(Op::DIV, da, a);
+      case Op::SQRT:
+        return binary(Op::DIV, da, binary(Op::MUL, constant(2), i));
+      case Op::ABS:
+        return binary(Op::MUL, unary(Op::SIGN, a), da);
+      case Op::SIGN:
+        break;
+    }
+    return constant(0);
+  }
+
+  int oneMinusSquare(int a) {
+    return binary(Op::SUB, constant(1), binary(Op::MUL, a, a));
+  }
+
+  bool isOp(int i, Op op) const {
+    return nodes[i].kind == static_cast<int>(op);
+  }
+  bool isConstant(int i) const { return nodes[i].kind == CONSTANT; }
+  bool is(int i, Val value) const {
+    return isConstant(i) && nodes[i].a == 0 && nodes[i].value == value;
+  }
+
+  // Constants are only folded into finite values, so that an expression
+  // like 1/0 reports inf at the point instead of silently vanishing
+  int fold(Op op, int a, int b) {
+    Val value = Apply(op, nodes[a].value, nodes[b].value);
+    if (!std::isfinite(value)) {
+      return add({static_cast<int>(op), a, b, 0});
+    }
+    return constant(value);
+  }
+
+  int add(const Node &node) {
+    auto key = std::make_tuple(node.kind, node.a, node.b, node.value);
+    auto found = index.find(key);
+    if (found != index.end()) {
+      return found->second;
+    }
+    nodes.push_back(node);
+    index[key] = size() - 1;
+    return size() - 1;
+  }
+
+  bool exact;
+  std::vector<Node> nodes;
+  std::map<std::tuple<int, int, int, Val>, int> index;
+  std::map<std::pair<int, int>, int> derivatives;
+  // Enclosures of the inexact literals of an exact graph; node.a is the
+  // index plus one
+  std::vector<std::pair<Val, Val>> enclosures;
+  std::map<std::pair<Val, Val>, int> enclosureIndex;
+};
+
+// Recursive descent over one equation:
+//   equation := sum ['=' sum]
+//   sum      := product (('+' | '-') product)*
+//   product  := unary (('*' | '/') unary)*
+//   unary    := ('-' | '+') unary | power
+//   power    := primary [('^' | '**') unary]
+//   primary  := number | xN | pi | e | function '(' sum ')' | '(' sum ')'
+class Parser {
+ public:
+  Parser(Graph &graph, const std::string &text) : graph(graph), text(text) {}
+
+  // Node of the residual, -1 with error set
+  int equation(int &maxVariable) {
+    maxIndex = 0;
+    pos = 0;
+    int node = sum();
+    if (node >= 0 && peek('=')) {
+      pos++;
+      int rhs = sum();
+      node = rhs < 0 ? -1 : graph.binary(Op::SUB, node, rhs);
+    }
+    if (node < 0) {
+      return -1;
+    }
+    skip();
+    if (pos < text.size()) {
+      return fail("unexpected '" + text.substr(pos, 1) + "'");
+    }
+    maxVariable = maxIndex;
+    return node;
+  }
+
+  std::string error;
+  size_t errorColumn = 0;
+
+ private:
+  int fail(const std::string &message) {
+    if (error.empty()) {
+      error = message;
+      errorColumn = pos + 1;
+    }
+    return -1;
+  }
+
+  void skip() {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' ||
+                                 text[pos] == '\r')) {
+      pos++;
+    }
+  }
+
+  bool peek(char c) {
+    skip();
+    return pos < text.size() && text[pos] == c;
+  }
+
+  int sum() {
+    int node = product();
+    while (node >= 0 && (peek('+') || peek('-'))) {
+      Op op = text[pos++] == '+' ? Op::ADD : Op::SUB;
+      int rhs = product();
+      node = rhs < 0 ? -1 : graph.binary(op, node, rhs);
+    }
+    return node;
+  }
+
+  int product() {
+    int node = unary();
+    while (node >= 0 && (peek('*') || peek('/'))) {
+      Op op = text[pos++] == '*' ? Op::MUL : Op::DIV;
+      int rhs = unary();
+      node = rhs < 0 ? -1 : graph.binary(op, node, rhs);
+    }
+    return node;
+  }
+
+  int unary() {
+    if (peek('-')) {
+      pos++;
+      int node = unary();
+      return node < 0 ? -1 : graph.unary(Op::NEG, node);
+    }
+    if (peek('+')) {
+      pos++;
+      return unary();
+    }
+    return power();
+  }
+
+  int power() {
+    int node = primary();
+    if (node < 0) {
+      return -1;
+    }
+    if (peek('^')) {
+      pos++;
+    } else if (text.compare(pos, 2, "**") == 0) {
+      pos += 2;
+    } else {
+      return node;
+    }
+    int exponent = unary();
+    return exponent < 0 ? -1 : graph.binary(Op::POW, node, exponent);
+  }
+
+  int primary() {
+    skip();
+    if (pos >= text.size()) {
+      return fail("expression expected");
+    }
+    char c = text[pos];
+    if (c == '(') {
+      pos++;
+      int node = sum();
+      if (node >= 0 && !peek(')')) {
+        return fail("')' expected");
+      }
+      pos++;
+      return node;
+    }
+    if ((c >= '0' && c <= '9') || c == '.') {
+      return number();
+    }
+    if (!std::isalpha(static_cast<unsigned char>(c))) {
+      return fail("unexpected '" + text.substr(pos, 1) + "'");
+    }
+    size_t start = pos;
+    while (pos < text.size() &&
+           (std::isalnum(static_cast<unsigned char>(text[pos])) ||
+            text[pos] == '_')) {
+      pos++;
+    }
+    std::string word = text.substr(start, pos - start);
+    if (word.size() > 1 && word[0] == 'x' &&
+        word.find_first_not_of("0123456789", 1) == std::string::npos) {
+      long index = std::strtol(word.c_str() + 1, nullptr, 10);
+      if (index < 1 || word.size() > 10) {
+        pos = start;
+        return fail("no variable " + word + ", they are x1, x2, ...");
+      }
+      maxIndex = std::max(maxIndex, static_cast<int>(index));
+      return graph.variable(static_cast<int>(index));
+    }
+    if (word == "pi") {
+      return named(3.14159265358979323846264338327950288L,
+                   "3.14159265358979323846264338327950288",
+                   "3.14159265358979323846264338327950289");
+    }
+    if (word == "e") {
+      return named(2.71828182845904523536028747135266250L,
+                   "2.71828182845904523536028747135266249",
+                   "2.71828182845904523536028747135266250");
+    }
+    for (const auto &function : FUNCTIONS) {
+      if (word == function.name) {
+        if (!peek('(')) {
+          return fail("'(' expected after " + word);
+        }
+        pos++;
+        int node = sum();
+        if (node >= 0 && !peek(')')) {
+          return fail("')' expected");
+        }
+        pos++;
+        return node < 0 ? -1 : graph.unary(function.op, node);
+      }
+    }
+    pos = start;
+    return fail("unknown name " + word);
+  }
+
+  int number() {
+    size_t start = pos;
+    while (pos < text.size() &&
+           (std::isdigit(static_cast<unsigned char>(text[pos])) ||
+            text[pos] == '.')) {
+      pos++;
+    }
+    if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+      size_t mark = pos++;
+      if (pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        pos++;
+      }
+      if (pos < text.size() &&
+          std::isdigit(static_cast<unsigned char>(text[pos]))) {
+        while (pos < text.size() &&
+               std::isdigit(static_cast<unsigned char>(text[pos]))) {
+          pos++;
+        }
+      } else {
+        // Not an exponent, e.g. "2e" would be 2 times e
+        pos = mark;
+      }
+    }
+    // Locale independent and correctly rounded, with the enclosure for
+    // exact graphs
+    const char *first = text.data() + start;
+    const char *last = text.data() + pos;
+    Val value, lo, hi;
+    if (!interval_arithmetic::ParseDecimal(first, last, value) ||
+        !interval_arithmetic::ParseDecimal(first, last, lo, hi)) {
+      pos = start;
+      return fail("malformed number");
+    }
+    return graph.literal(value, lo, hi);
+  }
+
+  // Irrational constant between the decimals below and above
+  int named(Val value, const std::string &below, const std::string &above) {
+    Val lo, hi, ignored;
+    interval_arithmetic::ParseDecimal(below, lo, ignored);
+    interval_arithmetic::ParseDecimal(above, ignored, hi);
+    return graph.literal(value, lo, hi);
+  }
+
+  Graph &graph;
+  const std::string &text;
+  size_t pos = 0;
+  int maxIndex = 0;
+};
+
+// Compiles the nodes of graph that the roots depend on. Values that are
+// dead free their register for the next operation.
+void Compile(const Graph &graph, const std::vector<int> &roots, int n,
+             int &registers, std::vector<Val> &constants,
+             std::vector<ExpressionSystem::Instruction> &code,
+             std::vector<int32_t> &outputs) {
+  std::vector<bool> live(graph.size(), false);
+  for (int root : roots) {
+    live[root] = true;
+  }
+  for (int i = graph.size() - 1; i >= 0; i--) {
+    const Graph::Node &node = graph[i];
+    if (live[i] && node.kind >= 0) {
+      live[node.a] = true;
+      if (node.kind != static_cast<int>(Op::POWI)) {
+        live[node.b] = true;
+      }
+    }
+  }
+
+  const int FOREVER = std::numeric_limits<int>::max();
+  std::vector<int> lastUse(graph.size(), -1);
+  for (int i = 0; i < graph.size(); i++) {
+    const Graph::Node &node = graph[i];
+    if (live[i] && node.kind >= 0) {
+      lastUse[node.a] = i;
+      if (node.kind != static_cast<int>(Op::POWI)) {
+        lastUse[node.b] = i;
+      }
+    }
+  }
+  for (int root : roots) {
+    lastUse[root] = FOREVER;
+  }
+
+  std::vector<int32_t> reg(graph.size(), -1);
+  constants.clear();
+  for (int i = 0; i < graph.size(); i++) {
+    if (!live[i]) {
+      continue;
+    }
+    if (graph[i].kind == Graph::VARIABLE) {
+      reg[i] = graph[i].a - 1;
+    } else if (graph[i].kind == Graph::CONSTANT) {
+      reg[i] = n + static_cast<int32_t>(constants.size());
+      constants.push_back(graph[i].value);
+    }
+  }
+  int32_t next = n + static_cast<int32_t>(constants.size());
+  std::vector<int32_t> released;
+  code.clear();
+  for (int i = 0; i < graph.size(); i++) {
+    const Graph::Node &node = graph[i];
+    if (!live[i] || node.kind < 0) {
+      continue;
+    }
+    Op op = static_cast<Op>(node.kind);
+    ExpressionSystem::Instruction in = {op, 0, reg[node.a],
+                                        op == Op::POWI ? node.b : reg[node.b]};
+    int operands[2] = {node.a, op == Op::POWI ? node.a : node.b};
+    for (int k = 0; k < (operands[0] == operands[1] ? 1 : 2); k++) {
+      const Graph::Node &operand = graph[operands[k]];
+      if (operand.kind >= 0 && lastUse[operands[k]] == i) {
+        released.push_back(reg[operands[k]]);
+      }
+    }
+    if (released.empty()) {
+      in.dst = next++;
+    } else {
+      in.dst = released.back();
+      released.pop_back();
+    }
+    reg[i] = in.dst;
+    code.push_back(in);
+  }
+  registers = next;
+  outputs.clear();
+  for (int root : roots) {
+    outputs.push_back(reg[root]);
+  }
+}
+const char *OpName(Op op) {
+  switch (op) {
+    case Op::POW:
+      return "non-integer powers";
+    case Op::TAN:
+      return "tan";
+    case Op::ASIN:
+      return "asin";
+    case Op::ACOS:
+      return "acos";
+    case Op::ATAN:
+      return "atan";
+    case Op::SINH:
+      return "sinh";
+    case Op::COSH:
+      return "cosh";
+    case Op::TANH:
+      return "tanh";
+    case Op::LOG:
+      return "log";
+    case Op::SQRT:
+      return "sqrt";
+    default:
+      return "this operation";
+  }
+}
+
+// Literal that reads back as exactly value
+std::string Literal(Val value) {
+  if (std::isinf(value)) {
+    return value > 0 ? "HUGE_VALL" : "-HUGE_VALL";
+  }
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), "%.21Lg", value);
+  std::string literal = buffer;
+  if (literal.find_first_of(".e") == std::string::npos) {
+    literal += ".0";
+  }
+  return literal + "L";
+}
+
+const char HELPERS_STANDARD[] =
+    "namespace {\n"
+    "\n"
+    "inline Val PowI(Val x, int k) {\n"
+    "  unsigned e = k < 0 ? -static_cast<unsigned>(k) : k;\n"
+    "  Val result = 1;\n"
+    "  for (; e; e >>= 1, x *= x) {\n"
+    "    if (e & 1) result *= x;\n"
+    "  }\n"
+    "  return k < 0 ? 1 / result : result;\n"
+    "}\n"
+    "\n"
+    "inline Val Sign(Val x) { return (x > 0) - (x < 0); }\n"
+    "}  // namespace\n";
+
+const char HELPERS_INTERVAL[] =
+    "namespace {\n"
+    "\n"
+    "// Squares use ISqr, which is tighter than x * x\n"
+    "inline ValInterval PowI(const ValInterval &x, int k) {\n"
+    "  int st = 0;\n"
+    "  unsigned e = k < 0 ? -static_cast<unsigned>(k) : k;\n"
+    "  ValInterval result(1, 1);\n"
+    "  ValInterval power = x;\n"
+    "  for (; e; e >>= 1) {\n"
+    "    if (e & 1) result = result * power;\n"
+    "    if (e > 1) power = ISqr(power, st);\n"
+    "  }\n"
+    "  return k < 0 ? ValInterval(1, 1) / result : result;\n"
+    "}\n"
+    "\n"
+    "inline ValInterval Sign(const ValInterval &x) {\n"
+    "  return ValInterval((x.a > 0) - (x.a < 0), (x.b > 0) - (x.b < 0));\n"
+    "}\n"
+    "}  // namespace\n";
+
+// Straight-line C++ over the DAG, one local per node. Interval code is
+// emitted from an exact graph.
+class Emitter {
+ public:
+  Emitter(const std::vector<ExpressionSystem::Node> &nodes,
+          const Graph *exact)
+      : nodes(nodes), exact(exact), interval(exact != nullptr) {}
+
+  // Statements computing the roots; the nodes they need are emitted in
+  // DAG order, each once
+  bool emit(const std::vector<int> &roots, std::string &body,
+            std::string &error) {
+    std::vector<bool> needed(nodes.size(), false);
+    for (int root : roots) {
+      needed[root] = true;
+    }
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; i--) {
+      const ExpressionSystem::Node &node = nodes[i];
+      if (needed[i] && node.kind >= 0) {
+        needed[node.a] = true;
+        if (node.kind != static_cast<int>(Op::POWI)) {
+          needed[node.b] = true;
+        }
+      }
+    }
+    for (size_t i = 0; i < nodes.size(); i++) {
+      const ExpressionSystem::Node &node = nodes[i];
+      if (!needed[i] || node.kind == ExpressionSystem::VARIABLE) {
+        continue;
+      }
+      std::string value;
+      if (node.kind == ExpressionSystem::CONSTANT) {
+        if (!interval) {
+          continue;
+        }
+        value = constant(static_cast<int>(i));
+      } else if (!operation(node, value)) {
+        error = std::string("The interval arithmetic has no ") +
+                OpName(static_cast<Op>(node.kind));
+        return false;
+      }
+      body += "      const " + type() + " v" + std::to_string(i) + " = " +
+              value + ";\n";
+    }
+    return true;
+  }
+
+  std::string ref(int i) const {
+    const ExpressionSystem::Node &node = nodes[i];
+    if (node.kind == ExpressionSystem::VARIABLE) {
+      return "x[" + std::to_string(node.a) + "]";
+    }
+    if (node.kind == ExpressionSystem::CONSTANT && !interval) {
+      return Literal(node.value);
+    }
+    return "v" + std::to_string(i);
+  }
+
+  std::string type() const { return interval ? "ValInterval" : "Val"; }
+
+  // Interval constants are the enclosures of the literals of the text;
+  // Literal() reads back exactly
+  std::string constant(int i) const {
+    std::pair<Val, Val> bounds = exact->enclosure(i);
+    return "ValInterval(" + Literal(bounds.first) + ", " +
+           Literal(bounds.second) + ")";
+  }
+
+ private:
+  bool operation(const ExpressionSystem::Node &node, std::string &value) {
+    Op op = static_cast<Op>(node.kind);
+    std::string a = ref(node.a);
+    std::string b = op == Op::POWI ? std::to_string(node.b) : ref(node.b);
+    const char *function = nullptr;
+    switch (op) {
+      case Op::ADD:
+        value = a + " + " + b;
+        return true;
+      case Op::SUB:
+        value = a + " - " + b;
+        return true;
+      case Op::MUL:
+        value = a + " * " + b;
+        return true;
+      case Op::DIV:
+        value = a + " / " + b;
+        return true;
+      case Op::NEG:
+        // Opposite() is the Kaucher opposite [-a, -b], not -x
+        value = interval ? "ValInterval(0, 0) - " + a : "-" + a;
+        return true;
+      case Op::POWI:
+        value = "PowI(" + a + ", " + b + ")";
+        return true;
+      case Op::SIGN:
+        value = "Sign(" + a + ")";
+        return true;
+      case Op::SIN:
+        function = interval ? "ISin" : "std::sin";
+        break;
+      case Op::COS:
+        function = interval ? "ICos" : "std::cos";
+        break;
+      case Op::EXP:
+        function = interval ? "IExp" : "std::exp";
+        break;
+      case Op::ABS:
+        function = interval ? "IAbs" : "std::fabs";
+        break;
+      case Op::POW:
+        if (interval) return false;
+        value = "std::pow(" + a + ", " + b + ")";
+        return true;
+      case Op::TAN:
+        function = "std::tan";
+        break;
+      case Op::ASIN:
+        function = "std::asin";
+        break;
+      case Op::ACOS:
+        function = "std::acos";
+        break;
+      case Op::ATAN:
+        function = "std::atan";
+        break;
+      case Op::SINH:
+        function = "std::sinh";
+        break;
+      case Op::COSH:
+        function = "std::cosh";
+        break;
+      case Op::TANH:
+        function = "std::tanh";
+        break;
+      case Op::LOG:
+        function = "std::log";
+        break;
+      case Op::SQRT:
+        function = "std::sqrt";
+        break;
+    }
+    if (interval && function[0] != 'I') {
+      return false;
+    }
+    value = std::string(function) + "(" + a + ")";
+    return true;
+  }
+
+  const std::vector<ExpressionSystem::Node> &nodes;
+  const Graph *exact;
+  bool interval;
+};
+
+// For a string literal in generated code
+std::string Quote(const std::string &text) {
+  std::string quoted = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    if (c == '\n' || c == '\r') {
+      c = ' ';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+// Parses every equation of source into graph: the residual nodes, and the
+// columns and nodes of the Jacobian entries of each row that do not
+// simplify to 0, which are structural zeros. False with error set.
+bool Build(Graph &graph, const std::string &source, std::vector<int> &roots,
+           std::vector<std::vector<int>> &nonZero,
+           std::vector<std::vector<int>> &entries, std::string &error) {
+  int maxVariable = 0;
+  std::istringstream lines(source);
+  std::string line;
+  for (int number = 1; std::getline(lines, line); number++) {
+    line = line.substr(0, line.find('#'));
+    if (line.find_first_not_of(" \t\r") == std::string::npos) {
+      continue;
+    }
+    Parser parser(graph, line);
+    int variables;
+    int root = parser.equation(variables);
+    if (root < 0) {
+      error = "Line " + std::to_string(number) + ", column " +
+              std::to_string(parser.errorColumn) + ": " + parser.error;
+      return false;
+    }
+    roots.push_back(root);
+    maxVariable = std::max(maxVariable, variables);
+  }
+  if (roots.empty()) {
+    error = "No equations";
+    return false;
+  }
+  int equationCount = static_cast<int>(roots.size());
+  if (maxVariable > equationCount) {
+    error = "x" + std::to_string(maxVariable) + " is used in a system of " +
+            std::to_string(equationCount) +
+            (equationCount == 1 ? " equation" : " equations");
+    return false;
+  }
+
+  nonZero.assign(equationCount, {});
+  entries.assign(equationCount, {});
+  for (int i = 0; i < equationCount; i++) {
+    for (int j = 0; j < equationCount; j++) {
+      int entry = graph.derivative(roots[i], j + 1);
+      if (!graph.isZero(entry)) {
+        nonZero[i].push_back(j);
+        entries[i].push_back(entry);
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+// Out-of-line definition, for std::min taking it by reference
+const int ExpressionSystem::BLOCK;
+
+ExpressionSystem::ExpressionSystem() : n(0) {}
+
+bool ExpressionSystem::parse(const std::string &source,
+                             const std::string &name) {
+  Graph graph;
+  std::vector<int> roots;
+  std::vector<std::vector<int>> nonZero;
+  std::vector<std::vector<int>> entries;
+  if (!Build(graph, source, roots, nonZero, entries, error)) {
+    return false;
+  }
+  int equationCount = static_cast<int>(roots.size());
+  std::vector<int> fusedRoots = roots;
+  for (const std::vector<int> &row : entries) {
+    fusedRoots.insert(fusedRoots.end(), row.begin(), row.end());
+  }
+
+  Program residual, fused;
+  Compile(graph, roots, equationCount, residual.registers, residual.constants,
+          residual.code, residual.outputs);
+  Compile(graph, fusedRoots, equationCount, fused.registers, fused.constants,
+          fused.code, fused.outputs);
+
+  systemName = name.empty() ? "Equations" : name;
+  error.clear();
+  text = source;
+  n = equationCount;
+  nodes = graph.all();
+  residualNodes = roots;
+  entryNodes = entries;
+  residualProgram = residual;
+  fusedProgram = fused;
+  columns = nonZero;
+  return true;
+}
+
+std::string ExpressionSystem::errorString() const { return error; }
+
+std::string ExpressionSystem::name() const { return systemName; }
+
+int ExpressionSystem::equations() const { return n; }
+
+std::vector<int> ExpressionSystem::pattern(int i) const {
+  std::vector<int> result;
+  for (int j : columns[i - 1]) {
+    result.push_back(j + 1);
+  }
+  return result;
+}
+
+int ExpressionSystem::nonZeros() const {
+  return static_cast<int>(fusedProgram.outputs.size()) - n;
+}
+
+bool ExpressionSystem::generateLibrary(Target target, std::string &source,
+                                       std::string &message) const {
+  bool interval = target == Target::INTERVAL;
+  // Folded constants are rounded, so the interval library is generated
+  // from the equations again, into a graph that folds none
+  Graph exact(true);
+  std::vector<int> exactRoots;
+  std::vector<std::vector<int>> exactColumns;
+  std::vector<std::vector<int>> exactEntries;
+  if (interval && !Build(exact, text, exactRoots, exactColumns, exactEntries,
+                         message)) {
+    return false;
+  }
+  const std::vector<int> &roots = interval ? exactRoots : residualNodes;
+  const std::vector<std::vector<int>> &rows =
+      interval ? exactColumns : columns;
+  const std::vector<std::vector<int>> &entries =
+      interval ? exactEntries : entryNodes;
+  Emitter emitter(interval ? exact.all() : nodes, interval ? &exact : nullptr);
+  const std::string type = emitter.type();
+
+  std::string code = "// Generated from the equations of " + systemName +
+                     ":\n";
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    // A trailing backslash would continue the comment
+    while (!line.empty() && (line.back() == '\\' || line.back() == '\r')) {
+      line.pop_back();
+    }
+    code += "//   " + line + "\n";
+  }
+  code += "\n#include <cmath>\n\n";
+  code += interval ? "#include \"LibraryInterfaceInterval.h\"\n\n"
+                   : "#include \"LibraryInterface.h\"\n\n";
+  code += interval ? HELPERS_INTERVAL : HELPERS_STANDARD;
+
+  code += "\nextern \"C\" {\nFUNCTION_EXPORT " + type +
+          " evaluateFunction(int i, int n, const " + type + " *x) {\n" +
+          "  switch (i) {\n";
+  for (int i = 0; i < n; i++) {
+    std::string body;
+    if (!emitter.emit({roots[i]}, body, message)) {
+      return false;
+    }
+    code += "    case " + std::to_string(i + 1) + ": {\n" + body +
+            "      return " + emitter.ref(roots[i]) + ";\n    }\n";
+  }
+  code += "  }\n  return " +
+          (interval ? std::string("ValInterval(0, 0)") : std::string("0")) +
+          ";\n}\n\n";
+
+  code += "FUNCTION_EXPORT void evaluateDerivatives(int i, int n, const " +
+          type + " *x,\n                                         " + type +
+          " *dfatx) {\n  switch (i) {\n";
+  for (int i = 0; i < n; i++) {
+    std::string body;
+    if (!emitter.emit(entries[i], body, message)) {
+      return false;
+    }
+    code += "    case " + std::to_string(i + 1) + ": {\n" + body;
+    // Structural zeros are written too, the caller's row is not cleared
+    size_t k = 0;
+    for (int j = 0; j < n; j++) {
+      std::string value;
+      if (k < rows[i].size() && rows[i][k] == j) {
+        value = emitter.ref(entries[i][k++]);
+      } else {
+        value = interval ? "ValInterval(0, 0)" : "0";
+      }
+      code += "      dfatx[" + std::to_string(j + 1) + "] = " + value + ";\n";
+    }
+    code += "      return;\n    }\n";
+  }
+  code += "  }\n}\n\n";
+
+  code += "FUNCTION_EXPORT const char *getName() { return " +
+          Quote(systemName) + "; }\n\n";
+  code += "FUNCTION_EXPORT int getNumberOfEquations() { return " +
+          std::to_string(n) + "; }\n}\n";
+  source = code;
+  return true;
+}
+
+int ExpressionSystem::instructionCount() const {
+  return static_cast<int>(residualProgram.code.size());
+}
+
+int ExpressionSystem::registerCount() const {
+  return residualProgram.registers;
+}
+
+int ExpressionSystem::fusedInstructionCount() const {
+  return static_cast<int>(fusedProgram.code.size());
+}
+
+ExpressionSystem::Evaluator::Evaluator(const ExpressionSystem &system)
+    : system(system),
+      registers(system.residualProgram.registers),
+      fusedRegisters(system.fusedProgram.registers),
+      block(static_cast<size_t>(system.residualProgram.registers) * BLOCK),
+      point(system.n),
+      residuals(system.n),
+      jacobian(static_cast<size_t>(system.n) * system.n, 0),
+      cached(false) {
+  const std::vector<Val> &constants = system.residualProgram.constants;
+  for (size_t k = 0; k < constants.size(); k++) {
+    registers[system.n + k] = constants[k];
+    std::fill_n(block.begin() + (system.n + k) * BLOCK, BLOCK, constants[k]);
+  }
+  std::copy(system.fusedProgram.constants.begin(),
+            system.fusedProgram.constants.end(),
+            fusedRegisters.begin() + system.n);
+}
+
+void ExpressionSystem::Evaluator::evaluate(const Val *x, Val *f) {
+  const Program &program = system.residualProgram;
+  std::copy(x + 1, x + 1 + system.n, registers.begin());
+  Run<1>(program.code, registers.data(), 1);
+  for (int i = 0; i < system.n; i++) {
+    f[i + 1] = registers[program.outputs[i]];
+  }
+}
+
+void ExpressionSystem::Evaluator::evaluateBatch(int count, const Val *points,
+                                                Val *results) {
+  const Program &program = system.residualProgram;
+  const int n = system.n;
+  for (int first = 0; first < count; first += BLOCK) {
+    int m = std::min(BLOCK, count - first);
+    const Val *in = points + static_cast<size_t>(first) * n;
+    for (int p = 0; p < m; p++) {
+      for (int j = 0; j < n; j++) {
+        block[j * BLOCK + p] = in[p * n + j];
+      }
+    }
+    Run<BLOCK>(program.code, block.data(), m);
+    Val *out = results + static_cast<size_t>(first) * n;
+    for (int p = 0; p < m; p++) {
+      for (int i = 0; i < n; i++) {
+        out[p * n + i] = block[program.outputs[i] * BLOCK + p];
+      }
+    }
+  }
+}
+
+bool ExpressionSystem::Evaluator::update(const Val *x) {
+  if (cached && std::equal(point.begin(), point.end(), x + 1)) {
+    return false;
+  }
+  const Program &program = system.fusedProgram;
+  const int n = system.n;
+  std::copy(x + 1, x + 1 + n, point.begin());
+  std::copy(x + 1, x + 1 + n, fusedRegisters.begin());
+  Run<1>(program.code, fusedRegisters.data(), 1);
+  for (int i = 0; i < n; i++) {
+    residuals[i] = fusedRegisters[program.outputs[i]];
+  }
+  // Structural zeros were set once and are never written
+  const int32_t *entry = &program.outputs[n];
+  for (int i = 0; i < n; i++) {
+    for (int j : system.columns[i]) {
+      jacobian[i * n + j] = fusedRegisters[*entry++];
+    }
+  }
+  cached = true;
+  return true;
+}
+
+Val ExpressionSystem::Evaluator::function(int i, const Val *x) {
+  update(x);
+  return residuals[i - 1];
+}
+
+void ExpressionSystem::Evaluator::derivatives(int i, const Val *x,
+                                              Val *dfatx) {
+  update(x);
+  const int n = system.n;
+  std::copy(&jacobian[(i - 1) * n], &jacobian[(i - 1) * n] + n, dfatx + 1);
+}
@@ -0,0 +1,346 @@
+#include "../include/IntervalLinearSystem.h"
+
+#include <cmath>
+#include <vector>
+
+using interval_arithmetic::SetRounding;
+
+namespace NInterval {
+
+// Inverts a point matrix m (1-based, stride n + 1) into y by Gauss-Jordan
+// elimination with partial pivoting. m is destroyed.
+static bool PointInverse(int n, std::vector<long double> &m,
+                         std::vector<long double> &y) {
+  int n1 = n + 1;
+  for (int r = 1; r <= n; r++) {
+    for (int c = 1; c <= n; c++) {
+      y[r * n1 + c] = r == c ? 1 : 0;
+    }
+  }
+
+  for (int k = 1; k <= n; k++) {
+    int p = k;
+    long double max = std::abs(m[k * n1 + k]);
+    for (int r = k + 1; r <= n; r++) {
+      long double s = std::abs(m[r * n1 + k]);
+      if (s > max) {
+        max = s;
+        p = r;
+      }
+    }
+    if (max == 0 || !std::isfinite(max)) {
+      return false;
+    }
+    if (p != k) {
+      for (int c = 1; c <= n; c++) {
+        std::swap(m[k * n1 + c], m[p * n1 + c]);
+        std::swap(y[k * n1 + c], y[p * n1 + c]);
+      }
+    }
+
+    long double d = 1 / m[k * n1 + k];
+    for (int c = 1; c <= n; c++) {
+      m[k * n1 + c] *= d;
+      y[k * n1 + c] *= d;
+    }
+    for (int r = 1; r <= n; r++) {
+      long double s = m[r * n1 + k];
+      if (r != k && s != 0) {
+        for (int c = 1; c <= n; c++) {
+          m[r * n1 + c] -= s * m[k * n1 + c];
+          y[r * n1 + c] -= s * y[k * n1 + c];
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// Approximate inverse of the midpoint matrix of a. Returns false if the
+// midpoint matrix is numerically singular.
+bool MidpointInverse(int n, const Matrix &a, std::vector<long double> &y) {
+  int n1 = n + 1;
+  std::vector<long double> m(n1 * n1);
+  for (int r = 1; r <= n; r++) {
+    for (int c = 1; c <= n; c++) {
+      m[r * n1 + c] = (a[r * n1 + c].a + a[r * n1 + c].b) / 2;
+    }
+  }
+  return PointInverse(n, m, y);
+}
+
+// Encloses c = y * a and r = y * b for a point matrix y using the
+// midpoint-radius form y * mid(a) +- |y| * rad(a), so that only point
+// operations with directed rounding are needed.
+void Precondition(int n, const std::vector<long double> &y, const Matrix &a,
+                  const Vector &b, Matrix &c, Vector &r) {
+  int n1 = n + 1;
+  std::vector<long double> mid(n1 * n1);
+  std::vector<long double> rad(n1 * n1);
+  std::vector<long double> bmid(n1);
+  std::vector<long double> brad(n1);
+  std::vector<long double> s(n1 * n1);
+  std::vector<long double> t(n1);
+
+  for (int k = 1; k <= n; k++) {
+    for (int j = 1; j <= n; j++) {
+      mid[k * n1 + j] = (a[k * n1 + j].a + a[k * n1 + j].b) / 2;
+    }
+    bmid[k] = (b[k].a + b[k].b) / 2;
+  }
+
+  SetRounding<long double>(FE_UPWARD);
+  for (int k = 1; k <= n; k++) {
+    for (int j = 1; j <= n; j++) {
+      const ValInterval &e = a[k * n1 + j];
+      rad[k * n1 + j] = std::max(mid[k * n1 + j] - e.a, e.b - mid[k * n1 + j]);
+    }
+    brad[k] = std::max(bmid[k] - b[k].a, b[k].b - bmid[k]);
+  }
+  for (int i = 1; i <= n; i++) {
+    for (int j = 1; j <= n; j++) {
+      long double hi = 0;
+      long double ra = 0;
+      for (int k = 1; k <= n; k++) {
+        hi += y[i * n1 + k] * mid[k * n1 + j];
+        ra += std::abs(y[i * n1 + k]) * rad[k * n1 + j];
+      }
+      s[i * n1 + j] = ra;
+      c[i * n1 + j].b = hi + ra;
+    }
+    long double hi = 0;
+    long double ra = 0;
+    for (int k = 1; k <= n; k++) {
+      hi += y[i * n1 + k] * bmid[k];
+      ra += std::abs(y[i * n1 + k]) * brad[k];
+    }
+    t[i] = ra;
+    r[i].b = hi + ra;
+  }
+
+  SetRounding<long double>(FE_DOWNWARD);
+  for (int i = 1; i <= n; i++) {
+    for (int j = 1; j <= n; j++) {
+      long double lo = 0;
+      for (int k = 1; k <= n; k++) {
+        lo += y[i * n1 + k] * mid[k * n1 + j];
+      }
+      c[i * n1 + j].a = lo - s[i * n1 + j];
+    }
+    long double lo = 0;
+    for (int k = 1; k <= n; k++) {
+      lo += y[i * n1 + k] * bmid[k];
+    }
+    r[i].a = lo - t[i];
+  }
+  SetRounding<long double>(FE_TONEAREST);
+}
+
+static inline long double Mag(const ValInterval &x) {
+  return std::max(std::abs(x.a), std::abs(x.b));
+}
+
+static inline long double Mig(const ValInterval &x) {
+  if (x.a <= 0 && x.b >= 0) {
+    return 0;
+  }
+  return std::min(std::abs(x.a), std::abs(x.b));
+}
+
+// Comparison matrix <c>: mig on the diagonal, -mag off the diagonal
+static void Comparison(int n, const Matrix &c, std::vector<long double> &m) {
+  int n1 = n + 1;
+  for (int i = 1; i <= n; i++) {
+    for (int j = 1; j <= n; j++) {
+      m[i * n1 + j] = i == j ? Mig(c[i * n1 + j]) : -Mag(c[i * n1 + j]);
+    }
+  }
+}
+
+// Rigorous initial enclosure of the solution set of c x = r, from the
+// comparison matrix cmp = <c> and an approximate inverse inv of it. For
+// v > 0 with u = <c> v > 0 every solution satisfies |x| <= max(|r_i| / u_i) v.
+static bool InitialEnclosure(int n, const Vector &r,
+                             const std::vector<long double> &cmp,
+                             const std::vector<long double> &inv, Vector &x) {
+  int n1 = n + 1;
+  std::vector<long double> v(n1);
+  std::vector<long double> t(n1);
+
+  for (int i = 1; i <= n; i++) {
+    long double s = 0;
+    for (int j = 1; j <= n; j++) {
+      s += inv[i * n1 + j];
+    }
+    if (!(s > 0)) {
+      return false;
+    }
+    v[i] = s;
+  }
+
+  SetRounding<long double>(FE_UPWARD);
+  for (int i = 1; i <= n; i++) {
+    long double s = 0;
+    for (int j = 1; j <= n; j++) {
+      if (j != i) {
+        s += -cmp[i * n1 + j] * v[j];
+      }
+    }
+    t[i] = s;
+  }
+  SetRounding<long double>(FE_DOWNWARD);
+  for (int i = 1; i <= n; i++) {
+    t[i] = cmp[i * n1 + i] * v[i] - t[i];
+  }
+  SetRounding<long double>(FE_UPWARD);
+  long double alpha = 0;
+  bool ok = true;
+  for (int i = 1; i <= n; i++) {
+    if (!(t[i] > 0)) {
+      ok = false;
+      break;
+    }
+    alpha = std::max(alpha, Mag(r[i]) / t[i]);
+  }
+  if (ok) {
+    for (int i = 1; i <= n; i++) {
+      long double e = alpha * v[i];
+      x[i] = ValInterval(-e, e);
+    }
+  }
+  SetRounding<long double>(FE_TONEAREST);
+  return ok && std::isfinite(alpha);
+}
+
+// Interval Gauss-Seidel sweeps on c x = r, contracting x. Returns false if
+// x is found not to contain any solution.
+static bool GaussSeidel(int n, const Matrix &c, const Vector &r, Vector &x) {
+  int n1 = n + 1;
+  for (int sweep = 0; sweep < 20; sweep++) {
+    bool contracted = false;
+    for (int i = 1; i <= n; i++) {
+      const ValInterval &d = c[i * n1 + i];
+      if (d.a <= 0 && d.b >= 0) {
+        continue;
+      }
+      ValInterval s = r[i];
+      for (int j = 1; j <= n; j++) {
+        if (j != i) {
+          s = ISub(s, IMul(c[i * n1 + j], x[j]));
+        }
+      }
+      ValInterval k;
+      if (!Intersect(x[i], IDiv(s, d), k)) {
+        return false;
+      }
+      if (IntWidth(k) < 0.99L * IntWidth(x[i])) {
+        contracted = true;
+      }
+      x[i] = k;
+    }
+    if (!contracted) {
+      break;
+    }
+  }
+  return true;
+}
+
+// Hansen-Bliek-Rohn enclosure in Neumaier's formulation, then verified:
+// if the Krawczyk image r + (I - c) x of the slightly inflated result lies
+// in its interior, it contains the whole solution set.
+static bool HansenBliekRohn(int n, const Matrix &c, const Vector &r,
+                            const std::vector<long double> &cmp,
+                            const std::vector<long double> &inv, Vector &x) {
+  int n1 = n + 1;
+  Vector h(n1);
+  for (int i = 1; i <= n; i++) {
+    long double u = 0;
+    for (int j = 1; j <= n; j++) {
+      u += inv[i * n1 + j] * Mag(r[j]);
+    }
+    long double d = inv[i * n1 + i];
+    if (!(d > 0)) {
+      return false;
+    }
+    long double alpha = std::max(0.0L, cmp[i * n1 + i] - 1 / d);
+    long double beta = std::max(0.0L, u / d - Mag(r[i]));
+    ValInterval den = IAdd(c[i * n1 + i], ValInterval(-alpha, alpha));
+    if (den.a <= 0 && den.b >= 0) {
+      return false;
+    }
+    ValInterval num = IAdd(r[i], ValInterval(-beta, beta));
+    h[i] = IDiv(num, den);
+
+    // epsilon inflation
+    long double w = IntWidth(h[i]) * 0.1L + 1e-300L;
+    h[i] = IAdd(h[i], ValInterval(-w, w));
+  }
+
+  for (int i = 1; i <= n; i++) {
+    ValInterval s = r[i];
+    for (int j = 1; j <= n; j++) {
+      ValInterval e = ISub(ValInterval(i == j ? 1 : 0, i == j ? 1 : 0),
+                           c[i * n1 + j]);
+      s = IAdd(s, IMul(e, h[j]));
+    }
+    if (!(s.a > h[i].a && s.b < h[i].b)) {
+      return false;
+    }
+    x[i] = s;
+  }
+  return true;
+}
+
+/**
+ * Encloses the solution set of the interval linear system a x = b
+ * preconditioned with the inverse of the midpoint of a.
+ *
+ * @param n Number of equations
+ * @param a Interval matrix (1-based, stride n + 1)
+ * @param b Right-hand side
+ * @param x Enclosure of the solution set (output, size n + 1)
+ * @param method HANSEN_BLIEK_ROHN or GAUSS_SEIDEL
+ * @param st Status code (output):
+ *           0 = success,
+ *           1 = invalid input (n<1 or unsupported method),
+ *           2 = the preconditioned matrix is not an H-matrix
+ */
+void IntervalLinearSystem(int n, const Matrix &a, const Vector &b, Vector &x,
+                          LinearSolver method, int &st) {
+  if (n < 1 || method == LinearSolver::GAUSS) {
+    st = 1;
+    return;
+  }
+
+  int n1 = n + 1;
+  std::vector<long double> y(n1 * n1);
+  if (!MidpointInverse(n, a, y)) {
+    st = 2;
+    return;
+  }
+
+  Matrix c(n1 * n1);
+  Vector r(n1);
+  Precondition(n, y, a, b, c, r);
+
+  std::vector<long double> cmp(n1 * n1);
+  std::vector<long double> inv(n1 * n1);
+  Comparison(n, c, cmp);
+  std::vector<long double> work = cmp;
+  if (!PointInverse(n, work, inv)) {
+    st = 2;
+    return;
+  }
+
+  st = 0;
+  if (method == LinearSolver::HANSEN_BLIEK_ROHN &&
+      HansenBliekRohn(n, c, r, cmp, inv, x)) {
+    GaussSeidel(n, c, r, x);
+    return;
+  }
+
+  if (!InitialEnclosure(n, r, cmp, inv, x) || !GaussSeidel(n, c, r, x)) {
+    st = 2;
+  }
+}
+}  // namespace NInterval
@@ -0,0 +1,467 @@
+#include "../include/IsolatedLibrary.h"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "../include/SharedLibrary.h"
+
+extern char **environ;
+
+using NStandard::DerivativeTypeC;
+using NStandard::FunctionTypeC;
+using NStandard::Val;
+
+namespace {
+
+// Descriptor of the shared memory region in the worker
+const int WORKER_FD = 3;
+const size_t HEADER_SIZE = 4096;
+// Keeps the shared Jacobian within 256 MB
+const int MAX_EQUATIONS = 4096;
+
+// Values of Channel::state, the futex word
+enum : uint32_t { STARTING, READY, FAILED, REQUEST, DONE, QUIT };
+
+// Start of the shared region, followed by x, the residuals and the Jacobian
+// rows, all 1-based with n + 1 entries per vector
+struct Channel {
+  std::atomic<uint32_t> state;
+  // Set while a side sleeps in the kernel, so the other knows to wake it
+  std::atomic<uint32_t> parentWaiting;
+  std::atomic<uint32_t> workerWaiting;
+  int32_t equations;
+  uint64_t size;
+  char name[256];
+  char error[512];
+};
+
+size_t DataOffset() {
+  return (sizeof(Channel) + 63) & ~static_cast<size_t>(63);
+}
+
+size_t MappingSize(int n) {
+  size_t m = n + 1;
+  return DataOffset() + (2 * m + m * m) * sizeof(Val);
+}
+
+Val *Data(Channel *channel) {
+  return reinterpret_cast<Val *>(reinterpret_cast<char *>(channel) +
+                                 DataOffset());
+}
+
+void FutexWait(std::atomic<uint32_t> *word, uint32_t value, long nanoseconds) {
+  timespec timeout = {nanoseconds / 1000000000, nanoseconds % 1000000000};
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, value,
+          &timeout, nullptr, 0);
+}
+
+void FutexWake(std::atomic<uint32_t> *word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, 1,
+          nullptr, nullptr, 0);
+}
+
+// Busy waiting pays off when the other side runs on another CPU; on a
+// single one, yielding hands it the CPU without a futex round trip
+const bool SINGLE_CPU = std::thread::hardware_concurrency() <= 1;
+
+inline void Pause() {
+  if (SINGLE_CPU) {
+    sched_yield();
+    return;
+  }
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#endif
+}
+
+int SpinLimit() { return SINGLE_CPU ? 20 : 4000; }
+
+// Publishes a new state; the kernel is only entered when the other side
+// sleeps. Both sides store before they load, so a sleeper is never missed.
+void Signal(Channel *channel, uint32_t value,
+            std::atomic<uint32_t> &otherWaiting) {
+  channel->state.store(value);
+  if (otherWaiting.load()) {
+    FutexWake(&channel->state);
+  }
+}
+
+std::string WorkerPath() {
+  const char *variable = std::getenv("EAN_WORKER");
+  if (variable && *variable) {
+    return variable;
+  }
+  // Next to the executable, then on the PATH
+  char executable[4096];
+  ssize_t length =
+      readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+  if (length > 0) {
+    executable[length] = '\0';
+    std::string path(executable);
+    path = path.substr(0, path.rfind('/') + 1) + "ean-worker";
+    if (access(path.c_str(), X_OK) == 0) {
+      return path;
+    }
+  }
+  return "ean-worker";
+}
+
+std::string DescribeExit(int status) {
+  char message[128];
+  if (WIFSIGNALED(status)) {
+    std::snprintf(message, sizeof(message),
+                  "Library process killed by signal %d (%s)",
+                  WTERMSIG(status), strsignal(WTERMSIG(status)));
+  } else {
+    std::snprintf(message, sizeof(message),
+                  "Library process exited with status %d",
+                  WEXITSTATUS(status));
+  }
+  return message;
+}
+
+// Waits in the worker until the parent posts a request; QUIT when the
+// parent is gone
+uint32_t WaitForRequest(Channel *channel, pid_t parent) {
+  uint32_t state;
+  for (int spin = 0; spin < SpinLimit(); spin++) {
+    state = channel->state.load(std::memory_order_acquire);
+    if (state == REQUEST || state == QUIT) {
+      return state;
+    }
+    Pause();
+  }
+  channel->workerWaiting.store(1);
+  for (;;) {
+    state = channel->state.load();
+    if (state == REQUEST || state == QUIT) {
+      break;
+    }
+    FutexWait(&channel->state, state, 1000000000);
+    if (getppid() != parent) {
+      state = QUIT;
+      break;
+    }
+  }
+  channel->workerWaiting.store(0);
+  return state;
+}
+}  // namespace
+
+struct IsolatedLibrary::Worker {
+  pid_t pid = -1;
+  Channel *channel = nullptr;
+  size_t size = 0;
+  int n = 0;
+
+  ~Worker() {
+    if (pid > 0) {
+      kill(pid, SIGKILL);
+      waitpid(pid, nullptr, 0);
+    }
+    if (channel) {
+      munmap(channel, size);
+    }
+  }
+
+  // Reaps the worker if it has terminated
+  bool alive(std::string &message) {
+    int status;
+    pid_t result = waitpid(pid, &status, WNOHANG);
+    if (result == 0) {
+      return true;
+    }
+    message = result == pid ? DescribeExit(status) : "Library process lost";
+    pid = -1;
+    return false;
+  }
+
+  // Waits while the state is busy; false if the worker died meanwhile
+  bool wait(uint32_t busy, std::string &message) {
+    for (int spin = 0; spin < SpinLimit(); spin++) {
+      if (channel->state.load(std::memory_order_acquire) != busy) {
+        return true;
+      }
+      Pause();
+    }
+    bool running = true;
+    channel->parentWaiting.store(1);
+    while (channel->state.load() == busy) {
+      // A dead worker never wakes us, so look at it now and then
+      FutexWait(&channel->state, busy, 20000000);
+      if (channel->state.load() == busy && !alive(message)) {
+        running = false;
+        break;
+      }
+    }
+    channel->parentWaiting.store(0);
+    return running;
+  }
+};
+
+IsolatedLibrary::Session::Session(IsolatedLibrary &library)
+    : library(library), worker(library.acquire()), cached(false) {}
+
+IsolatedLibrary::Session::~Session() { library.release(std::move(worker)); }
+
+void IsolatedLibrary::Session::evaluate(const Val *x) {
+  if (!worker) {
+    // Replaces the worker lost by an earlier request
+    worker = library.acquire();
+  }
+  Channel *channel = worker->channel;
+  Val *shared = Data(channel);
+  for (int i = 1; i <= worker->n; i++) {
+    shared[i] = x[i];
+  }
+  Signal(channel, REQUEST, channel->workerWaiting);
+  std::string message;
+  if (!worker->wait(REQUEST, message)) {
+    cached = false;
+    library.release(std::move(worker));
+    throw Error(message);
+  }
+  cached = true;
+}
+
+Val IsolatedLibrary::Session::function(int i, const Val *x) {
+  bool stale = !cached;
+  const Val *shared = cached ? Data(worker->channel) : nullptr;
+  for (int j = 1; !stale && j <= worker->n; j++) {
+    stale = shared[j] != x[j];
+  }
+  if (stale) {
+    evaluate(x);
+  }
+  return Data(worker->channel)[worker->n + 1 + i];
+}
+
+void IsolatedLibrary::Session::derivatives(int i, const Val *x, Val *dfatx) {
+  function(i, x);
+  int n = worker->n;
+  const Val *row = Data(worker->channel) + 2 * (n + 1) + i * (n + 1);
+  for (int j = 1; j <= n; j++) {
+    dfatx[j] = row[j];
+  }
+}
+
+IsolatedLibrary::IsolatedLibrary() : n(0), crashes(0) {}
+
+IsolatedLibrary::~IsolatedLibrary() {}
+
+bool IsolatedLibrary::load(const std::string &libraryPath) {
+  std::lock_guard<std::mutex> guard(lock);
+  idle.clear();
+  path = libraryPath;
+  n = 0;
+  std::unique_ptr<Worker> worker = start(error);
+  if (!worker) {
+    return false;
+  }
+  n = worker->n;
+  libraryName = worker->channel->name;
+  idle.push_back(std::move(worker));
+  error.clear();
+  return true;
+}
+
+std::string IsolatedLibrary::errorString() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return error;
+}
+
+std::string IsolatedLibrary::name() const { return libraryName; }
+
+int IsolatedLibrary::equations() const { return n; }
+
+int IsolatedLibrary::restarts() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return crashes;
+}
+
+std::unique_ptr<IsolatedLibrary::Worker> IsolatedLibrary::acquire() {
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!idle.empty()) {
+      std::unique_ptr<Worker> worker = std::move(idle.back());
+      idle.pop_back();
+      return worker;
+    }
+  }
+  std::string message;
+  std::unique_ptr<Worker> worker = start(message);
+  if (!worker) {
+    throw Error(message);
+  }
+  if (worker->n != n) {
+    throw Error("Library changed its number of equations");
+  }
+  return worker;
+}
+
+void IsolatedLibrary::release(std::unique_ptr<Worker> worker) {
+  if (!worker) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  if (worker->pid > 0) {
+    idle.push_back(std::move(worker));
+  } else {
+    crashes++;
+  }
+}
+
+std::unique_ptr<IsolatedLibrary::Worker> IsolatedLibrary::start(
+    std::string &message) const {
+  int fd = memfd_create("ean-worker", MFD_CLOEXEC);
+  if (fd == WORKER_FD) {
+    // dup2 onto itself would keep the close-on-exec flag
+    int moved = fcntl(fd, F_DUPFD_CLOEXEC, WORKER_FD + 1);
+    close(fd);
+    fd = moved;
+  }
+  if (fd < 0 || ftruncate(fd, HEADER_SIZE) != 0) {
+    message = std::string("Cannot create shared memory: ") +
+              std::strerror(errno);
+    if (fd >= 0) {
+      close(fd);
+    }
+    return nullptr;
+  }
+  void *header = mmap(nullptr, HEADER_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+  if (header == MAP_FAILED) {
+    message = std::string("Cannot map shared memory: ") + std::strerror(errno);
+    close(fd);
+    return nullptr;
+  }
+  std::unique_ptr<Worker> worker(new Worker);
+  worker->channel = new (header) Channel();
+  worker->size = HEADER_SIZE;
+
+  std::string executable = WorkerPath();
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_adddup2(&actions, fd, WORKER_FD);
+  char *argv[] = {const_cast<char *>("ean-worker"),
+                  const_cast<char *>(path.c_str()), nullptr};
+  int result = posix_spawnp(&worker->pid, executable.c_str(), &actions,
+                            nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  close(fd);
+  if (result != 0) {
+    worker->pid = -1;
+    message = "Cannot start " + executable + ": " + std::strerror(result);
+    return nullptr;
+  }
+
+  if (!worker->wait(STARTING, message)) {
+    return nullptr;
+  }
+  Channel *channel = worker->channel;
+  if (channel->state.load() == FAILED) {
+    channel->error[sizeof(channel->error) - 1] = '\0';
+    message = channel->error;
+    return nullptr;
+  }
+  // The worker has grown the region to hold the vectors
+  void *full = mremap(channel, HEADER_SIZE, channel->size, MREMAP_MAYMOVE);
+  if (full == MAP_FAILED) {
+    message = std::string("Cannot map shared memory: ") + std::strerror(errno);
+    return nullptr;
+  }
+  worker->channel = static_cast<Channel *>(full);
+  worker->size = worker->channel->size;
+  worker->n = worker->channel->equations;
+  worker->channel->name[sizeof(channel->name) - 1] = '\0';
+  return worker;
+}
+
+int RunIsolatedWorker(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::fprintf(stderr, "ean-worker is started by the solvers\n");
+    return 2;
+  }
+  pid_t parent = getppid();
+  void *header = mmap(nullptr, HEADER_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_SHARED, WORKER_FD, 0);
+  if (header == MAP_FAILED) {
+    std::perror("ean-worker");
+    return 2;
+  }
+  Channel *channel = static_cast<Channel *>(header);
+  auto fail = [channel](const std::string &message) {
+    std::snprintf(channel->error, sizeof(channel->error), "%s",
+                  message.c_str());
+    Signal(channel, FAILED, channel->parentWaiting);
+    return 1;
+  };
+
+  SharedLibrary library;
+  if (!library.load(argv[1])) {
+    return fail(library.errorString());
+  }
+  FunctionTypeC f =
+      (FunctionTypeC)library.resolve("evaluateFunction", "standard");
+  DerivativeTypeC df =
+      (DerivativeTypeC)library.resolve("evaluateDerivatives", "standard");
+  const char *(*getName)() =
+      (const char *(*)())library.resolve("getName", "standard");
+  int (*getNumberOfEquations)() =
+      (int (*)())library.resolve("getNumberOfEquations", "standard");
+  if (!f || !df || !getName || !getNumberOfEquations) {
+    return fail("Missing functions in library");
+  }
+  int n = getNumberOfEquations();
+  if (n < 1 || n > MAX_EQUATIONS) {
+    return fail("Unsupported number of equations");
+  }
+
+  size_t size = MappingSize(n);
+  if (ftruncate(WORKER_FD, size) != 0) {
+    return fail(std::string("Cannot grow shared memory: ") +
+                std::strerror(errno));
+  }
+  void *full = mremap(header, HEADER_SIZE, size, MREMAP_MAYMOVE);
+  if (full == MAP_FAILED) {
+    return fail(std::string("Cannot map shared memory: ") +
+                std::strerror(errno));
+  }
+  close(WORKER_FD);
+  channel = static_cast<Channel *>(full);
+  const char *name = getName();
+  std::snprintf(channel->name, sizeof(channel->name), "%s", name ? name : "");
+  channel->equations = n;
+  channel->size = size;
+  Signal(channel, READY, channel->parentWaiting);
+
+  Val *x = Data(channel);
+  Val *fx = x + n + 1;
+  Val *jacobian = fx + n + 1;
+  while (WaitForRequest(channel, parent) == REQUEST) {
+    for (int i = 1; i <= n; i++) {
+      fx[i] = f(i, n, x);
+      df(i, n, x, jacobian + i * (n + 1));
+    }
+    Signal(channel, DONE, channel->parentWaiting);
+  }
+  return 0;
+}
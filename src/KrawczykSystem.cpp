@@ -0,0 +1,180 @@
+#include "../include/KrawczykSystem.h"
+
+#include <cmath>
+#include <vector>
+
+#include "../include/IntervalLinearSystem.h"
+
+namespace NInterval {
+
+static inline ValInterval Point(long double v) { return ValInterval(v, v); }
+
+/**
+ * Encloses the solutions of a system of n nonlinear equations
+ * f[i](x[1],x[2],...,x[n])=0 (i=1,2,...,n) lying in the box x using the
+ * Krawczyk operator or the Hansen-Sengupta interval Gauss-Seidel operator,
+ * both preconditioned with the inverse of the midpoint Jacobian.
+ *
+ * @param n Number of equations
+ * @param x Initial box (contracted on exit)
+ * @param f Function that calculates the value of function f[i]
+ * @param df Function that calculates the derivatives df[i]/dx[j] (j=1,2,...,n)
+ * @param method Contraction operator
+ * @param mit Maximum number of contraction steps
+ * @param eps Relative width below which the box is not contracted further
+ * @param it Number of iterations performed (output)
+ * @param st Status code (output):
+ *           0 = success (box stopped contracting),
+ *           1 = invalid input (n<1, mit<1 or improper box),
+ *           2 = singular midpoint Jacobian,
+ *           3 = iterations exceeded,
+ *           4 = the box contains no solution,
+ *           5 = the box was split in two (Hansen-Sengupta only)
+ * @param unique True if the box is proven to contain exactly one solution
+ *               (output)
+ * @param split If not null, receives the second part of the box when a
+ *              pivot containing zero cuts a gap out of it; otherwise the
+ *              hull of both parts is kept
+ */
+void KrawczykSystem(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                    Contractor method, int mit, ValInterval eps, int &it,
+                    int &st, bool &unique, Vector *split) {
+  it = 0;
+  unique = false;
+  if (n < 1 || mit < 1) {
+    st = 1;
+    return;
+  }
+  for (int i = 1; i <= n; i++) {
+    if (x[i].a > x[i].b) {
+      st = 1;
+      return;
+    }
+  }
+
+  st = 0;
+  int n1 = n + 1;
+
+  Vector m(n1);
+  Vector b(n1);
+  Vector fm(n1);
+  Vector dx(n1);
+  Vector dfatx(n1);
+  Matrix j(n1 * n1);
+  Matrix a(n1 * n1);
+  std::vector<long double> y(n1 * n1);
+
+  bool cond = false;
+  do {
+    it++;
+    if (it > mit) {
+      st = 3;
+      it--;
+      break;
+    }
+
+    for (int i = 1; i <= n; i++) {
+      m[i] = Point(x[i].Mid());
+      dx[i] = ISub(x[i], m[i]);
+    }
+
+    // Interval Jacobian over the box and residual at the midpoint
+    for (int k = 1; k <= n; k++) {
+      df(k, n, &x[0], &dfatx[0]);
+      for (int c = 1; c <= n; c++) {
+        j[k * n1 + c] = dfatx[c];
+      }
+      fm[k] = f(k, n, &m[0]);
+    }
+
+    if (!MidpointInverse(n, j, y)) {
+      st = 2;
+      break;
+    }
+
+    // Preconditioned system a = y * j, b = y * f(m)
+    Precondition(n, y, j, fm, a, b);
+
+    bool inside = true;
+    cond = true;
+    for (int i = 1; i <= n; i++) {
+      ValInterval s = b[i];
+      ValInterval k;
+      if (method == Contractor::KRAWCZYK) {
+        // K(x) = m - y f(m) + (I - y f'(x)) (x - m)
+        for (int c = 1; c <= n; c++) {
+          ValInterval e = ISub(Point(i == c ? 1 : 0), a[i * n1 + c]);
+          s = ISub(s, IMul(e, dx[c]));
+        }
+        k = ISub(m[i], s);
+      } else {
+        // Gauss-Seidel sweep reusing the components already contracted
+        ValInterval d = a[i * n1 + i];
+        for (int c = 1; c <= n; c++) {
+          if (c != i) {
+            s = IAdd(s, IMul(a[i * n1 + c], dx[c]));
+          }
+        }
+
+        // A pivot containing zero leaves up to two pieces of x[i]
+        ValInterval q1, q2;
+        int count = IDivExtended(s, d, q1, q2);
+        if (count == 0) {
+          st = 4;
+          break;
+        }
+        k = ISub(m[i], q1);
+        if (d.a <= 0 && d.b >= 0) {
+          inside = false;
+        }
+        if (count == 2) {
+          ValInterval r1, r2;
+          bool in1 = Intersect(x[i], k, r1);
+          bool in2 = Intersect(x[i], ISub(m[i], q2), r2);
+          if (in1 && in2) {
+            if (split != nullptr) {
+              *split = x;
+              (*split)[i] = r2;
+              x[i] = r1;
+              st = 5;
+              break;
+            }
+            k = Hull(r1, r2);
+          } else if (in2) {
+            k = r2;
+          }
+        }
+      }
+
+      if (std::isnan(k.a) || std::isnan(k.b)) {
+        inside = false;
+        continue;
+      }
+      if (!(k.a > x[i].a && k.b < x[i].b)) {
+        inside = false;
+      }
+
+      ValInterval r;
+      if (!Intersect(x[i], k, r)) {
+        st = 4;
+        break;
+      }
+
+      long double w = IntWidth(x[i]);
+      long double wr = IntWidth(r);
+      long double ref = std::max(std::abs(r.a), std::abs(r.b));
+      if (wr < 0.9L * w && wr > eps.b * ref) {
+        cond = false;
+      }
+      x[i] = r;
+      if (method == Contractor::HANSEN_SENGUPTA) {
+        dx[i] = ISub(x[i], m[i]);
+      }
+    }
+
+    if (st == 0 && inside) {
+      unique = true;
+    }
+  } while (st == 0 && !cond);
+}
+}  // namespace NInterval
@@ -0,0 +1,474 @@
+#include "../include/LibraryRegistry.h"
+
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/inotify.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Paths are canonical, so they always contain a slash
+std::string Directory(const std::string &path) {
+  return path.substr(0, path.rfind('/'));
+}
+
+std::string BaseName(const std::string &path) {
+  return path.substr(path.rfind('/') + 1);
+}
+
+// Messages should name the user's file rather than its snapshot
+std::string Replace(std::string text, const std::string &from,
+                    const std::string &to) {
+  for (size_t at = text.find(from); at != std::string::npos;
+       at = text.find(from, at + to.size())) {
+    text.replace(at, from.size(), to);
+  }
+  return text;
+}
+
+// False for directories on a file system mounted noexec, where dlopen fails
+bool Executable(const std::string &directory) {
+  struct statvfs info;
+  return statvfs(directory.c_str(), &info) != 0 || !(info.f_flag & ST_NOEXEC);
+}
+
+// Places for snapshots, see LibraryRegistry::snapshot()
+const int SNAPSHOT_LOCATIONS = 3;
+
+// The snapshot file lives as long as the solver that loaded it
+template <typename S>
+std::shared_ptr<S> MakeSolver(const std::string &snapshot) {
+  return std::shared_ptr<S>(new S(), [snapshot](S *solver) {
+    delete solver;
+    unlink(snapshot.c_str());
+  });
+}
+}  // namespace
+
+LibraryRegistry::LibraryRegistry() : nextId(1), snapshots(0) {
+  inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+}
+
+LibraryRegistry::~LibraryRegistry() {
+  systems.clear();
+  if (inotifyFd >= 0) {
+    close(inotifyFd);
+  }
+  // Fails, harmlessly, while a caller still holds one of the solvers
+  for (const auto &directory : snapshotDirectories) {
+    if (!directory.second.empty()) {
+      rmdir(directory.second.c_str());
+    }
+  }
+}
+
+int LibraryRegistry::load(const std::string &path, Arithmetic arithmetic,
+                          std::string &error, NStandard::LibraryMode mode) {
+  char resolved[PATH_MAX];
+  if (!realpath(path.c_str(), resolved)) {
+    error = path + ": " + std::strerror(errno);
+    return -1;
+  }
+  std::string canonical = resolved;
+
+  Version version;
+  bool loaded = loadVersion(canonical, arithmetic, mode, version, error);
+
+  std::lock_guard<std::mutex> guard(lock);
+  for (auto &item : systems) {
+    Entry &entry = item.second.entry;
+    if (entry.path == canonical && entry.arithmetic == arithmetic) {
+      if (!loaded) {
+        entry.reloadError = error;
+        return -1;
+      }
+      install(item.second, version);
+      return item.first;
+    }
+  }
+  if (!loaded) {
+    return -1;
+  }
+
+  System system;
+  // generation becomes 0 with the first version
+  system.entry = {0, canonical, arithmetic, mode, "", 0, false, -1, "", false};
+  install(system, version);
+  int id = nextId++;
+  system.entry.id = id;
+  watch(canonical);
+  systems[id] = std::move(system);
+  return id;
+}
+
+int LibraryRegistry::define(const std::string &name, const std::string &source,
+                            std::string &error) {
+  std::shared_ptr<NStandard::Solver> solver =
+      std::make_shared<NStandard::Solver>();
+  if (!solver->loadExpressions(source, name)) {
+    error = solver->getLastError();
+    return -1;
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  System system;
+  system.entry = {nextId++,
+                  "",
+                  Arithmetic::STANDARD,
+                  NStandard::LibraryMode::IN_PROCESS,
+                  solver->getLibraryName(),
+                  solver->getEquationsCount(),
+                  false,
+                  0,
+                  "",
+                  false};
+  system.standard = std::move(solver);
+  int id = system.entry.id;
+  systems[id] = std::move(system);
+  return id;
+}
+
+bool LibraryRegistry::attach(int id, Arithmetic arithmetic,
+                             const std::string &library, std::string &error) {
+  // Loaded outside the lock: the library runs its constructors
+  std::shared_ptr<NStandard::Solver> standard;
+  std::shared_ptr<NInterval::Solver> interval;
+  std::string name;
+  int equations;
+  if (arithmetic == Arithmetic::STANDARD) {
+    standard = std::make_shared<NStandard::Solver>();
+    if (!standard->loadLibrary(library)) {
+      error = standard->getLastError();
+      return false;
+    }
+    name = standard->getLibraryName();
+    equations = standard->getEquationsCount();
+  } else {
+    interval = std::make_shared<NInterval::Solver>();
+    if (!interval->loadLibrary(library)) {
+      error = interval->getLastError();
+      return false;
+    }
+    name = interval->getLibraryName();
+    equations = interval->getEquationsCount();
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = systems.find(id);
+  if (found == systems.end() || !found->second.entry.path.empty()) {
+    error = "Not a system of typed equations";
+    return false;
+  }
+  System &system = found->second;
+  if (name != system.entry.name || equations != system.entry.equations) {
+    error = library + " is not compiled from " + system.entry.name;
+    return false;
+  }
+  if (standard) {
+    system.standard = std::move(standard);
+    system.entry.native = true;
+  } else {
+    if (system.interval) {
+      interval->setContext(system.interval->getContext());
+    }
+    system.interval = std::move(interval);
+  }
+  return true;
+}
+
+bool LibraryRegistry::unload(int id) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = systems.find(id);
+  if (found == systems.end()) {
+    return false;
+  }
+  if (found->second.entry.path.empty()) {
+    systems.erase(found);
+    return true;
+  }
+  std::string directory = Directory(found->second.entry.path);
+  systems.erase(found);
+  for (const auto &item : systems) {
+    if (Directory(item.second.entry.path) == directory) {
+      return true;
+    }
+  }
+  for (auto watched = watchedDirectories.begin();
+       watched != watchedDirectories.end(); ++watched) {
+    if (watched->second == directory) {
+      inotify_rm_watch(inotifyFd, watched->first);
+      watchedDirectories.erase(watched);
+      break;
+    }
+  }
+  return true;
+}
+
+std::vector<LibraryRegistry::Entry> LibraryRegistry::entries() const {
+  std::lock_guard<std::mutex> guard(lock);
+  std::vector<Entry> result;
+  for (const auto &item : systems) {
+    result.push_back(item.second.entry);
+  }
+  return result;
+}
+
+bool LibraryRegistry::find(int id, Entry &entry) const {
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = systems.find(id);
+  if (found == systems.end()) {
+    return false;
+  }
+  entry = found->second.entry;
+  return true;
+}
+
+std::shared_ptr<NStandard::Solver> LibraryRegistry::standard(int id) const {
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = systems.find(id);
+  return found == systems.end() ? nullptr : found->second.standard;
+}
+
+std::shared_ptr<NInterval::Solver> LibraryRegistry::interval(int id) const {
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = systems.find(id);
+  return found == systems.end() ? nullptr : found->second.interval;
+}
+
+int LibraryRegistry::watchDescriptor() const { return inotifyFd; }
+
+std::vector<int> LibraryRegistry::processEvents() {
+  std::vector<int> reloaded;
+  if (inotifyFd < 0) {
+    return reloaded;
+  }
+  // Libraries to reload, collected under the lock and loaded without it
+  std::vector<std::pair<int, Entry>> stale;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    std::set<std::string> changed;
+    bool overflow = false;
+    alignas(inotify_event) char buffer[16384];
+    ssize_t length;
+    while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+      for (char *p = buffer; p < buffer + length;) {
+        const inotify_event *event = reinterpret_cast<inotify_event *>(p);
+        auto directory = watchedDirectories.find(event->wd);
+        if (event->mask & IN_Q_OVERFLOW) {
+          overflow = true;
+        } else if (event->len > 0 && directory != watchedDirectories.end()) {
+          changed.insert(directory->second + "/" + event->name);
+        }
+        p += sizeof(inotify_event) + event->len;
+      }
+    }
+
+    // Lost events could concern any library
+    for (auto &item : systems) {
+      Entry &entry = item.second.entry;
+      if (entry.path.empty()) {
+        continue;
+      }
+      if (overflow || changed.count(entry.path)) {
+        stale.emplace_back(item.first, entry);
+      }
+    }
+  }
+
+  for (const auto &item : stale) {
+    const Entry &entry = item.second;
+    Version version;
+    std::string error;
+    bool loaded =
+        loadVersion(entry.path, entry.arithmetic, entry.mode, version, error);
+    std::lock_guard<std::mutex> guard(lock);
+    auto found = systems.find(item.first);
+    // Unloaded meanwhile
+    if (found == systems.end()) {
+      continue;
+    }
+    if (loaded) {
+      install(found->second, version);
+    } else {
+      found->second.entry.reloadError = error;
+    }
+    reloaded.push_back(item.first);
+  }
+  return reloaded;
+}
+
+bool LibraryRegistry::loadVersion(const std::string &path,
+                                  Arithmetic arithmetic,
+                                  NStandard::LibraryMode mode,
+                                  Version &version, std::string &error) {
+  // Never map the user's file: overwriting a loaded library in place
+  // crashes the process, and dlopen would return the handle it already has
+  // for the path instead of the new version
+  std::string firstError;
+  std::string reason;
+  for (int location = 0; location < SNAPSHOT_LOCATIONS; location++) {
+    std::string copy = snapshot(path, location, reason);
+    if (copy.empty()) {
+      continue;
+    }
+
+    if (arithmetic == Arithmetic::STANDARD) {
+      std::shared_ptr<NStandard::Solver> solver =
+          MakeSolver<NStandard::Solver>(copy);
+      if (solver->loadLibrary(copy, mode)) {
+        version.name = solver->getLibraryName();
+        version.equations = solver->getEquationsCount();
+        version.multiprecision = solver->hasMultiprecision();
+        version.mode = mode;
+        version.standard = std::move(solver);
+        return true;
+      }
+      reason = Replace(solver->getLastError(), copy, path);
+    } else {
+      std::shared_ptr<NInterval::Solver> solver =
+          MakeSolver<NInterval::Solver>(copy);
+      if (solver->loadLibrary(copy)) {
+        version.name = solver->getLibraryName();
+        version.equations = solver->getEquationsCount();
+        version.multiprecision = false;
+        version.mode = NStandard::LibraryMode::IN_PROCESS;
+        version.interval = std::move(solver);
+        return true;
+      }
+      reason = Replace(solver->getLastError(), copy, path);
+    }
+    // A broken library fails everywhere; report why it failed first
+    if (firstError.empty()) {
+      firstError = reason;
+    }
+  }
+  if (!firstError.empty()) {
+    error = firstError;
+  } else if (!reason.empty()) {
+    error = reason;
+  } else {
+    error = "No place to copy " + path + " to that allows loading it";
+  }
+  return false;
+}
+
+// The previous solver is left in version, so that the caller unloads it
+// after releasing the lock
+void LibraryRegistry::install(System &system, Version &version) {
+  Entry &entry = system.entry;
+  if (version.standard) {
+    std::swap(system.standard, version.standard);
+  } else {
+    if (system.interval) {
+      version.interval->setContext(system.interval->getContext());
+    }
+    std::swap(system.interval, version.interval);
+  }
+  entry.name = version.name;
+  entry.equations = version.equations;
+  entry.multiprecision = version.multiprecision;
+  entry.mode = version.mode;
+  entry.generation++;
+  entry.reloadError.clear();
+}
+
+/**
+ * Copies the library at path for loading, to one of the places tried in
+ * turn: 0 - a private directory in $XDG_RUNTIME_DIR, which belongs to the
+ * user and is not normally mounted noexec, 1 - the directory of the
+ * library, which the library was evidently meant to be loaded from,
+ * 2 - a private directory in $TMPDIR or /tmp.
+ *
+ * @param path Canonical path of the library
+ * @param location Place to copy to
+ * @param error Set when the place is unusable
+ * @return Path of the copy, empty if the place is unusable
+ */
+std::string LibraryRegistry::snapshot(const std::string &path, int location,
+                                      std::string &error) {
+  std::string copy;
+  {
+    std::lock_guard<std::mutex> guard(snapshotLock);
+    if (location == 1) {
+      std::string directory = Directory(path);
+      if (!Executable(directory)) {
+        return "";
+      }
+      std::string number = std::to_string(++snapshots);
+      // Hidden, and named apart from the library so that the watch on
+      // the directory does not take it for a rebuild
+      copy = directory + "/." + BaseName(path) + ".ean-" +
+             std::to_string(getpid()) + "-" + number;
+    } else {
+      const char *base =
+          std::getenv(location == 0 ? "XDG_RUNTIME_DIR" : "TMPDIR");
+      if (location == 0 && !(base && *base)) {
+        return "";
+      }
+      std::string directory =
+          snapshotDirectory(base && *base ? base : "/tmp", error);
+      if (directory.empty()) {
+        return "";
+      }
+      copy = directory + "/" + std::to_string(++snapshots) + "-" +
+             BaseName(path);
+    }
+  }
+
+  std::ifstream in(path, std::ios::binary);
+  std::ofstream out(copy, std::ios::binary);
+  if (in && out) {
+    out << in.rdbuf();
+    out.close();
+  }
+  if (!in || !out) {
+    unlink(copy.c_str());
+    error = "Cannot copy " + path + " to " + copy;
+    return "";
+  }
+  return copy;
+}
+
+// Private snapshot directory under base, created on first use. Empty if
+// it cannot be created or base is mounted noexec. Needs snapshotLock.
+std::string LibraryRegistry::snapshotDirectory(const std::string &base,
+                                               std::string &error) {
+  auto found = snapshotDirectories.find(base);
+  if (found != snapshotDirectories.end()) {
+    return found->second;
+  }
+  std::string &directory = snapshotDirectories[base];
+  if (!Executable(base)) {
+    return "";
+  }
+  std::string pattern = base + "/ean-libraries-XXXXXX";
+  std::vector<char> name(pattern.begin(), pattern.end());
+  name.push_back('\0');
+  if (!mkdtemp(name.data())) {
+    error = std::string("Cannot create a snapshot directory: ") +
+            std::strerror(errno);
+    return "";
+  }
+  directory = name.data();
+  return directory;
+}
+
+void LibraryRegistry::watch(const std::string &path) {
+  if (inotifyFd < 0) {
+    return;
+  }
+  // Watching the directory survives builds that replace the file
+  std::string directory = Directory(path);
+  int wd = inotify_add_watch(inotifyFd, directory.c_str(),
+                             IN_CLOSE_WRITE | IN_MOVED_TO);
+  if (wd >= 0) {
+    watchedDirectories[wd] = directory;
+  }
+}
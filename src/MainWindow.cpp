@@ -3,16 +3,26 @@
 #include <qabstractspinbox.h>
 #include <qmessagebox.h>
 
+#include <set>
+
 #include <QDoubleSpinBox>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QHBoxLayout>
+#include <QInputDialog>
 #include <QLabel>
 #include <QLineEdit>
 #include <QMenuBar>
 #include <QPushButton>
 #include <QRadioButton>
+#include <QSettings>
+#include <QSignalBlocker>
+#include <QSocketNotifier>
+#include <QStatusBar>
+#include <QStringList>
 #include <QVBoxLayout>
 
+#include "../include/NativeCompiler.h"
 #include "../include/Solver.h"
 #include "../include/SolverInterval.h"
 #include "../include/Util.h"
@@ -23,13 +33,36 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
   setWindowTitle("Newton Solver");
   auto *loadAction = new QAction("Load Library", this);
   connect(loadAction, &QAction::triggered, this, &MainWindow::loadLibrary);
+  auto *equationsAction = new QAction("Type Equations...", this);
+  connect(equationsAction, &QAction::triggered, this,
+          &MainWindow::enterEquations);
+  auto *pluginAction = new QAction("Add Plugin Directory...", this);
+  connect(pluginAction, &QAction::triggered, this,
+          &MainWindow::addPluginDirectory);
+
+  // Keeps a crashing library from taking the application down
+  isolateAction =
+      new QAction("Run Standard Libraries in a Separate Process", this);
+  isolateAction->setCheckable(true);
 
   QMenu *fileMenu = menuBar()->addMenu("File");
   fileMenu->addAction(loadAction);
+  fileMenu->addAction(equationsAction);
+  fileMenu->addAction(pluginAction);
+  fileMenu->addAction(isolateAction);
 
   mainLayout->setContentsMargins(50, 50, 50, 50);
   mainLayout->setSpacing(20);
 
+  systemInput = new QComboBox(this);
+  systemInput->setPlaceholderText("Load a library from the File menu");
+  QHBoxLayout *systemLayout = new QHBoxLayout();
+  systemLayout->addWidget(new QLabel("System: ", this));
+  systemLayout->addWidget(systemInput, 1);
+  mainLayout->addLayout(systemLayout);
+  connect(systemInput, &QComboBox::currentIndexChanged, this,
+          &MainWindow::selectSystem);
+
   auto modeGroup = new QGroupBox("Arithmetic Mode", this);
   QVBoxLayout *modeLayout = new QVBoxLayout();
   modeGroup->setLayout(modeLayout);
@@ -38,12 +71,54 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
   QRadioButton *radio1 = new QRadioButton("Standard");
   QRadioButton *radio2 = new QRadioButton("Interval (with Standard input)");
   QRadioButton *radio3 = new QRadioButton("Interval (with Interval input)");
+  QRadioButton *radio4 =
+      new QRadioButton("Interval verified (with Interval input)");
+  QRadioButton *radio5 =
+      new QRadioButton("Interval global search (with Interval input)");
+  QRadioButton *radio6 = new QRadioButton("Multiprecision (escalating)");
 
   radio1->setChecked(true);
 
   modeLayout->addWidget(radio1);
   modeLayout->addWidget(radio2);
   modeLayout->addWidget(radio3);
+  modeLayout->addWidget(radio4);
+  modeLayout->addWidget(radio5);
+  modeLayout->addWidget(radio6);
+
+  stepInput = new QComboBox(this);
+  stepInput->addItem("Full Newton step");
+  stepInput->addItem("Line search");
+  stepInput->addItem("Trust region (dogleg)");
+  QHBoxLayout *stepLayout = new QHBoxLayout();
+  stepLayout->addWidget(new QLabel("Step: ", this));
+  stepLayout->addWidget(stepInput);
+  modeLayout->addLayout(stepLayout);
+
+  contractorInput = new QComboBox(this);
+  contractorInput->addItem("Krawczyk");
+  contractorInput->addItem("Hansen-Sengupta");
+  QHBoxLayout *contractorLayout = new QHBoxLayout();
+  contractorLayout->addWidget(new QLabel("Contractor: ", this));
+  contractorLayout->addWidget(contractorInput);
+  modeLayout->addLayout(contractorLayout);
+
+  linearSolverInput = new QComboBox(this);
+  linearSolverInput->addItem("Gaussian elimination");
+  linearSolverInput->addItem("Hansen-Bliek-Rohn (preconditioned)");
+  linearSolverInput->addItem("Interval Gauss-Seidel (preconditioned)");
+  QHBoxLayout *linearSolverLayout = new QHBoxLayout();
+  linearSolverLayout->addWidget(new QLabel("Linear solver: ", this));
+  linearSolverLayout->addWidget(linearSolverInput);
+  modeLayout->addLayout(linearSolverLayout);
+
+  maxPrecisionInput = new QSpinBox(this);
+  maxPrecisionInput->setRange(53, 8192);
+  maxPrecisionInput->setValue(512);
+  QHBoxLayout *maxPrecisionLayout = new QHBoxLayout();
+  maxPrecisionLayout->addWidget(new QLabel("Max precision (bits): ", this));
+  maxPrecisionLayout->addWidget(maxPrecisionInput);
+  modeLayout->addLayout(maxPrecisionLayout);
   connect(radio1, &QRadioButton::toggled, [=](bool checked) {
     if (radio1->isChecked()) {
       arithmeticMode = ArithmeticMode::STANDARD;
@@ -62,6 +137,24 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
       updateInterface();
     }
   });
+  connect(radio4, &QRadioButton::toggled, [=](bool checked) {
+    if (radio4->isChecked()) {
+      arithmeticMode = ArithmeticMode::INTERVAL_VERIFIED;
+      updateInterface();
+    }
+  });
+  connect(radio5, &QRadioButton::toggled, [=](bool checked) {
+    if (radio5->isChecked()) {
+      arithmeticMode = ArithmeticMode::INTERVAL_SEARCH;
+      updateInterface();
+    }
+  });
+  connect(radio6, &QRadioButton::toggled, [=](bool checked) {
+    if (radio6->isChecked()) {
+      arithmeticMode = ArithmeticMode::MULTIPRECISION;
+      updateInterface();
+    }
+  });
 
   inputsGroup = new QGroupBox("Inputs", this);
   inputsGroupLayout = new QVBoxLayout();
@@ -94,12 +187,38 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent) {
 
   setCentralWidget(central);
 
-  standardSolver = std::make_unique<NStandard::Solver>();
-  intervalSolver = std::make_unique<NInterval::Solver>();
+  standardSolver = std::make_shared<NStandard::Solver>();
+  intervalSolver = std::make_shared<NInterval::Solver>();
+
+  // Rebuilt libraries are reloaded as soon as their file is written
+  if (registry.watchDescriptor() >= 0) {
+    auto *watcher = new QSocketNotifier(registry.watchDescriptor(),
+                                        QSocketNotifier::Read, this);
+    connect(watcher, &QSocketNotifier::activated, this,
+            &MainWindow::reloadLibraries);
+  }
+
+  // The cached catalogue is listed at once and checked in the background
+  std::vector<std::string> directories =
+      PluginCatalog::EnvironmentDirectories();
+  for (const QString &directory :
+       QSettings("EAN", "EAN").value("pluginDirectories").toStringList()) {
+    directories.push_back(directory.toStdString());
+  }
+  catalog.setDirectories(directories);
+  catalog.loadCache();
+  refreshSystems(-1);
+  scanPlugins();
   updateInterface();
 }
 
 MainWindow::~MainWindow() {
+  // The catalogue scan and the compilers of typed equations
+  for (QThread *thread : findChildren<QThread *>()) {
+    thread->wait();
+  }
+  // Keeps the names learned by loading plugins
+  catalog.saveCache();
   delete runButton;
   delete resultLabel;
   delete inputsGroupLayout;
@@ -114,44 +233,336 @@ void MainWindow::loadLibrary() {
     QMessageBox::critical(this, "Error", QString("No library selected"));
     return;
   }
-  switch (arithmeticMode) {
-    case ArithmeticMode::STANDARD:
-      if (!standardSolver->loadLibrary(filePath.toStdString())) {
-        QMessageBox::critical(
-            this, "Error",
-            QString("Failed to load library: %1")
-                .arg(QString::fromStdString(standardSolver->getLastError())));
-        return;
+  bool standard = arithmeticMode == ArithmeticMode::STANDARD ||
+                  arithmeticMode == ArithmeticMode::MULTIPRECISION;
+  int id = openLibrary(filePath, standard
+                                     ? LibraryRegistry::Arithmetic::STANDARD
+                                     : LibraryRegistry::Arithmetic::INTERVAL);
+  if (id < 0) {
+    return;
+  }
+  LibraryRegistry::Entry entry;
+  registry.find(id, entry);
+  QMessageBox::information(
+      this, "Library Loaded",
+      QString("Name: %1").arg(QString::fromStdString(entry.name)));
+}
+
+void MainWindow::enterEquations() {
+  bool accepted;
+  QString text = QInputDialog::getMultiLineText(
+      this, "Type Equations",
+      "One equation per line in x1, x2, ..., e.g. x1^2 + 8*x2 - 16 or\n"
+      "x1 = exp(x2); functions: sin cos tan asin acos atan sinh cosh tanh\n"
+      "exp log sqrt abs; constants: pi e; # starts a comment",
+      equationsText.isEmpty() ? "x1^2 + 8*x2 - 16\nx1 = exp(x2)\n"
+                              : equationsText,
+      &accepted);
+  if (!accepted) {
+    return;
+  }
+  equationsText = text;
+  std::string error;
+  std::string name =
+      QString("Equations %1").arg(typedSystems + 1).toStdString();
+  int id = registry.define(name, text.toStdString(), error);
+  if (id < 0) {
+    QMessageBox::critical(
+        this, "Error",
+        QString("Invalid equations: %1").arg(QString::fromStdString(error)));
+    return;
+  }
+  typedSystems++;
+  if (arithmeticMode != ArithmeticMode::STANDARD &&
+      arithmeticMode != ArithmeticMode::MULTIPRECISION) {
+    statusBar()->showMessage(
+        "Typed equations are solved in standard arithmetic until their "
+        "interval library is compiled",
+        5000);
+  }
+  refreshSystems(id);
+  selectSystem(systemInput->currentIndex());
+  compileEquations(id, name, text.toStdString());
+}
+
+// Builds native libraries of typed equations in the background. The
+// system is interpreted until they are ready and then switched over; a
+// system compiled in an earlier session is found in the cache at once.
+void MainWindow::compileEquations(int id, const std::string &name,
+                                  const std::string &source) {
+  struct Build {
+    std::string standard;
+    std::string interval;
+    std::string error;
+  };
+  auto build = std::make_shared<Build>();
+  QThread *thread = QThread::create([build, name, source] {
+    ExpressionSystem system;
+    if (!system.parse(source, name)) {
+      build->error = system.errorString();
+      return;
+    }
+    NativeCompiler compiler;
+    build->standard = compiler.compile(
+        system, ExpressionSystem::Target::STANDARD, build->error);
+    // Equations using functions the interval arithmetic lacks have none
+    std::string ignored;
+    build->interval = compiler.compile(
+        system, ExpressionSystem::Target::INTERVAL, ignored);
+  });
+  thread->setParent(this);
+  connect(thread, &QThread::finished, this, [this, thread, build, id] {
+    thread->deleteLater();
+    std::string error = build->error;
+    if (build->standard.empty() ||
+        !registry.attach(id, LibraryRegistry::Arithmetic::STANDARD,
+                         build->standard, error)) {
+      // No compiler, or the system was unloaded meanwhile
+      LibraryRegistry::Entry entry;
+      if (registry.find(id, entry)) {
+        statusBar()->showMessage(
+            QString("Typed equations stay interpreted: %1")
+                .arg(QString::fromStdString(error)),
+            5000);
       }
-      QMessageBox::information(
-          this, "Library Loaded",
-          QString("Name: %1")
-              .arg(QString::fromStdString(standardSolver->getLibraryName())));
-      break;
-    case ArithmeticMode::INTERVAL:
-    case ArithmeticMode::INTERVAL_INPUT:
-      if (!intervalSolver->loadLibrary(filePath.toStdString())) {
-        QMessageBox::critical(
-            this, "Error",
-            QString("Failed to load library: %1")
-                .arg(QString::fromStdString(intervalSolver->getLastError())));
-        return;
+      return;
+    }
+    if (!build->interval.empty()) {
+      std::string ignored;
+      registry.attach(id, LibraryRegistry::Arithmetic::INTERVAL,
+                      build->interval, ignored);
+    }
+    refreshSystems(currentSystem);
+    if (id == currentSystem) {
+      // Same equations, so the guesses typed so far stay unless the
+      // interval solver was another system's until now
+      int beforeInterval = intervalSolver->getEquationsCount();
+      standardSolver = registry.standard(id);
+      if (auto solver = registry.interval(id)) {
+        intervalSolver = solver;
       }
-      QMessageBox::information(
-          this, "Library Loaded",
-          QString("Name: %1")
-              .arg(QString::fromStdString(intervalSolver->getLibraryName())));
-      break;
+      if (intervalSolver->getEquationsCount() != beforeInterval) {
+        updateInterface();
+      }
+    }
+    statusBar()->showMessage("Typed equations now run as native code", 5000);
+  });
+  thread->start();
+}
+
+void MainWindow::addPluginDirectory() {
+  QString directory =
+      QFileDialog::getExistingDirectory(this, "Select Plugin Directory");
+  if (directory.isEmpty()) {
+    return;
+  }
+  QSettings settings("EAN", "EAN");
+  QStringList saved = settings.value("pluginDirectories").toStringList();
+  if (!saved.contains(directory)) {
+    saved.append(directory);
+    settings.setValue("pluginDirectories", saved);
+  }
+  std::vector<std::string> directories = catalog.getDirectories();
+  directories.push_back(directory.toStdString());
+  catalog.setDirectories(directories);
+  scanPlugins();
+}
+
+// Scans the plugin directories on a worker thread; a request made while a
+// scan runs starts another one when it finishes
+void MainWindow::scanPlugins() {
+  if (scanThread) {
+    scanPending = true;
+    return;
+  }
+  scanThread = QThread::create([this] {
+    catalog.scan();
+    catalog.saveCache();
+  });
+  scanThread->setParent(this);
+  connect(scanThread, &QThread::finished, this, [this] {
+    scanThread->deleteLater();
+    scanThread = nullptr;
+    refreshSystems(currentSystem);
+    if (scanPending) {
+      scanPending = false;
+      scanPlugins();
+    }
+  });
+  scanThread->start();
+}
+
+// Loads the library into the registry and selects it, or returns -1 after
+// reporting the error
+int MainWindow::openLibrary(const QString &path,
+                            LibraryRegistry::Arithmetic arithmetic) {
+  std::string error;
+  int id = registry.load(path.toStdString(), arithmetic, error,
+                         isolateAction->isChecked()
+                             ? NStandard::LibraryMode::ISOLATED
+                             : NStandard::LibraryMode::IN_PROCESS);
+  if (id < 0) {
+    QMessageBox::critical(
+        this, "Error",
+        QString("Failed to load library: %1")
+            .arg(QString::fromStdString(error)));
+    return -1;
+  }
+  LibraryRegistry::Entry entry;
+  registry.find(id, entry);
+  catalog.describe(entry.path, entry.name, entry.equations);
+  refreshSystems(id);
+  selectSystem(systemInput->currentIndex());
+  return id;
+}
+
+// Lists the loaded systems, keeping selectId selected
+void MainWindow::refreshSystems(int selectId) {
+  QSignalBlocker blocker(systemInput);
+  systemInput->clear();
+  std::set<std::string> loaded;
+  for (const LibraryRegistry::Entry &entry : registry.entries()) {
+    QString label =
+        QString("%1 (%2, %3)")
+            .arg(QString::fromStdString(entry.name),
+                 entry.arithmetic == LibraryRegistry::Arithmetic::STANDARD
+                     ? "standard"
+                     : "interval",
+                 entry.path.empty()
+                     ? QString(entry.native ? "typed, native" : "typed")
+                     : QFileInfo(QString::fromStdString(entry.path))
+                           .fileName());
+    if (entry.generation > 0) {
+      label += QString(", reload %1").arg(entry.generation);
+    }
+    systemInput->addItem(label, entry.id);
+    systemInput->setItemData(systemInput->count() - 1,
+                             QString::fromStdString(entry.path),
+                             Qt::ToolTipRole);
+    loaded.insert(entry.path);
+  }
+
+  // Catalogue plugins that are not loaded yet have id 0 and their path
+  bool separated = false;
+  for (const PluginCatalog::Plugin &plugin : catalog.plugins()) {
+    if (loaded.count(plugin.path)) {
+      continue;
+    }
+    if (!separated && systemInput->count() > 0) {
+      systemInput->insertSeparator(systemInput->count());
+    }
+    separated = true;
+    QString file = QFileInfo(QString::fromStdString(plugin.path)).fileName();
+    QString label =
+        QString("%1 (%2, %3)")
+            .arg(plugin.name.empty() ? file
+                                     : QString::fromStdString(plugin.name),
+                 PluginArithmeticName(plugin.arithmetic), file);
+    if (plugin.equations > 0) {
+      label += QString(", %1 equations").arg(plugin.equations);
+    }
+    int index = systemInput->count();
+    systemInput->addItem(label, 0);
+    systemInput->setItemData(index, QString::fromStdString(plugin.path),
+                             Qt::ToolTipRole);
+    systemInput->setItemData(index, QString::fromStdString(plugin.path),
+                             Qt::UserRole + 1);
+    systemInput->setItemData(index, static_cast<int>(plugin.arithmetic),
+                             Qt::UserRole + 2);
   }
+  systemInput->setCurrentIndex(selectId > 0 ? systemInput->findData(selectId)
+                                            : -1);
+}
 
+void MainWindow::selectSystem(int index) {
+  if (index < 0) {
+    return;
+  }
+  QString path = systemInput->itemData(index, Qt::UserRole + 1).toString();
+  if (!path.isEmpty()) {
+    auto arithmetic = static_cast<PluginCatalog::Arithmetic>(
+        systemInput->itemData(index, Qt::UserRole + 2).toInt());
+    // Libraries of either arithmetic follow the current mode
+    bool standard =
+        arithmetic == PluginCatalog::Arithmetic::UNKNOWN ||
+                arithmetic == PluginCatalog::Arithmetic::ANY
+            ? arithmeticMode == ArithmeticMode::STANDARD ||
+                  arithmeticMode == ArithmeticMode::MULTIPRECISION
+            : arithmetic == PluginCatalog::Arithmetic::STANDARD;
+    if (openLibrary(path, standard ? LibraryRegistry::Arithmetic::STANDARD
+                                   : LibraryRegistry::Arithmetic::INTERVAL) <
+        0) {
+      refreshSystems(currentSystem);
+    }
+    return;
+  }
+  int id = systemInput->itemData(index).toInt();
+  currentSystem = id;
+  if (auto solver = registry.standard(id)) {
+    standardSolver = solver;
+  }
+  if (auto solver = registry.interval(id)) {
+    intervalSolver = solver;
+  }
   updateInterface();
 }
 
+void MainWindow::reloadLibraries() {
+  std::vector<int> ids = registry.processEvents();
+  if (ids.empty()) {
+    return;
+  }
+  int current = systemInput->currentData().toInt();
+  bool currentReloaded = false;
+  for (int id : ids) {
+    LibraryRegistry::Entry entry;
+    if (!registry.find(id, entry)) {
+      continue;
+    }
+    QString name = QString::fromStdString(entry.name);
+    if (entry.reloadError.empty()) {
+      statusBar()->showMessage(QString("Reloaded %1").arg(name), 5000);
+      currentReloaded = currentReloaded || id == current;
+    } else {
+      statusBar()->showMessage(
+          QString("Reloading %1 failed, keeping the previous version: %2")
+              .arg(name, QString::fromStdString(entry.reloadError)));
+    }
+  }
+  refreshSystems(current);
+  if (!currentReloaded) {
+    return;
+  }
+  // Keep the guesses typed so far unless the size of the system changed
+  int before = standardSolver->getEquationsCount();
+  int beforeInterval = intervalSolver->getEquationsCount();
+  if (auto solver = registry.standard(current)) {
+    standardSolver = solver;
+  }
+  if (auto solver = registry.interval(current)) {
+    intervalSolver = solver;
+  }
+  if (standardSolver->getEquationsCount() != before ||
+      intervalSolver->getEquationsCount() != beforeInterval) {
+    updateInterface();
+  }
+}
+
 void MainWindow::updateInterface() {
   clearInputs();
   resultLabel->clear();
+  stepInput->setEnabled(arithmeticMode == ArithmeticMode::STANDARD);
+  contractorInput->setEnabled(
+      arithmeticMode == ArithmeticMode::INTERVAL_VERIFIED ||
+      arithmeticMode == ArithmeticMode::INTERVAL_SEARCH);
+  linearSolverInput->setEnabled(
+      arithmeticMode == ArithmeticMode::INTERVAL ||
+      arithmeticMode == ArithmeticMode::INTERVAL_INPUT);
+  maxPrecisionInput->setEnabled(arithmeticMode ==
+                                ArithmeticMode::MULTIPRECISION);
   switch (arithmeticMode) {
     case ArithmeticMode::STANDARD:
+    case ArithmeticMode::MULTIPRECISION:
       if (standardSolver->isReady()) {
         runButton->setEnabled(true);
         int n = standardSolver->getEquationsCount();
@@ -164,6 +575,8 @@ void MainWindow::updateInterface() {
       break;
     case ArithmeticMode::INTERVAL:
     case ArithmeticMode::INTERVAL_INPUT:
+    case ArithmeticMode::INTERVAL_VERIFIED:
+    case ArithmeticMode::INTERVAL_SEARCH:
       if (intervalSolver->isReady()) {
         runButton->setEnabled(true);
         int n = intervalSolver->getEquationsCount();
@@ -184,13 +597,16 @@ void MainWindow::createInput(int i) {
   hLayout->addWidget(label);
   switch (arithmeticMode) {
     case ArithmeticMode::STANDARD:
-    case ArithmeticMode::INTERVAL: {
+    case ArithmeticMode::INTERVAL:
+    case ArithmeticMode::MULTIPRECISION: {
       auto *spinBox = new QLineEdit(this);
       spinBox->setText("0.0");
       hLayout->addWidget(spinBox);
       break;
     }
-    case ArithmeticMode::INTERVAL_INPUT: {
+    case ArithmeticMode::INTERVAL_INPUT:
+    case ArithmeticMode::INTERVAL_VERIFIED:
+    case ArithmeticMode::INTERVAL_SEARCH: {
       auto *spinBoxStart = new QLineEdit(this);
       spinBoxStart->setText("0.0");
       hLayout->addWidget(spinBoxStart);
@@ -216,52 +632,89 @@ void MainWindow::clearInputs() {
 
 void MainWindow::showResult(NStandard::SolverResult &result) {
   QString resultText = "Result:\n";
+  char buffer[interval_arithmetic::FORMAT_BUFFER_SIZE];
   for (size_t i = 1; i < result.solution.size(); ++i) {
-    std::ostringstream resultStr;
-    resultStr << std::scientific
-              << std::uppercase
-              // << std::setprecision(18);
-              << std::setprecision(std::numeric_limits<long double>::digits10 +
-                                   1)
-              << "x[" << i << "] = " << result.solution[i] << "\n";
-    resultText += QString::fromStdString(resultStr.str());
+    size_t length = interval_arithmetic::FormatDecimal(
+        result.solution[i], std::numeric_limits<long double>::digits10 + 1,
+        MPFR_RNDN, buffer, sizeof(buffer));
+    resultText += QString("x[%1] = %2\n")
+                      .arg(i)
+                      .arg(QString::fromLatin1(buffer, length));
   }
   resultText += QString("Iterations: %1").arg(result.iterations);
   std::cout << resultText.toStdString() << std::endl;
   resultLabel->setText(resultText);
 }
 
+void MainWindow::showResult(NStandard::SolverResultMP &result) {
+  QString resultText = "Result:\n";
+  int digits = static_cast<int>(result.precision * 0.30103);
+  for (size_t i = 1; i < result.solution.size(); ++i) {
+    resultText += QString::fromStdString(
+        "x[" + std::to_string(i) +
+        "] = " + result.solution[i].toString(digits) + "\n");
+  }
+  resultText += QString("Iterations: %1\n").arg(result.iterations);
+  resultText += QString("Final precision: %1 bits").arg(result.precision);
+  std::cout << resultText.toStdString() << std::endl;
+  resultLabel->setText(resultText);
+}
+
 void MainWindow::showResult(NInterval::SolverResult &result) {
   QString resultText = "Result:\n";
-  std::ostringstream resultStr;
+  char buffer[2 * interval_arithmetic::FORMAT_BUFFER_SIZE];
   for (size_t i = 1; i < result.solution.size(); ++i) {
-    resultStr.str("");
-    resultStr.clear();
-    std::string left, right;
-    result.solution[i].IEndsToStrings(left, right);
-    //   std::cout <<  << std::endl;
-    resultStr
-        << std::scientific << std::uppercase
-        << std::setprecision(18)
-        // << std::setprecision(std::numeric_limits<long double>::digits10 +
-        //                     1)
-        << "x[" << i << "] = " << "[" << left << ";" << right << "]"
-        << "\n";
-    resultStr
-        << std::scientific << std::uppercase
-        << std::setprecision(18)
-        // << std::setprecision(std::numeric_limits<long double>::digits10 +
-        //                     1)
-        << "w(x[" << i << "]) = " << result.solution[i].GetWidth() << "\n";
-    resultText += QString::fromStdString(resultStr.str());
+    size_t length = interval_arithmetic::FormatInterval(
+        result.solution[i],
+        interval_arithmetic::Interval<long double>::GetOutDigits(), buffer,
+        sizeof(buffer));
+    resultText += QString("x[%1] = %2\n")
+                      .arg(i)
+                      .arg(QString::fromLatin1(buffer, length));
+    // The width is an upper bound, so it is rounded up as well
+    length = interval_arithmetic::FormatDecimal(
+        result.solution[i].GetWidth(), 19, MPFR_RNDU, buffer, sizeof(buffer));
+    resultText += QString("w(x[%1]) = %2\n")
+                      .arg(i)
+                      .arg(QString::fromLatin1(buffer, length));
   }
 
   resultText += QString("Iterations: %1\n").arg(result.iterations);
+  if (result.unique) {
+    resultText += "Unique root verified in the box\n";
+  }
+  std::cout << resultText.toStdString() << std::endl;
+  resultLabel->setText(resultText);
+}
+
+void MainWindow::showResult(NInterval::BoxSearchResult &result) {
+  QString resultText = "Result:\n";
+  char buffer[2 * interval_arithmetic::FORMAT_BUFFER_SIZE];
+  for (size_t r = 0; r < result.roots.size(); ++r) {
+    resultText += QString("Root %1:\n").arg(r + 1);
+    NInterval::Vector &box = result.roots[r];
+    for (size_t i = 1; i < box.size(); ++i) {
+      size_t length = interval_arithmetic::FormatInterval(
+          box[i], interval_arithmetic::Interval<long double>::GetOutDigits(),
+          buffer, sizeof(buffer));
+      resultText += QString("x[%1] = %2\n")
+                        .arg(i)
+                        .arg(QString::fromLatin1(buffer, length));
+    }
+  }
+  resultText += QString("Verified roots: %1\n").arg(result.roots.size());
+  resultText += QString("Undecided boxes: %1\n").arg(result.undecided.size());
+  resultText += QString("Boxes processed: %1 (%2 discarded)\n")
+                    .arg(result.processed)
+                    .arg(result.discarded);
+  resultText += QString("Boxes per second: %1\n")
+                    .arg(result.boxesPerSecond(), 0, 'f', 0);
   std::cout << resultText.toStdString() << std::endl;
   resultLabel->setText(resultText);
 }
 
-void MainWindow::checkResultStatus(SolverStatus status) {
+void MainWindow::checkResultStatus(SolverStatus status,
+                                   const std::string &message) {
   switch (status) {
     case SolverStatus::SUCCESS:
       QMessageBox::information(this, "Success",
@@ -277,10 +730,22 @@ void MainWindow::checkResultStatus(SolverStatus status) {
       QMessageBox::warning(this, "Warning", "Max iterations exceeded");
       break;
     case SolverStatus::LIBRARY_ERROR:
-      QMessageBox::critical(this, "Error", "Library error");
+      QMessageBox::critical(this, "Error",
+                            message.empty()
+                                ? QString("Library error")
+                                : QString::fromStdString(message));
+      break;
     case SolverStatus::FUNCTION_NOT_LOADED:
       QMessageBox::critical(this, "Error", "Functions not loaded");
       break;
+    case SolverStatus::NO_ROOT:
+      QMessageBox::information(this, "No Solution",
+                               "The box contains no solution");
+      break;
+    case SolverStatus::PRECISION_EXHAUSTED:
+      QMessageBox::warning(this, "Warning",
+                           "Epsilon not reached at the maximum precision");
+      break;
     default:
       break;
   }
@@ -297,20 +762,54 @@ void MainWindow::runStandardSolver() {
     QLineEdit *spinBox = qobject_cast<QLineEdit *>(
         inputsGroupLayout->itemAt(i)->layout()->itemAt(1)->widget());
     if (spinBox) {
-      NStandard::Val val = std::stold(spinBox->text().toStdString());
+      NStandard::Val val = interval_arithmetic::NearestRead<NStandard::Val>(
+          spinBox->text().toStdString());
       initialGuess[i + 1] = val;
     }
   }
   int maxIterations = maxIterationsInput->value();
   NStandard::Vector inputCopy = initialGuess;
-  NStandard::Val epsilon = std::stold(epsilonInput->text().toStdString());
-  NStandard::SolverResult result =
-      standardSolver->solve(initialGuess, maxIterations, epsilon);
-  checkResultStatus(result.status);
+  NStandard::Val epsilon = interval_arithmetic::NearestRead<NStandard::Val>(
+      epsilonInput->text().toStdString());
+  NStandard::Globalization globalization =
+      static_cast<NStandard::Globalization>(stepInput->currentIndex());
+  NStandard::SolverResult result = standardSolver->solve(
+      initialGuess, maxIterations, epsilon, globalization);
+  checkResultStatus(result.status, result.errorMessage);
   checkAnswer(result, standardSolver->getLibraryName(), inputCopy);
   showResult(result);
 }
 
+void MainWindow::runMultiprecisionSolver() {
+  if (!standardSolver->isReady()) {
+    QMessageBox::critical(this, "Error", "Library not loaded");
+    return;
+  }
+  if (!standardSolver->hasMultiprecision()) {
+    QMessageBox::warning(this, "Warning",
+                         "Library has no multiprecision functions, precision "
+                         "is limited to long double");
+  }
+
+  int maxPrecision = maxPrecisionInput->value();
+  NMultiprecision::Vector initialGuess(standardSolver->getEquationsCount() + 1,
+                                       mpfr::mpreal(0, maxPrecision));
+  for (int i = 0; i < standardSolver->getEquationsCount(); ++i) {
+    QLineEdit *spinBox = qobject_cast<QLineEdit *>(
+        inputsGroupLayout->itemAt(i)->layout()->itemAt(1)->widget());
+    if (spinBox) {
+      initialGuess[i + 1] =
+          mpfr::mpreal(spinBox->text().toStdString(), maxPrecision);
+    }
+  }
+  int maxIterations = maxIterationsInput->value();
+  mpfr::mpreal epsilon(epsilonInput->text().toStdString(), maxPrecision);
+  NStandard::SolverResultMP result = standardSolver->solveMultiprecision(
+      initialGuess, maxIterations, epsilon, maxPrecision);
+  checkResultStatus(result.status, result.errorMessage);
+  showResult(result);
+}
+
 void MainWindow::runIntervalSolver() {
   if (!intervalSolver->isReady()) {
     QMessageBox::critical(this, "Error", "Library not loaded");
@@ -330,8 +829,10 @@ void MainWindow::runIntervalSolver() {
   int maxIterations = maxIterationsInput->value();
   NInterval::ValInterval epsilon = interval_arithmetic::IntRead<NStandard::Val>(
       epsilonInput->text().toStdString());
-  NInterval::SolverResult result =
-      intervalSolver->solve(initialGuess, maxIterations, epsilon);
+  NInterval::LinearSolver linearSolver =
+      static_cast<NInterval::LinearSolver>(linearSolverInput->currentIndex());
+  NInterval::SolverResult result = intervalSolver->solve(
+      initialGuess, maxIterations, epsilon, linearSolver);
   checkResultStatus(result.status);
   showResult(result);
 }
@@ -362,12 +863,70 @@ void MainWindow::runIntervalInputSolver() {
   int maxIterations = maxIterationsInput->value();
   NInterval::ValInterval epsilon = interval_arithmetic::IntRead<NStandard::Val>(
       epsilonInput->text().toStdString());
+  NInterval::LinearSolver linearSolver =
+      static_cast<NInterval::LinearSolver>(linearSolverInput->currentIndex());
+  NInterval::SolverResult result = intervalSolver->solve(
+      initialGuess, maxIterations, epsilon, linearSolver);
+  checkResultStatus(result.status);
+  showResult(result);
+}
+
+NInterval::Vector MainWindow::readIntervalInputs() {
+  NInterval::Vector box(intervalSolver->getEquationsCount() + 1,
+                        NInterval::ValInterval(0.0, 0.0));
+  for (int i = 0; i < intervalSolver->getEquationsCount(); ++i) {
+    QLineEdit *spinBoxStart = qobject_cast<QLineEdit *>(
+        inputsGroupLayout->itemAt(i)->layout()->itemAt(1)->widget());
+    QLineEdit *spinBoxEnd = qobject_cast<QLineEdit *>(
+        inputsGroupLayout->itemAt(i)->layout()->itemAt(2)->widget());
+    if (spinBoxStart && spinBoxEnd) {
+      box[i + 1] = interval_arithmetic::LeftRightRead<NStandard::Val>(
+          spinBoxStart->text().toStdString(), spinBoxEnd->text().toStdString());
+    }
+  }
+  return box;
+}
+
+void MainWindow::runVerifiedSolver() {
+  if (!intervalSolver->isReady()) {
+    QMessageBox::critical(this, "Error", "Library not loaded");
+    return;
+  }
+
+  NInterval::Vector initialBox = readIntervalInputs();
+  int maxIterations = maxIterationsInput->value();
+  NInterval::ValInterval epsilon = interval_arithmetic::IntRead<NStandard::Val>(
+      epsilonInput->text().toStdString());
+  NInterval::Contractor method =
+      static_cast<NInterval::Contractor>(contractorInput->currentIndex());
   NInterval::SolverResult result =
-      intervalSolver->solve(initialGuess, maxIterations, epsilon);
+      intervalSolver->verify(initialBox, maxIterations, epsilon, method);
   checkResultStatus(result.status);
   showResult(result);
 }
 
+void MainWindow::runSearchSolver() {
+  if (!intervalSolver->isReady()) {
+    QMessageBox::critical(this, "Error", "Library not loaded");
+    return;
+  }
+
+  NInterval::Vector initialBox = readIntervalInputs();
+  NInterval::BoxSearchOptions options;
+  options.method =
+      static_cast<NInterval::Contractor>(contractorInput->currentIndex());
+  options.contractIterations = maxIterationsInput->value();
+  options.eps = interval_arithmetic::IntRead<NStandard::Val>(
+      epsilonInput->text().toStdString());
+  NInterval::BoxSearchResult result =
+      intervalSolver->search(initialBox, options);
+  if (result.roots.empty()) {
+    QMessageBox::information(this, "No Solution",
+                             "No root could be verified in the box");
+  }
+  showResult(result);
+}
+
 void MainWindow::runSolver() {
   switch (arithmeticMode) {
     case ArithmeticMode::STANDARD:
@@ -379,5 +938,14 @@ void MainWindow::runSolver() {
     case ArithmeticMode::INTERVAL_INPUT:
       runIntervalInputSolver();
       break;
+    case ArithmeticMode::INTERVAL_VERIFIED:
+      runVerifiedSolver();
+      break;
+    case ArithmeticMode::INTERVAL_SEARCH:
+      runSearchSolver();
+      break;
+    case ArithmeticMode::MULTIPRECISION:
+      runMultiprecisionSolver();
+      break;
   }
 }
@@ -0,0 +1,282 @@
+#include "../include/NativeCompiler.h"
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+
+extern char **environ;
+
+namespace {
+
+// Changes to the generated code that make cached libraries unusable must
+// increment this; the headers they include are part of the key anyway
+const char CACHE_VERSION[] = "ean-native 2";
+
+// Headers that ExpressionSystem::generateLibrary includes
+const char *const GENERATED_INCLUDES[] = {"LibraryInterface.h",
+                                          "LibraryInterfaceInterval.h"};
+
+const char *const FLAGS[] = {"-std=c++11", "-O3", "-march=native", "-shared",
+                             "-fPIC"};
+
+// Compiler output beyond this is not worth showing
+const size_t MAX_LOG = 4096;
+
+uint64_t Fnv1a(const std::string &data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::string IncludeDirectory() {
+  const char *path = std::getenv("EAN_INCLUDE_PATH");
+  if (path && *path) {
+    return path;
+  }
+#ifdef EAN_INCLUDE_DIR
+  return EAN_INCLUDE_DIR;
+#else
+  return "";
+#endif
+}
+
+// -march=native code is only valid on the CPU it was built for
+std::string CpuModel() {
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      return line;
+    }
+  }
+  return "";
+}
+
+bool MakeDirectories(const std::string &path) {
+  for (size_t at = path.find('/', 1);; at = path.find('/', at + 1)) {
+    std::string prefix = path.substr(0, at);
+    if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (at == std::string::npos) {
+      return true;
+    }
+  }
+}
+
+std::string ReadFile(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+// Appends to contents the name and text of header and, once each, of the
+// headers it includes with quotes, all of which live in directory
+void AppendHeader(const std::string &directory, const std::string &header,
+                  std::set<std::string> &seen, std::string &contents) {
+  if (!seen.insert(header).second) {
+    return;
+  }
+  std::string text = ReadFile(directory + "/" + header);
+  contents += header + '\n' + text + '\n';
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    size_t start = line.find_first_not_of(" \t");
+    if (start == std::string::npos ||
+        line.compare(start, 10, "#include \"") != 0) {
+      continue;
+    }
+    size_t end = line.find('"', start + 10);
+    if (end == std::string::npos) {
+      continue;
+    }
+    std::string name = line.substr(start + 10, end - start - 10);
+    if (name.compare(0, 2, "./") == 0) {
+      name.erase(0, 2);
+    }
+    AppendHeader(directory, name, seen, contents);
+  }
+}
+
+// Runs argv with its output in log; the exit status, or -1 with error set
+// if it could not be started
+int Run(const std::vector<std::string> &arguments, const std::string &log,
+        std::string &error) {
+  std::vector<char *> argv;
+  for (const std::string &argument : arguments) {
+    argv.push_back(const_cast<char *>(argument.c_str()));
+  }
+  argv.push_back(nullptr);
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(),
+                                   O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+  pid_t pid;
+  int result =
+      posix_spawnp(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (result != 0) {
+    error = "Cannot start " + arguments[0] + ": " + std::strerror(result);
+    return -1;
+  }
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      error = std::string("Cannot wait for the compiler: ") +
+              std::strerror(errno);
+      return -1;
+    }
+  }
+  if (!WIFEXITED(status)) {
+    error = arguments[0] + " was killed by signal " +
+            std::to_string(WTERMSIG(status));
+    return -1;
+  }
+  return WEXITSTATUS(status);
+}
+}  // namespace
+
+NativeCompiler::NativeCompiler(const std::string &cacheDirectory)
+    : cacheDirectory(cacheDirectory) {
+  const char *compiler = std::getenv("CXX");
+  std::istringstream words(compiler && *compiler ? compiler : "c++");
+  std::string word;
+  while (words >> word) {
+    command.push_back(word);
+  }
+  for (const char *flag : FLAGS) {
+    command.push_back(flag);
+  }
+  std::string include = IncludeDirectory();
+  if (!include.empty()) {
+    command.push_back("-I" + include);
+  }
+  configuration = CACHE_VERSION;
+  for (const std::string &argument : command) {
+    configuration += '\n' + argument;
+  }
+  configuration += '\n' + CpuModel() + '\n';
+  // A change to the interval arithmetic must not leave stale libraries
+  std::set<std::string> seen;
+  for (const char *header : GENERATED_INCLUDES) {
+    AppendHeader(include, header, seen, configuration);
+  }
+}
+
+std::string NativeCompiler::DefaultCacheDirectory() {
+  const char *cache = std::getenv("XDG_CACHE_HOME");
+  if (cache && *cache) {
+    return std::string(cache) + "/ean/native";
+  }
+  const char *home = std::getenv("HOME");
+  if (home && *home) {
+    return std::string(home) + "/.cache/ean/native";
+  }
+  return "";
+}
+
+std::string NativeCompiler::libraryPath(const std::string &source) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "/%016llx.so",
+                static_cast<unsigned long long>(
+                    Fnv1a(configuration + source)));
+  return cacheDirectory + name;
+}
+
+bool NativeCompiler::isCached(const std::string &source) const {
+  return !cacheDirectory.empty() &&
+         access(libraryPath(source).c_str(), R_OK) == 0;
+}
+
+std::string NativeCompiler::compile(const std::string &source,
+                                    std::string &error) const {
+  if (cacheDirectory.empty()) {
+    error = "No cache directory for compiled libraries";
+    return "";
+  }
+  std::string library = libraryPath(source);
+  if (access(library.c_str(), R_OK) == 0) {
+    return library;
+  }
+  if (!MakeDirectories(cacheDirectory)) {
+    error = "Cannot create " + cacheDirectory + ": " + std::strerror(errno);
+    return "";
+  }
+
+  // Unique names for this compilation, next to the library so that the
+  // rename below stays on one file system
+  std::string base = library.substr(0, library.size() - 3) + "-XXXXXX";
+  std::vector<char> pattern(base.begin(), base.end());
+  pattern.insert(pattern.end(), {'.', 'c', 'p', 'p', '\0'});
+  int fd = mkstemps(pattern.data(), 4);
+  if (fd < 0) {
+    error = "Cannot write to " + cacheDirectory + ": " + std::strerror(errno);
+    return "";
+  }
+  std::string file(pattern.data());
+  bool written = write(fd, source.data(), source.size()) ==
+                 static_cast<ssize_t>(source.size());
+  close(fd);
+  std::string stem = file.substr(0, file.size() - 4);
+  std::string output = stem + ".so.tmp";
+  std::string log = stem + ".log";
+
+  std::vector<std::string> arguments = command;
+  arguments.push_back("-o");
+  arguments.push_back(output);
+  arguments.push_back(file);
+  int status = -1;
+  if (!written) {
+    error = "Cannot write " + file;
+  } else {
+    status = Run(arguments, log, error);
+  }
+  if (status > 0) {
+    error = ReadFile(log);
+    if (error.size() > MAX_LOG) {
+      error.resize(MAX_LOG);
+      error += "...";
+    }
+    if (error.empty()) {
+      error = arguments[0] + " failed";
+    }
+  }
+  if (status == 0 && rename(output.c_str(), library.c_str()) != 0) {
+    error = "Cannot store " + library + ": " + std::strerror(errno);
+    status = -1;
+  }
+  unlink(file.c_str());
+  unlink(log.c_str());
+  if (status != 0) {
+    unlink(output.c_str());
+    return "";
+  }
+  return library;
+}
+
+std::string NativeCompiler::compile(const ExpressionSystem &system,
+                                    ExpressionSystem::Target target,
+                                    std::string &error) const {
+  std::string source;
+  if (!system.generateLibrary(target, source, error)) {
+    return "";
+  }
+  return compile(source, error);
+}
@@ -3,6 +3,9 @@
 #include <cmath>
 #include <vector>
 
+#include "../include/NewtonSystemFixed.h"
+#include "../include/NewtonSystemGlobal.h"
+
 /**
  * Solves a system of n nonlinear equations of the form
  * f[i](x[1],x[2],...,x[n])=0 (i=1,2,...,n) using Newton's method.
@@ -19,14 +22,30 @@
  *           1 = invalid input (n<1 or mit<1),
  *           2 = singular matrix,
  *           3 = iterations exceeded
+ * @param globalization Step control, see NewtonSystemGlobal.h for the
+ *                      methods other than the full step
  */
 namespace NStandard {
 void NewtonSystem(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
-                  int mit, Val eps, int &it, int &st) {
+                  int mit, Val eps, int &it, int &st,
+                  Globalization globalization) {
   if (n < 1 || mit < 1) {
     st = 1;
     return;
   }
+  if (globalization == Globalization::LINE_SEARCH) {
+    NewtonLineSearch(n, x, f, df, mit, eps, it, st);
+    return;
+  }
+  if (globalization == Globalization::TRUST_REGION) {
+    NewtonTrustRegion(n, x, f, df, mit, eps, it, st);
+    return;
+  }
+  // Small systems have kernels of their own size
+  if (n <= MAX_FIXED_EQUATIONS) {
+    NewtonSystemFixed(n, x, f, df, mit, eps, it, st);
+    return;
+  }
 
   st = 0;
   it = 0;
@@ -0,0 +1,154 @@
+#include "../include/NewtonSystemBatch.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "../include/BatchKernels.h"
+#include "../include/LinearSystem.h"
+
+namespace NStandard {
+
+/**
+ * Solves a system of n nonlinear equations for m initial guesses with
+ * Newton's method in double precision.
+ *
+ * @param n Number of equations
+ * @param m Number of initial guesses
+ * @param X Initial guesses, X[j * m + k] = x[j + 1] of guess k (changed on
+ *          exit)
+ * @param f Function that evaluates the system at several points
+ * @param df Function that evaluates the Jacobian at several points
+ * @param mit Maximum number of iterations in Newton's method
+ * @param eps Relative accuracy of the solution, as a fraction of its
+ *            largest component, at least 4 DBL_EPSILON
+ * @param it Number of iterations performed for each guess (output)
+ * @param st Status code for each guess (output), as in NewtonSystem:
+ *           0 = success,
+ *           1 = invalid input (n<1 or mit<1),
+ *           2 = singular matrix, or values that are not finite,
+ *           3 = iterations exceeded
+ */
+void NewtonSystemBatch(int n, int m, double *X, BatchFunctionTypeC f,
+                       BatchJacobianTypeC df, int mit, double eps, int *it,
+                       int *st) {
+  if (n < 1 || mit < 1) {
+    std::fill(it, it + m, 0);
+    std::fill(st, st + m, 1);
+    return;
+  }
+  // Below this double cannot tell successive iterates apart
+  eps = std::max(eps, 4 * DBL_EPSILON);
+
+  // Guesses still iterating, packed together in the same layout
+  std::vector<int> active(m);
+  for (int k = 0; k < m; k++) {
+    active[k] = k;
+    it[k] = 0;
+    st[k] = 3;
+  }
+  std::vector<double> x(X, X + static_cast<size_t>(n) * m);
+  std::vector<double> fx(x.size());
+  std::vector<double> jx(x.size() * n);
+  std::vector<unsigned char> failed(m), converged(m), kept(m);
+  const BatchKernels &kernels = GetBatchKernels();
+
+  for (int iteration = 1; iteration <= mit && !active.empty(); iteration++) {
+    int count = static_cast<int>(active.size());
+    f(n, count, &x[0], &fx[0]);
+    df(n, count, &x[0], &jx[0]);
+    kernels.solveLinear(n, count, &jx[0], &fx[0], &failed[0]);
+    kernels.update(n, count, &x[0], &fx[0], eps, &converged[0]);
+
+    // Finished guesses go back to X, the others move up to fill the gaps
+    int remaining = 0;
+    for (int p = 0; p < count; p++) {
+      int k = active[p];
+      it[k] = iteration;
+      kept[p] = !failed[p] && !converged[p];
+      if (kept[p]) {
+        active[remaining++] = k;
+      } else {
+        st[k] = failed[p] ? 2 : 0;
+        for (int j = 0; j < n; j++) {
+          X[static_cast<size_t>(j) * m + k] = x[j * count + p];
+        }
+      }
+    }
+    for (int j = 0, q = 0; j < n; j++) {
+      for (int p = 0; p < count; p++) {
+        if (kept[p]) {
+          x[q++] = x[j * count + p];
+        }
+      }
+    }
+    active.resize(remaining);
+  }
+  // Guesses out of iterations keep their last iterate
+  for (size_t p = 0; p < active.size(); p++) {
+    for (int j = 0; j < n; j++) {
+      X[static_cast<size_t>(j) * m + active[p]] = x[j * active.size() + p];
+    }
+  }
+}
+
+/**
+ * Refines a solution found by NewtonSystemBatch to long double accuracy:
+ * steps x - A^-1 f(x) with f in long double and A the Jacobian in double
+ * at the starting point, factored once. Each step gains about as many
+ * digits as double has, so one or two steps usually suffice.
+ *
+ * @param n Number of equations
+ * @param x Solution in double (changed on exit)
+ * @param f Function that calculates the value of function f[i]
+ * @param J Jacobian at x, J[(i * n + j) * stride] = df[i + 1]/dx[j + 1]
+ * @param stride Distance between the Jacobian entries
+ * @param mit Maximum number of steps
+ * @param eps Relative accuracy of the solution
+ * @param it Number of steps performed (output)
+ * @param st Status code (output), as in NewtonSystem
+ */
+void RefineSystem(int n, Vector &x, FunctionTypeC f, const double *J,
+                  int stride, int mit, Val eps, int &it, int &st) {
+  it = 0;
+  if (n < 1 || mit < 1) {
+    st = 1;
+    return;
+  }
+  std::vector<Val> a(static_cast<size_t>(n) * n);
+  std::vector<Val> d(n);
+  std::vector<int> pivot(n);
+  for (size_t e = 0; e < a.size(); e++) {
+    a[e] = J[e * stride];
+  }
+  if (!Factor(n, &a[0], &pivot[0])) {
+    st = 2;
+    return;
+  }
+  for (it = 1; it <= mit; it++) {
+    for (int i = 0; i < n; i++) {
+      d[i] = -f(i + 1, n, &x[0]);
+    }
+    if (!Substitute(n, &a[0], &pivot[0], &d[0])) {
+      st = 2;
+      return;
+    }
+    bool cond = true;
+    for (int j = 0; j < n; j++) {
+      Val x1 = x[j + 1] + d[j];
+      Val max = std::max(std::abs(x[j + 1]), std::abs(x1));
+      if (max != 0 && std::abs(d[j]) / max >= eps) {
+        cond = false;
+      }
+      x[j + 1] = x1;
+    }
+    if (cond) {
+      st = 0;
+      return;
+    }
+  }
+  it = mit;
+  st = 3;
+}
+}  // namespace NStandard
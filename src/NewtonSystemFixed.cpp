@@ -0,0 +1,136 @@
+#include "../include/NewtonSystemFixed.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace NStandard {
+
+namespace {
+
+// Solves a d = b for the Newton step, b overwritten by d, by Gaussian
+// elimination with partial pivoting; false if a is singular. N is known
+// at compile time, so the loops unroll.
+template <int N>
+bool SolveStep(Val (&a)[N][N], Val (&b)[N]) {
+  for (int k = 0; k < N; k++) {
+    int p = k;
+    for (int i = k + 1; i < N; i++) {
+      if (std::abs(a[i][k]) > std::abs(a[p][k])) {
+        p = i;
+      }
+    }
+    if (a[p][k] == 0) {
+      return false;
+    }
+    if (p != k) {
+      std::swap(a[p], a[k]);
+      std::swap(b[p], b[k]);
+    }
+    for (int i = k + 1; i < N; i++) {
+      Val factor = a[i][k] / a[k][k];
+      for (int j = k + 1; j < N; j++) {
+        a[i][j] -= factor * a[k][j];
+      }
+      b[i] -= factor * b[k];
+    }
+  }
+  for (int k = N - 1; k >= 0; k--) {
+    for (int j = k + 1; j < N; j++) {
+      b[k] -= a[k][j] * b[j];
+    }
+    b[k] /= a[k][k];
+  }
+  return true;
+}
+
+template <>
+bool SolveStep<1>(Val (&a)[1][1], Val (&b)[1]) {
+  if (a[0][0] == 0) {
+    return false;
+  }
+  b[0] /= a[0][0];
+  return true;
+}
+
+// Cramer's rule, which is forward stable for two equations (though not
+// for more)
+template <>
+bool SolveStep<2>(Val (&a)[2][2], Val (&b)[2]) {
+  Val det = a[0][0] * a[1][1] - a[0][1] * a[1][0];
+  if (det == 0) {
+    return false;
+  }
+  Val d0 = (b[0] * a[1][1] - a[0][1] * b[1]) / det;
+  Val d1 = (a[0][0] * b[1] - b[0] * a[1][0]) / det;
+  b[0] = d0;
+  b[1] = d1;
+  return true;
+}
+
+// The iteration of NewtonSystem, with the same calls of f and df and the
+// same stopping test. It solves for the step rather than for the next
+// iterate, so the rounding errors near the solution are those of the
+// step, and the test is met an iteration earlier at times.
+template <int N>
+void Newton(Vector &x, FunctionTypeC f, DerivativeTypeC df, int mit, Val eps,
+            int &it, int &st) {
+  // 1-based like x, for f and df
+  Val v[N + 1], row[N + 1];
+  Val a[N][N], d[N];
+  std::copy(x.begin(), x.begin() + N + 1, v);
+
+  st = 0;
+  it = 0;
+  bool cond = false;
+  while (!cond) {
+    it++;
+    if (it > mit) {
+      st = 3;
+      it--;
+      break;
+    }
+
+    for (int i = 0; i < N; i++) {
+      df(i + 1, N, v, row);
+      std::copy(row + 1, row + N + 1, a[i]);
+      d[i] = -f(i + 1, N, v);
+    }
+    if (!SolveStep<N>(a, d)) {
+      st = 2;
+      break;
+    }
+
+    cond = true;
+    for (int i = 0; i < N; i++) {
+      Val x1 = v[i + 1] + d[i];
+      Val max = std::max(std::abs(v[i + 1]), std::abs(x1));
+      if (max != 0 && std::abs(v[i + 1] - x1) / max >= eps) {
+        cond = false;
+      }
+      v[i + 1] = x1;
+    }
+  }
+  std::copy(v + 1, v + N + 1, x.begin() + 1);
+}
+
+using Kernel = void (*)(Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                        int mit, Val eps, int &it, int &st);
+
+const Kernel KERNELS[MAX_FIXED_EQUATIONS] = {
+    Newton<1>, Newton<2>, Newton<3>, Newton<4>,
+    Newton<5>, Newton<6>, Newton<7>, Newton<8>};
+}  // namespace
+
+/**
+ * Newton's method for a system of at most MAX_FIXED_EQUATIONS equations,
+ * with the parameters and status codes of NewtonSystem.
+ */
+void NewtonSystemFixed(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                       int mit, Val eps, int &it, int &st) {
+  if (n < 1 || n > MAX_FIXED_EQUATIONS || mit < 1) {
+    st = 1;
+    return;
+  }
+  KERNELS[n - 1](x, f, df, mit, eps, it, st);
+}
+}  // namespace NStandard
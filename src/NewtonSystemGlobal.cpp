@@ -0,0 +1,353 @@
+#include "../include/NewtonSystemGlobal.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "../include/LinearSystem.h"
+
+namespace NStandard {
+
+namespace {
+
+// Sufficient decrease of the line search: |F|^2 must fall by this fraction
+// of what the linear model predicts
+const Val ARMIJO = 1e-4L;
+// Initial trust radius relative to the scaled starting point (hybrj's
+// factor)
+const Val RADIUS_FACTOR = 100;
+
+// fx[i] = f[i + 1](x) (x 1-based) and norm2 = |fx|^2; false if a value is
+// not finite
+bool Residuals(int n, const Val *x, FunctionTypeC f, Val *fx, Val &norm2) {
+  norm2 = 0;
+  for (int i = 0; i < n; i++) {
+    fx[i] = f(i + 1, n, x);
+    norm2 += fx[i] * fx[i];
+  }
+  return std::isfinite(norm2);
+}
+
+// J[i * n + j] = df[i + 1]/dx[j + 1] at x (1-based)
+void Jacobian(int n, const Val *x, DerivativeTypeC df, Val *J, Val *row) {
+  for (int i = 0; i < n; i++) {
+    df(i + 1, n, x, row);
+    std::copy(row + 1, row + n + 1, J + i * n);
+  }
+}
+
+// The step d from x (1-based) meets the relative accuracy eps of
+// NewtonSystem
+bool Small(int n, const Val *x, const Val *d, Val eps) {
+  for (int j = 0; j < n; j++) {
+    Val max = std::max(std::abs(x[j + 1]), std::abs(x[j + 1] + d[j]));
+    if (max != 0 && std::abs(d[j]) / max >= eps) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// |D v| for the diagonal scaling D = diag
+Val ScaledNorm(int n, const Val *diag, const Val *v) {
+  Val sum = 0;
+  for (int j = 0; j < n; j++) {
+    sum += diag[j] * v[j] * diag[j] * v[j];
+  }
+  return std::sqrt(sum);
+}
+
+// Powell's dogleg step p within |D p| <= delta, from the Newton step dn
+// and the gradient g = J^T F of |F|^2 / 2, as MINPACK's dogleg: dn if it
+// fits, else the steepest descent step to the radius or to the minimum of
+// the linear model along it, else the point of the segment from there to
+// dn on the boundary. Without dn (J singular) the steepest descent step.
+void Dogleg(int n, const Val *J, const Val *diag, const Val *dn, const Val *g,
+            Val fnorm, Val delta, Val *p, Val *s) {
+  Val qnorm = dn ? ScaledNorm(n, diag, dn) : 0;
+  if (dn && qnorm <= delta) {
+    std::copy(dn, dn + n, p);
+    return;
+  }
+
+  // Steepest descent, of length 1 in the scaled norm
+  Val gnorm = 0;
+  for (int j = 0; j < n; j++) {
+    gnorm += (g[j] / diag[j]) * (g[j] / diag[j]);
+  }
+  gnorm = std::sqrt(gnorm);
+  Val sgnorm = 0;
+  Val alpha = dn ? delta / qnorm : 0;
+  if (gnorm != 0) {
+    for (int j = 0; j < n; j++) {
+      s[j] = -(g[j] / diag[j] / gnorm) / diag[j];
+    }
+    Val js = 0;
+    for (int i = 0; i < n; i++) {
+      Val sum = 0;
+      for (int j = 0; j < n; j++) {
+        sum += J[i * n + j] * s[j];
+      }
+      js += sum * sum;
+    }
+    js = std::sqrt(js);
+    // Distance to the minimum of the model along s
+    sgnorm = gnorm / js / js;
+    alpha = 0;
+    if (dn && sgnorm < delta) {
+      Val ratio = delta / qnorm;
+      Val inside = sgnorm / delta;
+      Val temp = fnorm / gnorm * (fnorm / qnorm) * inside;
+      temp = temp - ratio * inside * inside +
+             std::sqrt((temp - ratio) * (temp - ratio) +
+                       (1 - ratio * ratio) * (1 - inside * inside));
+      alpha = ratio * (1 - inside * inside) / temp;
+    }
+  } else {
+    std::fill(s, s + n, 0);
+  }
+  Val length = (1 - alpha) * std::min(sgnorm, delta);
+  for (int j = 0; j < n; j++) {
+    p[j] = length * s[j] + (dn ? alpha * dn[j] : 0);
+  }
+}
+}  // namespace
+
+/**
+ * Newton's method with a backtracking line search. Each iteration solves
+ * for the Newton step d and moves to x + t d with the largest t of
+ * 1 > t/2 > ... (refined by quadratic interpolation, within [t/10, t/2])
+ * for which |F(x + t d)|^2 <= (1 - 2 ARMIJO t) |F(x)|^2. Only the residuals
+ * are evaluated at the trial points. The iteration stops, taking d in
+ * full, when d meets the accuracy test of NewtonSystem, and fails when no
+ * t gives enough decrease before t d falls below that accuracy.
+ *
+ * @param n Number of equations
+ * @param x Initial approximations to solution components (changed on exit)
+ * @param f Function that calculates the value of function f[i]
+ * @param df Function that calculates the derivatives df[i]/dx[j]
+ * @param mit Maximum number of iterations (Jacobian evaluations)
+ * @param eps Relative accuracy of the solution
+ * @param it Number of iterations performed (output)
+ * @param st Status code (output), as in NewtonSystem; 2 also when the
+ *           residuals are not finite at the initial approximation or no
+ *           step decreases them (x near a minimum of |F|^2 that is not a
+ *           solution, where the Jacobian is singular)
+ */
+void NewtonLineSearch(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                      int mit, Val eps, int &it, int &st) {
+  it = 0;
+  if (n < 1 || mit < 1) {
+    st = 1;
+    return;
+  }
+  std::vector<Val> J(static_cast<size_t>(n) * n), row(n + 1);
+  std::vector<Val> fx(n), d(n), step(n), trial(n + 1), ftrial(n);
+  std::vector<int> pivot(n);
+  Val phi, phiTrial;
+  if (!Residuals(n, &x[0], f, &fx[0], phi)) {
+    st = 2;
+    return;
+  }
+
+  for (it = 1; it <= mit; it++) {
+    Jacobian(n, &x[0], df, &J[0], &row[0]);
+    for (int i = 0; i < n; i++) {
+      d[i] = -fx[i];
+    }
+    if (!Factor(n, &J[0], &pivot[0]) ||
+        !Substitute(n, &J[0], &pivot[0], &d[0])) {
+      st = 2;
+      return;
+    }
+    if (Small(n, &x[0], &d[0], eps)) {
+      for (int j = 0; j < n; j++) {
+        x[j + 1] += d[j];
+      }
+      st = 0;
+      return;
+    }
+
+    Val t = 1;
+    trial[0] = x[0];
+    while (true) {
+      for (int j = 0; j < n; j++) {
+        trial[j + 1] = x[j + 1] + t * d[j];
+      }
+      bool finite = Residuals(n, &trial[0], f, &ftrial[0], phiTrial);
+      if (finite && phiTrial <= (1 - 2 * ARMIJO * t) * phi) {
+        break;
+      }
+      // Minimum of the quadratic through |F|^2 at 0 and t with the slope
+      // -2 |F|^2 at 0
+      Val next = finite ? phi * t * t / (phiTrial - phi + 2 * phi * t) : 0;
+      next = std::max(t / 10, std::min(t / 2, next));
+      for (int j = 0; j < n; j++) {
+        step[j] = next * d[j];
+      }
+      // Shorter steps would not move x: it is at a minimum of |F|^2 that
+      // is not a solution, where the Jacobian is singular
+      if (Small(n, &x[0], &step[0], eps)) {
+        st = 2;
+        return;
+      }
+      t = next;
+    }
+    std::copy(trial.begin() + 1, trial.end(), x.begin() + 1);
+    fx.swap(ftrial);
+    phi = phiTrial;
+  }
+  it = mit;
+  st = 3;
+}
+
+/**
+ * Newton's method in a trust region, after MINPACK's hybrj: each trial
+ * step is Powell's dogleg within the radius delta in the variables scaled
+ * by the column norms of the Jacobian, and is accepted if |F|^2 falls by
+ * at least 1e-4 of the decrease the linear model predicts. The radius
+ * halves when the ratio of the two is below 0.1 and grows to twice the
+ * step when it is above 0.5 or twice in a row above 0.1. Where the
+ * Jacobian is singular the step is one of steepest descent. Unlike hybrj
+ * the Jacobian is evaluated at every accepted point instead of being
+ * updated by Broyden's formula. The iteration stops, taking the Newton step in
+ * full, when that step meets the accuracy test of NewtonSystem, and fails
+ * like hybrj when |F|^2 falls by less than 0.1% in ten steps in a row.
+ *
+ * @param n Number of equations
+ * @param x Initial approximations to solution components (changed on exit)
+ * @param f Function that calculates the value of function f[i]
+ * @param df Function that calculates the derivatives df[i]/dx[j]
+ * @param mit Maximum number of iterations (trial steps)
+ * @param eps Relative accuracy of the solution
+ * @param it Number of iterations performed (output)
+ * @param st Status code (output), as in NewtonSystem; 2 also when the
+ *           residuals are not finite at the initial approximation or the
+ *           steps make no progress (x near a minimum of |F|^2 that is not
+ *           a solution, where the Jacobian is singular)
+ */
+void NewtonTrustRegion(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+                       int mit, Val eps, int &it, int &st) {
+  it = 0;
+  if (n < 1 || mit < 1) {
+    st = 1;
+    return;
+  }
+  std::vector<Val> J(static_cast<size_t>(n) * n), lu(J.size()), row(n + 1);
+  std::vector<Val> fx(n), dn(n), g(n), p(n), s(n), diag(n);
+  std::vector<Val> trial(n + 1), ftrial(n);
+  std::vector<int> pivot(n);
+  Val phi, phiTrial;
+  if (!Residuals(n, &x[0], f, &fx[0], phi)) {
+    st = 2;
+    return;
+  }
+
+  bool first = true, fresh = true, newton = false;
+  // Successful steps in a row, and steps since |F|^2 last fell by 0.1%
+  int successes = 0, slow = 0;
+  Val delta = 0;
+  trial[0] = x[0];
+  for (it = 1; it <= mit; it++) {
+    if (fresh) {
+      Jacobian(n, &x[0], df, &J[0], &row[0]);
+      // The scaling only grows, so that the radius keeps its meaning
+      for (int j = 0; j < n; j++) {
+        Val norm = 0;
+        for (int i = 0; i < n; i++) {
+          norm += J[i * n + j] * J[i * n + j];
+        }
+        norm = std::sqrt(norm);
+        diag[j] = first ? (norm != 0 ? norm : 1) : std::max(diag[j], norm);
+      }
+      lu = J;
+      for (int i = 0; i < n; i++) {
+        dn[i] = -fx[i];
+      }
+      newton = Factor(n, &lu[0], &pivot[0]) &&
+               Substitute(n, &lu[0], &pivot[0], &dn[0]);
+      if (newton && Small(n, &x[0], &dn[0], eps)) {
+        for (int j = 0; j < n; j++) {
+          x[j + 1] += dn[j];
+        }
+        st = 0;
+        return;
+      }
+      bool stationary = true;
+      for (int j = 0; j < n; j++) {
+        g[j] = 0;
+        for (int i = 0; i < n; i++) {
+          g[j] += J[i * n + j] * fx[i];
+        }
+        stationary = stationary && g[j] == 0;
+      }
+      // A singular Jacobian still gives a descent direction, unless x is
+      // a minimum of |F|^2
+      if (!newton && stationary) {
+        st = 2;
+        return;
+      }
+      if (first) {
+        delta = RADIUS_FACTOR * ScaledNorm(n, &diag[0], &x[1]);
+        if (delta == 0) {
+          delta = RADIUS_FACTOR;
+        }
+      }
+      fresh = false;
+    }
+
+    Dogleg(n, &J[0], &diag[0], newton ? &dn[0] : nullptr, &g[0],
+           std::sqrt(phi), delta, &p[0], &s[0]);
+    Val pnorm = ScaledNorm(n, &diag[0], &p[0]);
+    if (first) {
+      delta = std::min(delta, pnorm);
+      first = false;
+    }
+    for (int j = 0; j < n; j++) {
+      trial[j + 1] = x[j + 1] + p[j];
+    }
+    bool finite = Residuals(n, &trial[0], f, &ftrial[0], phiTrial);
+    // Decrease of |F|^2 predicted by the linear model F + J p
+    Val model = 0;
+    for (int i = 0; i < n; i++) {
+      Val sum = fx[i];
+      for (int j = 0; j < n; j++) {
+        sum += J[i * n + j] * p[j];
+      }
+      model += sum * sum;
+    }
+    Val predicted = phi - model;
+    Val ratio = finite && predicted > 0 ? (phi - phiTrial) / predicted : 0;
+    Val reduction = finite && phiTrial < phi ? 1 - phiTrial / phi : -1;
+
+    if (ratio < 0.1L) {
+      successes = 0;
+      delta /= 2;
+    } else {
+      successes++;
+      if (ratio >= 0.5L || successes > 1) {
+        delta = std::max(delta, 2 * pnorm);
+      }
+      if (std::abs(ratio - 1) <= 0.1L) {
+        delta = 2 * pnorm;
+      }
+    }
+    if (ratio >= 1e-4L) {
+      std::copy(trial.begin() + 1, trial.end(), x.begin() + 1);
+      fx.swap(ftrial);
+      phi = phiTrial;
+      fresh = true;
+    }
+
+    // hybrj's test for an iteration that makes no progress, which is
+    // near a minimum of |F|^2 that is not a solution
+    slow = reduction >= 0.001L ? 0 : slow + 1;
+    if (slow == 10) {
+      st = 2;
+      return;
+    }
+  }
+  it = mit;
+  st = 3;
+}
+}  // namespace NStandard
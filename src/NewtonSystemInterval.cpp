@@ -2,6 +2,8 @@
 
 #include <vector>
 
+#include "../include/IntervalLinearSystem.h"
+
 /**
  * Solves a system of n nonlinear equations of the form
  * f[i](x[1],x[2],...,x[n])=0 (i=1,2,...,n) using Newton's method.
@@ -18,10 +20,13 @@
  *           1 = invalid input (n<1 or mit<1),
  *           2 = singular matrix,
  *           3 = iterations exceeded
+ * @param solver Method for the linear system of each step: plain interval
+ *               Gaussian elimination or a midpoint-preconditioned solver
  */
 namespace NInterval {
 void NewtonSystem(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
-                  int mit, ValInterval eps, int &it, int &st) {
+                  int mit, ValInterval eps, int &it, int &st,
+                  LinearSolver solver) {
   if (n < 1 || mit < 1) {
     st = 1;
     return;
@@ -36,6 +41,12 @@ void NewtonSystem(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
   std::vector<ValInterval> b(n1 + 1);
   std::vector<int> r(n1 + 1, 0);
   std::vector<ValInterval> x1(((n + 2) * (n + 2)) / 4 + 1);
+  Matrix am;
+  Vector bm;
+  if (solver != LinearSolver::GAUSS) {
+    am.resize(n1 * n1);
+    bm.resize(n1);
+  }
 
   bool cond = false;
   do {
@@ -46,108 +57,123 @@ void NewtonSystem(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
       break;
     }
 
-    int p = n1;
-    for (int i = 1; i <= n1; i++) {
-      r[i] = 0;
-    }
-
-    int k = 0;
-    do {
-      k++;
-      df(k, n, &x[0], &dfatx[0]);
-
-      for (int i = 1; i <= n; i++) {
-        a[i] = dfatx[i];
+    if (solver == LinearSolver::GAUSS) {
+      int p = n1;
+      for (int i = 1; i <= n1; i++) {
+        r[i] = 0;
       }
 
-      ValInterval s = f(k, n, &x[0]).Opposite();
-      for (int i = 1; i <= n; i++) {
-        s = s + dfatx[i] * x[i];
-      }
-      a[n1] = s;
+      int k = 0;
+      do {
+        k++;
+        df(k, n, &x[0], &dfatx[0]);
 
-      for (int i = 1; i <= n; i++) {
-        int rh = r[i];
-        if (rh != 0) {
-          b[rh] = a[i];
+        for (int i = 1; i <= n; i++) {
+          a[i] = dfatx[i];
         }
-      }
 
-      int kh = k - 1;
-      int l = 0;
-      ValInterval max = ValInterval(0, 0);
-      int jh = 0, lh = 0;
-
-      for (int j = 1; j <= n1; j++) {
-        if (r[j] == 0) {
-          s = a[j];
-          l++;
-          int q = l;
-          for (int i = 1; i <= kh; i++) {
-            s = s - b[i] * x1[q];
-            q = q + p;
+        ValInterval s = f(k, n, &x[0]).Opposite();
+        for (int i = 1; i <= n; i++) {
+          s = s + dfatx[i] * x[i];
+        }
+        a[n1] = s;
+
+        for (int i = 1; i <= n; i++) {
+          int rh = r[i];
+          if (rh != 0) {
+            b[rh] = a[i];
           }
-          a[l] = s;
-          s = IAbs(s);
-          if (j < n1 && s > max) {
-            max = s;
-            jh = j;
-            lh = l;
+        }
+
+        int kh = k - 1;
+        int l = 0;
+        ValInterval max = ValInterval(0, 0);
+        int jh = 0, lh = 0;
+
+        for (int j = 1; j <= n1; j++) {
+          if (r[j] == 0) {
+            s = a[j];
+            l++;
+            int q = l;
+            for (int i = 1; i <= kh; i++) {
+              s = s - b[i] * x1[q];
+              q = q + p;
+            }
+            a[l] = s;
+            s = IAbs(s);
+            if (j < n1 && s > max) {
+              max = s;
+              jh = j;
+              lh = l;
+            }
           }
         }
-      }
 
-      if (max.a <= 0.0 && max.b >= 0.0) {
-        st = 2;
-        break;
-      }
+        if (max.a <= 0.0 && max.b >= 0.0) {
+          st = 2;
+          break;
+        }
 
-      max = ValInterval(1, 1) / a[lh];
-      r[jh] = k;
-      for (int i = 1; i <= p; i++) {
-        a[i] = max * a[i];
-      }
+        max = ValInterval(1, 1) / a[lh];
+        r[jh] = k;
+        for (int i = 1; i <= p; i++) {
+          a[i] = max * a[i];
+        }
+
+        jh = 0;
+        int q = 0;
+        for (int j = 1; j <= kh; j++) {
+          s = x1[q + lh];
+          for (int i = 1; i <= p; i++) {
+            if (i != lh) {
+              jh++;
+              x1[jh] = x1[q + i] - s * a[i];
+            }
+          }
+          q = q + p;
+        }
 
-      jh = 0;
-      int q = 0;
-      for (int j = 1; j <= kh; j++) {
-        s = x1[q + lh];
         for (int i = 1; i <= p; i++) {
           if (i != lh) {
             jh++;
-            x1[jh] = x1[q + i] - s * a[i];
+            x1[jh] = a[i];
           }
         }
-        q = q + p;
-      }
-
-      for (int i = 1; i <= p; i++) {
-        if (i != lh) {
-          jh++;
-          x1[jh] = a[i];
+        p = p - 1;
+      } while (k < n && st != 2);
+
+      if (st == 0) {
+        for (int k = 1; k <= n; k++) {
+          int rh = r[k];
+          if (rh != k) {
+            ValInterval s = x1[k];
+            x1[k] = x1[rh];
+            int i = r[rh];
+            while (i != k) {
+              x1[rh] = x1[i];
+              r[rh] = rh;
+              rh = i;
+              i = r[rh];
+            }
+            x1[rh] = s;
+            r[rh] = rh;
+          }
         }
       }
-      p = p - 1;
-    } while (k < n && st != 2);
-
-    if (st == 0) {
+    } else {
       for (int k = 1; k <= n; k++) {
-        int rh = r[k];
-        if (rh != k) {
-          ValInterval s = x1[k];
-          x1[k] = x1[rh];
-          int i = r[rh];
-          while (i != k) {
-            x1[rh] = x1[i];
-            r[rh] = rh;
-            rh = i;
-            i = r[rh];
-          }
-          x1[rh] = s;
-          r[rh] = rh;
+        df(k, n, &x[0], &dfatx[0]);
+        ValInterval s = f(k, n, &x[0]).Opposite();
+        for (int i = 1; i <= n; i++) {
+          am[k * n1 + i] = dfatx[i];
+          s = s + dfatx[i] * x[i];
         }
+        bm[k] = s;
       }
+      IntervalLinearSystem(n, am, bm, x1, solver, st);
+    }
 
+    if (st == 0) {
       cond = true;
       for (int i = 1; i <= n; i++) {
         long double max = std::max(std::abs(x[i].a), std::abs(x[i].b));
@@ -0,0 +1,433 @@
+#include "../include/NewtonSystemMP.h"
+
+#include <gmp.h>
+#include <mpfr.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace NMultiprecision {
+
+namespace {
+
+// Free lists for GMP/MPFR limb blocks. An MPFR significand is one size word
+// followed by whole limbs, so every MPFR allocation is a multiple of 8 bytes
+// and lands exactly in one of the size classes below. Only requests of an
+// exact class size are served from the lists, and everything comes from and
+// goes back to the functions GMP had before, so a block always has the size
+// it was allocated with, whichever side of the installation it was made on.
+const size_t POOL_GRANULE = 8;
+const size_t POOL_CLASSES = 129;  // blocks up to 1 KiB (about 8000 bits)
+const unsigned POOL_DEPTH = 256;
+
+void *(*previousAllocate)(size_t);
+void *(*previousReallocate)(void *, size_t, size_t);
+void (*previousFree)(void *, size_t);
+
+// Size class of a block, 0 if it has none
+size_t PoolClass(size_t size) {
+  size_t c = size / POOL_GRANULE;
+  return size % POOL_GRANULE == 0 && c < POOL_CLASSES ? c : 0;
+}
+
+struct LimbPool {
+  void *head[POOL_CLASSES];
+  unsigned count[POOL_CLASSES];
+  ~LimbPool();
+};
+
+// Set when the thread's pool has been destroyed; frees issued by later
+// destructors of the thread then bypass it. Trivially destructible.
+thread_local bool poolClosed = false;
+thread_local LimbPool limbPool;
+
+// Returns the cached blocks when the thread exits
+LimbPool::~LimbPool() {
+  poolClosed = true;
+  for (size_t c = 1; c < POOL_CLASSES; c++) {
+    while (head[c] != nullptr) {
+      void *p = head[c];
+      head[c] = *static_cast<void **>(p);
+      previousFree(p, c * POOL_GRANULE);
+    }
+    count[c] = 0;
+  }
+}
+
+void *PoolAllocate(size_t size) {
+  size_t c = PoolClass(size);
+  if (c != 0 && !poolClosed && limbPool.head[c] != nullptr) {
+    void *p = limbPool.head[c];
+    limbPool.head[c] = *static_cast<void **>(p);
+    limbPool.count[c]--;
+    return p;
+  }
+  return previousAllocate(size);
+}
+
+void PoolFree(void *p, size_t size) {
+  size_t c = PoolClass(size);
+  if (p != nullptr && c != 0 && !poolClosed &&
+      limbPool.count[c] < POOL_DEPTH) {
+    *static_cast<void **>(p) = limbPool.head[c];
+    limbPool.head[c] = p;
+    limbPool.count[c]++;
+    return;
+  }
+  previousFree(p, size);
+}
+
+void *PoolReallocate(void *p, size_t oldSize, size_t newSize) {
+  if (PoolClass(oldSize) == 0 && PoolClass(newSize) == 0) {
+    return previousReallocate(p, oldSize, newSize);
+  }
+  void *q = PoolAllocate(newSize);
+  std::memcpy(q, p, oldSize < newSize ? oldSize : newSize);
+  PoolFree(p, oldSize);
+  return q;
+}
+
+std::once_flag poolInstalled;
+
+// Outcome of one precision stage
+enum class Stage { CONVERGED, STALLED, SINGULAR, EXCEEDED };
+
+// Classifies the relative step delta taken at the given precision. The
+// stage has converged once the step is below eps and the precision can
+// represent eps; it has stalled once the step reaches the rounding floor or,
+// close to the root, stops contracting quadratically.
+int Classify(long double delta, long double previous, int precision,
+             long double eps) {
+  long double u = std::ldexp(1.0L, -precision);
+  if (delta <= eps && 4 * u <= eps) {
+    return 1;
+  }
+  if (delta <= 16 * u || (delta < std::sqrt(u) && delta > previous / 4)) {
+    return 2;
+  }
+  return 0;
+}
+
+// Solves a * d = b in place (b receives d) by Gaussian elimination with
+// partial pivoting. a is 1-based with row stride n + 1.
+template <typename T>
+bool SolveDense(int n, std::vector<T> &a, std::vector<T> &b) {
+  int n1 = n + 1;
+  for (int k = 1; k <= n; k++) {
+    int piv = k;
+    for (int r = k + 1; r <= n; r++) {
+      if (std::abs(a[r * n1 + k]) > std::abs(a[piv * n1 + k])) {
+        piv = r;
+      }
+    }
+    if (a[piv * n1 + k] == 0) {
+      return false;
+    }
+    if (piv != k) {
+      for (int c = k; c <= n; c++) {
+        std::swap(a[k * n1 + c], a[piv * n1 + c]);
+      }
+      std::swap(b[k], b[piv]);
+    }
+    for (int r = k + 1; r <= n; r++) {
+      T t = a[r * n1 + k] / a[k * n1 + k];
+      for (int c = k + 1; c <= n; c++) {
+        a[r * n1 + c] -= t * a[k * n1 + c];
+      }
+      b[r] -= t * b[k];
+    }
+  }
+  for (int k = n; k >= 1; k--) {
+    T s = b[k];
+    for (int c = k + 1; c <= n; c++) {
+      s -= a[k * n1 + c] * b[c];
+    }
+    b[k] = s / a[k * n1 + k];
+  }
+  return true;
+}
+
+// Newton iterations in double or long double. Residuals always come from the
+// long double library entry points; in the double stage the results are
+// rounded so that the whole iteration runs in the cheaper type.
+template <typename T>
+Stage FloatStage(int n, std::vector<T> &x, NStandard::FunctionTypeC f,
+                 NStandard::DerivativeTypeC df, int precision, int mit,
+                 long double eps, int &it) {
+  int n1 = n + 1;
+  NStandard::Vector xl(n1), dfatx(n1);
+  std::vector<T> a(n1 * n1), b(n1);
+  long double previous = std::numeric_limits<long double>::infinity();
+
+  while (true) {
+    if (it >= mit) {
+      return Stage::EXCEEDED;
+    }
+    it++;
+
+    for (int i = 1; i <= n; i++) {
+      xl[i] = x[i];
+    }
+    for (int i = 1; i <= n; i++) {
+      df(i, n, &xl[0], &dfatx[0]);
+      for (int j = 1; j <= n; j++) {
+        a[i * n1 + j] = static_cast<T>(dfatx[j]);
+      }
+      b[i] = -static_cast<T>(f(i, n, &xl[0]));
+    }
+    if (!SolveDense(n, a, b)) {
+      return Stage::SINGULAR;
+    }
+
+    T step = 0, norm = 0;
+    for (int i = 1; i <= n; i++) {
+      x[i] += b[i];
+      step = std::max<T>(step, std::abs(b[i]));
+      norm = std::max<T>(norm, std::abs(x[i]));
+    }
+    long double delta = norm > 0 ? step / norm : step;
+
+    switch (Classify(delta, previous, precision, eps)) {
+      case 1:
+        return Stage::CONVERGED;
+      case 2:
+        return Stage::STALLED;
+    }
+    previous = delta;
+  }
+}
+
+// MPFR variant of FloatStage. All operands live in workspace vectors that are
+// allocated once for the stage and updated in place, so the only MPFR
+// allocations per iteration are the ones made inside the library functions,
+// and those are served from the limb pool.
+Stage MPStage(int n, Vector &x, FunctionTypeC f, DerivativeTypeC df,
+              int precision, int mit, long double eps, int &it) {
+  int n1 = n + 1;
+  const mpfr_rnd_t rnd = MPFR_RNDN;
+  Vector a(n1 * n1, mpreal(0, precision));
+  Vector b(n1, mpreal(0, precision));
+  mpreal t(0, precision), s(0, precision);
+  long double previous = std::numeric_limits<long double>::infinity();
+
+  for (int i = 1; i <= n; i++) {
+    x[i].setPrecision(precision);
+  }
+
+  while (true) {
+    if (it >= mit) {
+      return Stage::EXCEEDED;
+    }
+    it++;
+
+    // Row i of a doubles as the dfatx vector of equation i
+    for (int i = 1; i <= n; i++) {
+      df(i, n, &x[0], &a[i * n1]);
+      f(i, n, &x[0], b[i]);
+      mpfr_neg(b[i].mpfr_ptr(), b[i].mpfr_srcptr(), rnd);
+    }
+
+    bool singular = false;
+    for (int k = 1; k <= n && !singular; k++) {
+      int piv = k;
+      for (int r = k + 1; r <= n; r++) {
+        if (mpfr_cmpabs(a[r * n1 + k].mpfr_srcptr(),
+                        a[piv * n1 + k].mpfr_srcptr()) > 0) {
+          piv = r;
+        }
+      }
+      if (mpfr_zero_p(a[piv * n1 + k].mpfr_srcptr())) {
+        singular = true;
+        break;
+      }
+      if (piv != k) {
+        for (int c = k; c <= n; c++) {
+          mpfr_swap(a[k * n1 + c].mpfr_ptr(), a[piv * n1 + c].mpfr_ptr());
+        }
+        mpfr_swap(b[k].mpfr_ptr(), b[piv].mpfr_ptr());
+      }
+      for (int r = k + 1; r <= n; r++) {
+        mpfr_div(t.mpfr_ptr(), a[r * n1 + k].mpfr_srcptr(),
+                 a[k * n1 + k].mpfr_srcptr(), rnd);
+        for (int c = k + 1; c <= n; c++) {
+          mpfr_mul(s.mpfr_ptr(), t.mpfr_srcptr(), a[k * n1 + c].mpfr_srcptr(),
+                   rnd);
+          mpfr_sub(a[r * n1 + c].mpfr_ptr(), a[r * n1 + c].mpfr_srcptr(),
+                   s.mpfr_srcptr(), rnd);
+        }
+        mpfr_mul(s.mpfr_ptr(), t.mpfr_srcptr(), b[k].mpfr_srcptr(), rnd);
+        mpfr_sub(b[r].mpfr_ptr(), b[r].mpfr_srcptr(), s.mpfr_srcptr(), rnd);
+      }
+    }
+    if (singular) {
+      return Stage::SINGULAR;
+    }
+    for (int k = n; k >= 1; k--) {
+      for (int c = k + 1; c <= n; c++) {
+        mpfr_mul(s.mpfr_ptr(), a[k * n1 + c].mpfr_srcptr(),
+                 b[c].mpfr_srcptr(), rnd);
+        mpfr_sub(b[k].mpfr_ptr(), b[k].mpfr_srcptr(), s.mpfr_srcptr(), rnd);
+      }
+      mpfr_div(b[k].mpfr_ptr(), b[k].mpfr_srcptr(),
+               a[k * n1 + k].mpfr_srcptr(), rnd);
+    }
+
+    int istep = 1, inorm = 1;
+    for (int i = 1; i <= n; i++) {
+      mpfr_add(x[i].mpfr_ptr(), x[i].mpfr_srcptr(), b[i].mpfr_srcptr(), rnd);
+      if (mpfr_cmpabs(b[i].mpfr_srcptr(), b[istep].mpfr_srcptr()) > 0) {
+        istep = i;
+      }
+      if (mpfr_cmpabs(x[i].mpfr_srcptr(), x[inorm].mpfr_srcptr()) > 0) {
+        inorm = i;
+      }
+    }
+    long double step = std::fabs(mpfr_get_ld(b[istep].mpfr_srcptr(), rnd));
+    long double norm = std::fabs(mpfr_get_ld(x[inorm].mpfr_srcptr(), rnd));
+    long double delta = norm > 0 ? step / norm : step;
+
+    switch (Classify(delta, previous, precision, eps)) {
+      case 1:
+        return Stage::CONVERGED;
+      case 2:
+        return Stage::STALLED;
+    }
+    previous = delta;
+  }
+}
+}  // namespace
+
+/**
+ * Solves a system of n nonlinear equations of the form
+ * f[i](x[1],x[2],...,x[n])=0 (i=1,2,...,n) using Newton's method with
+ * automatic precision escalation. Iterations start in double and move to
+ * long double and then to MPFR at 128, 256, 512, ... bits each time the
+ * quadratic convergence stalls at the current precision, so only the last
+ * few iterations pay for the high precision.
+ *
+ * @param n Number of equations
+ * @param x Initial approximations to solution components (changed on exit,
+ *          returned at the final working precision)
+ * @param f Function that calculates the value of function f[i]
+ * @param df Function that calculates the derivatives df[i]/dx[j] (j=1,2,...,n)
+ * @param fmp Multiprecision variant of f (may be null, which limits the
+ *            working precision to long double)
+ * @param dfmp Multiprecision variant of df (may be null)
+ * @param mit Maximum total number of iterations over all precisions
+ * @param eps Relative accuracy of the solution
+ * @param maxPrecision Largest working precision in bits
+ * @param it Number of iterations performed (output)
+ * @param prec Working precision in bits of the last iteration (output)
+ * @param st Status code (output):
+ *           0 = success,
+ *           1 = invalid input (n<1, mit<1 or maxPrecision<53),
+ *           2 = singular matrix,
+ *           3 = iterations exceeded,
+ *           4 = convergence stalled at the largest available precision
+ */
+void NewtonSystem(int n, Vector &x, NStandard::FunctionTypeC f,
+                  NStandard::DerivativeTypeC df, FunctionTypeC fmp,
+                  DerivativeTypeC dfmp, int mit, const mpreal &eps,
+                  int maxPrecision, int &it, int &prec, int &st) {
+  it = 0;
+  prec = 0;
+  if (n < 1 || mit < 1 || maxPrecision < DOUBLE_PRECISION ||
+      static_cast<int>(x.size()) < n + 1) {
+    st = 1;
+    return;
+  }
+
+  std::vector<int> ladder = {DOUBLE_PRECISION};
+  if (maxPrecision >= LDOUBLE_PRECISION) {
+    ladder.push_back(LDOUBLE_PRECISION);
+  }
+  if (fmp && dfmp) {
+    int p = FIRST_MP_PRECISION;
+    for (; p <= maxPrecision; p *= 2) {
+      ladder.push_back(p);
+    }
+    if (ladder.back() < maxPrecision) {
+      ladder.push_back(maxPrecision);
+    }
+  }
+
+  long double epsl = eps.toLDouble();
+  std::vector<double> xd(n + 1);
+  std::vector<long double> xl(n + 1);
+  for (int i = 1; i <= n; i++) {
+    xd[i] = x[i].toDouble();
+  }
+
+  Stage stage = Stage::STALLED;
+  // Whether x holds the result of an MPFR stage rather than xl
+  bool multiprecision = false;
+  size_t level = 0;
+  for (; level < ladder.size(); level++) {
+    prec = ladder[level];
+    if (prec == DOUBLE_PRECISION) {
+      stage = FloatStage(n, xd, f, df, prec, mit, epsl, it);
+      for (int i = 1; i <= n; i++) {
+        xl[i] = xd[i];
+      }
+    } else if (prec == LDOUBLE_PRECISION) {
+      stage = FloatStage(n, xl, f, df, prec, mit, epsl, it);
+    } else {
+      // Continue from the double or long double stage below, whichever
+      // ran last (maxPrecision below 64 skips the long double one)
+      if (!multiprecision) {
+        for (int i = 1; i <= n; i++) {
+          x[i].setPrecision(prec);
+          mpfr_set_ld(x[i].mpfr_ptr(), xl[i], MPFR_RNDN);
+        }
+      }
+      // Constants built inside the library follow the default precision
+      mpfr_prec_t defaultPrecision = mpreal::get_default_prec();
+      mpreal::set_default_prec(prec);
+      stage = MPStage(n, x, fmp, dfmp, prec, mit, epsl, it);
+      mpreal::set_default_prec(defaultPrecision);
+      multiprecision = true;
+    }
+    if (stage != Stage::STALLED) {
+      break;
+    }
+  }
+
+  if (!multiprecision) {
+    for (int i = 1; i <= n; i++) {
+      x[i].setPrecision(LDOUBLE_PRECISION);
+      mpfr_set_ld(x[i].mpfr_ptr(), xl[i], MPFR_RNDN);
+    }
+  }
+
+  switch (stage) {
+    case Stage::CONVERGED:
+      st = 0;
+      break;
+    case Stage::SINGULAR:
+      st = 2;
+      break;
+    case Stage::EXCEEDED:
+      st = 3;
+      break;
+    case Stage::STALLED:
+      st = 4;
+      break;
+  }
+}
+
+/**
+ * Replaces GMP's memory functions with per-thread free lists of limb
+ * blocks, process-wide. See NewtonSystemMP.h.
+ */
+void InstallLimbPool() {
+  std::call_once(poolInstalled, [] {
+    mp_get_memory_functions(&previousAllocate, &previousReallocate,
+                            &previousFree);
+    mp_set_memory_functions(PoolAllocate, PoolReallocate, PoolFree);
+  });
+}
+}  // namespace NMultiprecision
@@ -0,0 +1,408 @@
+#include "../include/PluginCatalog.h"
+
+#include <dirent.h>
+#include <elf.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// Version 2 added the "products" extension, version 3 the "any" arithmetic,
+// version 4 the "batch" extension
+const char CACHE_HEADER[] = "ean-plugin-cache 4";
+
+const char *const REQUIRED[] = {"evaluateFunction", "evaluateDerivatives",
+                                "getName", "getNumberOfEquations"};
+
+struct Extension {
+  const char *name;
+  const char *symbols[2];
+};
+
+const Extension EXTENSIONS[] = {
+    {"multiprecision", {"evaluateFunctionMP", "evaluateDerivativesMP"}},
+    {"products", {"evaluateJacobianVector", "evaluateVectorJacobian"}},
+    {"batch", {"evaluateSystemBatch", "evaluateJacobianBatch"}}};
+
+uint64_t Fnv1a(const std::string &data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Reads the dynamic symbol table of a 64-bit shared object of the host byte
+// order. Collects the names it defines and whether any symbol belongs to
+// interval_arithmetic.
+bool ReadSymbols(const std::string &image, std::set<std::string> &defined,
+                 bool &interval) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  const unsigned char byteOrder = ELFDATA2LSB;
+#else
+  const unsigned char byteOrder = ELFDATA2MSB;
+#endif
+  Elf64_Ehdr header;
+  if (image.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, image.data(), sizeof(header));
+  if (std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 ||
+      header.e_ident[EI_CLASS] != ELFCLASS64 ||
+      header.e_ident[EI_DATA] != byteOrder || header.e_type != ET_DYN ||
+      header.e_shentsize != sizeof(Elf64_Shdr) ||
+      header.e_shoff > image.size() ||
+      header.e_shnum > (image.size() - header.e_shoff) / sizeof(Elf64_Shdr)) {
+    return false;
+  }
+  std::vector<Elf64_Shdr> sections(header.e_shnum);
+  std::memcpy(sections.data(), image.data() + header.e_shoff,
+              sections.size() * sizeof(Elf64_Shdr));
+
+  interval = false;
+  bool found = false;
+  for (const Elf64_Shdr &table : sections) {
+    if (table.sh_type != SHT_DYNSYM || table.sh_link >= sections.size()) {
+      continue;
+    }
+    const Elf64_Shdr &strings = sections[table.sh_link];
+    if (table.sh_offset > image.size() ||
+        table.sh_size > image.size() - table.sh_offset ||
+        strings.sh_offset > image.size() ||
+        strings.sh_size > image.size() - strings.sh_offset) {
+      return false;
+    }
+    found = true;
+    const char *names = image.data() + strings.sh_offset;
+    size_t count = table.sh_size / sizeof(Elf64_Sym);
+    for (size_t k = 1; k < count; k++) {
+      Elf64_Sym symbol;
+      std::memcpy(&symbol,
+                  image.data() + table.sh_offset + k * sizeof(Elf64_Sym),
+                  sizeof(symbol));
+      if (symbol.st_name >= strings.sh_size ||
+          !std::memchr(names + symbol.st_name, '\0',
+                       strings.sh_size - symbol.st_name)) {
+        continue;
+      }
+      const char *name = names + symbol.st_name;
+      if (std::strstr(name, "interval_arithmetic")) {
+        interval = true;
+      }
+      unsigned char binding = ELF64_ST_BIND(symbol.st_info);
+      if (symbol.st_shndx != SHN_UNDEF &&
+          (binding == STB_GLOBAL || binding == STB_WEAK)) {
+        defined.insert(name);
+      }
+    }
+  }
+  return found;
+}
+
+// Fills the content fields of plugin; false if the file is no system
+// library
+bool Inspect(PluginCatalog::Plugin &plugin) {
+  std::ifstream in(plugin.path, std::ios::binary);
+  if (!in) {
+    return false;
+  }
+  std::string image((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  std::set<std::string> defined;
+  bool interval;
+  if (!ReadSymbols(image, defined, interval)) {
+    return false;
+  }
+  for (const char *symbol : REQUIRED) {
+    if (!defined.count(symbol)) {
+      return false;
+    }
+  }
+  plugin.hash = Fnv1a(image);
+  // Single-source libraries name their variants; any of them may carry
+  // interval code without being an interval library
+  bool standardVariant = defined.count("ean_v1_standard_evaluateFunction");
+  bool intervalVariant = defined.count("ean_v1_interval_evaluateFunction");
+  if (standardVariant && intervalVariant) {
+    plugin.arithmetic = PluginCatalog::Arithmetic::ANY;
+  } else if (standardVariant || intervalVariant) {
+    plugin.arithmetic = standardVariant ? PluginCatalog::Arithmetic::STANDARD
+                                        : PluginCatalog::Arithmetic::INTERVAL;
+  } else {
+    plugin.arithmetic = interval ? PluginCatalog::Arithmetic::INTERVAL
+                                 : PluginCatalog::Arithmetic::STANDARD;
+  }
+  plugin.extensions.clear();
+  for (const Extension &extension : EXTENSIONS) {
+    if (defined.count(extension.symbols[0]) &&
+        defined.count(extension.symbols[1])) {
+      plugin.extensions.push_back(extension.name);
+    }
+  }
+  return true;
+}
+
+bool SameFile(const PluginCatalog::Plugin &a, const PluginCatalog::Plugin &b) {
+  return a.size == b.size && a.modified == b.modified && a.inode == b.inode;
+}
+
+bool SameEntry(const PluginCatalog::Plugin &a,
+               const PluginCatalog::Plugin &b) {
+  return SameFile(a, b) && a.hash == b.hash && a.name == b.name &&
+         a.equations == b.equations;
+}
+
+// Cache lines are tab separated, so names must not contain tabs or newlines
+std::string Sanitize(std::string text) {
+  for (char &c : text) {
+    if (c == '\t' || c == '\n' || c == '\r') {
+      c = ' ';
+    }
+  }
+  return text;
+}
+}  // namespace
+
+PluginCatalog::PluginCatalog(const std::string &cacheFile)
+    : cacheFile(cacheFile), dirty(false) {}
+
+std::string PluginCatalog::DefaultCacheFile() {
+  const char *cache = std::getenv("XDG_CACHE_HOME");
+  if (cache && *cache) {
+    return std::string(cache) + "/ean/plugins";
+  }
+  const char *home = std::getenv("HOME");
+  if (home && *home) {
+    return std::string(home) + "/.cache/ean/plugins";
+  }
+  return "";
+}
+
+std::vector<std::string> PluginCatalog::EnvironmentDirectories() {
+  std::vector<std::string> result;
+  const char *variable = std::getenv("EAN_PLUGIN_PATH");
+  std::stringstream list(variable ? variable : "");
+  std::string directory;
+  while (std::getline(list, directory, ':')) {
+    if (!directory.empty()) {
+      result.push_back(directory);
+    }
+  }
+  return result;
+}
+
+void PluginCatalog::setDirectories(
+    const std::vector<std::string> &directories) {
+  std::lock_guard<std::mutex> guard(lock);
+  this->directories = directories;
+}
+
+std::vector<std::string> PluginCatalog::getDirectories() const {
+  std::lock_guard<std::mutex> guard(lock);
+  return directories;
+}
+
+bool PluginCatalog::loadCache() {
+  std::ifstream in(cacheFile);
+  std::string line;
+  if (cacheFile.empty() || !std::getline(in, line) || line != CACHE_HEADER) {
+    return false;
+  }
+  std::map<std::string, Plugin> loaded;
+  while (std::getline(in, line)) {
+    std::stringstream fields(line);
+    Plugin plugin;
+    std::string size, modified, inode, hash, arithmetic, extensions, equations;
+    if (!std::getline(fields, plugin.path, '\t') ||
+        !std::getline(fields, size, '\t') ||
+        !std::getline(fields, modified, '\t') ||
+        !std::getline(fields, inode, '\t') ||
+        !std::getline(fields, hash, '\t') ||
+        !std::getline(fields, arithmetic, '\t') ||
+        !std::getline(fields, extensions, '\t') ||
+        !std::getline(fields, equations, '\t')) {
+      continue;
+    }
+    std::getline(fields, plugin.name);
+    plugin.size = std::strtoull(size.c_str(), nullptr, 10);
+    plugin.modified = std::strtoll(modified.c_str(), nullptr, 10);
+    plugin.inode = std::strtoull(inode.c_str(), nullptr, 10);
+    plugin.hash = std::strtoull(hash.c_str(), nullptr, 16);
+    plugin.arithmetic = arithmetic == "interval" ? Arithmetic::INTERVAL
+                        : arithmetic == "standard" ? Arithmetic::STANDARD
+                        : arithmetic == "any"      ? Arithmetic::ANY
+                                                   : Arithmetic::UNKNOWN;
+    std::stringstream list(extensions);
+    std::string extension;
+    while (std::getline(list, extension, ',')) {
+      if (!extension.empty() && extension != "-") {
+        plugin.extensions.push_back(extension);
+      }
+    }
+    plugin.equations = std::atoi(equations.c_str());
+    loaded[plugin.path] = plugin;
+  }
+  std::lock_guard<std::mutex> guard(lock);
+  entries = std::move(loaded);
+  dirty = false;
+  return true;
+}
+
+bool PluginCatalog::saveCache() {
+  std::lock_guard<std::mutex> guard(lock);
+  if (!dirty) {
+    return true;
+  }
+  if (cacheFile.empty()) {
+    return false;
+  }
+  // Creates the ean directory and, if needed, the cache directory above it
+  std::string directory = cacheFile.substr(0, cacheFile.rfind('/'));
+  if (mkdir(directory.c_str(), 0755) != 0 && errno == ENOENT) {
+    mkdir(directory.substr(0, directory.rfind('/')).c_str(), 0700);
+    mkdir(directory.c_str(), 0755);
+  }
+  // Written next to the cache and renamed, so readers never see half a file
+  std::string temporary = cacheFile + "." + std::to_string(getpid());
+  {
+    std::ofstream out(temporary);
+    out << CACHE_HEADER << '\n';
+    for (const auto &item : entries) {
+      const Plugin &plugin = item.second;
+      std::string extensions;
+      for (const std::string &extension : plugin.extensions) {
+        extensions += (extensions.empty() ? "" : ",") + extension;
+      }
+      char hash[17];
+      std::snprintf(hash, sizeof(hash), "%016llx",
+                    static_cast<unsigned long long>(plugin.hash));
+      out << plugin.path << '\t' << plugin.size << '\t' << plugin.modified
+          << '\t' << plugin.inode << '\t' << hash << '\t'
+          << PluginArithmeticName(plugin.arithmetic) << '\t'
+          << (extensions.empty() ? "-" : extensions) << '\t'
+          << plugin.equations << '\t' << plugin.name << '\n';
+    }
+    if (!out.flush()) {
+      unlink(temporary.c_str());
+      return false;
+    }
+  }
+  if (rename(temporary.c_str(), cacheFile.c_str()) != 0) {
+    unlink(temporary.c_str());
+    return false;
+  }
+  dirty = false;
+  return true;
+}
+
+void PluginCatalog::scan() {
+  std::vector<std::string> roots;
+  std::map<std::string, Plugin> previous;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    roots = directories;
+    previous = entries;
+  }
+
+  std::map<std::string, Plugin> found;
+  for (const std::string &root : roots) {
+    char resolved[PATH_MAX];
+    DIR *listing = realpath(root.c_str(), resolved) ? opendir(resolved)
+                                                    : nullptr;
+    if (!listing) {
+      continue;
+    }
+    while (dirent *item = readdir(listing)) {
+      std::string name = item->d_name;
+      if (name.size() < 4 || name.compare(name.size() - 3, 3, ".so") != 0 ||
+          name.find_first_of("\t\n\r") != std::string::npos) {
+        continue;
+      }
+      Plugin plugin;
+      plugin.path = std::string(resolved) + "/" + name;
+      struct stat status;
+      if (stat(plugin.path.c_str(), &status) != 0 ||
+          !S_ISREG(status.st_mode)) {
+        continue;
+      }
+      plugin.size = status.st_size;
+      plugin.modified = static_cast<int64_t>(status.st_mtim.tv_sec) *
+                            1000000000 +
+                        status.st_mtim.tv_nsec;
+      plugin.inode = status.st_ino;
+      plugin.equations = -1;
+
+      auto known = previous.find(plugin.path);
+      if (known != previous.end() && SameFile(known->second, plugin)) {
+        found[plugin.path] = known->second;
+        continue;
+      }
+      if (!Inspect(plugin)) {
+        continue;
+      }
+      // Touched but not changed: the description still holds
+      if (known != previous.end() && known->second.hash == plugin.hash) {
+        plugin.name = known->second.name;
+        plugin.equations = known->second.equations;
+      }
+      found[plugin.path] = plugin;
+    }
+    closedir(listing);
+  }
+
+  std::lock_guard<std::mutex> guard(lock);
+  // Keep descriptions recorded while the scan ran
+  for (auto &item : found) {
+    auto current = entries.find(item.first);
+    if (current != entries.end() && item.second.name.empty() &&
+        current->second.hash == item.second.hash) {
+      item.second.name = current->second.name;
+      item.second.equations = current->second.equations;
+    }
+  }
+  bool changed = found.size() != entries.size();
+  for (auto a = found.begin(), b = entries.begin();
+       !changed && a != found.end(); ++a, ++b) {
+    changed = a->first != b->first || !SameEntry(a->second, b->second);
+  }
+  if (changed) {
+    entries = std::move(found);
+    dirty = true;
+  }
+}
+
+std::vector<PluginCatalog::Plugin> PluginCatalog::plugins() const {
+  std::lock_guard<std::mutex> guard(lock);
+  std::vector<Plugin> result;
+  for (const auto &item : entries) {
+    result.push_back(item.second);
+  }
+  return result;
+}
+
+void PluginCatalog::describe(const std::string &path, const std::string &name,
+                             int equations) {
+  std::lock_guard<std::mutex> guard(lock);
+  auto found = entries.find(path);
+  if (found == entries.end()) {
+    return;
+  }
+  std::string clean = Sanitize(name);
+  if (found->second.name != clean || found->second.equations != equations) {
+    found->second.name = clean;
+    found->second.equations = equations;
+    dirty = true;
+  }
+}
@@ -0,0 +1,74 @@
+#include "../include/SharedLibrary.h"
+
+#include <dlfcn.h>
+
+#include <cstring>
+#include <utility>
+
+SharedLibrary::SharedLibrary() : handle(nullptr) {}
+
+SharedLibrary::~SharedLibrary() { unload(); }
+
+SharedLibrary::SharedLibrary(SharedLibrary &&other)
+    : handle(other.handle), error(std::move(other.error)) {
+  other.handle = nullptr;
+}
+
+SharedLibrary &SharedLibrary::operator=(SharedLibrary &&other) {
+  if (this != &other) {
+    unload();
+    handle = other.handle;
+    error = std::move(other.error);
+    other.handle = nullptr;
+  }
+  return *this;
+}
+
+bool SharedLibrary::load(const std::string &path) {
+  unload();
+  // Lazy binding keeps start-up cheap; RTLD_LOCAL keeps the symbols of
+  // different user libraries apart
+  handle = dlopen(path.c_str(), RTLD_LAZY | RTLD_LOCAL);
+  if (!handle) {
+    const char *message = dlerror();
+    error = message ? message : "Cannot load " + path;
+    return false;
+  }
+  error.clear();
+  return true;
+}
+
+void *SharedLibrary::resolve(const char *symbol) const {
+  return handle ? dlsym(handle, symbol) : nullptr;
+}
+
+void *SharedLibrary::resolve(const char *symbol, const char *variant) const {
+  std::string versioned = std::string("ean_v1_") + variant + "_" + symbol;
+  void *address = resolve(versioned.c_str());
+  if (address) {
+    return address;
+  }
+  // The plain names of a single-source library are its long double entries,
+  // never a stand-in for another arithmetic
+  return hasVariant(variant) ? resolve(symbol) : nullptr;
+}
+
+bool SharedLibrary::hasVariant(const char *variant) const {
+  if (std::strcmp(variant, "standard") == 0 ||
+      !resolve("ean_v1_standard_getName")) {
+    return true;
+  }
+  std::string name = std::string("ean_v1_") + variant + "_getName";
+  return resolve(name.c_str()) != nullptr;
+}
+
+void SharedLibrary::unload() {
+  if (handle) {
+    dlclose(handle);
+    handle = nullptr;
+  }
+}
+
+bool SharedLibrary::isLoaded() const { return handle != nullptr; }
+
+std::string SharedLibrary::errorString() const { return error; }
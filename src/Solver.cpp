@@ -1,49 +1,196 @@
 #include "../include/Solver.h"
 
-#include <QLibrary>
-#include <QMessageBox>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "../include/NewtonSystem.h"
 
 namespace NStandard {
 
-Solver::Solver() : functionsLoaded(false) {}
+namespace {
 
-bool Solver::loadLibrary(std::string libraryPath) {
-  QLibrary lib(libraryPath.c_str());
-  if (!lib.load()) {
-    lastError = lib.errorString().toStdString();
+// Worker reserved by the isolated solve running on this thread
+thread_local IsolatedLibrary::Session *session = nullptr;
+
+Val IsolatedFunction(int i, int, const Val *x) {
+  return session->function(i, x);
+}
+
+void IsolatedDerivatives(int i, int, const Val *x, Val *dfatx) {
+  session->derivatives(i, x, dfatx);
+}
+
+// Points the functions above at a worker for the duration of one solve;
+// does nothing for libraries loaded in process
+class IsolatedScope {
+ public:
+  explicit IsolatedScope(IsolatedLibrary *library) : previous(session) {
+    if (library) {
+      local.reset(new IsolatedLibrary::Session(*library));
+      session = local.get();
+    }
+  }
+  ~IsolatedScope() { session = previous; }
+
+ private:
+  IsolatedLibrary::Session *previous;
+  std::unique_ptr<IsolatedLibrary::Session> local;
+};
+
+// Evaluation state of the expression solve running on this thread
+thread_local ExpressionSystem::Evaluator *evaluator = nullptr;
+
+Val ExpressionFunction(int i, int, const Val *x) {
+  return evaluator->function(i, x);
+}
+
+void ExpressionDerivatives(int i, int, const Val *x, Val *dfatx) {
+  evaluator->derivatives(i, x, dfatx);
+}
+
+// Evaluator of the system last solved on this thread, kept because setting
+// one up costs more than a small solve
+thread_local std::weak_ptr<const ExpressionSystem> lastSystem;
+thread_local std::unique_ptr<ExpressionSystem::Evaluator> lastEvaluator;
+
+class ExpressionScope {
+ public:
+  explicit ExpressionScope(
+      const std::shared_ptr<const ExpressionSystem> &system)
+      : previous(evaluator) {
+    if (system) {
+      if (lastSystem.lock() != system) {
+        lastEvaluator.reset(new ExpressionSystem::Evaluator(*system));
+        lastSystem = system;
+      }
+      evaluator = lastEvaluator.get();
+    }
+  }
+  ~ExpressionScope() { evaluator = previous; }
+
+ private:
+  ExpressionSystem::Evaluator *previous;
+};
+}  // namespace
+
+Solver::Solver()
+    : evaluateFunctionMP(nullptr),
+      evaluateDerivativesMP(nullptr),
+      evaluateJacobianVector(nullptr),
+      evaluateVectorJacobian(nullptr),
+      evaluateSystemBatch(nullptr),
+      evaluateJacobianBatch(nullptr),
+      functionsLoaded(false) {}
+
+bool Solver::loadLibrary(std::string libraryPath, LibraryMode mode) {
+  if (mode == LibraryMode::ISOLATED) {
+    std::unique_ptr<IsolatedLibrary> worker(new IsolatedLibrary);
+    if (!worker->load(libraryPath)) {
+      lastError = worker->errorString();
+      return false;
+    }
+    isolated = std::move(worker);
+    expressions.reset();
+    library.unload();
+    evaluateFunction = IsolatedFunction;
+    evaluateDerivatives = IsolatedDerivatives;
+    evaluateFunctionMP = nullptr;
+    evaluateDerivativesMP = nullptr;
+    evaluateJacobianVector = nullptr;
+    evaluateVectorJacobian = nullptr;
+    evaluateSystemBatch = nullptr;
+    evaluateJacobianBatch = nullptr;
+    functionsLoaded = true;
+    return true;
+  }
+
+  SharedLibrary lib;
+  if (!lib.load(libraryPath)) {
+    lastError = lib.errorString();
     return false;
   }
 
-  evaluateFunction = (FunctionTypeC)lib.resolve("evaluateFunction");
-  evaluateDerivatives = (DerivativeTypeC)lib.resolve("evaluateDerivatives");
-  getName = (GetNameFunc)lib.resolve("getName");
-  getNumberOfEquations =
-      (GetNumberOfEquationsFunc)lib.resolve("getNumberOfEquations");
+  // Single-source libraries export a long double variant of every entry
+  const char *variant = "standard";
+  evaluateFunction = (FunctionTypeC)lib.resolve("evaluateFunction", variant);
+  evaluateDerivatives =
+      (DerivativeTypeC)lib.resolve("evaluateDerivatives", variant);
+  getName = (GetNameFunc)lib.resolve("getName", variant);
+  getNumberOfEquations = (GetNumberOfEquationsFunc)lib.resolve(
+      "getNumberOfEquations", variant);
+  // Optional, only needed beyond long double precision
+  evaluateFunctionMP =
+      (NMultiprecision::FunctionTypeC)lib.resolve("evaluateFunctionMP");
+  evaluateDerivativesMP =
+      (NMultiprecision::DerivativeTypeC)lib.resolve("evaluateDerivativesMP");
+  // Optional, for methods working with Jacobian products
+  evaluateJacobianVector =
+      (ProductTypeC)lib.resolve("evaluateJacobianVector", variant);
+  evaluateVectorJacobian =
+      (ProductTypeC)lib.resolve("evaluateVectorJacobian", variant);
+  // Optional, for solving many guesses at once
+  evaluateSystemBatch =
+      (BatchFunctionTypeC)lib.resolve("evaluateSystemBatch");
+  evaluateJacobianBatch =
+      (BatchJacobianTypeC)lib.resolve("evaluateJacobianBatch");
 
   if (evaluateFunction && evaluateDerivatives && getName &&
       getNumberOfEquations) {
+    // Replaces (and unloads) any previously loaded library
+    library = std::move(lib);
+    isolated.reset();
+    expressions.reset();
     functionsLoaded = true;
     return true;
   }
+  functionsLoaded = false;
   lastError = "Missing functions in library";
 
   return false;
 }
 
-SolverResult Solver::solve(Vector &x, int maxIterations, Val epsilon) {
+bool Solver::loadExpressions(const std::string &source,
+                             const std::string &name) {
+  std::unique_ptr<ExpressionSystem> system(new ExpressionSystem);
+  if (!system->parse(source, name)) {
+    lastError = system->errorString();
+    return false;
+  }
+  expressions = std::move(system);
+  isolated.reset();
+  library.unload();
+  evaluateFunction = ExpressionFunction;
+  evaluateDerivatives = ExpressionDerivatives;
+  evaluateFunctionMP = nullptr;
+  evaluateDerivativesMP = nullptr;
+  evaluateJacobianVector = nullptr;
+  evaluateVectorJacobian = nullptr;
+  evaluateSystemBatch = nullptr;
+  evaluateJacobianBatch = nullptr;
+  functionsLoaded = true;
+  return true;
+}
+
+SolverResult Solver::solve(Vector &x, int maxIterations, Val epsilon,
+                           Globalization globalization) {
   if (!functionsLoaded) {
     return {SolverStatus::FUNCTION_NOT_LOADED, 0, {}, lastError};
   }
 
-  int n = getNumberOfEquations();
+  int n = getEquationsCount();
   int iterations = 0;
   int status = 0;
 
-  NewtonSystem(n, x, evaluateFunction, evaluateDerivatives, maxIterations,
-               epsilon, iterations, status);
+  try {
+    IsolatedScope scope(isolated.get());
+    ExpressionScope expressionScope(expressions);
+    NewtonSystem(n, x, evaluateFunction, evaluateDerivatives, maxIterations,
+                 epsilon, iterations, status, globalization);
+  } catch (const IsolatedLibrary::Error &e) {
+    return {SolverStatus::LIBRARY_ERROR, iterations, x, e.what()};
+  }
 
   switch (status) {
     case 0:
@@ -59,15 +206,155 @@ SolverResult Solver::solve(Vector &x, int maxIterations, Val epsilon) {
   }
 }
 
+std::vector<SolverResult> Solver::solveBatch(std::vector<Vector> &xs,
+                                             int maxIterations, Val epsilon,
+                                             Globalization globalization) {
+  std::vector<SolverResult> results;
+  results.reserve(xs.size());
+  if (!hasBatch() || xs.empty()) {
+    for (Vector &x : xs) {
+      results.push_back(solve(x, maxIterations, epsilon, globalization));
+    }
+    return results;
+  }
+
+  int n = getEquationsCount();
+  int m = static_cast<int>(xs.size());
+  std::vector<double> X(static_cast<size_t>(n) * m);
+  for (int k = 0; k < m; k++) {
+    for (int j = 0; j < n; j++) {
+      X[static_cast<size_t>(j) * m + k] = static_cast<double>(xs[k][j + 1]);
+    }
+  }
+  std::vector<int> iterations(m), status(m);
+  NewtonSystemBatch(n, m, X.data(), evaluateSystemBatch,
+                    evaluateJacobianBatch, maxIterations,
+                    static_cast<double>(epsilon), iterations.data(),
+                    status.data());
+
+  // Each double result is refined in long double with the Jacobian there;
+  // guesses that failed in double, or whose refinement failed, are solved
+  // from the start
+  std::vector<double> J(X.size() * n);
+  evaluateJacobianBatch(n, m, X.data(), J.data());
+  for (int k = 0; k < m; k++) {
+    if (status[k] == 0) {
+      Vector x(n + 1);
+      for (int j = 0; j < n; j++) {
+        x[j + 1] = X[static_cast<size_t>(j) * m + k];
+      }
+      int steps = 0, refined = 0;
+      RefineSystem(n, x, evaluateFunction, &J[k], m, maxIterations, epsilon,
+                   steps, refined);
+      if (refined == 0) {
+        xs[k] = x;
+        results.push_back({SolverStatus::SUCCESS, iterations[k] + steps, x,
+                           ""});
+        continue;
+      }
+    }
+    results.push_back(solve(xs[k], maxIterations, epsilon, globalization));
+  }
+  return results;
+}
+
+SolverResultMP Solver::solveMultiprecision(NMultiprecision::Vector &x,
+                                           int maxIterations,
+                                           const mpfr::mpreal &epsilon,
+                                           int maxPrecision) {
+  if (!functionsLoaded) {
+    return {SolverStatus::FUNCTION_NOT_LOADED, 0, 0, {}, lastError};
+  }
+
+  int n = getEquationsCount();
+  int iterations = 0;
+  int precision = 0;
+  int status = 0;
+
+  try {
+    IsolatedScope scope(isolated.get());
+    ExpressionScope expressionScope(expressions);
+    NMultiprecision::NewtonSystem(n, x, evaluateFunction, evaluateDerivatives,
+                                  evaluateFunctionMP, evaluateDerivativesMP,
+                                  maxIterations, epsilon, maxPrecision,
+                                  iterations, precision, status);
+  } catch (const IsolatedLibrary::Error &e) {
+    return {SolverStatus::LIBRARY_ERROR, iterations, precision, x, e.what()};
+  }
+
+  switch (status) {
+    case 0:
+      return {SolverStatus::SUCCESS, iterations, precision, x, ""};
+    case 1:
+      return {SolverStatus::INVALID_INPUT, iterations, precision, x, ""};
+    case 2:
+      return {SolverStatus::SINGULAR_MATRIX, iterations, precision, x, ""};
+    case 3:
+      return {SolverStatus::MAX_ITERATIONS_EXCEEDED, iterations, precision, x,
+              ""};
+    case 4:
+      return {SolverStatus::PRECISION_EXHAUSTED, iterations, precision, x,
+              ""};
+    default:
+      return {SolverStatus::LIBRARY_ERROR, iterations, precision, x, ""};
+  }
+}
+
+bool Solver::hasMultiprecision() const {
+  return functionsLoaded && evaluateFunctionMP && evaluateDerivativesMP;
+}
+
+bool Solver::hasProducts() const {
+  return functionsLoaded && evaluateJacobianVector && evaluateVectorJacobian;
+}
+
+bool Solver::hasBatch() const {
+  return functionsLoaded && evaluateSystemBatch && evaluateJacobianBatch;
+}
+
+bool Solver::jacobianVector(const Vector &x, const Vector &v,
+                            Vector &result) {
+  if (!hasProducts()) {
+    return false;
+  }
+  int n = getEquationsCount();
+  result.assign(n + 1, 0);
+  evaluateJacobianVector(n, &x[0], &v[0], &result[0]);
+  return true;
+}
+
+bool Solver::vectorJacobian(const Vector &x, const Vector &w,
+                            Vector &result) {
+  if (!hasProducts()) {
+    return false;
+  }
+  int n = getEquationsCount();
+  result.assign(n + 1, 0);
+  evaluateVectorJacobian(n, &x[0], &w[0], &result[0]);
+  return true;
+}
+
 std::string Solver::getLastError() const { return lastError; }
 
 std::string Solver::getLibraryName() const {
-  return functionsLoaded ? getName() : "No library";
+  if (!functionsLoaded) {
+    return "No library";
+  }
+  if (expressions) {
+    return expressions->name();
+  }
+  return isolated ? isolated->name() : getName();
 }
 
 bool Solver::isReady() const { return functionsLoaded; }
 
 int Solver::getEquationsCount() const {
-  return functionsLoaded ? getNumberOfEquations() : 0;
+  if (!functionsLoaded) {
+    return 0;
+  }
+  if (expressions) {
+    return expressions->equations();
+  }
+  return isolated ? isolated->equations() : getNumberOfEquations();
 }
 }  // namespace NStandard
\ No newline at end of file
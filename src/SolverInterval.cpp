@@ -1,8 +1,8 @@
 #include "../include/SolverInterval.h"
 
-#include <QLibrary>
-#include <QMessageBox>
+#include <stdexcept>
 #include <string>
+#include <utility>
 
 #include "../include/NewtonSystemInterval.h"
 
@@ -11,19 +11,25 @@ namespace NInterval {
 Solver::Solver() : functionsLoaded(false) {}
 
 bool Solver::loadLibrary(std::string libraryPath) {
-  QLibrary lib(libraryPath.c_str());
-  if (!lib.load()) {
-    lastError = lib.errorString().toStdString();
+  SharedLibrary lib;
+  if (!lib.load(libraryPath)) {
+    lastError = lib.errorString();
     return false;
   }
 
-  std::cout << "Library loaded: " << libraryPath << std::endl;
-
-  evaluateFunction = (FunctionTypeC)lib.resolve("evaluateFunction");
-  evaluateDerivatives = (DerivativeTypeC)lib.resolve("evaluateDerivatives");
-  getName = (GetNameFunc)lib.resolve("getName");
-  getNumberOfEquations =
-      (GetNumberOfEquationsFunc)lib.resolve("getNumberOfEquations");
+  // Single-source libraries export an interval variant of every entry,
+  // unless their residual branches on the variables
+  const char *variant = "interval";
+  if (!lib.hasVariant(variant)) {
+    lastError = "Library has no interval variant";
+    return false;
+  }
+  evaluateFunction = (FunctionTypeC)lib.resolve("evaluateFunction", variant);
+  evaluateDerivatives =
+      (DerivativeTypeC)lib.resolve("evaluateDerivatives", variant);
+  getName = (GetNameFunc)lib.resolve("getName", variant);
+  getNumberOfEquations = (GetNumberOfEquationsFunc)lib.resolve(
+      "getNumberOfEquations", variant);
 
   //   std::cout << "Functions loaded: " << libraryPath << std::endl;
 
@@ -52,40 +58,102 @@ bool Solver::loadLibrary(std::string libraryPath) {
 
   if (evaluateFunction && evaluateDerivatives && getName &&
       getNumberOfEquations) {
+    // Replaces (and unloads) any previously loaded library
+    library = std::move(lib);
     functionsLoaded = true;
     return true;
   }
+  functionsLoaded = false;
   lastError = "Missing functions in library";
 
   return false;
 }
 
-SolverResult Solver::solve(Vector &x, int maxIterations, ValInterval epsilon) {
+SolverResult Solver::solve(Vector &x, int maxIterations, ValInterval epsilon,
+                           LinearSolver linearSolver) {
   if (!functionsLoaded) {
-    return {SolverStatus::FUNCTION_NOT_LOADED, 0, {}, lastError};
+    return {SolverStatus::FUNCTION_NOT_LOADED, 0, {}, lastError, false};
   }
 
   int n = getNumberOfEquations();
   int iterations = 0;
   int status = 0;
 
-  NewtonSystem(n, x, evaluateFunction, evaluateDerivatives, maxIterations,
-               epsilon, iterations, status);
+  interval_arithmetic::IAContextGuard<long double> guard(context);
+  try {
+    NewtonSystem(n, x, evaluateFunction, evaluateDerivatives, maxIterations,
+                 epsilon, iterations, status, linearSolver);
+  } catch (const std::exception &e) {
+    return {SolverStatus::LIBRARY_ERROR, iterations, x, e.what(), false};
+  }
 
   switch (status) {
     case 0:
-      return {SolverStatus::SUCCESS, iterations, x, ""};
+      return {SolverStatus::SUCCESS, iterations, x, "", false};
     case 1:
-      return {SolverStatus::INVALID_INPUT, iterations, x, ""};
+      return {SolverStatus::INVALID_INPUT, iterations, x, "", false};
     case 2:
-      return {SolverStatus::SINGULAR_MATRIX, iterations, x, ""};
+      return {SolverStatus::SINGULAR_MATRIX, iterations, x, "", false};
     case 3:
-      return {SolverStatus::MAX_ITERATIONS_EXCEEDED, iterations, x, ""};
+      return {SolverStatus::MAX_ITERATIONS_EXCEEDED, iterations, x, "", false};
     default:
-      return {SolverStatus::LIBRARY_ERROR, iterations, x, ""};
+      return {SolverStatus::LIBRARY_ERROR, iterations, x, "", false};
   }
 }
 
+SolverResult Solver::verify(Vector &x, int maxIterations, ValInterval epsilon,
+                            Contractor method) {
+  if (!functionsLoaded) {
+    return {SolverStatus::FUNCTION_NOT_LOADED, 0, {}, lastError, false};
+  }
+
+  int n = getNumberOfEquations();
+  int iterations = 0;
+  int status = 0;
+  bool unique = false;
+
+  interval_arithmetic::IAContextGuard<long double> guard(context);
+  try {
+    KrawczykSystem(n, x, evaluateFunction, evaluateDerivatives, method,
+                   maxIterations, epsilon, iterations, status, unique);
+  } catch (const std::exception &e) {
+    return {SolverStatus::LIBRARY_ERROR, iterations, x, e.what(), false};
+  }
+
+  switch (status) {
+    case 0:
+      return {SolverStatus::SUCCESS, iterations, x, "", unique};
+    case 1:
+      return {SolverStatus::INVALID_INPUT, iterations, x, "", false};
+    case 2:
+      return {SolverStatus::SINGULAR_MATRIX, iterations, x, "", false};
+    case 3:
+      return {SolverStatus::MAX_ITERATIONS_EXCEEDED, iterations, x, "",
+              unique};
+    case 4:
+      return {SolverStatus::NO_ROOT, iterations, x, "", false};
+    default:
+      return {SolverStatus::LIBRARY_ERROR, iterations, x, "", false};
+  }
+}
+
+BoxSearchResult Solver::search(const Vector &x,
+                               const BoxSearchOptions &options) {
+  if (!functionsLoaded) {
+    return {};
+  }
+
+  interval_arithmetic::IAContextGuard<long double> guard(context);
+  return BoxSearch(getNumberOfEquations(), x, evaluateFunction,
+                   evaluateDerivatives, options);
+}
+
+void Solver::setContext(const interval_arithmetic::IAContext &context) {
+  this->context = context;
+}
+
+interval_arithmetic::IAContext Solver::getContext() const { return context; }
+
 std::string Solver::getLastError() const { return lastError; }
 
 std::string Solver::getLibraryName() const {
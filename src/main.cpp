@@ -2,6 +2,7 @@
 
 // #include "../include/Interval.h"
 #include "../include/MainWindow.h"
+#include "../include/NewtonSystemMP.h"
 // #include "../include/NewtonSystem.h"
 
 // using Extended = long double;
@@ -33,6 +34,8 @@ int main(int argc, char *argv[]) {
   //   std::cout << mainf(x) << std::endl;
   //   std::cout << maindf(x) << std::endl;
 
+  // Before anything uses GMP
+  NMultiprecision::InstallLimbPool();
   QApplication app(argc, argv);
   MainWindow window;
   window.show();
@@ -0,0 +1,12 @@
+// Single-source library whose residual branches on a variable, so that it
+// has no interval variant (see LibraryVariantTest.cpp)
+#define EAN_BRANCHING_RESIDUAL
+#include "../include/LibraryTemplate.h"
+
+template <class T>
+T residual(int i, const T *x) {
+  if (i == 1) return x[1] > 0 ? sqr(x[1]) - 4 : x[1] + 2;
+  return x[2] - x[1];
+}
+
+EAN_AUTODIFF_LIBRARY("Branching", 2)
@@ -0,0 +1,59 @@
+// A single-source library built with EAN_BRANCHING_RESIDUAL only exports
+// long double entries. Loading it for interval arithmetic must fail with
+// an error instead of binding those entries as interval functions.
+//
+// Usage: library_variant_test BRANCHING_RESIDUAL_LIBRARY
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "../include/Solver.h"
+#include "../include/SolverInterval.h"
+#include "../include/ean.h"
+
+namespace {
+
+int failures = 0;
+
+void Expect(bool condition, const std::string &what) {
+  if (!condition) {
+    std::cerr << "FAILED: " << what << std::endl;
+    failures++;
+  }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::cerr << "Usage: library_variant_test BRANCHING_RESIDUAL_LIBRARY"
+              << std::endl;
+    return 2;
+  }
+  const std::string path = argv[1];
+  const std::string expected = "Library has no interval variant";
+
+  NStandard::Solver standard;
+  Expect(standard.loadLibrary(path), "standard load: " +
+                                         standard.getLastError());
+
+  NInterval::Solver interval;
+  Expect(!interval.loadLibrary(path), "interval load succeeded");
+  Expect(interval.getLastError() == expected,
+         "interval load error: " + interval.getLastError());
+
+  ean_solver *solver =
+      ean_solver_create(EAN_API_VERSION, EAN_ARITHMETIC_INTERVAL);
+  Expect(solver != nullptr, "ean_solver_create");
+  if (solver) {
+    Expect(ean_solver_load_library(solver, path.c_str()) ==
+               EAN_FUNCTION_NOT_LOADED,
+           "C API interval load status");
+    Expect(expected == ean_solver_last_error(solver),
+           std::string("C API interval load error: ") +
+               ean_solver_last_error(solver));
+    ean_solver_destroy(solver);
+  }
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,7 @@
+// Helper process of the isolated library mode: loads one system library and
+// evaluates it on request through the memory shared with the solver that
+// started it (see IsolatedLibrary).
+
+#include "../include/IsolatedLibrary.h"
+
+int main(int argc, char *argv[]) { return RunIsolatedWorker(argc, argv); }